@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <string>
 #include <utility>
 
@@ -96,6 +97,14 @@ class TensorTable {
 
     virtual void PrefetchCachedTensors(int64_t seq_id) = 0;
 
+    /**
+      * Latency and traffic statistics of the process, shared by all tables
+      * @return "<metric>.<label>" -> fields, e.g. "stage_latency_us.read" -> {count, sum, mean, p50, p90, p99,
+      *         p999, max} in microseconds, "peer_read_bytes_total.<host:port>" -> {value} (only counted with
+      *         TRANSFER_ENGINE_ENABLE_PERF_METRICS)
+      */
+    virtual std::map<std::string, std::map<std::string, double>> Stats() = 0;
+
     [[nodiscard]] const std::string& Name() const { return name_; }
 
  protected:
@@ -388,6 +388,26 @@ class TensorTable:
         except Exception as e:
             raise RuntimeError(f"Failed to scan tensor metadata for seq_id {seq_id}: {e}") from e
     
+    def stats(self) -> Dict[str, Dict[str, float]]:
+        """
+        Get latency and traffic statistics of the process.
+
+        Statistics are shared by all tables of the process. The same metrics are served
+        in Prometheus text format at /metrics of the control server.
+
+        Returns:
+            Dict[str, Dict[str, float]]: Metric name to its fields, e.g.
+                - "stage_latency_us.read": count, sum, mean, p50, p90, p99, p999, max (us)
+                - "peer_read_bytes_total.<host:port>": value (bytes), with TRANSFER_ENGINE_ENABLE_PERF_METRICS
+
+        Raises:
+            RuntimeError: If statistics cannot be collected
+        """
+        try:
+            return self._table.stats()
+        except Exception as e:
+            raise RuntimeError(f"Failed to get stats: {e}") from e
+
     @property
     def name(self) -> str:
         """Get table name."""
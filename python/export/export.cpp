@@ -107,6 +107,7 @@ PYBIND11_MODULE(astate_cpp, m) {
             "scan_tensor_meta",
             &astate::TensorTable::ScanTensorMeta,
             "Scan all tensor metadata for the specified sequence ID")
+        .def("stats", &astate::TensorTable::Stats, "Latency percentiles and traffic counters of the process")
         .def("name", &astate::TensorTable::Name, "Get the name of the tensor table");
 
     // Export TensorStorage with proper return value policy
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include <numa.h>
+
+#include <linux/mman.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+
+namespace astate {
+
+/*
+ * Pinned memory arena of one NUMA node. Chunks of chunk_size bytes are mapped on hugetlb pages of hugepage_size
+ * (2MB or 1GB) bound to the node, or on transparent hugepages when no hugetlb pages are reserved. A chunk is pinned
+ * once through register_fn when it is mapped, buffers are then carved out of it by a buddy allocator, so staging
+ * buffers neither pay one registration each nor thousands of 4KB page table entries.
+ *
+ * Requests larger than a chunk get a dedicated mapping that is unmapped on Free. Freed blocks are zeroed and kept for
+ * reuse, regular chunks are only unmapped with the arena.
+ */
+class HugePageArena {
+ public:
+    using RegisterFn = std::function<bool(void*, size_t)>;
+    using UnregisterFn = std::function<void(void*, size_t)>;
+
+    static constexpr size_t kMinBlockSize = 64UL * 1024;
+    static constexpr size_t kHugePage2M = 2UL * 1024 * 1024;
+    static constexpr size_t kHugePage1G = 1024UL * 1024 * 1024;
+
+    HugePageArena(
+        int numa_node, size_t chunk_size, size_t hugepage_size, RegisterFn register_fn, UnregisterFn unregister_fn)
+        : numa_node_(numa_node),
+          hugepage_size_(hugepage_size == kHugePage1G ? kHugePage1G : kHugePage2M),
+          chunk_size_(std::bit_ceil(std::max(chunk_size, hugepage_size_))),
+          register_fn_(std::move(register_fn)),
+          unregister_fn_(std::move(unregister_fn)) {}
+
+    HugePageArena(const HugePageArena&) = delete;
+    HugePageArena& operator=(const HugePageArena&) = delete;
+
+    ~HugePageArena() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [base, chunk] : chunks_) {
+            UnmapChunk(*chunk);
+        }
+    }
+
+    // nullptr when no chunk could be mapped or pinned, the caller falls back to a plain allocation
+    void* Allocate(size_t size) {
+        if (size == 0) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (size > chunk_size_) {
+            Chunk* chunk = MapChunk(RoundUp(size, hugepage_size_), true);
+            if (chunk == nullptr) {
+                return nullptr;
+            }
+            chunk->allocated[0] = {0, size};
+            return chunk->base;
+        }
+
+        size_t order = OrderOf(size);
+        for (auto& [base, chunk] : chunks_) {
+            if (!chunk->dedicated) {
+                if (void* ptr = AllocateFromChunk(*chunk, order, size); ptr != nullptr) {
+                    return ptr;
+                }
+            }
+        }
+        Chunk* chunk = MapChunk(chunk_size_, false);
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+        return AllocateFromChunk(*chunk, order, size);
+    }
+
+    // false when ptr was not allocated by this arena
+    bool Free(void* ptr) {
+        size_t requested = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = FindChunk(ptr);
+            if (it == chunks_.end()) {
+                return false;
+            }
+            Chunk& chunk = *it->second;
+            auto block = chunk.allocated.find(static_cast<char*>(ptr) - chunk.base);
+            if (block == chunk.allocated.end()) {
+                SPDLOG_ERROR("Free of {} which is not the start of a block on NUMA node {}", ptr, numa_node_);
+                return true;
+            }
+            if (chunk.dedicated) {
+                UnmapChunk(chunk);
+                chunks_.erase(it);
+                return true;
+            }
+            requested = block->second.second;
+        }
+
+        // Free blocks are kept zeroed, a buffer only dirtied its requested bytes. The block is still allocated and
+        // regular chunks stay mapped, so zeroing needs no lock and does not stall other frees and allocations.
+        std::memset(ptr, 0, requested);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        Chunk& chunk = *FindChunk(ptr)->second;
+        size_t offset = static_cast<char*>(ptr) - chunk.base;
+        auto block = chunk.allocated.find(offset);
+        size_t order = block->second.first;
+        chunk.allocated.erase(block);
+        while (order + 1 < chunk.free_lists.size()) {
+            size_t buddy = offset ^ BlockSize(order);
+            auto free_buddy = chunk.free_lists[order].find(buddy);
+            if (free_buddy == chunk.free_lists[order].end()) {
+                break;
+            }
+            chunk.free_lists[order].erase(free_buddy);
+            offset = std::min(offset, buddy);
+            ++order;
+        }
+        chunk.free_lists[order].insert(offset);
+        return true;
+    }
+
+    // Maps chunks ahead of the first allocations until bytes fit in free blocks, returns the free bytes
+    size_t Reserve(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t free_bytes = 0;
+        for (const auto& [base, chunk] : chunks_) {
+            for (size_t order = 0; order < chunk->free_lists.size(); ++order) {
+                free_bytes += chunk->free_lists[order].size() * BlockSize(order);
+            }
+        }
+        while (free_bytes < bytes && MapChunk(chunk_size_, false) != nullptr) {
+            free_bytes += chunk_size_;
+        }
+        return free_bytes;
+    }
+
+    bool Owns(const void* ptr) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return FindChunk(ptr) != chunks_.end();
+    }
+
+    // Bytes mapped and pinned by the arena
+    size_t GetMappedBytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t bytes = 0;
+        for (const auto& [base, chunk] : chunks_) {
+            bytes += chunk->size;
+        }
+        return bytes;
+    }
+
+    int GetNumaNode() const { return numa_node_; }
+
+    size_t GetChunkSize() const { return chunk_size_; }
+
+ private:
+    struct Chunk {
+        char* base = nullptr;
+        size_t size = 0;
+        bool hugetlb = false;
+        bool dedicated = false;
+        // Free block offsets per order, a block of order k spans kMinBlockSize << k bytes
+        std::vector<std::set<size_t>> free_lists;
+        // Offset of an allocated block -> (order, requested bytes)
+        std::unordered_map<size_t, std::pair<size_t, size_t>> allocated;
+    };
+
+    static size_t RoundUp(size_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+    static size_t BlockSize(size_t order) { return kMinBlockSize << order; }
+
+    static size_t OrderOf(size_t size) {
+        return std::countr_zero(std::bit_ceil(std::max(size, kMinBlockSize)) / kMinBlockSize);
+    }
+
+    void* AllocateFromChunk(Chunk& chunk, size_t order, size_t size) {
+        size_t available = order;
+        while (available < chunk.free_lists.size() && chunk.free_lists[available].empty()) {
+            ++available;
+        }
+        if (available == chunk.free_lists.size()) {
+            return nullptr;
+        }
+        size_t offset = *chunk.free_lists[available].begin();
+        chunk.free_lists[available].erase(chunk.free_lists[available].begin());
+        // Split down to the requested order, the upper halves stay free
+        while (available > order) {
+            --available;
+            chunk.free_lists[available].insert(offset + BlockSize(available));
+        }
+        chunk.allocated[offset] = {order, size};
+        return chunk.base + offset;
+    }
+
+    std::map<uintptr_t, std::unique_ptr<Chunk>>::const_iterator FindChunk(const void* ptr) const {
+        auto addr = reinterpret_cast<uintptr_t>(ptr);
+        auto it = chunks_.upper_bound(addr);
+        if (it == chunks_.begin()) {
+            return chunks_.end();
+        }
+        --it;
+        if (addr >= it->first + it->second->size) {
+            return chunks_.end();
+        }
+        return it;
+    }
+
+    std::map<uintptr_t, std::unique_ptr<Chunk>>::iterator FindChunk(const void* ptr) {
+        auto it = static_cast<const HugePageArena*>(this)->FindChunk(ptr);
+        return chunks_.erase(it, it);
+    }
+
+    // hugetlb pages bound to the node, else a THP-advised mapping aligned to 2MB
+    void* MapHugePages(size_t size, bool& hugetlb) const {
+        int page_flag = hugepage_size_ == kHugePage1G ? MAP_HUGE_1GB : MAP_HUGE_2MB;
+        void* ptr
+            = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | page_flag, -1, 0);
+        hugetlb = ptr != MAP_FAILED;
+        if (!hugetlb) {
+            SPDLOG_INFO(
+                "No {} byte hugetlb pages for {} bytes on NUMA node {} (errno={}), using transparent hugepages",
+                hugepage_size_,
+                size,
+                numa_node_,
+                errno);
+            size_t padded = size + kHugePage2M;
+            void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) {
+                return nullptr;
+            }
+            auto start = reinterpret_cast<uintptr_t>(raw);
+            uintptr_t aligned = RoundUp(start, kHugePage2M);
+            if (aligned > start) {
+                munmap(raw, aligned - start);
+            }
+            if (aligned + size < start + padded) {
+                munmap(reinterpret_cast<void*>(aligned + size), start + padded - aligned - size);
+            }
+            ptr = reinterpret_cast<void*>(aligned);
+            madvise(ptr, size, MADV_HUGEPAGE);
+        }
+        // Before the first touch, so every page is faulted in on the node
+        if (numa_node_ >= 0 && numa_available() >= 0) {
+            numa_tonode_memory(ptr, size, numa_node_);
+        }
+        return ptr;
+    }
+
+    Chunk* MapChunk(size_t size, bool dedicated) {
+        auto chunk = std::make_unique<Chunk>();
+        void* ptr = MapHugePages(size, chunk->hugetlb);
+        if (ptr == nullptr) {
+            SPDLOG_ERROR("Failed to map {} bytes for the arena of NUMA node {}", size, numa_node_);
+            return nullptr;
+        }
+        if (register_fn_ && !register_fn_(ptr, size)) {
+            SPDLOG_ERROR("Failed to pin {} bytes of the arena of NUMA node {}", size, numa_node_);
+            munmap(ptr, size);
+            return nullptr;
+        }
+        chunk->base = static_cast<char*>(ptr);
+        chunk->size = size;
+        chunk->dedicated = dedicated;
+        if (!dedicated) {
+            chunk->free_lists.resize(OrderOf(size) + 1);
+            chunk->free_lists.back().insert(0);
+        }
+        SPDLOG_INFO(
+            "Mapped {} arena chunk of {} bytes on NUMA node {} ({})",
+            dedicated ? "dedicated" : "shared",
+            size,
+            numa_node_,
+            chunk->hugetlb ? "hugetlb" : "transparent hugepages");
+        Chunk* raw = chunk.get();
+        chunks_.emplace(reinterpret_cast<uintptr_t>(ptr), std::move(chunk));
+        return raw;
+    }
+
+    void UnmapChunk(Chunk& chunk) {
+        if (unregister_fn_) {
+            unregister_fn_(chunk.base, chunk.size);
+        }
+        if (munmap(chunk.base, chunk.size) != 0) {
+            SPDLOG_WARN("munmap of arena chunk {} failed: errno={}", static_cast<void*>(chunk.base), errno);
+        }
+    }
+
+    const int numa_node_;
+    const size_t hugepage_size_;
+    const size_t chunk_size_;
+    RegisterFn register_fn_;
+    UnregisterFn unregister_fn_;
+
+    mutable std::mutex mutex_;
+    std::map<uintptr_t, std::unique_ptr<Chunk>> chunks_;
+};
+
+} // namespace astate
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <cstddef>
 #include <thread>
 
 namespace astate {
@@ -92,4 +94,90 @@ class RWSpinGuard {
     bool is_write_;
 };
 
+/*
+ * Reader-biased read/write lock for read-mostly maps. Each thread counts itself in one of kSlots reader slots, each
+ * on its own cache line, so readers on different slots never write a shared line. A writer raises writer_ first,
+ * which turns new readers away, then waits for every slot to drain; writers are therefore never starved by readers.
+ * Reader critical sections are expected to be short, writers spin while they drain.
+ */
+class ReaderBiasedLock {
+ public:
+    void LockRead() {
+        std::atomic<int>& readers = slots_[ThreadSlot()].readers;
+        for (;;) {
+            // seq_cst pairs the reader count with the writer flag, see LockWrite
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if (!writer_.load(std::memory_order_seq_cst)) {
+                return;
+            }
+            readers.fetch_sub(1, std::memory_order_release);
+            writer_.wait(true, std::memory_order_acquire);
+        }
+    }
+
+    void UnlockRead() { slots_[ThreadSlot()].readers.fetch_sub(1, std::memory_order_release); }
+
+    void LockWrite() {
+        bool expected = false;
+        while (!writer_.compare_exchange_weak(expected, true, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            if (expected) {
+                writer_.wait(true, std::memory_order_relaxed);
+            }
+            expected = false;
+        }
+        for (auto& slot : slots_) {
+            while (slot.readers.load(std::memory_order_seq_cst) != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void UnlockWrite() {
+        writer_.store(false, std::memory_order_release);
+        writer_.notify_all();
+    }
+
+ private:
+    static constexpr size_t kSlots = 64;
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<int> readers{0};
+    };
+
+    // Threads are spread over the slots round robin, a thread keeps its slot for its lifetime
+    static size_t ThreadSlot() {
+        static std::atomic<size_t> next_slot{0};
+        thread_local size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed) % kSlots;
+        return slot;
+    }
+
+    std::array<ReaderSlot, kSlots> slots_;
+    alignas(64) std::atomic<bool> writer_{false};
+};
+
+class ReaderBiasedGuard {
+ public:
+    ReaderBiasedGuard(ReaderBiasedLock& lock, bool is_write)
+        : lock_(lock),
+          is_write_(is_write) {
+        if (is_write_) {
+            lock_.LockWrite();
+        } else {
+            lock_.LockRead();
+        }
+    }
+
+    ~ReaderBiasedGuard() {
+        if (is_write_) {
+            lock_.UnlockWrite();
+        } else {
+            lock_.UnlockRead();
+        }
+    }
+
+ private:
+    ReaderBiasedLock& lock_;
+    bool is_write_;
+};
+
 } // namespace astate
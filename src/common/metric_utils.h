@@ -1,9 +1,24 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
+#include "common/lock_utils.h"
 #include "common/option.h"
 
 namespace astate {
@@ -53,4 +68,315 @@ class PerfMetricsController {
     std::atomic_int perf_read_count_{0};
 };
 
+// Metric updates go to one of kMetricShards per-thread shards, a scrape sums the shards without stopping writers
+constexpr size_t kMetricShards = 16;
+
+// Threads are spread over the shards round robin, a thread keeps its shard for its lifetime
+inline size_t MetricThreadShard() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+    return shard;
+}
+
+class MetricCounter {
+ public:
+    void Add(uint64_t value) { shards_[MetricThreadShard()].value.fetch_add(value, std::memory_order_relaxed); }
+
+    [[nodiscard]] uint64_t Value() const {
+        uint64_t value = 0;
+        for (const auto& shard : shards_) {
+            value += shard.value.load(std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+ private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::array<Shard, kMetricShards> shards_;
+};
+
+// Last value set, for states such as the transport serving a peer
+class MetricGauge {
+ public:
+    void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+
+    [[nodiscard]] int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+    std::atomic<int64_t> value_{0};
+};
+
+struct HistogramSnapshot {
+    std::vector<uint64_t> counts; // per bucket of LatencyHistogram
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    // Upper bound of the bucket holding the q quantile, at most 1/8 above the exact value
+    [[nodiscard]] uint64_t Percentile(double q) const;
+};
+
+/*
+ * HDR-style log-linear histogram of microsecond latencies: values below 8 get a bucket each, every power of two
+ * above is split into 8 buckets, so a percentile is within 12.5% of the recorded value. Values are clamped to
+ * 2^(kMaxExponent+1) - 1 (about 25 days). Record is a few relaxed atomic adds on the shard of the calling thread.
+ */
+class LatencyHistogram {
+ public:
+    static constexpr size_t kSubBucketBits = 3;
+    static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+    static constexpr size_t kMaxExponent = 40;
+    static constexpr size_t kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+    static constexpr uint64_t kMaxValue = (uint64_t{1} << (kMaxExponent + 1)) - 1;
+
+    void Record(uint64_t value) {
+        value = std::min(value, kMaxValue);
+        Shard& shard = shards_[MetricThreadShard()];
+        shard.counts[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = shard.max.load(std::memory_order_relaxed);
+        while (value > max && !shard.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    template <typename Rep, typename Period>
+    void Record(std::chrono::duration<Rep, Period> duration) {
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        Record(static_cast<uint64_t>(std::max<decltype(micros)>(micros, 0)));
+    }
+
+    [[nodiscard]] HistogramSnapshot Snapshot() const {
+        HistogramSnapshot snapshot;
+        snapshot.counts.resize(kBucketCount, 0);
+        for (const auto& shard : shards_) {
+            for (size_t i = 0; i < kBucketCount; ++i) {
+                snapshot.counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+            }
+            snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+            snapshot.max = std::max(snapshot.max, shard.max.load(std::memory_order_relaxed));
+        }
+        for (uint64_t count : snapshot.counts) {
+            snapshot.count += count;
+        }
+        return snapshot;
+    }
+
+    static size_t BucketOf(uint64_t value) {
+        if (value < kSubBuckets) {
+            return value;
+        }
+        size_t exponent = std::bit_width(value) - 1;
+        size_t sub_bucket = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+        return ((exponent - kSubBucketBits + 1) * kSubBuckets) + sub_bucket;
+    }
+
+    // Largest value that falls into the bucket
+    static uint64_t BucketUpperBound(size_t bucket) {
+        if (bucket < kSubBuckets) {
+            return bucket;
+        }
+        size_t shift = (bucket / kSubBuckets) - 1;
+        uint64_t lower = (kSubBuckets + (bucket % kSubBuckets)) << shift;
+        return lower + (uint64_t{1} << shift) - 1;
+    }
+
+ private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, kBucketCount> counts{};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> max{0};
+    };
+
+    std::array<Shard, kMetricShards> shards_;
+};
+
+inline uint64_t HistogramSnapshot::Percentile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    auto rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(LatencyHistogram::BucketUpperBound(i), max);
+        }
+    }
+    return max;
+}
+
+// A metric name and its label, exported as astate_<name>{<label>="..."}
+struct MetricFamily {
+    const char* name;
+    const char* label;
+    const char* help;
+};
+
+inline constexpr MetricFamily kStageLatencyUs{
+    "stage_latency_us", "stage", "Latency of a transfer stage in microseconds"};
+inline constexpr MetricFamily kPeerReadBytes{"peer_read_bytes_total", "peer", "Bytes read from a peer"};
+inline constexpr MetricFamily kPeerRoute{
+    "peer_route", "peer", "Transport serving a peer under TRANSFER_ENGINE_TYPE=auto: 2 RDMA, 3 TCP, 4 SHM, 0 none"};
+
+/*
+ * Histograms, counters and gauges of the process, one per (family, label value). Get* looks a metric up under a
+ * reader-biased lock and creates it on first use; metrics are never removed, so callers on hot paths keep the
+ * returned reference. Scrapes only read the shard atomics, they never block Record or Add.
+ */
+class MetricsRegistry {
+ public:
+    LatencyHistogram& GetHistogram(const MetricFamily& family, const std::string& label_value) {
+        return GetOrCreate(histograms_, family, label_value);
+    }
+
+    MetricCounter& GetCounter(const MetricFamily& family, const std::string& label_value) {
+        return GetOrCreate(counters_, family, label_value);
+    }
+
+    MetricGauge& GetGauge(const MetricFamily& family, const std::string& label_value) {
+        return GetOrCreate(gauges_, family, label_value);
+    }
+
+    // Prometheus text exposition format, histogram buckets end at le = 2^k - 1 microseconds
+    [[nodiscard]] std::string ToPrometheusText() const {
+        std::ostringstream oss;
+        const MetricFamily* last_family = nullptr;
+        for (const auto& [family, label_value, histogram] : Collect(histograms_)) {
+            WriteFamilyHeader(oss, *family, "histogram", last_family);
+            HistogramSnapshot snapshot = histogram->Snapshot();
+            std::string labels = std::string(family->label) + "=\"" + label_value + "\"";
+            uint64_t cumulative = 0;
+            size_t bucket = 0;
+            for (size_t exponent = 0; exponent <= LatencyHistogram::kMaxExponent + 1; ++exponent) {
+                uint64_t le = (uint64_t{1} << exponent) - 1;
+                while (bucket < snapshot.counts.size() && LatencyHistogram::BucketUpperBound(bucket) <= le) {
+                    cumulative += snapshot.counts[bucket++];
+                }
+                oss << "astate_" << family->name << "_bucket{" << labels << ",le=\"" << le << "\"} " << cumulative
+                    << "\n";
+            }
+            oss << "astate_" << family->name << "_bucket{" << labels << ",le=\"+Inf\"} " << snapshot.count << "\n";
+            oss << "astate_" << family->name << "_sum{" << labels << "} " << snapshot.sum << "\n";
+            oss << "astate_" << family->name << "_count{" << labels << "} " << snapshot.count << "\n";
+        }
+        last_family = nullptr;
+        for (const auto& [family, label_value, counter] : Collect(counters_)) {
+            WriteFamilyHeader(oss, *family, "counter", last_family);
+            oss << "astate_" << family->name << "{" << family->label << "=\"" << label_value << "\"} "
+                << counter->Value() << "\n";
+        }
+        last_family = nullptr;
+        for (const auto& [family, label_value, gauge] : Collect(gauges_)) {
+            WriteFamilyHeader(oss, *family, "gauge", last_family);
+            oss << "astate_" << family->name << "{" << family->label << "=\"" << label_value << "\"} "
+                << gauge->Value() << "\n";
+        }
+        return oss.str();
+    }
+
+    // label value -> value of the counters of a family
+    [[nodiscard]] std::map<std::string, uint64_t> GetCounterValues(const MetricFamily& family) const {
+        std::map<std::string, uint64_t> values;
+        for (const auto& [counter_family, label_value, counter] : Collect(counters_)) {
+            if (std::string(counter_family->name) == family.name) {
+                values[label_value] = counter->Value();
+            }
+        }
+        return values;
+    }
+
+    /*
+     * Flat view for Python: "<name>.<label value>" -> {count, sum, mean, p50, p90, p99, p999, max} for histograms
+     * and -> {value} for counters and gauges.
+     */
+    [[nodiscard]] std::map<std::string, std::map<std::string, double>> Stats() const {
+        std::map<std::string, std::map<std::string, double>> stats;
+        for (const auto& [family, label_value, histogram] : Collect(histograms_)) {
+            HistogramSnapshot snapshot = histogram->Snapshot();
+            auto& entry = stats[std::string(family->name) + "." + label_value];
+            entry["count"] = static_cast<double>(snapshot.count);
+            entry["sum"] = static_cast<double>(snapshot.sum);
+            entry["mean"] = snapshot.count == 0
+                ? 0.0
+                : static_cast<double>(snapshot.sum) / static_cast<double>(snapshot.count);
+            entry["p50"] = static_cast<double>(snapshot.Percentile(0.5));
+            entry["p90"] = static_cast<double>(snapshot.Percentile(0.9));
+            entry["p99"] = static_cast<double>(snapshot.Percentile(0.99));
+            entry["p999"] = static_cast<double>(snapshot.Percentile(0.999));
+            entry["max"] = static_cast<double>(snapshot.max);
+        }
+        for (const auto& [family, label_value, counter] : Collect(counters_)) {
+            stats[std::string(family->name) + "." + label_value]["value"] = static_cast<double>(counter->Value());
+        }
+        for (const auto& [family, label_value, gauge] : Collect(gauges_)) {
+            stats[std::string(family->name) + "." + label_value]["value"] = static_cast<double>(gauge->Value());
+        }
+        return stats;
+    }
+
+ private:
+    // (family name, label value) -> (family, metric)
+    template <typename Metric>
+    using MetricMap
+        = std::map<std::pair<std::string, std::string>, std::pair<const MetricFamily*, std::unique_ptr<Metric>>>;
+
+    template <typename Metric>
+    using CollectedMetrics = std::vector<std::tuple<const MetricFamily*, std::string, const Metric*>>;
+
+    template <typename Metric>
+    Metric& GetOrCreate(MetricMap<Metric>& metrics, const MetricFamily& family, const std::string& label_value) {
+        auto key = std::make_pair(std::string(family.name), label_value);
+        {
+            ReaderBiasedGuard guard(lock_, false);
+            auto it = metrics.find(key);
+            if (it != metrics.end()) {
+                return *it->second.second;
+            }
+        }
+        ReaderBiasedGuard guard(lock_, true);
+        auto& entry = metrics[key];
+        if (entry.second == nullptr) {
+            entry = {&family, std::make_unique<Metric>()};
+        }
+        return *entry.second;
+    }
+
+    // Metrics ordered by family, the pointers stay valid after the lock is released
+    template <typename Metric>
+    CollectedMetrics<Metric> Collect(const MetricMap<Metric>& metrics) const {
+        CollectedMetrics<Metric> collected;
+        ReaderBiasedGuard guard(lock_, false);
+        collected.reserve(metrics.size());
+        for (const auto& [key, entry] : metrics) {
+            collected.emplace_back(entry.first, key.second, entry.second.get());
+        }
+        return collected;
+    }
+
+    static void WriteFamilyHeader(
+        std::ostringstream& oss, const MetricFamily& family, const char* metric_type, const MetricFamily*& last) {
+        if (last != nullptr && std::string(last->name) == family.name) {
+            return;
+        }
+        last = &family;
+        oss << "# HELP astate_" << family.name << " " << family.help << "\n";
+        oss << "# TYPE astate_" << family.name << " " << metric_type << "\n";
+    }
+
+    mutable ReaderBiasedLock lock_;
+    MetricMap<LatencyHistogram> histograms_;
+    MetricMap<MetricCounter> counters_;
+    MetricMap<MetricGauge> gauges_;
+};
+
+// Process-wide registry, shared by the transfer service and the tables
+inline MetricsRegistry& GetMetricsRegistry() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
 } // namespace astate
@@ -2,8 +2,10 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
@@ -19,6 +21,8 @@
 #include <sys/resource.h>
 
 #include "common/cuda_utils.h"
+#include "common/hugepage_arena.h"
+#include "common/numa_placement.h"
 #include "common/string_utils.h"
 
 namespace astate {
@@ -97,6 +101,32 @@ class NumaAwareAllocator {
         return true;
     }
 
+    /*
+     * Serve AllocatePinned from one hugepage arena per NUMA node, chunk_size bytes are mapped and pinned at a time.
+     * chunk_size 0 goes back to one numa_alloc_onnode and one registration per buffer. Call before allocating.
+     */
+    void EnableHugePageArena(size_t chunk_size, size_t hugepage_size) {
+        std::lock_guard<std::mutex> lock(alloc_mutex_);
+        arena_chunk_size_ = chunk_size;
+        arena_hugepage_size_ = hugepage_size;
+        SPDLOG_INFO("NUMA hugepage arena: chunk size {}, hugepage size {}", chunk_size, hugepage_size);
+    }
+
+    // New pinned memory is faulted in by this many threads on its node before it is registered, 0 leaves it lazy
+    void SetPrefaultThreads(size_t threads) { prefault_threads_ = threads; }
+    size_t GetPrefaultThreads() const { return prefault_threads_; }
+
+    // Map and prefault arena chunks on numa_node ahead of time, returns the bytes ready for allocations
+    size_t ReserveArena(int numa_node, size_t bytes) {
+        HugePageArena* arena = GetArena(numa_node);
+        return arena == nullptr ? 0 : arena->Reserve(bytes);
+    }
+
+    size_t GetArenaChunkSize() const { return arena_chunk_size_; }
+
+    size_t GetPrefaultedBytes() const { return prefaulted_bytes_; }
+    int64_t GetPrefaultMicros() const { return prefault_us_; }
+
     int GetCurrentProcessNumaId() {
         if (cuda_available_) {
             int dev = -1;
@@ -200,11 +230,19 @@ class NumaAwareAllocator {
             SPDLOG_ERROR("NUMA node {} is not available", numa_node);
             return {};
         }
+        if (HugePageArena* arena = GetArena(numa_node); arena != nullptr) {
+            if (void* ptr = arena->Allocate(size); ptr != nullptr) {
+                return {ptr, numa_node, size, true};
+            }
+            SPDLOG_WARN(
+                "Hugepage arena of NUMA node {} can not serve {} bytes, allocating them separately", numa_node, size);
+        }
         void* ptr = numa_alloc_onnode(size, numa_node);
         if (ptr == nullptr) {
             SPDLOG_ERROR("numa_alloc_onnode failed node={}, size={}", numa_node, size);
             return {};
         }
+        Prefault(ptr, size, numa_node);
 
         if (cuda_available_) {
             cudaError_t rc = cudaHostRegister(ptr, size, cudaHostRegisterPortable);
@@ -243,6 +281,9 @@ class NumaAwareAllocator {
         if (ptr == nullptr) {
             return;
         }
+        if (FreeFromArena(ptr)) {
+            return;
+        }
 
         if (cuda_available_) {
             // Try to unregister; ignore "not registered" error
@@ -348,6 +389,65 @@ class NumaAwareAllocator {
         }
     }
 
+    HugePageArena* GetArena(int numa_node) {
+        std::lock_guard<std::mutex> lock(alloc_mutex_);
+        if (arena_chunk_size_ == 0) {
+            return nullptr;
+        }
+        auto& arena = arenas_[numa_node];
+        if (arena == nullptr) {
+            // A chunk is registered once here instead of every buffer carved out of it
+            bool cuda_available = cuda_available_;
+            arena = std::make_unique<HugePageArena>(
+                numa_node,
+                arena_chunk_size_,
+                arena_hugepage_size_,
+                [this, cuda_available, numa_node](void* ptr, size_t size) {
+                    Prefault(ptr, size, numa_node);
+                    if (cuda_available) {
+                        cudaError_t rc = cudaHostRegister(ptr, size, cudaHostRegisterPortable);
+                        if (rc != cudaSuccess) {
+                            SPDLOG_ERROR("cudaHostRegister of arena chunk failed: {}", cudaGetErrorString(rc));
+                            return false;
+                        }
+                        return true;
+                    }
+                    TryMlock(ptr, size);
+                    return true;
+                },
+                [cuda_available](void* ptr, size_t size) {
+                    if (cuda_available) {
+                        cudaHostUnregister(ptr);
+                    } else {
+                        munlock(ptr, size);
+                    }
+                });
+        }
+        return arena.get();
+    }
+
+    void Prefault(void* ptr, size_t size, int numa_node) {
+        if (prefault_threads_ == 0) {
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        PrefaultOnNumaNode(ptr, size, numa_node, prefault_threads_);
+        prefault_us_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start)
+                            .count();
+        prefaulted_bytes_ += size;
+    }
+
+    bool FreeFromArena(void* ptr) {
+        std::vector<HugePageArena*> arenas;
+        {
+            std::lock_guard<std::mutex> lock(alloc_mutex_);
+            for (auto& [node, arena] : arenas_) {
+                arenas.push_back(arena.get());
+            }
+        }
+        return std::any_of(arenas.begin(), arenas.end(), [ptr](HugePageArena* arena) { return arena->Free(ptr); });
+    }
+
     std::vector<int> available_nodes_;
     std::atomic<size_t> current_node_index_{0};
     std::atomic<bool> initialized_{false};
@@ -355,6 +455,13 @@ class NumaAwareAllocator {
     mutable std::mutex init_mutex_;
     mutable std::mutex alloc_mutex_;
     std::unordered_map<int, int> cuda_to_numa_;
+    size_t arena_chunk_size_ = 0;
+    std::atomic<size_t> prefault_threads_{0};
+    std::atomic<size_t> prefaulted_bytes_{0};
+    std::atomic<int64_t> prefault_us_{0};
+    size_t arena_hugepage_size_ = HugePageArena::kHugePage2M;
+    // Arenas live as long as the allocator, buffers carved out of them must be freed before
+    std::unordered_map<int, std::unique_ptr<HugePageArena>> arenas_;
 };
 
 } // namespace astate
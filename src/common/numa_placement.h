@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <numa.h>
+#include <numaif.h>
+#include <sched.h>
+
+#include <spdlog/spdlog.h>
+
+namespace astate {
+
+// NUMA node of the page backing addr, -1 when unknown (no NUMA, or the page was never touched)
+inline int NumaNodeOfAddress(const void* addr) {
+    if (addr == nullptr || numa_available() < 0) {
+        return -1;
+    }
+    int node = -1;
+    if (get_mempolicy(&node, nullptr, 0, const_cast<void*>(addr), MPOL_F_NODE | MPOL_F_ADDR) != 0) {
+        return -1;
+    }
+    return node;
+}
+
+// NUMA nodes that have CPUs this process may run on, empty without NUMA support
+inline std::vector<int> NumaNodesWithCpus() {
+    std::vector<int> nodes;
+    if (numa_available() < 0) {
+        return nodes;
+    }
+    struct bitmask* cpus = numa_allocate_cpumask();
+    for (int node = 0; node <= numa_max_node(); ++node) {
+        if (numa_bitmask_isbitset(numa_all_nodes_ptr, node) == 0 || numa_node_to_cpus(node, cpus) != 0) {
+            continue;
+        }
+        for (unsigned int cpu = 0; cpu < cpus->size; ++cpu) {
+            if (numa_bitmask_isbitset(cpus, cpu) != 0 && numa_bitmask_isbitset(numa_all_cpus_ptr, cpu) != 0) {
+                nodes.push_back(node);
+                break;
+            }
+        }
+    }
+    numa_free_cpumask(cpus);
+    return nodes;
+}
+
+// Node of every worker, spread evenly over the NUMA nodes; empty on a single node machine, nothing to place there
+inline std::vector<int> PlanWorkerNumaNodes(size_t threads) {
+    std::vector<int> nodes = NumaNodesWithCpus();
+    std::vector<int> plan;
+    if (nodes.size() <= 1 || threads < nodes.size()) {
+        return plan;
+    }
+    plan.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        plan.push_back(nodes[i * nodes.size() / threads]);
+    }
+    return plan;
+}
+
+// Run the calling thread on the CPUs of node and prefer its memory for new pages
+inline bool BindCurrentThreadToNumaNode(int node) {
+    if (node < 0 || numa_available() < 0) {
+        return false;
+    }
+    if (numa_run_on_node(node) != 0) {
+        SPDLOG_WARN("Failed to bind thread to the CPUs of NUMA node {}", node);
+        return false;
+    }
+    numa_set_preferred(node);
+    return true;
+}
+
+// Binds the calling thread to node for the scope, e.g. so per-worker buffers are first touched on the worker's node
+class ScopedNumaBinding {
+ public:
+    explicit ScopedNumaBinding(int node) {
+        if (node < 0 || numa_available() < 0) {
+            return;
+        }
+        CPU_ZERO(&saved_affinity_);
+        if (sched_getaffinity(0, sizeof(saved_affinity_), &saved_affinity_) != 0) {
+            return;
+        }
+        bound_ = BindCurrentThreadToNumaNode(node);
+    }
+
+    ScopedNumaBinding(const ScopedNumaBinding&) = delete;
+    ScopedNumaBinding& operator=(const ScopedNumaBinding&) = delete;
+
+    ~ScopedNumaBinding() {
+        if (!bound_) {
+            return;
+        }
+        sched_setaffinity(0, sizeof(saved_affinity_), &saved_affinity_);
+        numa_set_localalloc();
+    }
+
+ private:
+    cpu_set_t saved_affinity_{};
+    bool bound_ = false;
+};
+
+/*
+ * Faults in the pages of [ptr, ptr + size) from up to threads threads bound to numa_node (-1 leaves them unbound), so
+ * the kernel zeroes them in parallel and places them on that node, instead of the first copy into the buffer or a
+ * serial pinning call doing it. zero clears every byte, for memory that may hold old data; otherwise every page is
+ * read and written back, which keeps its content.
+ */
+inline void PrefaultOnNumaNode(void* ptr, size_t size, int numa_node, size_t threads, bool zero = false) {
+    constexpr size_t kPageSize = 4096;
+    // Below this a thread costs more than it saves
+    constexpr size_t kMinSliceSize = 64UL * 1024 * 1024;
+    if (ptr == nullptr || size == 0) {
+        return;
+    }
+    threads = std::clamp<size_t>((size + kMinSliceSize - 1) / kMinSliceSize, 1, std::max<size_t>(threads, 1));
+    size_t slice = (size / threads + kPageSize - 1) / kPageSize * kPageSize;
+    auto* base = static_cast<char*>(ptr);
+    auto touch = [base, size, numa_node, zero](size_t begin, size_t end) {
+        BindCurrentThreadToNumaNode(numa_node);
+        end = std::min(end, size);
+        if (zero) {
+            std::memset(base + begin, 0, end - begin);
+            return;
+        }
+        volatile char* pages = base;
+        for (size_t offset = begin; offset < end; offset += kPageSize) {
+            pages[offset] = pages[offset];
+        }
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t begin = 0; begin < size; begin += slice) {
+        workers.emplace_back(touch, begin, begin + slice);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace astate
@@ -2,6 +2,8 @@
 
 #include <filesystem>
 #include <fstream>
+#include <stdexcept>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
@@ -18,6 +20,67 @@ void PutOptionValue(Options& options, const std::string& name, const std::string
     }
 }
 
+namespace {
+
+OptionValue ParseOptionValue(ValueType type, const std::string& value) {
+    switch (type) {
+        case ValueType::INT:
+            return value.empty() ? 0 : ParseInt(value);
+        case ValueType::STRING:
+            return value;
+        case ValueType::STRING_LIST:
+            return value.empty() ? std::vector<std::string>{} : ParseStringList(value);
+        case ValueType::BOOL:
+            return value.empty() ? false : ParseBool(value);
+        case ValueType::FLOAT:
+            return value.empty() ? 0.0F : ParseFloat(value);
+        case ValueType::DOUBLE:
+            return value.empty() ? 0.0 : ParseDouble(value);
+        case ValueType::INT64:
+            return value.empty() ? int64_t{0} : ParseLong(value);
+        default:
+            throw std::invalid_argument("Invalid type for value: " + std::to_string(type));
+    }
+}
+
+} // namespace
+
+ResolvedOptions::ResolvedOptions(const Options& options) {
+    const auto& defs = GetOptionDefinitions();
+    for (const auto& [name, value] : options) {
+        if (defs.find(name) == defs.end()) {
+            SPDLOG_ERROR("Unknown option {}={}", name, value);
+            throw std::invalid_argument("Unknown option: " + name);
+        }
+    }
+
+    // An empty default resolves to the zero value of the type, as GetOptionValue returns T{}
+    values_.resize(defs.size());
+    for (const auto& [name, def] : defs) {
+        auto it = options.find(name);
+        const std::string& value = it != options.end() ? it->second : def.default_value;
+        try {
+            values_[def.slot] = ParseOptionValue(def.value_type, value);
+        } catch (const std::exception& e) {
+            SPDLOG_ERROR("Invalid value for option {}: '{}' ({})", name, value, e.what());
+            throw std::invalid_argument("Invalid value for option " + name + ": '" + value + "'");
+        }
+    }
+}
+
+void ValidateOptions(const Options& options) {
+    ResolvedOptions resolved(options);
+}
+
+std::shared_ptr<const ResolvedOptions> TryResolveOptions(const Options& options) {
+    try {
+        return std::make_shared<const ResolvedOptions>(options);
+    } catch (const std::invalid_argument& e) {
+        SPDLOG_ERROR("Invalid options: {}", e.what());
+        return nullptr;
+    }
+}
+
 auto GetOptionFromEnv(const std::string& name) -> std::string {
     const char* env_value = std::getenv(name.c_str());
     return env_value != nullptr ? std::string(env_value) : "";
@@ -29,10 +92,13 @@ void LoadOptions(Options& options) {
     if (load_mode == "ENV") {
         LoadOptionsFromEnv(options);
     } else if (load_mode == "FILE") {
-        LoadOptionsFromFile(options);
+        LoadOptionsFromFile(options, "", true);
     } else {
         SPDLOG_ERROR("Invalid load mode: {}", load_mode);
     }
+
+    // Fail at startup rather than on the first call that reads a mistyped value
+    ValidateOptions(options);
 }
 
 // Load options from ENV
@@ -51,7 +117,7 @@ void LoadOptionsFromEnv(Options& options) {
 
 constexpr const char* DEFAULT_ASTATE_CONFIG_FILE = "astate_config.yaml";
 
-void LoadOptionsFromFile(Options& options, std::string file_path) {
+void LoadOptionsFromFile(Options& options, std::string file_path, bool strict) {
     file_path = file_path.empty() ? GetOptionFromEnv(ASTATE_OPTIONS_FILE_PATH) : file_path;
 
     // If file path was not specified in ENV, try to get it from options
@@ -70,6 +136,7 @@ void LoadOptionsFromFile(Options& options, std::string file_path) {
     // Start to load options from file
     std::string line;
     int line_number = 0;
+    std::vector<std::string> unknown_keys;
 
     while (std::getline(config_file, line)) {
         line_number++;
@@ -106,12 +173,18 @@ void LoadOptionsFromFile(Options& options, std::string file_path) {
         if (defs.find(key) != defs.end()) {
             PutOptionValue(options, key, value);
             SPDLOG_INFO("Loaded option from file: {} = {}", key, value);
+        } else if (strict) {
+            SPDLOG_ERROR("Unknown option in config file line {}: {}", line_number, key);
+            unknown_keys.push_back(key);
         } else {
             SPDLOG_WARN("Unknown option in config file line {}: {} (skipping)", line_number, key);
         }
     }
 
     config_file.close();
+    if (!unknown_keys.empty()) {
+        throw std::invalid_argument("Unknown options in config file " + file_path + ": " + ToString(unknown_keys));
+    }
     SPDLOG_INFO("Load options from file [{}]: {}", file_path, ToString(options));
 }
 
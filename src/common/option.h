@@ -3,9 +3,11 @@
 #include <any>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <variant>
 #include <vector>
 
 #include <spdlog/spdlog.h>
@@ -36,7 +38,7 @@ inline std::string ToString(const Options& options) {
 }
 
 // Option definition: config name, config value type, default value.....
-using ValueType = enum : uint8_t {
+enum ValueType : uint8_t {
     INT = 0,
     STRING = 1,
     STRING_LIST = 2,
@@ -47,9 +49,12 @@ using ValueType = enum : uint8_t {
     UNKNOWN = 255
 };
 
-using OptionDef = struct {
+// ValueType and OptionDef shall be named types: unnamed ones have no linkage, which would
+// give GetOptionDefinitions() internal linkage and a separate registry per TU
+struct OptionDef {
     ValueType value_type;
     std::string default_value;
+    size_t slot = 0; // index of the option in ResolvedOptions
 };
 
 using OptionDefinition = std::unordered_map<std::string, OptionDef>;
@@ -71,9 +76,11 @@ struct CreatOption {
 
         auto it = defs.find(name);
         if (it == defs.end()) {
-            defs.emplace(name, OptionDef{type, default_value});
+            slot = defs.size();
+            defs.emplace(name, OptionDef{type, default_value, slot});
         } else {
             const auto& old = it->second;
+            slot = old.slot;
             if (old.value_type != type || old.default_value != default_value) {
                 SPDLOG_ERROR(
                     "Option {} already defined with different definition: "
@@ -88,11 +95,77 @@ struct CreatOption {
             }
         }
     }
+
+    size_t slot = 0;
+};
+
+// C++ type of the values of an option type
+template <ValueType V>
+struct OptionValueTypeOf;
+template <>
+struct OptionValueTypeOf<INT> {
+    using type = int;
+};
+template <>
+struct OptionValueTypeOf<STRING> {
+    using type = std::string;
+};
+template <>
+struct OptionValueTypeOf<STRING_LIST> {
+    using type = std::vector<std::string>;
+};
+template <>
+struct OptionValueTypeOf<BOOL> {
+    using type = bool;
+};
+template <>
+struct OptionValueTypeOf<FLOAT> {
+    using type = float;
+};
+template <>
+struct OptionValueTypeOf<DOUBLE> {
+    using type = double;
+};
+template <>
+struct OptionValueTypeOf<INT64> {
+    using type = int64_t;
+};
+
+template <ValueType V>
+using OptionValueType = typename OptionValueTypeOf<V>::type;
+
+// Typed handle of an option, OPTION(NAME, ...) declares NAME_KEY next to the NAME string
+template <typename T>
+struct OptionKey {
+    const std::string& name;
+    size_t slot;
+};
+
+// One alternative per ValueType, in the same order
+using OptionValue = std::variant<int, std::string, std::vector<std::string>, bool, float, double, int64_t>;
+
+/*
+ * All defined options parsed once into a flat table indexed by OptionKey::slot: unset options take their default,
+ * unknown names and values that do not parse as their type throw std::invalid_argument. Get is an index plus a
+ * variant check, for paths that read options per call instead of GetOptionValue's lookup and parse.
+ */
+class ResolvedOptions {
+ public:
+    explicit ResolvedOptions(const Options& options = {});
+
+    template <typename T>
+    const T& Get(const OptionKey<T>& key) const {
+        return std::get<T>(values_[key.slot]);
+    }
+
+ private:
+    std::vector<OptionValue> values_;
 };
 
 #define OPTION(name, type, default_value) \
     inline const std::string name = #name; \
-    inline const ::astate::CreatOption option_reg_##name(name, type, default_value);
+    inline const ::astate::CreatOption option_reg_##name(name, type, default_value); \
+    inline const ::astate::OptionKey<::astate::OptionValueType<type>> name##_KEY{name, option_reg_##name.slot};
 
 /********** Option definition: [Option Name, Option Type, Default Value] ***********/
 OPTION(ASTATE_OPTIONS_LOAD_MODE, STRING, "ENV") // ENV, FILE...
@@ -106,12 +179,15 @@ OPTION(TRANSFER_ENGINE_PEERS_HOST, STRING_LIST, "")
 OPTION(TRANSFER_ENGINE_GROUP_HOST, STRING_LIST, "")
 
 // Transfer Engine Data Transport Options
-OPTION(TRANSFER_ENGINE_TYPE, STRING, "")
+OPTION(TRANSFER_ENGINE_TYPE, STRING, "") // rdma (default when empty), tcp, auto (per-peer SHM/RDMA/TCP, opt-in)
+OPTION(TRANSFER_ENGINE_AUTO_BACKENDS, STRING_LIST, "shm,rdma,tcp") // backends tried per peer by auto, best first
 OPTION(TRANSFER_ENGINE_LOCAL_ADDRESS, STRING, "")
 OPTION(TRANSFER_ENGINE_LOCAL_PORT, INT, "0")
 OPTION(TRANSFER_ENGINE_READ_TIMEOUT_MS, INT, "120000") // 120s
 OPTION(TRANSFER_ENGINE_WRITE_TIMEOUT_MS, INT, "120000") // 120s
 OPTION(TRANSFER_ENGINE_READ_THREAD_NUM, INT, "32")
+OPTION(TRANSFER_ENGINE_THREAD_POOL_WORK_STEALING, BOOL, "false") // per-worker deques, else one shared queue
+OPTION(TRANSFER_ENGINE_THREAD_POOL_NUMA_AWARE, BOOL, "true") // work-stealing workers grouped per NUMA node
 OPTION(TRANSFER_ENGINE_COPY_THREAD_NUM, INT, "32")
 OPTION(TRANSFER_ENGINE_COPY_BUCKET_MEM_SIZE, INT64, "524288000") // 500MB
 OPTION(TRANSFER_ENGINE_COPY_LARGE_THREAD_NUM, INT, "2")
@@ -146,26 +222,53 @@ OPTION(DISCOVERY_WORLD_SIZE_RETRY_COUNT, INT,
        "270") // sleep interval 10s, total 2700s
 OPTION(DISCOVERY_CONFIG_CENTER_TYPE, STRING, "FILE") // TCPStore, HTTP, FILE
 OPTION(TRANSFER_ENGINE_LOG_TENSOR_META, BOOL, "true")
+OPTION(TRANSFER_ENGINE_META_ENCODING, STRING, "json") // json, binary (smaller and faster, every rank must decode it)
+OPTION(TRANSFER_ENGINE_META_SUBSCRIPTION, BOOL, "false") // readers only receive metas of the shards they read
+OPTION(TRANSFER_ENGINE_CTRL_TRANSPORT, STRING, "brpc") // brpc, tcp (on the tcp data connections, no extra port)
+OPTION(TRANSFER_ENGINE_CTRL_AGGREGATION, STRING, "none") // none, host (per-host leaders relay control messages)
+OPTION(TRANSFER_ENGINE_CTRL_AGGREGATION_TIMEOUT_MS, INT64, "60000") // leader waits this long for its members
+OPTION(TRANSFER_ENGINE_ELASTIC_MEMBERSHIP, BOOL, "false") // follow peers joining and leaving, no restart
+OPTION(TRANSFER_ENGINE_RESTART_SNAPSHOT_DIR, STRING, "") // e.g. /dev/shm, discovery and meta snapshots for restarts
 
 // skip rdma exception for test environment when rdma not working
 OPTION(TRANSFER_ENGINE_SKIP_RDMA_EXCEPTION, BOOL, "false")
 OPTION(TRANSFER_ENGINE_MAX_RDMA_DEVICES, INT, "2")
 OPTION(TRANSFER_ENGINE_RDMA_NUM_POLLERS, INT, "1")
+OPTION(TRANSFER_ENGINE_SHM_PORT, INT, "0") // 0 means pick a free one
+OPTION(TRANSFER_ENGINE_SHM_ALLOW_PTRACE, BOOL, "false") // PR_SET_PTRACER_ANY, lets local peers read us under yama
+OPTION(TRANSFER_ENGINE_TCP_PORT, INT, "0") // 0 means pick a free one
+OPTION(TRANSFER_ENGINE_TCP_NUM_STREAMS, INT, "4") // parallel connections per peer
+OPTION(TRANSFER_ENGINE_TCP_CHUNK_SIZE, INT64, "4194304") // 4MB, large reads are striped across streams
+OPTION(TRANSFER_ENGINE_TCP_SOCKET_BUFFER_SIZE, INT, "16777216") // 16MB
+OPTION(TRANSFER_ENGINE_TCP_ZEROCOPY, BOOL, "false") // MSG_ZEROCOPY on the serving side
+OPTION(TRANSFER_ENGINE_TCP_WORKER_NUM, INT, "16") // fixed pool running streams and peers in parallel
+OPTION(TRANSFER_ENGINE_TCP_SERVER_THREAD_NUM, INT, "16") // fixed pool serving the incoming connections
 OPTION(TRANSPORT_RECEIVE_RETRY_COUNT, INT, "30")
 OPTION(TRANSPORT_RECEIVE_RETRY_SLEEP_MS, INT, "3000")
 OPTION(TRANSPORT_SEND_RETRY_COUNT, INT, "30")
 OPTION(TRANSPORT_SEND_RETRY_SLEEP_MS, INT, "5000")
+OPTION(TRANSPORT_HTTP_POOL_SIZE, INT, "4") // keep-alive connections per peer
+OPTION(TRANSPORT_HTTP_IDLE_TIMEOUT_MS, INT, "3000") // below the server keep-alive timeout
+OPTION(TRANSPORT_HTTP_SERVER_THREAD_NUM, INT, "128") // an open keep-alive connection holds one, at least peers x pool
 
 // NUMA Options
 OPTION(TRANSFER_ENGINE_ENABLE_NUMA_RUN_BINDING, BOOL, "true") // cpu affinity
 OPTION(TRANSFER_ENGINE_ENABLE_NUMA_ALLOCATION, BOOL,
        "true") // numa allocation affinity
+OPTION(TRANSFER_ENGINE_NUMA_ARENA_CHUNK_SIZE, INT64, "0") // pinned hugepage chunk per node, e.g. 1GB; 0 disables arena
+OPTION(TRANSFER_ENGINE_NUMA_ARENA_HUGEPAGE_SIZE, INT64, "2097152") // 2MB or 1GB hugetlb pages, else THP
+OPTION(TRANSFER_ENGINE_PREFAULT_THREAD_NUM, INT, "0") // threads faulting in staging memory on its node, 0 is lazy, no warmup
 
 // BRPC Transport Options
 OPTION(BRPC_TRANSPORT_MAX_RETRIES, INT, "90")
 OPTION(BRPC_TRANSPORT_TIMEOUT_MS, INT, "10000")
+OPTION(BRPC_TRANSPORT_ATTACHMENT, BOOL, "false") // payload as IOBuf attachment, no protobuf copy and parse
+OPTION(BRPC_TRANSPORT_MAX_BODY_SIZE, INT64, "0") // brpc max_body_size flag, 0 keeps brpc's default (64MB)
 
 OPTION(DISCOVERY_USE_BATCH_API, BOOL, "true")
+OPTION(DISCOVERY_USE_BARRIER, BOOL, "true") // wait on one completion key instead of polling the node list
+OPTION(DISCOVERY_BARRIER_TIMEOUT_MS, INT64, "300000") // 300s, at most half the discovery timeout, then polling
+OPTION(DISCOVERY_RUN_ID, STRING, "") // barrier key prefix, set per run if the tcpstore outlives restarts
 
 // Log Options
 OPTION(ASTATE_LOG_BACKEND, STRING, "SPDLOG") // SPDLOG, GLOG
@@ -314,10 +417,17 @@ T GetOptionValue(const Options& options, const std::string& name) {
 
 void PutOptionValue(Options& options, const std::string& name, const std::string& value);
 
+// Throws std::invalid_argument on unknown option names and on values that do not parse as their type
+void ValidateOptions(const Options& options);
+
+// ResolvedOptions for callers that report failure by return value, nullptr (already logged) on invalid options
+std::shared_ptr<const ResolvedOptions> TryResolveOptions(const Options& options);
+
 // Utils for config
 std::string GetOptionFromEnv(const std::string& name);
 void LoadOptions(Options& options);
 void LoadOptionsFromEnv(Options& options);
-void LoadOptionsFromFile(Options& options, std::string file_path = "");
+// strict: unknown options in the file throw instead of being skipped
+void LoadOptionsFromFile(Options& options, std::string file_path = "", bool strict = false);
 
 } // namespace astate
@@ -1,51 +1,175 @@
 #pragma once
 
-#include <condition_variable>
+#include <atomic>
 #include <cstddef>
-#include <mutex>
-#include <queue>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
 
 namespace astate {
 
-// A simple thread-safe message queue.
+/*
+ * A bounded thread-safe message queue: a lock-free multi-producer multi-consumer ring buffer (Vyukov's bounded MPMC
+ * queue). Every cell carries a sequence number telling producers and consumers whose turn it is, so a push or pop is
+ * one CAS on the position plus one store to the cell, and the producer and consumer positions sit on their own cache
+ * lines.
+ *
+ * Push blocks while the queue is full (backpressure), Pop blocks while it is empty; TryPush and TryPop never block.
+ * Blocked callers spin briefly, then sleep on an epoch that the other side only bumps when somebody sleeps.
+ */
 template <typename T>
 class MessageQueue {
  public:
+    static constexpr size_t kDefaultCapacity = 4096;
+
+    // The capacity is rounded up to a power of two
+    explicit MessageQueue(size_t capacity = kDefaultCapacity)
+        : mask_(RoundUpToPowerOfTwo(capacity) - 1),
+          cells_(std::make_unique<Cell[]>(mask_ + 1)) {
+        for (size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MessageQueue(const MessageQueue&) = delete;
+    MessageQueue& operator=(const MessageQueue&) = delete;
+
+    // Blocking wait while the queue is full
     void Push(T value) {
-        std::unique_lock<std::mutex> lock(mtx_);
-        q_.push(std::move(value));
-        cond_.notify_one();
+        if (!TryPush(value)) {
+            WaitFor(pop_epoch_, push_waiters_, [this, &value] { return TryPush(value); });
+        }
+    }
+
+    // Push if there is room (non-blocking); value is left untouched when the queue is full
+    bool TryPush(T& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value.emplace(std::move(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        Notify(push_epoch_, pop_waiters_);
+        return true;
     }
 
     // Blocking wait until there is a message
     T Pop() {
-        std::unique_lock<std::mutex> lock(mtx_);
-        cond_.wait(lock, [this] { return !q_.empty(); });
-        T val = std::move(q_.front());
-        q_.pop();
-        return val;
+        T value;
+        if (!TryPop(value)) {
+            WaitFor(push_epoch_, pop_waiters_, [this, &value] { return TryPop(value); });
+        }
+        return value;
     }
 
     // Try to pop a message (non-blocking); optional, for polling
     bool TryPop(T& value) {
-        std::unique_lock<std::mutex> lock(mtx_);
-        if (q_.empty()) {
-            return false;
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
         }
-        value = std::move(q_.front());
-        q_.pop();
+        value = std::move(*cell->value);
+        cell->value.reset();
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        Notify(pop_epoch_, push_waiters_);
         return true;
     }
 
+    // Approximate while other threads push or pop
     size_t Size() const {
-        std::lock_guard<std::mutex> lock(mtx_);
-        return q_.size();
+        size_t dequeued = dequeue_pos_.load(std::memory_order_acquire);
+        size_t enqueued = enqueue_pos_.load(std::memory_order_acquire);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
     }
 
+    size_t Capacity() const { return mask_ + 1; }
+
  private:
-    std::queue<T> q_;
-    mutable std::mutex mtx_;
-    std::condition_variable cond_;
+    static constexpr size_t kCacheLineSize = 64;
+    static constexpr int kSpinCount = 64;
+
+    struct alignas(kCacheLineSize) Cell {
+        std::atomic<size_t> sequence{0};
+        std::optional<T> value;
+    };
+
+    static size_t RoundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // Wake the other side only if one of its callers sleeps, the fence pairs with the one in WaitFor
+    static void Notify(std::atomic<uint32_t>& epoch, std::atomic<uint32_t>& waiters) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) != 0) {
+            epoch.fetch_add(1, std::memory_order_release);
+            epoch.notify_all();
+        }
+    }
+
+    template <typename TryOnce>
+    static void WaitFor(std::atomic<uint32_t>& epoch, std::atomic<uint32_t>& waiters, TryOnce&& try_once) {
+        for (int spin = 0; spin < kSpinCount; ++spin) {
+            if (try_once()) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+        for (;;) {
+            uint32_t seen = epoch.load(std::memory_order_acquire);
+            waiters.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool done = try_once();
+            if (!done) {
+                epoch.wait(seen, std::memory_order_acquire);
+            }
+            waiters.fetch_sub(1, std::memory_order_relaxed);
+            if (done || try_once()) {
+                return;
+            }
+        }
+    }
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+
+    alignas(kCacheLineSize) std::atomic<size_t> enqueue_pos_{0};
+    alignas(kCacheLineSize) std::atomic<size_t> dequeue_pos_{0};
+
+    // Bumped by pushes for sleeping Pop callers and by pops for sleeping Push callers
+    alignas(kCacheLineSize) std::atomic<uint32_t> push_epoch_{0};
+    std::atomic<uint32_t> pop_waiters_{0};
+    alignas(kCacheLineSize) std::atomic<uint32_t> pop_epoch_{0};
+    std::atomic<uint32_t> push_waiters_{0};
 };
 
-} // namespace astate
\ No newline at end of file
+} // namespace astate
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace astate {
+
+/*
+ * Opens once CountDown was called count times. Only the call that reaches zero takes the mutex, and Wait always
+ * takes it, so a waiter never returns while that last CountDown still touches the latch.
+ */
+class CountdownLatch {
+ public:
+    explicit CountdownLatch(size_t count)
+        : count_(count) {}
+
+    CountdownLatch(const CountdownLatch&) = delete;
+    CountdownLatch& operator=(const CountdownLatch&) = delete;
+
+    void CountDown() {
+        if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            condition_.notify_all();
+        }
+    }
+
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this] { return count_.load(std::memory_order_acquire) == 0; });
+    }
+
+ private:
+    std::atomic<size_t> count_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+};
+
+// Completion of one SubmitBatch: a single latch for all its tasks, the first exception is kept for the submitter
+class TaskBatch {
+ public:
+    explicit TaskBatch(size_t count)
+        : latch_(count) {}
+
+    template <typename F>
+    void Run(F&& task) noexcept {
+        try {
+            std::forward<F>(task)();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+        latch_.CountDown();
+    }
+
+    void Wait() { latch_.Wait(); }
+
+    // Only after Wait
+    void RethrowIfFailed() const {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+ private:
+    CountdownLatch latch_;
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+};
+
+// Free list of task blocks, a batch takes one and gives it back once its latch opened
+template <typename T>
+class TaskBlockPool {
+ public:
+    std::vector<T> Acquire(size_t count) {
+        std::vector<T> block;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_blocks_.empty()) {
+                block = std::move(free_blocks_.back());
+                free_blocks_.pop_back();
+            }
+        }
+        block.resize(count);
+        return block;
+    }
+
+    void Release(std::vector<T> block) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_blocks_.size() < kMaxFreeBlocks) {
+            free_blocks_.push_back(std::move(block));
+        }
+    }
+
+ private:
+    // Concurrent batches kept warm, more are freed
+    static constexpr size_t kMaxFreeBlocks = 8;
+
+    std::mutex mutex_;
+    std::vector<std::vector<T>> free_blocks_;
+};
+
+} // namespace astate
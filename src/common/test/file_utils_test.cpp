@@ -0,0 +1,44 @@
+#include "common/file_utils.h"
+
+#include <filesystem>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace astate {
+class FileUtilsTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() / ("astate_file_utils_test_" + std::to_string(getpid()));
+        std::filesystem::create_directories(dir_);
+    }
+    void TearDown() override { std::filesystem::remove_all(dir_); }
+
+    std::filesystem::path dir_;
+};
+
+TEST_F(FileUtilsTest, WriteAndReadBack) {
+    std::string path = (dir_ / "snapshot").string();
+    std::string content("binary\0content\n", 15);
+    ASSERT_TRUE(WriteFileAtomically(path, content));
+    auto read = ReadFile(path);
+    ASSERT_TRUE(read.has_value());
+    EXPECT_EQ(*read, content);
+
+    ASSERT_TRUE(WriteFileAtomically(path, "replaced"));
+    EXPECT_EQ(ReadFile(path).value_or(""), "replaced");
+
+    // The temporary file is renamed over the target, nothing else is left in the directory
+    size_t file_count = 0;
+    for ([[maybe_unused]] const auto& entry : std::filesystem::directory_iterator(dir_)) {
+        ++file_count;
+    }
+    EXPECT_EQ(file_count, 1);
+}
+
+TEST_F(FileUtilsTest, MissingFileOrDirectory) {
+    EXPECT_FALSE(ReadFile((dir_ / "missing").string()).has_value());
+    EXPECT_FALSE(WriteFileAtomically((dir_ / "missing" / "snapshot").string(), "content"));
+}
+
+} // namespace astate
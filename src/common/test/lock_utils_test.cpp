@@ -0,0 +1,84 @@
+#include "common/lock_utils.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace astate {
+class LockUtilsTest : public ::testing::Test {
+ protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(LockUtilsTest, ReaderBiasedLockExcludesWriters) {
+    constexpr int kReaders = 8;
+    constexpr int kWrites = 2000;
+    ReaderBiasedLock lock;
+    // Writers keep both values equal, readers must never see them differ
+    long first = 0;
+    long second = 0;
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::atomic<long> reads{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < kReaders; ++i) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                ReaderBiasedGuard guard(lock, false);
+                if (first != second) {
+                    ++torn;
+                }
+                ++reads;
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 2; ++i) {
+        writers.emplace_back([&] {
+            for (int j = 0; j < kWrites; ++j) {
+                ReaderBiasedGuard guard(lock, true);
+                ++first;
+                ++second;
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(first, 2 * kWrites);
+    EXPECT_EQ(second, 2 * kWrites);
+    EXPECT_GT(reads.load(), 0);
+}
+
+TEST_F(LockUtilsTest, ReaderBiasedLockAllowsConcurrentReaders) {
+    ReaderBiasedLock lock;
+    std::atomic<int> inside{0};
+    std::atomic<bool> together{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            ReaderBiasedGuard guard(lock, false);
+            ++inside;
+            // Every reader holds the lock until all of them got in
+            while (inside.load() < 4) {
+                std::this_thread::yield();
+            }
+            together = true;
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_TRUE(together.load());
+}
+
+} // namespace astate
@@ -0,0 +1,108 @@
+#include "common/metric_utils.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace astate {
+class MetricUtilsTest : public ::testing::Test {
+ protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(MetricUtilsTest, HistogramBucketsCoverValues) {
+    for (uint64_t value : {0UL, 1UL, 7UL, 8UL, 9UL, 15UL, 16UL, 17UL, 1000UL, 123456UL, LatencyHistogram::kMaxValue}) {
+        size_t bucket = LatencyHistogram::BucketOf(value);
+        ASSERT_LT(bucket, LatencyHistogram::kBucketCount) << value;
+        EXPECT_GE(LatencyHistogram::BucketUpperBound(bucket), value);
+        if (bucket > 0) {
+            EXPECT_LT(LatencyHistogram::BucketUpperBound(bucket - 1), value);
+        }
+    }
+    EXPECT_EQ(LatencyHistogram::BucketOf(LatencyHistogram::kMaxValue), LatencyHistogram::kBucketCount - 1);
+}
+
+TEST_F(MetricUtilsTest, HistogramPercentiles) {
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram.Record(value);
+    }
+    histogram.Record(std::chrono::milliseconds(5));
+
+    HistogramSnapshot snapshot = histogram.Snapshot();
+    EXPECT_EQ(snapshot.count, 1001);
+    EXPECT_EQ(snapshot.sum, 500500 + 5000);
+    EXPECT_EQ(snapshot.max, 5000);
+    uint64_t p50 = snapshot.Percentile(0.5);
+    EXPECT_GE(p50, 501);
+    EXPECT_LE(p50, 501 + 501 / 8);
+    uint64_t p99 = snapshot.Percentile(0.99);
+    EXPECT_GE(p99, 991);
+    EXPECT_LE(p99, 991 + 991 / 8);
+    EXPECT_EQ(snapshot.Percentile(1.0), 5000);
+    EXPECT_EQ(LatencyHistogram().Snapshot().Percentile(0.99), 0);
+}
+
+TEST_F(MetricUtilsTest, ConcurrentRecordsMerge) {
+    constexpr int kThreads = 8;
+    constexpr int kRecords = 20000;
+    LatencyHistogram histogram;
+    MetricCounter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < kRecords; ++i) {
+                histogram.Record(static_cast<uint64_t>(i % 100));
+                counter.Add(2);
+            }
+        });
+    }
+    // Scrapes while the writers run
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_LE(histogram.Snapshot().count, kThreads * kRecords);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(histogram.Snapshot().count, kThreads * kRecords);
+    EXPECT_EQ(counter.Value(), 2UL * kThreads * kRecords);
+}
+
+TEST_F(MetricUtilsTest, RegistryExportsPrometheusTextAndStats) {
+    MetricsRegistry registry;
+    LatencyHistogram& read = registry.GetHistogram(kStageLatencyUs, "read");
+    EXPECT_EQ(&read, &registry.GetHistogram(kStageLatencyUs, "read"));
+    read.Record(3);
+    read.Record(100);
+    registry.GetHistogram(kStageLatencyUs, "wait").Record(10);
+    registry.GetCounter(kPeerReadBytes, "10.0.0.1:9000").Add(4096);
+    registry.GetGauge(kPeerRoute, "10.0.0.1:9000").Set(4);
+    registry.GetGauge(kPeerRoute, "10.0.0.1:9000").Set(3);
+
+    std::string text = registry.ToPrometheusText();
+    EXPECT_NE(text.find("# TYPE astate_stage_latency_us histogram"), std::string::npos);
+    EXPECT_EQ(text.find("# TYPE astate_stage_latency_us histogram"), text.rfind("# TYPE astate_stage_latency_us"));
+    EXPECT_NE(text.find("astate_stage_latency_us_bucket{stage=\"read\",le=\"3\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("astate_stage_latency_us_bucket{stage=\"read\",le=\"127\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("astate_stage_latency_us_bucket{stage=\"read\",le=\"+Inf\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("astate_stage_latency_us_sum{stage=\"read\"} 103\n"), std::string::npos);
+    EXPECT_NE(text.find("astate_stage_latency_us_count{stage=\"wait\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE astate_peer_read_bytes_total counter"), std::string::npos);
+    EXPECT_NE(text.find("astate_peer_read_bytes_total{peer=\"10.0.0.1:9000\"} 4096\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE astate_peer_route gauge"), std::string::npos);
+    EXPECT_NE(text.find("astate_peer_route{peer=\"10.0.0.1:9000\"} 3\n"), std::string::npos);
+
+    auto stats = registry.Stats();
+    EXPECT_EQ(stats["stage_latency_us.read"]["count"], 2);
+    EXPECT_EQ(stats["stage_latency_us.read"]["max"], 100);
+    EXPECT_EQ(stats["stage_latency_us.wait"]["p99"], 10);
+    EXPECT_EQ(stats["peer_read_bytes_total.10.0.0.1:9000"]["value"], 4096);
+    EXPECT_EQ(stats["peer_route.10.0.0.1:9000"]["value"], 3);
+}
+
+} // namespace astate
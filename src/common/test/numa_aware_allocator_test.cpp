@@ -1,6 +1,9 @@
 #include "common/numa_aware_allocator.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include <spdlog/spdlog.h>
@@ -324,4 +327,90 @@ TEST_F(NumaAwareAllocatorTest, LargeAllocation) {
         SPDLOG_WARN("Large allocation failed, possibly due to insufficient memory");
     }
 }
+
+TEST_F(NumaAwareAllocatorTest, HugePageArenaReusesZeroedBlocks) {
+    // 8MB chunks, the THP fallback is taken when no hugetlb pages are reserved
+    HugePageArena arena(0, 8UL * 1024 * 1024, HugePageArena::kHugePage2M, nullptr, nullptr);
+    std::vector<char*> blocks;
+    for (size_t size : {1000UL, 64UL * 1024, 100UL * 1024, 3UL * 1024 * 1024}) {
+        auto* block = static_cast<char*>(arena.Allocate(size));
+        ASSERT_NE(block, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % HugePageArena::kMinBlockSize, 0);
+        EXPECT_TRUE(arena.Owns(block));
+        std::memset(block, 0xab, size);
+        blocks.push_back(block);
+    }
+    EXPECT_EQ(arena.GetMappedBytes(), 8UL * 1024 * 1024);
+
+    char* first = blocks[0];
+    EXPECT_TRUE(arena.Free(first));
+    auto* again = static_cast<char*>(arena.Allocate(1000));
+    EXPECT_EQ(again, first);
+    EXPECT_EQ(again[0], 0);
+    EXPECT_EQ(again[999], 0);
+    blocks[0] = again;
+
+    int local = 0;
+    EXPECT_FALSE(arena.Free(&local));
+    for (char* block : blocks) {
+        EXPECT_TRUE(arena.Free(block));
+    }
+    // Everything merged back into one chunk sized block
+    EXPECT_NE(arena.Allocate(8UL * 1024 * 1024), nullptr);
+    EXPECT_EQ(arena.GetMappedBytes(), 8UL * 1024 * 1024);
+}
+
+TEST_F(NumaAwareAllocatorTest, HugePageArenaDedicatedChunkForLargeBuffers) {
+    HugePageArena arena(0, 4UL * 1024 * 1024, HugePageArena::kHugePage2M, nullptr, nullptr);
+    void* large = arena.Allocate(5UL * 1024 * 1024);
+    ASSERT_NE(large, nullptr);
+    EXPECT_EQ(arena.GetMappedBytes(), 6UL * 1024 * 1024);
+    EXPECT_TRUE(arena.Free(large));
+    EXPECT_EQ(arena.GetMappedBytes(), 0);
+}
+
+TEST_F(NumaAwareAllocatorTest, AllocatePinnedFromArena) {
+    NumaAwareAllocator allocator;
+    if (!allocator.Initialize()) {
+        GTEST_SKIP() << "NUMA not available, skipping arena test";
+    }
+    allocator.EnableHugePageArena(16UL * 1024 * 1024, HugePageArena::kHugePage2M);
+    int node = allocator.GetAvailableNodes()[0];
+    auto first = allocator.AllocatePinned(1024 * 1024, node);
+    auto second = allocator.AllocatePinned(1024 * 1024, node);
+    ASSERT_TRUE(first.success);
+    ASSERT_TRUE(second.success);
+    // Both come out of the same chunk
+    EXPECT_EQ(std::abs(static_cast<char*>(second.ptr) - static_cast<char*>(first.ptr)), 1024 * 1024);
+    allocator.Deallocate(first.ptr, first.size);
+    allocator.Deallocate(second.ptr, second.size);
+}
+
+TEST_F(NumaAwareAllocatorTest, PrefaultKeepsContentOrZeroes) {
+    constexpr size_t kSize = 200UL * 1024 * 1024 + 123;
+    std::vector<char> buffer(kSize, 7);
+    PrefaultOnNumaNode(buffer.data(), kSize, -1, 4);
+    EXPECT_EQ(buffer.front(), 7);
+    EXPECT_EQ(buffer[kSize / 2], 7);
+    EXPECT_EQ(buffer.back(), 7);
+    PrefaultOnNumaNode(buffer.data(), kSize, 0, 4, true);
+    EXPECT_EQ(std::count(buffer.begin(), buffer.end(), 0), kSize);
+}
+
+TEST_F(NumaAwareAllocatorTest, ReserveArenaPrefaultsAhead) {
+    NumaAwareAllocator allocator;
+    if (!allocator.Initialize()) {
+        GTEST_SKIP() << "NUMA not available, skipping arena test";
+    }
+    allocator.EnableHugePageArena(8UL * 1024 * 1024, HugePageArena::kHugePage2M);
+    allocator.SetPrefaultThreads(2);
+    int node = allocator.GetAvailableNodes()[0];
+    EXPECT_GE(allocator.ReserveArena(node, 12UL * 1024 * 1024), 12UL * 1024 * 1024);
+    EXPECT_EQ(allocator.GetPrefaultedBytes(), 16UL * 1024 * 1024);
+    // Served from the reserved chunks, nothing new is faulted in
+    auto result = allocator.AllocatePinned(4UL * 1024 * 1024, node);
+    ASSERT_TRUE(result.success);
+    EXPECT_EQ(allocator.GetPrefaultedBytes(), 16UL * 1024 * 1024);
+    allocator.Deallocate(result.ptr, result.size);
+}
 } // namespace astate
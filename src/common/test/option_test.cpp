@@ -577,4 +577,77 @@ TEST_F(OptionTest, LoadOptionsFileMode) {
     unsetenv("ASTATE_OPTIONS_FILE_PATH");
 }
 
+// Test ResolvedOptions with set and default values
+TEST_F(OptionTest, ResolvedOptionsTypedValues) {
+    Options options;
+    PutOptionValue(options, TRANSFER_ENGINE_LOCAL_PORT, "8081");
+    PutOptionValue(options, TRANSFER_ENGINE_PEERS_HOST, "host1,host2");
+    PutOptionValue(options, TRANSPORT_SEND_RETRY_SLEEP_MS, "7");
+
+    ResolvedOptions resolved(options);
+    EXPECT_EQ(resolved.Get(TRANSFER_ENGINE_LOCAL_PORT_KEY), 8081);
+    EXPECT_EQ(resolved.Get(TRANSFER_ENGINE_PEERS_HOST_KEY), (std::vector<std::string>{"host1", "host2"}));
+    EXPECT_EQ(resolved.Get(TRANSPORT_SEND_RETRY_SLEEP_MS_KEY), 7);
+
+    // Unset options resolve to what GetOptionValue returns
+    EXPECT_EQ(
+        resolved.Get(TRANSPORT_SEND_RETRY_COUNT_KEY), GetOptionValue<int>(options, TRANSPORT_SEND_RETRY_COUNT));
+    EXPECT_EQ(
+        resolved.Get(TRANSFER_ENGINE_COPY_BUCKET_MEM_SIZE_KEY),
+        GetOptionValue<int64_t>(options, TRANSFER_ENGINE_COPY_BUCKET_MEM_SIZE));
+    EXPECT_EQ(resolved.Get(ASTATE_DEBUG_MODE_KEY), false);
+    EXPECT_TRUE(resolved.Get(TRANSFER_ENGINE_TYPE_KEY).empty());
+    EXPECT_TRUE(resolved.Get(TRANSFER_ENGINE_GROUP_HOST_KEY).empty());
+
+    ResolvedOptions defaults;
+    EXPECT_EQ(defaults.Get(TRANSFER_ENGINE_LOCAL_PORT_KEY), 0);
+}
+
+// Test ResolvedOptions with an unknown option name
+TEST_F(OptionTest, ResolvedOptionsUnknownOption) {
+    Options options;
+    options["TRANSFER_ENGINE_LOCAL_PROT"] = "8081";
+    EXPECT_THROW(ResolvedOptions resolved(options), std::invalid_argument);
+    EXPECT_THROW(ValidateOptions(options), std::invalid_argument);
+}
+
+// Test ResolvedOptions with values that do not parse as their type
+TEST_F(OptionTest, ResolvedOptionsInvalidValue) {
+    Options options;
+    PutOptionValue(options, TRANSFER_ENGINE_LOCAL_PORT, "port");
+    EXPECT_THROW(ValidateOptions(options), std::invalid_argument);
+
+    options.clear();
+    PutOptionValue(options, ASTATE_DEBUG_MODE, "yes");
+    EXPECT_THROW(ValidateOptions(options), std::invalid_argument);
+
+    options.clear();
+    PutOptionValue(options, ASTATE_DEBUG_MODE, "true");
+    EXPECT_NO_THROW(ValidateOptions(options));
+}
+
+// Integration test: LoadOptions with FILE mode rejects unknown and invalid options
+TEST_F(OptionTest, LoadOptionsFileModeFailsFast) {
+    setenv("ASTATE_OPTIONS_LOAD_MODE", "FILE", 1);
+    setenv("ASTATE_OPTIONS_FILE_PATH", "fail_fast_config.txt", 1);
+
+    std::ofstream typo_file("fail_fast_config.txt");
+    typo_file << "TRANSFER_ENGINE_TYPE=rdma\n"
+              << "TRANSFER_ENGINE_LOCAL_PROT=7777\n";
+    typo_file.close();
+    Options typo_options;
+    EXPECT_THROW(LoadOptions(typo_options), std::invalid_argument);
+
+    std::ofstream invalid_file("fail_fast_config.txt");
+    invalid_file << "TRANSFER_ENGINE_LOCAL_PORT=port\n";
+    invalid_file.close();
+    Options invalid_options;
+    EXPECT_THROW(LoadOptions(invalid_options), std::invalid_argument);
+
+    // Clean up
+    std::remove("fail_fast_config.txt");
+    unsetenv("ASTATE_OPTIONS_LOAD_MODE");
+    unsetenv("ASTATE_OPTIONS_FILE_PATH");
+}
+
 } // namespace astate
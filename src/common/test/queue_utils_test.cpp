@@ -0,0 +1,87 @@
+#include "common/queue_utils.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace astate {
+class QueueUtilsTest : public ::testing::Test {
+ protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(QueueUtilsTest, FifoAndBounded) {
+    MessageQueue<std::string> queue(3);
+    EXPECT_EQ(queue.Capacity(), 4);
+    for (int i = 0; i < 4; ++i) {
+        std::string value = std::to_string(i);
+        ASSERT_TRUE(queue.TryPush(value));
+    }
+    std::string extra = "extra";
+    EXPECT_FALSE(queue.TryPush(extra));
+    EXPECT_EQ(extra, "extra");
+    EXPECT_EQ(queue.Size(), 4);
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(queue.Pop(), std::to_string(i));
+    }
+    std::string value;
+    EXPECT_FALSE(queue.TryPop(value));
+    EXPECT_EQ(queue.Size(), 0);
+}
+
+TEST_F(QueueUtilsTest, PushBlocksWhileFull) {
+    MessageQueue<int> queue(2);
+    queue.Push(0);
+    queue.Push(1);
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        queue.Push(2);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(pushed.load());
+    EXPECT_EQ(queue.Pop(), 0);
+    producer.join();
+    EXPECT_TRUE(pushed.load());
+    EXPECT_EQ(queue.Pop(), 1);
+    EXPECT_EQ(queue.Pop(), 2);
+}
+
+TEST_F(QueueUtilsTest, ConcurrentProducersAndConsumers) {
+    constexpr int kProducers = 4;
+    constexpr int kConsumers = 4;
+    constexpr int kItemsPerProducer = 20000;
+    MessageQueue<int> queue(64);
+    std::vector<std::atomic<int>> seen(kProducers * kItemsPerProducer);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&queue, p] {
+            for (int i = 0; i < kItemsPerProducer; ++i) {
+                queue.Push(p * kItemsPerProducer + i);
+            }
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&queue, &seen] {
+            for (int i = 0; i < kProducers * kItemsPerProducer / kConsumers; ++i) {
+                seen[queue.Pop()].fetch_add(1);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < seen.size(); ++i) {
+        ASSERT_EQ(seen[i].load(), 1) << "item " << i;
+    }
+    EXPECT_EQ(queue.Size(), 0);
+}
+
+} // namespace astate
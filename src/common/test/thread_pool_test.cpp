@@ -2,6 +2,8 @@
 
 #include <atomic>
 #include <chrono>
+#include <ranges>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 
@@ -69,6 +71,105 @@ TEST_F(ThreadPoolTest, SubmitAfterDestructionThrows) {
     SUCCEED();
 }
 
+TEST_F(ThreadPoolTest, WorkStealingTaskExecution) {
+    ThreadPool pool(4, true);
+    std::atomic<int> counter{0};
+    std::vector<std::future<int>> futures;
+    futures.reserve(100);
+    for (int i = 0; i < 100; ++i) {
+        futures.push_back(pool.Submit(
+            [&counter](int value) {
+                ++counter;
+                return value * 2;
+            },
+            i));
+    }
+    pool.WaitForTasks();
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(futures[i].get(), i * 2);
+    }
+    EXPECT_EQ(counter, 100);
+    EXPECT_EQ(pool.GetTaskCount(), 0);
+}
+
+TEST_F(ThreadPoolTest, WorkStealingExceptionHandling) {
+    ThreadPool pool(2, true);
+    auto fut = pool.Submit([] { throw std::runtime_error("error"); });
+    EXPECT_THROW(fut.get(), std::runtime_error);
+    EXPECT_EQ(pool.Submit([] { return 1; }).get(), 1);
+}
+
+TEST_F(ThreadPoolTest, SubmitBatch) {
+    for (bool work_stealing : {false, true}) {
+        ThreadPool pool(4, work_stealing);
+        std::vector<int> values(1000, 1);
+        pool.SubmitBatch(values, [](int& value) { value *= 3; });
+        for (int value : values) {
+            ASSERT_EQ(value, 3);
+        }
+        // Blocks are reused by the following batches
+        std::atomic<int> sum{0};
+        pool.SubmitBatch(std::views::iota(0, 100), [&sum](int value) { sum += value; });
+        EXPECT_EQ(sum, 4950);
+        pool.SubmitBatch(std::vector<int>{}, [](int) { FAIL(); });
+    }
+}
+
+TEST_F(ThreadPoolTest, SubmitBatchRethrowsFirstException) {
+    for (bool work_stealing : {false, true}) {
+        ThreadPool pool(2, work_stealing);
+        std::atomic<int> counter{0};
+        EXPECT_THROW(
+            pool.SubmitBatch(
+                std::views::iota(0, 10),
+                [&counter](int value) {
+                    ++counter;
+                    if (value % 2 == 0) {
+                        throw std::runtime_error("error");
+                    }
+                }),
+            std::runtime_error);
+        // The other tasks of the batch still ran before SubmitBatch returned
+        EXPECT_EQ(counter, 10);
+    }
+}
+
+TEST_F(ThreadPoolTest, WaitForTasksWaitsForRunningTasks) {
+    for (bool work_stealing : {false, true}) {
+        ThreadPool pool(2, work_stealing);
+        std::atomic<int> counter{0};
+        for (int i = 0; i < 4; ++i) {
+            pool.Submit([&counter] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                ++counter;
+            });
+        }
+        pool.WaitForTasks();
+        EXPECT_EQ(counter, 4);
+    }
+}
+
+TEST_F(ThreadPoolTest, NumaHintsKeepResults) {
+    for (bool work_stealing : {false, true}) {
+        ThreadPool pool(4, work_stealing, true);
+        // Hints name nodes that may not exist, tasks still run exactly once
+        EXPECT_EQ(pool.SubmitToNode(0, [](int value) { return value + 1; }, 1).get(), 2);
+        EXPECT_EQ(pool.SubmitToNode(64, [] { return 3; }).get(), 3);
+        std::vector<int> values(1000, 1);
+        pool.SubmitBatch(
+            values,
+            [](int& value) { value *= 3; },
+            [&values](int& value) { return static_cast<int>(&value - values.data()) % 2; });
+        for (int value : values) {
+            ASSERT_EQ(value, 3);
+        }
+        std::atomic<int> sum{0};
+        pool.SubmitBatch(
+            std::views::iota(0, 100), [&sum](int value) { sum += value; }, [](int value) { return value % 3 - 1; });
+        EXPECT_EQ(sum, 4950);
+    }
+}
+
 class CUDAStreamThreadPoolTest : public ::testing::Test {
  protected:
     void SetUp() override {}
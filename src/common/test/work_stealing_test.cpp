@@ -0,0 +1,195 @@
+#include "common/work_stealing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace astate {
+class WorkStealingTest : public ::testing::Test {
+ protected:
+    void SetUp() override {}
+    void TearDown() override {}
+};
+
+TEST_F(WorkStealingTest, DequeOwnerIsLifoThiefIsFifo) {
+    ChaseLevDeque<int*> deque(2);
+    std::vector<int> values{0, 1, 2, 3, 4};
+    for (auto& value : values) {
+        deque.Push(&value);
+    }
+    EXPECT_EQ(deque.Size(), 5);
+    EXPECT_EQ(deque.Steal(), &values[0]);
+    EXPECT_EQ(deque.Pop(), &values[4]);
+    EXPECT_EQ(deque.Steal(), &values[1]);
+    EXPECT_EQ(deque.Pop(), &values[3]);
+    EXPECT_EQ(deque.Pop(), &values[2]);
+    EXPECT_EQ(deque.Pop(), nullptr);
+    EXPECT_EQ(deque.Steal(), nullptr);
+}
+
+TEST_F(WorkStealingTest, DequeConcurrentStealTakesEveryItemOnce) {
+    constexpr int kItems = 100000;
+    constexpr int kThieves = 3;
+    ChaseLevDeque<int*> deque(4);
+    std::vector<int> values(kItems);
+    std::vector<std::atomic<int>> taken(kItems);
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < kThieves; ++t) {
+        thieves.emplace_back([&] {
+            while (!done.load() || deque.Size() > 0) {
+                if (int* item = deque.Steal(); item != nullptr) {
+                    taken[item - values.data()].fetch_add(1);
+                }
+            }
+        });
+    }
+    for (int i = 0; i < kItems; ++i) {
+        deque.Push(&values[i]);
+        if (i % 3 == 0) {
+            if (int* item = deque.Pop(); item != nullptr) {
+                taken[item - values.data()].fetch_add(1);
+            }
+        }
+    }
+    while (int* item = deque.Pop()) {
+        taken[item - values.data()].fetch_add(1);
+    }
+    done = true;
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+    for (int i = 0; i < kItems; ++i) {
+        ASSERT_EQ(taken[i].load(), 1) << "item " << i;
+    }
+}
+
+TEST_F(WorkStealingTest, SchedulerRunsAllTasks) {
+    std::atomic<int> counter{0};
+    {
+        WorkStealingScheduler scheduler(4);
+        for (int i = 0; i < 10000; ++i) {
+            scheduler.Submit([&counter](size_t) { counter.fetch_add(1); });
+        }
+    }
+    // Shutdown drains the queued tasks
+    EXPECT_EQ(counter.load(), 10000);
+}
+
+TEST_F(WorkStealingTest, NestedSubmitsAreStolen) {
+    constexpr int kChildren = 64;
+    std::atomic<int> counter{0};
+    std::mutex mutex;
+    std::set<size_t> workers;
+    {
+        WorkStealingScheduler scheduler(4);
+        // The children land on one worker's deque, idle workers have to steal them
+        scheduler.Submit([&](size_t) {
+            for (int i = 0; i < kChildren; ++i) {
+                scheduler.Submit([&](size_t worker_index) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        workers.insert(worker_index);
+                    }
+                    counter.fetch_add(1);
+                });
+            }
+        });
+        while (counter.load() < kChildren) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    EXPECT_EQ(counter.load(), kChildren);
+    EXPECT_GT(workers.size(), 1);
+}
+
+TEST_F(WorkStealingTest, ParkedWorkersWakeUp) {
+    WorkStealingScheduler scheduler(2);
+    for (int round = 0; round < 5; ++round) {
+        // Give the workers time to park between rounds
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::promise<size_t> done;
+        auto future = done.get_future();
+        scheduler.Submit([&done](size_t worker_index) { done.set_value(worker_index); });
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_LT(future.get(), scheduler.GetWorkerCount());
+    }
+    EXPECT_EQ(scheduler.GetQueuedCount(), 0);
+}
+
+TEST_F(WorkStealingTest, RunBulkSignalsOneLatch) {
+    WorkStealingScheduler scheduler(4);
+    for (size_t count : {1, 10, 1000}) {
+        std::vector<int> hits(count, 0);
+        TaskBatch batch(count);
+        WorkStealingScheduler::BulkBody body = [&](size_t index, size_t) { batch.Run([&] { ++hits[index]; }); };
+        scheduler.RunBulk(count, body, batch);
+        EXPECT_EQ(std::count(hits.begin(), hits.end(), 1), count);
+    }
+    scheduler.WaitIdle();
+    EXPECT_EQ(scheduler.GetQueuedCount(), 0);
+}
+
+TEST_F(WorkStealingTest, NumaGroupsRunTasksOnTheirNode) {
+    std::atomic<int> started{0};
+    WorkStealingScheduler scheduler(4, {0, 0, 1, 1}, [&started](size_t) { ++started; });
+    EXPECT_EQ(scheduler.GetGroupCount(), 2);
+
+    std::mutex mutex;
+    std::set<size_t> node1_workers;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 200; ++i) {
+        auto done = std::make_shared<std::promise<void>>();
+        futures.push_back(done->get_future());
+        scheduler.Submit(
+            [&, done](size_t worker_index) {
+                std::lock_guard<std::mutex> lock(mutex);
+                node1_workers.insert(worker_index);
+                done->set_value();
+            },
+            1);
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_EQ(started.load(), 4);
+    EXPECT_TRUE(node1_workers.count(0) == 0 && node1_workers.count(1) == 0);
+
+    // Bulk tasks follow the node of their index, unknown nodes may run anywhere
+    size_t count = 1000;
+    std::vector<int> index_nodes(count);
+    std::vector<size_t> ran_on(count);
+    for (size_t i = 0; i < count; ++i) {
+        index_nodes[i] = i % 3 == 2 ? 7 : static_cast<int>(i % 3);
+    }
+    TaskBatch batch(count);
+    WorkStealingScheduler::BulkBody body = [&](size_t index, size_t worker_index) {
+        batch.Run([&] { ran_on[index] = worker_index; });
+    };
+    scheduler.RunBulk(count, body, batch, index_nodes);
+    for (size_t i = 0; i < count; ++i) {
+        if (index_nodes[i] == 0) {
+            ASSERT_LT(ran_on[i], 2);
+        } else if (index_nodes[i] == 1) {
+            ASSERT_GE(ran_on[i], 2);
+        }
+    }
+}
+
+TEST_F(WorkStealingTest, SubmitAfterShutdownThrows) {
+    WorkStealingScheduler scheduler(1);
+    scheduler.Shutdown();
+    EXPECT_THROW(scheduler.Submit([](size_t) {}), std::runtime_error);
+}
+
+} // namespace astate
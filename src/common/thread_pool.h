@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
@@ -8,6 +9,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <ranges>
 #include <stdexcept>
 #include <thread>
 #include <type_traits>
@@ -23,6 +25,9 @@
 #include <torch/torch.h>
 
 #include "common/cuda_utils.h"
+#include "common/numa_placement.h"
+#include "common/task_batch.h"
+#include "common/work_stealing.h"
 
 namespace astate {
 
@@ -68,11 +73,87 @@ static std::shared_ptr<c10::cuda::CUDAStream> GetSafeCudaStream() {
     return std::make_shared<c10::cuda::CUDAStream>(stream);
 }
 
+// NUMA node of every worker when the pool places its workers, empty otherwise
+inline std::vector<int> PlanPoolWorkerNodes(size_t threads, bool numa_aware) {
+    if (!numa_aware) {
+        return {};
+    }
+    std::vector<int> worker_nodes = PlanWorkerNumaNodes(threads);
+    if (!worker_nodes.empty()) {
+        SPDLOG_INFO(
+            "Thread pool with {} workers spread over NUMA nodes {} to {}",
+            threads,
+            worker_nodes.front(),
+            worker_nodes.back());
+    }
+    return worker_nodes;
+}
+
+// Pool the calling thread is a worker of, nullptr on other threads
+inline thread_local const void* tls_current_pool = nullptr;
+
+// A SubmitBatch from a task of the same pool waits for tasks that may only run on its own worker, fail instead
+inline void CheckNotNestedBatch(const void* pool) {
+    if (tls_current_pool == pool) {
+        throw std::logic_error("SubmitBatch called from a task of the same thread pool");
+    }
+}
+
+inline std::unique_ptr<WorkStealingScheduler>
+MakeWorkStealingScheduler(size_t threads, const std::vector<int>& worker_nodes, const void* pool) {
+    return std::make_unique<WorkStealingScheduler>(threads, worker_nodes, [worker_nodes, pool](size_t worker_index) {
+        tls_current_pool = pool;
+        if (!worker_nodes.empty()) {
+            BindCurrentThreadToNumaNode(worker_nodes[worker_index]);
+        }
+    });
+}
+
+// SubmitBatch without node_of, its tasks may run in any worker group
+struct NoNumaHint {};
+
+// node_of(element) for every element, only when the scheduler has per-node groups to route to
+template <class Iterator, class NodeOf>
+std::vector<int> BatchNumaNodes(
+    const std::unique_ptr<WorkStealingScheduler>& scheduler, Iterator begin, size_t count, NodeOf& node_of) {
+    std::vector<int> nodes;
+    if constexpr (!std::is_same_v<std::decay_t<NodeOf>, NoNumaHint>) {
+        if (scheduler && scheduler->GetGroupCount() > 1) {
+            nodes.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                nodes.push_back(node_of(begin[i]));
+            }
+        }
+    }
+    return nodes;
+}
+
+/*
+ * SubmitBatch(range, fn) runs fn once per element of a random access range and returns when all of them finished,
+ * rethrowing the first exception. The whole batch shares one TaskBatch latch instead of a packaged_task and a
+ * future per element. A queued task only holds a reference to the batch and an index, small enough for the inline
+ * storage of std::function, and the work-stealing path takes its task slots from a pooled block, so nothing is
+ * allocated per task.
+ * SubmitBatch blocks its caller, from a task of the same pool it throws std::logic_error instead of deadlocking.
+ *
+ * WaitForTasks returns once every submitted task finished.
+ *
+ * numa_aware (work-stealing pools only) splits the workers into one CPU-bound group per NUMA node, per-worker
+ * resources are first touched on their worker's node. SubmitToNode and SubmitBatch(range, fn, node_of) route a task
+ * to the group of the node it names, typically the node of the buffer it reads; other tasks go to any group.
+ */
 class ThreadPool {
  public:
-    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency()) {
+    // work_stealing runs the tasks on a WorkStealingScheduler instead of the shared queue
+    explicit ThreadPool(
+        size_t threads = std::thread::hardware_concurrency(), bool work_stealing = false, bool numa_aware = false) {
+        if (work_stealing) {
+            scheduler_ = MakeWorkStealingScheduler(threads, PlanPoolWorkerNodes(threads, numa_aware), this);
+            return;
+        }
         for (size_t i = 0; i < threads; ++i) {
             workers_.emplace_back([this] {
+                tls_current_pool = this;
                 while (true) {
                     std::function<void()> task;
                     {
@@ -85,6 +166,7 @@ class ThreadPool {
                         this->tasks_.pop();
                     }
                     task();
+                    FinishTask();
                 }
             });
         }
@@ -92,12 +174,21 @@ class ThreadPool {
 
     template <class F, class... Args>
     auto Submit(F&& func, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        return SubmitToNode(-1, std::forward<F>(func), std::forward<Args>(args)...);
+    }
+
+    template <class F, class... Args>
+    auto SubmitToNode(int numa_node, F&& func, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
         using return_type = std::invoke_result_t<F, Args...>;
 
         auto task = std::make_shared<std::packaged_task<return_type()>>(
             std::bind(std::forward<F>(func), std::forward<Args>(args)...));
 
         std::future<return_type> res = task->get_future();
+        if (scheduler_) {
+            scheduler_->Submit([task](size_t) { (*task)(); }, numa_node);
+            return res;
+        }
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
             if (stop_) {
@@ -105,24 +196,60 @@ class ThreadPool {
             }
 
             tasks_.emplace([task]() { (*task)(); });
+            ++pending_;
         }
         condition_.notify_one();
         return res;
     }
 
-    void WaitForTasks() {
-        while (true) {
+    // fn(element)
+    template <class Range, class F, class NodeOf = NoNumaHint>
+    void SubmitBatch(Range&& range, F&& fn, NodeOf&& node_of = {}) {
+        CheckNotNestedBatch(this);
+        auto begin = std::ranges::begin(range);
+        auto count = static_cast<size_t>(std::ranges::size(range));
+        if (count == 0) {
+            return;
+        }
+        TaskBatch batch(count);
+        auto run = [&](size_t index) { batch.Run([&] { fn(begin[index]); }); };
+        if (scheduler_) {
+            scheduler_->RunBulk(
+                count,
+                [&run](size_t index, size_t) { run(index); },
+                batch,
+                BatchNumaNodes(scheduler_, begin, count, node_of));
+        } else {
             {
-                std::lock_guard<std::mutex> lock(queue_mutex_);
-                if (tasks_.empty() || stop_) {
-                    break;
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                if (stop_) {
+                    throw std::runtime_error("submit on stopped thread_pool");
                 }
+                for (size_t i = 0; i < count; ++i) {
+                    tasks_.emplace([&run, i]() { run(i); });
+                }
+                pending_ += count;
             }
-            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            condition_.notify_all();
+            batch.Wait();
         }
+        batch.RethrowIfFailed();
+    }
+
+    void WaitForTasks() {
+        if (scheduler_) {
+            scheduler_->WaitIdle();
+            return;
+        }
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        idle_condition_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0 || stop_; });
     }
 
     ~ThreadPool() {
+        if (scheduler_) {
+            scheduler_->Shutdown();
+            return;
+        }
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
             stop_ = true;
@@ -134,26 +261,52 @@ class ThreadPool {
     }
 
     size_t GetTaskCount() {
+        if (scheduler_) {
+            return scheduler_->GetQueuedCount();
+        }
         std::lock_guard<std::mutex> lock(queue_mutex_);
         return tasks_.size();
     }
 
  private:
+    void FinishTask() {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            idle_condition_.notify_all();
+        }
+    }
+
     std::vector<std::thread> workers_;
     std::queue<std::function<void()>> tasks_;
 
     std::mutex queue_mutex_;
     std::condition_variable condition_;
     bool stop_{};
+
+    // Submitted and not finished, WaitForTasks waits on idle_condition_ for zero
+    std::atomic<size_t> pending_{0};
+    std::condition_variable idle_condition_;
+
+    std::unique_ptr<WorkStealingScheduler> scheduler_;
 };
 
 class CUDAStreamThreadPool {
  public:
-    explicit CUDAStreamThreadPool(size_t threads = std::thread::hardware_concurrency()) {
+    explicit CUDAStreamThreadPool(
+        size_t threads = std::thread::hardware_concurrency(), bool work_stealing = false, bool numa_aware = false) {
+        if (work_stealing) {
+            // One stream per worker as below, a task runs on the stream of the worker that picked it up
+            for (size_t i = 0; i < threads; ++i) {
+                streams_.emplace_back(GetSafeCudaStream());
+            }
+            scheduler_ = MakeWorkStealingScheduler(threads, PlanPoolWorkerNodes(threads, numa_aware), this);
+            return;
+        }
         for (size_t i = 0; i < threads; ++i) {
             auto stream = GetSafeCudaStream();
             streams_.emplace_back(stream);
             workers_.emplace_back([this, i] {
+                tls_current_pool = this;
                 while (true) {
                     std::function<void(std::shared_ptr<c10::cuda::CUDAStream>)> task;
                     {
@@ -166,6 +319,7 @@ class CUDAStreamThreadPool {
                         this->tasks_.pop();
                     }
                     task(streams_[i]);
+                    FinishTask();
                 }
             });
         }
@@ -173,6 +327,12 @@ class CUDAStreamThreadPool {
 
     template <class F, class... Args>
     auto Submit(F&& func, Args&&... args)
+        -> std::future<std::invoke_result_t<F, std::shared_ptr<c10::cuda::CUDAStream>, Args...>> {
+        return SubmitToNode(-1, std::forward<F>(func), std::forward<Args>(args)...);
+    }
+
+    template <class F, class... Args>
+    auto SubmitToNode(int numa_node, F&& func, Args&&... args)
         -> std::future<std::invoke_result_t<F, std::shared_ptr<c10::cuda::CUDAStream>, Args...>> {
         using return_type = std::invoke_result_t<F, std::shared_ptr<c10::cuda::CUDAStream>, Args...>;
 
@@ -180,6 +340,10 @@ class CUDAStreamThreadPool {
             std::bind(std::forward<F>(func), std::placeholders::_1, std::forward<Args>(args)...));
 
         std::future<return_type> res = task->get_future();
+        if (scheduler_) {
+            scheduler_->Submit([this, task](size_t worker_index) { (*task)(streams_[worker_index]); }, numa_node);
+            return res;
+        }
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
             if (stop_) {
@@ -187,24 +351,62 @@ class CUDAStreamThreadPool {
             }
 
             tasks_.emplace([task](std::shared_ptr<c10::cuda::CUDAStream> stream) { (*task)(stream); });
+            ++pending_;
         }
         condition_.notify_one();
         return res;
     }
 
-    void WaitForTasks() {
-        while (true) {
+    // fn(element, stream)
+    template <class Range, class F, class NodeOf = NoNumaHint>
+    void SubmitBatch(Range&& range, F&& fn, NodeOf&& node_of = {}) {
+        CheckNotNestedBatch(this);
+        auto begin = std::ranges::begin(range);
+        auto count = static_cast<size_t>(std::ranges::size(range));
+        if (count == 0) {
+            return;
+        }
+        TaskBatch batch(count);
+        auto run = [&](size_t index, const std::shared_ptr<c10::cuda::CUDAStream>& stream) {
+            batch.Run([&] { fn(begin[index], stream); });
+        };
+        if (scheduler_) {
+            scheduler_->RunBulk(
+                count,
+                [this, &run](size_t index, size_t worker_index) { run(index, streams_[worker_index]); },
+                batch,
+                BatchNumaNodes(scheduler_, begin, count, node_of));
+        } else {
             {
-                std::lock_guard<std::mutex> lock(queue_mutex_);
-                if (tasks_.empty() || stop_) {
-                    break;
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                if (stop_) {
+                    throw std::runtime_error("submit on stopped thread_pool");
                 }
+                for (size_t i = 0; i < count; ++i) {
+                    tasks_.emplace([&run, i](std::shared_ptr<c10::cuda::CUDAStream> stream) { run(i, stream); });
+                }
+                pending_ += count;
             }
-            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            condition_.notify_all();
+            batch.Wait();
         }
+        batch.RethrowIfFailed();
+    }
+
+    void WaitForTasks() {
+        if (scheduler_) {
+            scheduler_->WaitIdle();
+            return;
+        }
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        idle_condition_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0 || stop_; });
     }
 
     ~CUDAStreamThreadPool() {
+        if (scheduler_) {
+            scheduler_->Shutdown();
+            return;
+        }
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
             stop_ = true;
@@ -216,6 +418,13 @@ class CUDAStreamThreadPool {
     }
 
  private:
+    void FinishTask() {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            idle_condition_.notify_all();
+        }
+    }
+
     std::vector<std::thread> workers_;
     std::queue<std::function<void(std::shared_ptr<c10::cuda::CUDAStream>)>> tasks_;
 
@@ -223,7 +432,11 @@ class CUDAStreamThreadPool {
     std::condition_variable condition_;
     bool stop_{};
 
+    std::atomic<size_t> pending_{0};
+    std::condition_variable idle_condition_;
+
     std::vector<std::shared_ptr<c10::cuda::CUDAStream>> streams_;
+    std::unique_ptr<WorkStealingScheduler> scheduler_;
 };
 
 template <typename ResourceType>
@@ -232,12 +445,25 @@ class ResourceThreadPool {
     explicit ResourceThreadPool(
         std::function<ResourceType()> resource_creator,
         std::function<void(ResourceType&)> resource_destructor,
-        size_t threads = std::thread::hardware_concurrency())
+        size_t threads = std::thread::hardware_concurrency(),
+        bool work_stealing = false,
+        bool numa_aware = false)
         : resource_destructor_(resource_destructor) {
+        if (work_stealing) {
+            // A task gets the resource of the worker that picked it up
+            std::vector<int> worker_nodes = PlanPoolWorkerNodes(threads, numa_aware);
+            for (size_t i = 0; i < threads; ++i) {
+                ScopedNumaBinding binding(worker_nodes.empty() ? -1 : worker_nodes[i]);
+                resources_.push_back(resource_creator());
+            }
+            scheduler_ = MakeWorkStealingScheduler(threads, worker_nodes, this);
+            return;
+        }
         for (size_t i = 0; i < threads; ++i) {
             auto resource = resource_creator();
             resources_.push_back(resource);
             workers_.emplace_back([&, resource]() mutable {
+                tls_current_pool = this;
                 while (true) {
                     std::function<void(ResourceType&)> task;
                     {
@@ -250,6 +476,7 @@ class ResourceThreadPool {
                         this->tasks_.pop();
                     }
                     task(resource);
+                    FinishTask();
                 }
             });
         }
@@ -257,12 +484,22 @@ class ResourceThreadPool {
 
     template <class F, class... Args>
     auto Submit(F&& func, Args&&... args) -> std::future<std::invoke_result_t<F, ResourceType&, Args...>> {
+        return SubmitToNode(-1, std::forward<F>(func), std::forward<Args>(args)...);
+    }
+
+    template <class F, class... Args>
+    auto SubmitToNode(int numa_node, F&& func, Args&&... args)
+        -> std::future<std::invoke_result_t<F, ResourceType&, Args...>> {
         using return_type = std::invoke_result_t<F, ResourceType&, Args...>;
 
         auto task = std::make_shared<std::packaged_task<return_type(ResourceType&, Args...)>>(
             std::bind(std::forward<F>(func), std::placeholders::_1, std::forward<Args>(args)...));
 
         std::future<return_type> ret = task->get_future();
+        if (scheduler_) {
+            scheduler_->Submit([this, task](size_t worker_index) { (*task)(resources_[worker_index]); }, numa_node);
+            return ret;
+        }
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
             if (stop_) {
@@ -270,31 +507,81 @@ class ResourceThreadPool {
             }
 
             tasks_.emplace([task](ResourceType& resource) { (*task)(resource); });
+            ++pending_;
         }
         condition_.notify_one();
         return ret;
     }
 
+    // fn(element, resource)
+    template <class Range, class F, class NodeOf = NoNumaHint>
+    void SubmitBatch(Range&& range, F&& fn, NodeOf&& node_of = {}) {
+        CheckNotNestedBatch(this);
+        auto begin = std::ranges::begin(range);
+        auto count = static_cast<size_t>(std::ranges::size(range));
+        if (count == 0) {
+            return;
+        }
+        TaskBatch batch(count);
+        auto run = [&](size_t index, ResourceType& resource) { batch.Run([&] { fn(begin[index], resource); }); };
+        if (scheduler_) {
+            scheduler_->RunBulk(
+                count,
+                [this, &run](size_t index, size_t worker_index) { run(index, resources_[worker_index]); },
+                batch,
+                BatchNumaNodes(scheduler_, begin, count, node_of));
+        } else {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                if (stop_) {
+                    throw std::runtime_error("submit on stopped thread_pool");
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    tasks_.emplace([&run, i](ResourceType& resource) { run(i, resource); });
+                }
+                pending_ += count;
+            }
+            condition_.notify_all();
+            batch.Wait();
+        }
+        batch.RethrowIfFailed();
+    }
+
     void WaitForTasks() {
+        if (scheduler_) {
+            scheduler_->WaitIdle();
+            return;
+        }
         std::unique_lock<std::mutex> lock(queue_mutex_);
-        condition_.wait(lock, [this] { return tasks_.empty(); });
+        idle_condition_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0 || stop_; });
     }
 
     ~ResourceThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            stop_ = true;
-        }
-        condition_.notify_all();
-        for (std::thread& worker : workers_) {
-            worker.join();
+        if (scheduler_) {
+            scheduler_->Shutdown();
+        } else {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                stop_ = true;
+            }
+            condition_.notify_all();
+            for (std::thread& worker : workers_) {
+                worker.join();
+            }
         }
         for (ResourceType& res : resources_) {
-            resource_destructor(res);
+            resource_destructor_(res);
         }
     }
 
  private:
+    void FinishTask() {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            idle_condition_.notify_all();
+        }
+    }
+
     bool stop_{};
     std::vector<ResourceType> resources_;
     std::function<void(ResourceType&)> resource_destructor_;
@@ -303,6 +590,11 @@ class ResourceThreadPool {
     std::queue<std::function<void(ResourceType&)>> tasks_;
     std::mutex queue_mutex_;
     std::condition_variable condition_;
+
+    std::atomic<size_t> pending_{0};
+    std::condition_variable idle_condition_;
+
+    std::unique_ptr<WorkStealingScheduler> scheduler_;
 };
 
 template <typename ResourceType>
@@ -311,14 +603,28 @@ class CUDAStreamResourceThreadPool {
     explicit CUDAStreamResourceThreadPool(
         std::function<ResourceType()> resource_creator,
         std::function<void(ResourceType&)> resource_destructor,
-        size_t threads = std::thread::hardware_concurrency())
+        size_t threads = std::thread::hardware_concurrency(),
+        bool work_stealing = false,
+        bool numa_aware = false)
         : resource_destructor_(resource_destructor) {
+        if (work_stealing) {
+            // A task gets the resource and the stream of the worker that picked it up
+            std::vector<int> worker_nodes = PlanPoolWorkerNodes(threads, numa_aware);
+            for (size_t i = 0; i < threads; ++i) {
+                ScopedNumaBinding binding(worker_nodes.empty() ? -1 : worker_nodes[i]);
+                resources_.emplace_back(resource_creator());
+                streams_.emplace_back(GetSafeCudaStream());
+            }
+            scheduler_ = MakeWorkStealingScheduler(threads, worker_nodes, this);
+            return;
+        }
         for (size_t i = 0; i < threads; ++i) {
             auto resource = resource_creator();
             resources_.emplace_back(resource);
             auto stream = GetSafeCudaStream();
             streams_.emplace_back(stream);
             workers_.emplace_back([this, i]() mutable {
+                tls_current_pool = this;
                 while (true) {
                     std::function<void(ResourceType&, std::shared_ptr<c10::cuda::CUDAStream>)> task;
                     {
@@ -331,6 +637,7 @@ class CUDAStreamResourceThreadPool {
                         this->tasks_.pop();
                     }
                     task(resources_[i], streams_[i]);
+                    FinishTask();
                 }
             });
         }
@@ -338,6 +645,12 @@ class CUDAStreamResourceThreadPool {
 
     template <class F, class... Args>
     auto Submit(F&& func, Args&&... args)
+        -> std::future<std::invoke_result_t<F, ResourceType&, std::shared_ptr<c10::cuda::CUDAStream>, Args...>> {
+        return SubmitToNode(-1, std::forward<F>(func), std::forward<Args>(args)...);
+    }
+
+    template <class F, class... Args>
+    auto SubmitToNode(int numa_node, F&& func, Args&&... args)
         -> std::future<std::invoke_result_t<F, ResourceType&, std::shared_ptr<c10::cuda::CUDAStream>, Args...>> {
         using return_type = std::invoke_result_t<F, ResourceType&, std::shared_ptr<c10::cuda::CUDAStream>, Args...>;
 
@@ -346,6 +659,12 @@ class CUDAStreamResourceThreadPool {
             std::forward<F>(func), std::placeholders::_1, std::placeholders::_2, std::forward<Args>(args)...));
 
         std::future<return_type> ret = task->get_future();
+        if (scheduler_) {
+            scheduler_->Submit(
+                [this, task](size_t worker_index) { (*task)(resources_[worker_index], streams_[worker_index]); },
+                numa_node);
+            return ret;
+        }
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
             if (stop_) {
@@ -355,24 +674,73 @@ class CUDAStreamResourceThreadPool {
             tasks_.emplace([task](ResourceType& resource, std::shared_ptr<c10::cuda::CUDAStream> stream) {
                 (*task)(resource, stream);
             });
+            ++pending_;
         }
         condition_.notify_one();
         return ret;
     }
 
+    // fn(element, resource, stream)
+    template <class Range, class F, class NodeOf = NoNumaHint>
+    void SubmitBatch(Range&& range, F&& fn, NodeOf&& node_of = {}) {
+        CheckNotNestedBatch(this);
+        auto begin = std::ranges::begin(range);
+        auto count = static_cast<size_t>(std::ranges::size(range));
+        if (count == 0) {
+            return;
+        }
+        TaskBatch batch(count);
+        auto run = [&](size_t index, ResourceType& resource, const std::shared_ptr<c10::cuda::CUDAStream>& stream) {
+            batch.Run([&] { fn(begin[index], resource, stream); });
+        };
+        if (scheduler_) {
+            scheduler_->RunBulk(
+                count,
+                [this, &run](size_t index, size_t worker_index) {
+                    run(index, resources_[worker_index], streams_[worker_index]);
+                },
+                batch,
+                BatchNumaNodes(scheduler_, begin, count, node_of));
+        } else {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                if (stop_) {
+                    throw std::runtime_error("submit on stopped thread_pool");
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    tasks_.emplace([&run, i](ResourceType& resource, std::shared_ptr<c10::cuda::CUDAStream> stream) {
+                        run(i, resource, stream);
+                    });
+                }
+                pending_ += count;
+            }
+            condition_.notify_all();
+            batch.Wait();
+        }
+        batch.RethrowIfFailed();
+    }
+
     void WaitForTasks() {
+        if (scheduler_) {
+            scheduler_->WaitIdle();
+            return;
+        }
         std::unique_lock<std::mutex> lock(queue_mutex_);
-        condition_.wait(lock, [this] { return tasks_.empty(); });
+        idle_condition_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0 || stop_; });
     }
 
     ~CUDAStreamResourceThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            stop_ = true;
-        }
-        condition_.notify_all();
-        for (std::thread& worker : workers_) {
-            worker.join();
+        if (scheduler_) {
+            scheduler_->Shutdown();
+        } else {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                stop_ = true;
+            }
+            condition_.notify_all();
+            for (std::thread& worker : workers_) {
+                worker.join();
+            }
         }
         for (ResourceType& res : resources_) {
             resource_destructor_(res);
@@ -380,6 +748,13 @@ class CUDAStreamResourceThreadPool {
     }
 
  private:
+    void FinishTask() {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            idle_condition_.notify_all();
+        }
+    }
+
     bool stop_{};
     std::vector<ResourceType> resources_;
     std::function<void(ResourceType&)> resource_destructor_;
@@ -389,7 +764,11 @@ class CUDAStreamResourceThreadPool {
     std::mutex queue_mutex_;
     std::condition_variable condition_;
 
+    std::atomic<size_t> pending_{0};
+    std::condition_variable idle_condition_;
+
     std::vector<std::shared_ptr<c10::cuda::CUDAStream>> streams_;
+    std::unique_ptr<WorkStealingScheduler> scheduler_;
 };
 
 // class MutexWaitQueueThreadPool {
@@ -0,0 +1,535 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common/task_batch.h"
+
+namespace astate {
+
+/*
+ * Chase-Lev work-stealing deque (Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models").
+ * The owner pushes and pops at the bottom, any thread steals from the top. Items are pointers, a thief reads
+ * the slot before winning the race for it, which is only safe for trivially copyable items.
+ * Grown arrays are retired rather than freed, a thief may still read the old one.
+ */
+template <typename T>
+class ChaseLevDeque {
+    static_assert(std::is_pointer_v<T>, "ChaseLevDeque holds pointers");
+
+ public:
+    explicit ChaseLevDeque(size_t capacity = kDefaultCapacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        arrays_.push_back(std::make_unique<Array>(rounded));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    // Owner only
+    void Push(T item) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Array* array = array_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(array->Capacity()) - 1) {
+            array = Grow(array, top, bottom);
+        }
+        array->Put(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only, nullptr if empty
+    T Pop() {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* array = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T item = array->Get(bottom);
+        if (top == bottom) {
+            // Last item, race the thieves for it
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread, nullptr if empty or lost the race to another thread
+    T Steal() {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+        Array* array = array_.load(std::memory_order_acquire);
+        T item = array->Get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    // Approximate, exact only when no other thread touches the deque
+    [[nodiscard]] size_t Size() const {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+
+ private:
+    static constexpr size_t kDefaultCapacity = 256;
+
+    struct Array {
+        explicit Array(size_t capacity)
+            : mask(capacity - 1),
+              slots(new std::atomic<T>[capacity]) {}
+
+        [[nodiscard]] size_t Capacity() const { return mask + 1; }
+        T Get(int64_t index) const { return slots[static_cast<size_t>(index) & mask].load(std::memory_order_acquire); }
+        void Put(int64_t index, T item) {
+            slots[static_cast<size_t>(index) & mask].store(item, std::memory_order_release);
+        }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Array* Grow(Array* array, int64_t top, int64_t bottom) {
+        arrays_.push_back(std::make_unique<Array>(array->Capacity() * 2));
+        Array* grown = arrays_.back().get();
+        for (int64_t i = top; i < bottom; ++i) {
+            grown->Put(i, array->Get(i));
+        }
+        array_.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    alignas(64) std::atomic<Array*> array_{nullptr};
+    std::vector<std::unique_ptr<Array>> arrays_; // owner only, the current one is last
+};
+
+/*
+ * Work-stealing scheduler behind the thread pools (TRANSFER_ENGINE_THREAD_POOL_WORK_STEALING).
+ * - Every worker owns a ChaseLevDeque, tasks submitted from a worker go to its own deque.
+ * - Tasks submitted from other threads go to an injection queue, an idle worker moves a batch of them to its deque
+ *   at once, so the queue lock is taken once per batch rather than once per task.
+ * - An idle worker steals from the other deques, starting at a random victim.
+ * - Workers with nothing to do park on an atomic wait (a futex on Linux), a submit only wakes one if any sleeps.
+ * A task gets the index of the worker running it, pools keep their per-worker resources under that index.
+ *
+ * With worker_nodes the workers form one group per NUMA node (TRANSFER_ENGINE_THREAD_POOL_NUMA_AWARE). Each group
+ * has its own injection queue and parking slot. A task submitted with a node goes to that node's group, one without
+ * a node goes round robin over the groups. A worker steals within its group first and only takes work of the other
+ * groups once its own is empty, so a batch all on one node still runs on every worker. on_worker_start runs first
+ * on every worker thread, the pools bind the thread to its node there.
+ */
+class WorkStealingScheduler {
+ public:
+    using Task = std::function<void(size_t worker_index)>;
+    using BulkBody = std::function<void(size_t index, size_t worker_index)>;
+    using WorkerHook = std::function<void(size_t worker_index)>;
+
+    explicit WorkStealingScheduler(
+        size_t threads, const std::vector<int>& worker_nodes = {}, WorkerHook on_worker_start = {}) {
+        threads = std::max<size_t>(threads, 1);
+        worker_group_.resize(threads, 0);
+        if (worker_nodes.size() == threads) {
+            for (size_t i = 0; i < threads; ++i) {
+                worker_group_[i] = GroupIndexOrAdd(worker_nodes[i]);
+            }
+        } else {
+            GroupIndexOrAdd(-1);
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            groups_[worker_group_[i]]->workers.push_back(i);
+            deques_.push_back(std::make_unique<ChaseLevDeque<SchedulerTask*>>());
+        }
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this, i, on_worker_start] {
+                if (on_worker_start) {
+                    on_worker_start(i);
+                }
+                WorkerLoop(i);
+            });
+        }
+    }
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    ~WorkStealingScheduler() { Shutdown(); }
+
+    // numa_node < 0 or without a group of its own: no preference
+    void Submit(Task task, int numa_node = -1) {
+        Admit(1);
+        SchedulerTask* item = new OwnedTask(std::move(task));
+        Push(&item, 1, TargetGroup(numa_node));
+    }
+
+    /*
+     * Runs body(index, worker_index) for every index below count and returns once the batch latch opened.
+     * The task slots come from a pooled block, so a batch allocates nothing per task.
+     * The body reports to batch itself, it must call batch.Run exactly once per index.
+     * index_nodes, if not empty, holds the preferred NUMA node of every index.
+     */
+    void RunBulk(size_t count, const BulkBody& body, TaskBatch& batch, const std::vector<int>& index_nodes = {}) {
+        if (count == 0) {
+            return;
+        }
+        Admit(count);
+        std::vector<BulkTask> block = bulk_blocks_.Acquire(count);
+        std::vector<SchedulerTask*> items = bulk_items_.Acquire(count);
+        for (size_t i = 0; i < count; ++i) {
+            block[i].body = &body;
+            block[i].index = i;
+        }
+        if (groups_.size() == 1 || index_nodes.size() != count) {
+            for (size_t i = 0; i < count; ++i) {
+                items[i] = &block[i];
+            }
+            Push(items.data(), count, TargetGroup(-1));
+        } else {
+            // One push per group, the target of an index without a group of its own is picked once for the batch
+            size_t fallback = TargetGroup(-1);
+            for (size_t group = 0; group < groups_.size(); ++group) {
+                size_t group_count = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    int target = GroupIndex(index_nodes[i]);
+                    if ((target < 0 ? fallback : static_cast<size_t>(target)) == group) {
+                        items[group_count++] = &block[i];
+                    }
+                }
+                if (group_count > 0) {
+                    Push(items.data(), group_count, group);
+                }
+            }
+        }
+        bulk_items_.Release(std::move(items));
+        batch.Wait();
+        bulk_blocks_.Release(std::move(block));
+    }
+
+    // Block until every submitted task finished
+    void WaitIdle() {
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        idle_condition_.wait(lock, [this] { return unfinished_.load(std::memory_order_acquire) == 0; });
+    }
+
+    // Run the queued tasks, then join the workers
+    void Shutdown() {
+        if (stop_.exchange(true)) {
+            return;
+        }
+        for (auto& group : groups_) {
+            group->wake_epoch.fetch_add(1, std::memory_order_release);
+            group->wake_epoch.notify_all();
+        }
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    // Tasks submitted and not picked up by a worker yet
+    [[nodiscard]] size_t GetQueuedCount() const { return queued_.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] size_t GetWorkerCount() const { return workers_.size(); }
+
+    [[nodiscard]] size_t GetGroupCount() const { return groups_.size(); }
+
+ private:
+    // Deque item, run dispatches to the concrete task without a virtual call
+    struct SchedulerTask {
+        void (*run)(SchedulerTask* task, size_t worker_index) = nullptr;
+    };
+
+    // Submitted alone, deleted after it ran
+    struct OwnedTask : SchedulerTask {
+        explicit OwnedTask(Task task)
+            : fn(std::move(task)) {
+            run = [](SchedulerTask* self, size_t worker_index) {
+                std::unique_ptr<OwnedTask> owned(static_cast<OwnedTask*>(self));
+                owned->fn(worker_index);
+            };
+        }
+        Task fn;
+    };
+
+    // Slot of a RunBulk block, the block outlives the batch latch
+    struct BulkTask : SchedulerTask {
+        BulkTask() {
+            run = [](SchedulerTask* self, size_t worker_index) {
+                auto* task = static_cast<BulkTask*>(self);
+                (*task->body)(task->index, worker_index);
+            };
+        }
+        const BulkBody* body = nullptr;
+        size_t index = 0;
+    };
+
+    // Workers of one NUMA node, or all workers without NUMA placement
+    struct WorkerGroup {
+        int numa_node = -1;
+        std::vector<size_t> workers;
+        std::mutex injection_mutex;
+        std::deque<SchedulerTask*> injection;
+        alignas(64) std::atomic<uint32_t> wake_epoch{0};
+        alignas(64) std::atomic<int> sleepers{0};
+    };
+
+    // Injected tasks moved to a local deque at once, the rest stays for the other workers
+    static constexpr size_t kInjectionBatchSize = 32;
+    // Rounds of yield before parking, a short burst of submits is picked up without a futex wake
+    static constexpr int kSpinRounds = 64;
+
+    size_t GroupIndexOrAdd(int numa_node) {
+        if (int index = GroupIndex(numa_node); index >= 0) {
+            return static_cast<size_t>(index);
+        }
+        groups_.push_back(std::make_unique<WorkerGroup>());
+        groups_.back()->numa_node = numa_node;
+        return groups_.size() - 1;
+    }
+
+    [[nodiscard]] int GroupIndex(int numa_node) const {
+        if (numa_node < 0) {
+            return -1;
+        }
+        for (size_t i = 0; i < groups_.size(); ++i) {
+            if (groups_[i]->numa_node == numa_node) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    size_t TargetGroup(int numa_node) {
+        if (groups_.size() == 1) {
+            return 0;
+        }
+        if (int index = GroupIndex(numa_node); index >= 0) {
+            return static_cast<size_t>(index);
+        }
+        if (tls_scheduler == this) {
+            return worker_group_[tls_worker_index];
+        }
+        return next_group_.fetch_add(1, std::memory_order_relaxed) % groups_.size();
+    }
+
+    void Admit(size_t count) {
+        // Count the tasks before checking stop_, a worker draining on shutdown waits for them to show up
+        queued_.fetch_add(count, std::memory_order_seq_cst);
+        unfinished_.fetch_add(count, std::memory_order_relaxed);
+        if (stop_.load(std::memory_order_seq_cst)) {
+            queued_.fetch_sub(count, std::memory_order_relaxed);
+            unfinished_.fetch_sub(count, std::memory_order_relaxed);
+            throw std::runtime_error("submit on stopped thread_pool");
+        }
+    }
+
+    void Push(SchedulerTask* const* items, size_t count, size_t group_index) {
+        WorkerGroup& group = *groups_[group_index];
+        size_t backlog = count;
+        if (tls_scheduler == this && worker_group_[tls_worker_index] == group_index) {
+            for (size_t i = 0; i < count; ++i) {
+                deques_[tls_worker_index]->Push(items[i]);
+            }
+        } else {
+            std::lock_guard<std::mutex> lock(group.injection_mutex);
+            group.injection.insert(group.injection.end(), items, items + count);
+            backlog = group.injection.size();
+        }
+        Wake(group, count > 1);
+        // More than the group can start at once, the parked workers of the other groups come and steal the rest
+        if (groups_.size() > 1 && backlog > group.workers.size()) {
+            for (auto& other : groups_) {
+                if (other.get() != &group) {
+                    Wake(*other, true);
+                }
+            }
+        }
+    }
+
+    static void Wake(WorkerGroup& group, bool all) {
+        // Pairs with the fence before parking: either the submitter sees the sleeper or the sleeper sees the task
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (group.sleepers.load(std::memory_order_relaxed) > 0) {
+            group.wake_epoch.fetch_add(1, std::memory_order_release);
+            if (all) {
+                group.wake_epoch.notify_all();
+            } else {
+                group.wake_epoch.notify_one();
+            }
+        }
+    }
+
+    SchedulerTask* TakeInjected(size_t worker_index) {
+        WorkerGroup& group = *groups_[worker_group_[worker_index]];
+        std::lock_guard<std::mutex> lock(group.injection_mutex);
+        if (group.injection.empty()) {
+            return nullptr;
+        }
+        SchedulerTask* task = group.injection.front();
+        group.injection.pop_front();
+        // Keep a share for the other workers, move up to a batch to the own deque
+        size_t batch = std::min(kInjectionBatchSize, group.injection.size() / group.workers.size());
+        for (size_t i = 0; i < batch; ++i) {
+            deques_[worker_index]->Push(group.injection.front());
+            group.injection.pop_front();
+        }
+        return task;
+    }
+
+    // One task off the injection queue of another group, left there for its own workers otherwise
+    static SchedulerTask* TakeInjectedFrom(WorkerGroup& group) {
+        std::lock_guard<std::mutex> lock(group.injection_mutex);
+        if (group.injection.empty()) {
+            return nullptr;
+        }
+        SchedulerTask* task = group.injection.front();
+        group.injection.pop_front();
+        return task;
+    }
+
+    SchedulerTask* StealFrom(const WorkerGroup& group, size_t worker_index, std::minstd_rand& random) {
+        const std::vector<size_t>& victims = group.workers;
+        size_t count = victims.size();
+        size_t start = random() % count;
+        for (size_t i = 0; i < count; ++i) {
+            size_t victim = victims[(start + i) % count];
+            if (victim == worker_index) {
+                continue;
+            }
+            if (SchedulerTask* task = deques_[victim]->Steal(); task != nullptr) {
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    SchedulerTask* FindTask(size_t worker_index, std::minstd_rand& random) {
+        if (SchedulerTask* task = deques_[worker_index]->Pop(); task != nullptr) {
+            return task;
+        }
+        if (SchedulerTask* task = TakeInjected(worker_index); task != nullptr) {
+            return task;
+        }
+        size_t own_group = worker_group_[worker_index];
+        if (SchedulerTask* task = StealFrom(*groups_[own_group], worker_index, random); task != nullptr) {
+            return task;
+        }
+        // Nothing left on the own node, help the other groups rather than idle
+        for (size_t i = 1; i < groups_.size(); ++i) {
+            WorkerGroup& group = *groups_[(own_group + i) % groups_.size()];
+            if (SchedulerTask* task = TakeInjectedFrom(group); task != nullptr) {
+                return task;
+            }
+            if (SchedulerTask* task = StealFrom(group, worker_index, random); task != nullptr) {
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    void Run(SchedulerTask* task, size_t worker_index) {
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        task->run(task, worker_index);
+        if (unfinished_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            idle_condition_.notify_all();
+        }
+    }
+
+    void WorkerLoop(size_t worker_index) {
+        tls_scheduler = this;
+        tls_worker_index = worker_index;
+        WorkerGroup& group = *groups_[worker_group_[worker_index]];
+        std::minstd_rand random(static_cast<uint32_t>(worker_index) + 1);
+        int idle_rounds = 0;
+        while (true) {
+            if (SchedulerTask* task = FindTask(worker_index, random); task != nullptr) {
+                Run(task, worker_index);
+                idle_rounds = 0;
+                continue;
+            }
+            if (++idle_rounds < kSpinRounds) {
+                std::this_thread::yield();
+                continue;
+            }
+            idle_rounds = 0;
+
+            // Park: announce the sleeper, look once more, then wait for an epoch change
+            uint32_t epoch = group.wake_epoch.load(std::memory_order_acquire);
+            group.sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (SchedulerTask* task = FindTask(worker_index, random); task != nullptr) {
+                group.sleepers.fetch_sub(1, std::memory_order_relaxed);
+                Run(task, worker_index);
+                continue;
+            }
+            if (stop_.load(std::memory_order_acquire)) {
+                group.sleepers.fetch_sub(1, std::memory_order_relaxed);
+                if (queued_.load(std::memory_order_acquire) == 0) {
+                    break;
+                }
+                // Tasks in flight, e.g. still being pushed by a worker, keep draining
+                std::this_thread::yield();
+                continue;
+            }
+            group.wake_epoch.wait(epoch, std::memory_order_acquire);
+            group.sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+        tls_scheduler = nullptr;
+    }
+
+    std::vector<std::unique_ptr<WorkerGroup>> groups_;
+    std::vector<size_t> worker_group_;
+    std::atomic<size_t> next_group_{0};
+
+    std::vector<std::unique_ptr<ChaseLevDeque<SchedulerTask*>>> deques_;
+    std::vector<std::thread> workers_;
+
+    TaskBlockPool<BulkTask> bulk_blocks_;
+    TaskBlockPool<SchedulerTask*> bulk_items_;
+
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> unfinished_{0};
+    std::mutex idle_mutex_;
+    std::condition_variable idle_condition_;
+
+    std::atomic<bool> stop_{false};
+
+    static inline thread_local const WorkStealingScheduler* tls_scheduler = nullptr;
+    static inline thread_local size_t tls_worker_index = 0;
+};
+
+} // namespace astate
@@ -1,5 +1,7 @@
 #include "core/atensor_storage.h"
 
+#include <stdexcept>
+
 #include "core/remote_tensor_table.h"
 #include "transfer/tensor_transfer_pull.h"
 
@@ -8,8 +10,18 @@ namespace astate {
 bool ATensorStorageCtx::Init(const Options& options, const AParallelConfig& parallel_config) {
     this->options = options;
     this->parallel_config = parallel_config;
+    resolved_options = TryResolveOptions(options);
+    if (resolved_options == nullptr) {
+        return false;
+    }
     // TransferServiceBuilder::Build(TransferEngineBackendType, options_);
     if (GetOptionValue<std::string>(options, TENSOR_TRANSFER_SERVICE_TYPE) == "PULL") {
+        // Opt-in: the warmup maps and prefaults the arena chunks of every staging buffer up front
+        if (GetOptionValue<bool>(options, TRANSFER_ENGINE_ENABLE_NUMA_ALLOCATION)
+            && GetOptionValue<int64_t>(options, TRANSFER_ENGINE_NUMA_ARENA_CHUNK_SIZE) > 0
+            && GetOptionValue<int>(options, TRANSFER_ENGINE_PREFAULT_THREAD_NUM) > 0) {
+            staging_allocator = RemoteTensorTable::StartStagingWarmup(options, parallel_config);
+        }
         transfer_service = new TensorTransferPull(this);
         return transfer_service->Start(options, parallel_config);
     }
@@ -21,7 +33,12 @@ bool ATensorStorageCtx::Init(const Options& options, const AParallelConfig& para
 bool ATensorStorageImpl::Init(const AParallelConfig& parallel_config) {
     // Load configs from ENV
     Options options;
-    LoadOptions(options);
+    try {
+        LoadOptions(options);
+    } catch (const std::invalid_argument& e) {
+        SPDLOG_ERROR("Failed to load options: {}", e.what());
+        return false;
+    }
 
     // Initialize tensor storage context
     if (!ctx_->Init(options, parallel_config)) {
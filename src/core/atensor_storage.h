@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -23,12 +24,18 @@
 
 namespace astate {
 
+class NumaAwareAllocator;
+
 // Context for ATensorStorage
 struct ATensorStorageCtx {
     Options options;
+    // options parsed once in Init and handed down to the transports
+    std::shared_ptr<const ResolvedOptions> resolved_options;
     AParallelConfig parallel_config{};
     TensorTable* tensor_table = nullptr;
     TensorTransferService* transfer_service = nullptr;
+    // Pinned staging memory, prepared in the background while the transfer service starts
+    std::shared_future<std::shared_ptr<NumaAwareAllocator>> staging_allocator;
 
     ATensorStorageCtx() = default;
 
@@ -1,5 +1,6 @@
 #include <cstdint>
 #include <exception>
+#include <map>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -15,6 +16,7 @@
 #include <torch/torch.h>
 
 #include "common/lock_utils.h"
+#include "common/metric_utils.h"
 #include "common/option.h"
 #include "core/atensor.h"
 #include "core/shardedkey.h"
@@ -178,6 +180,10 @@ std::vector<std::pair<std::string, TorchTensorMeta>> InMemoryTensorTable::ScanTe
     return result;
 }
 
+std::map<std::string, std::map<std::string, double>> InMemoryTensorTable::Stats() {
+    return GetMetricsRegistry().Stats();
+}
+
 std::vector<std::pair<ShardedKey, torch::Tensor>> InMemoryTensorTable::GetTensorShards(
     const ShardedKey& sharded_key, int64_t seq_id, const torch::Tensor& target_tensor) {
     std::vector<std::pair<ShardedKey, torch::Tensor>> ret;
@@ -1,13 +1,20 @@
 #include "core/remote_tensor_table.h"
 
+#include <algorithm>
+#include <bit>
 #include <chrono>
 #include <cstdint>
 #include <exception>
+#include <future>
+#include <map>
 #include <memory>
 #include <random>
+#include <ranges>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -23,6 +30,7 @@
 
 #include "common/lock_utils.h"
 #include "common/numa_aware_allocator.h"
+#include "common/numa_placement.h"
 #include "common/option.h"
 #include "core/atensor.h"
 #include "core/atensor_storage.h"
@@ -47,7 +55,16 @@ RemoteTensorTable::RemoteTensorTable(const std::string& name, std::shared_ptr<AT
       pinned_memory_enabled_(torch::cuda::is_available()),
       enable_numa_allocation_(GetOptionValue<bool>(ctx_->options, TRANSFER_ENGINE_ENABLE_NUMA_ALLOCATION)) {
     is_debug_mode_ = GetOptionValue<bool>(ctx_->options, ASTATE_DEBUG_MODE);
-    numa_allocator_.Initialize();
+    auto warmup_wait_start = std::chrono::steady_clock::now();
+    if (ctx_->staging_allocator.valid()) {
+        numa_allocator_ = ctx_->staging_allocator.get();
+    } else {
+        numa_allocator_ = std::make_shared<NumaAwareAllocator>();
+        ConfigureStagingAllocator(*numa_allocator_, ctx_->options);
+        numa_allocator_->Initialize();
+    }
+    auto warmup_wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - warmup_wait_start);
 
     UpdateGlobalParallelConfig(ctx_->options);
 
@@ -94,6 +111,8 @@ RemoteTensorTable::RemoteTensorTable(const std::string& name, std::shared_ptr<AT
         enable_log_tensor_meta_,
         perf_metrics_controller_->IsPerfMetricsEnabled());
 
+    bool work_stealing = GetOptionValue<bool>(ctx_->options, TRANSFER_ENGINE_THREAD_POOL_WORK_STEALING);
+    bool numa_aware = GetOptionValue<bool>(ctx_->options, TRANSFER_ENGINE_THREAD_POOL_NUMA_AWARE);
     if (ctx_->parallel_config.IsInference()) {
         copy_thread_pool_ = std::make_unique<astate::CUDAStreamResourceThreadPool<torch::Tensor>>(
             [&, copy_bucket_mem_size]() {
@@ -108,7 +127,9 @@ RemoteTensorTable::RemoteTensorTable(const std::string& name, std::shared_ptr<AT
                 return tensor;
             },
             [](torch::Tensor& tensor) { tensor.reset(); },
-            copy_thread_num);
+            copy_thread_num,
+            work_stealing,
+            numa_aware);
         copy_bucket_mem_size_ = copy_bucket_mem_size;
 
         copy_large_thread_pool_ = std::make_unique<astate::CUDAStreamResourceThreadPool<torch::Tensor>>(
@@ -124,10 +145,12 @@ RemoteTensorTable::RemoteTensorTable(const std::string& name, std::shared_ptr<AT
                 return tensor;
             },
             [](torch::Tensor& tensor) { tensor.reset(); },
-            copy_large_thread_num);
+            copy_large_thread_num,
+            work_stealing,
+            numa_aware);
         copy_large_bucket_mem_size_ = copy_large_bucket_mem_size;
     } else {
-        thread_pool_ = std::make_unique<astate::CUDAStreamThreadPool>(copy_thread_num);
+        thread_pool_ = std::make_unique<astate::CUDAStreamThreadPool>(copy_thread_num, work_stealing, numa_aware);
         small_tensor_compact_cache_offset_ = 0;
         small_tensor_compact_cache_ = CreateZeroTensor(
             {small_tensor_compact_cache_size_},
@@ -136,6 +159,90 @@ RemoteTensorTable::RemoteTensorTable(const std::string& name, std::shared_ptr<AT
             false,
             pinned_memory_enabled_);
     }
+    SPDLOG_INFO(
+        "Staging buffers ready: waited {} ms for the background warmup, {} bytes prefaulted by {} threads in {} ms",
+        warmup_wait.count(),
+        numa_allocator_->GetPrefaultedBytes(),
+        numa_allocator_->GetPrefaultThreads(),
+        numa_allocator_->GetPrefaultMicros() / 1000);
+}
+
+void RemoteTensorTable::ConfigureStagingAllocator(NumaAwareAllocator& allocator, const Options& options) {
+    allocator.EnableHugePageArena(
+        GetOptionValue<int64_t>(options, TRANSFER_ENGINE_NUMA_ARENA_CHUNK_SIZE),
+        GetOptionValue<int64_t>(options, TRANSFER_ENGINE_NUMA_ARENA_HUGEPAGE_SIZE));
+    allocator.SetPrefaultThreads(std::max(GetOptionValue<int>(options, TRANSFER_ENGINE_PREFAULT_THREAD_NUM), 0));
+}
+
+std::shared_future<std::shared_ptr<NumaAwareAllocator>>
+RemoteTensorTable::StartStagingWarmup(const Options& options, const AParallelConfig& parallel_config) {
+    // The table allocates near the GPU of, or on the node preferred by, the thread creating it, i.e. this one
+    int cuda_device = -1;
+    if (HasNvGpu() && cudaGetDevice(&cuda_device) != cudaSuccess) {
+        cuda_device = -1;
+    }
+    int caller_node = numa_available() < 0 ? -1 : std::max(numa_preferred(), 0);
+
+    auto warmup = [options, parallel_config, cuda_device, caller_node]() {
+        auto start_time = std::chrono::steady_clock::now();
+        // cudaHostRegister in the arena would otherwise create a primary context on GPU 0 for this thread
+        if (cuda_device >= 0 && cudaSetDevice(cuda_device) != cudaSuccess) {
+            SPDLOG_WARN("Staging warmup failed to set CUDA device {}", cuda_device);
+        }
+        auto allocator = std::make_shared<NumaAwareAllocator>();
+        ConfigureStagingAllocator(*allocator, options);
+        if (!allocator->Initialize()) {
+            return allocator;
+        }
+        size_t chunk_size = allocator->GetArenaChunkSize();
+        if (chunk_size == 0) {
+            return allocator;
+        }
+
+        // Arena bytes each node will be asked for by the staging buckets, buffers larger than a chunk get
+        // their own mapping when they are created and can not be reserved
+        std::map<int, size_t> node_bytes;
+        auto add_buffers = [&](int threads, long buffer_size) {
+            if (buffer_size <= 0 || static_cast<size_t>(buffer_size) > chunk_size) {
+                return;
+            }
+            std::vector<int> worker_nodes;
+            if (cuda_device < 0 && GetOptionValue<bool>(options, TRANSFER_ENGINE_THREAD_POOL_WORK_STEALING)
+                && GetOptionValue<bool>(options, TRANSFER_ENGINE_THREAD_POOL_NUMA_AWARE)) {
+                worker_nodes = PlanWorkerNumaNodes(threads);
+            }
+            for (int i = 0; i < threads; ++i) {
+                int node = cuda_device >= 0 ? allocator->GetNumaNodeForCuda(cuda_device)
+                                            : (worker_nodes.empty() ? caller_node : worker_nodes[i]);
+                node_bytes[node] += std::bit_ceil(static_cast<size_t>(buffer_size));
+            }
+        };
+        if (parallel_config.IsInference()) {
+            add_buffers(
+                GetOptionValue<int>(options, TRANSFER_ENGINE_COPY_THREAD_NUM),
+                GetOptionValue<long>(options, TRANSFER_ENGINE_COPY_BUCKET_MEM_SIZE));
+            add_buffers(
+                GetOptionValue<int>(options, TRANSFER_ENGINE_COPY_LARGE_THREAD_NUM),
+                GetOptionValue<long>(options, TRANSFER_ENGINE_COPY_LARGE_BUCKET_MEM_SIZE));
+        } else {
+            add_buffers(1, GetOptionValue<long>(options, TRANSFER_ENGINE_SMALL_TENSOR_COMPACT_CACHE_SIZE));
+        }
+
+        size_t reserved = 0;
+        for (const auto& [node, bytes] : node_bytes) {
+            if (node >= 0) {
+                reserved += allocator->ReserveArena(node, bytes);
+            }
+        }
+        SPDLOG_INFO(
+            "Staging warmup reserved {} bytes on {} NUMA nodes in {} ms",
+            reserved,
+            node_bytes.size(),
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time)
+                .count());
+        return allocator;
+    };
+    return std::async(std::launch::async, std::move(warmup)).share();
 }
 
 bool RemoteTensorTable::Put(int64_t seq_id, const ShardedKey& tensor_key, pybind11::object& py_tensor) {
@@ -159,10 +266,7 @@ bool RemoteTensorTable::Put(int64_t seq_id, const ShardedKey& tensor_key, pybind
         std::shared_ptr<ATensor> atensor = TensorToATensor(*local_copy);
         bool result = ctx_->transfer_service->Put(seq_id, tensor_key, *atensor);
 
-        auto end_time = std::chrono::high_resolution_clock::now();
-        SPDLOG_INFO(
-            "put::total cost {} us",
-            std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count());
+        stage_latency_.put.Record(std::chrono::high_resolution_clock::now() - start_time);
         return result;
     } catch (const std::exception& e) {
         SPDLOG_ERROR("Error in put with seq_id {} and tensor_key {}: {}", seq_id, tensor_key.key, e.what());
@@ -172,6 +276,7 @@ bool RemoteTensorTable::Put(int64_t seq_id, const ShardedKey& tensor_key, pybind
 
 bool RemoteTensorTable::Get(int64_t seq_id, const ShardedKey& tensor_key, pybind11::object& py_tensor) {
     pybind11::gil_scoped_release release;
+    InvalidateChangedRemoteShards();
     try {
         // Convert py_tensor to torch::Tensor
         const torch::Tensor& target_tensor = PyObjectToTensor(py_tensor);
@@ -203,11 +308,12 @@ bool RemoteTensorTable::MultiPut(
         // Convert py_tensor to ATensor using local tensor copies
         std::vector<std::pair<ShardedKey, ATensor>> atensor_list;
         bool need_sync = false;
-        std::vector<std::future<std::vector<ShardedATensor>>> copy_futures;
-        copy_futures.reserve(tensor_list.size());
-        for (const auto& pair : tensor_list) {
-            copy_futures.push_back(thread_pool_->Submit([this, seq_id, &pair](
-                                                            const std::shared_ptr<c10::cuda::CUDAStream>& stream) {
+        std::vector<std::vector<ShardedATensor>> copy_results(tensor_list.size());
+        thread_pool_->SubmitBatch(
+            std::views::iota(size_t{0}, tensor_list.size()),
+            [this, seq_id, &tensor_list, &copy_results](
+                size_t index, const std::shared_ptr<c10::cuda::CUDAStream>& stream) {
+                const auto& pair = tensor_list[index];
                 auto start_time = std::chrono::high_resolution_clock::now();
                 const torch::Tensor& source_tensor = PyObjectToTensor(pair.second);
                 if (stream != nullptr && source_tensor.device().index() != stream->device_index()) {
@@ -236,6 +342,7 @@ bool RemoteTensorTable::MultiPut(
                     }
 
                     auto end_time = std::chrono::high_resolution_clock::now();
+                    stage_latency_.put_copy.Record(end_time - start_copy_time);
                     if (perf_metrics_controller_->ShouldLogPerfMetric(seq_id)) {
                         SPDLOG_INFO(
                             "multi_put::tensor_key: {}, total cost {} us, "
@@ -249,15 +356,14 @@ bool RemoteTensorTable::MultiPut(
                     local_sharded_tensors.emplace_back(sharded_key, TensorToATensor(*local_copy));
                 }
 
-                // return std::make_pair(pair.first, TensorToATensor(*local_copy));
-                return local_sharded_tensors;
-            }));
-        }
+                copy_results[index] = std::move(local_sharded_tensors);
+            },
+            // Copy out of the source on a worker next to it
+            [this, &tensor_list](size_t index) {
+                return GetTensorNumaNode(PyObjectToTensor(tensor_list[index].second));
+            });
 
-        for (auto& future : copy_futures) {
-            // auto pair = future.get();
-            // atensor_list.emplace_back(pair.first, *pair.second);
-            auto sharded_tensors = future.get();
+        for (const auto& sharded_tensors : copy_results) {
             for (const auto& it : sharded_tensors) {
                 atensor_list.emplace_back(it.first, *it.second);
             }
@@ -268,6 +374,7 @@ bool RemoteTensorTable::MultiPut(
         bool ret = ctx_->transfer_service->MultiPut(seq_id, atensor_list);
 
         auto end_time = std::chrono::high_resolution_clock::now();
+        stage_latency_.multi_put.Record(end_time - start_time);
         if (is_debug_mode_) {
             SPDLOG_INFO(
                 "multi_put::total cost {} us",
@@ -286,20 +393,11 @@ bool RemoteTensorTable::MultiPut(
 
 bool RemoteTensorTable::MultiGet(int64_t seq_id, std::vector<std::pair<ShardedKey, pybind11::object>>& tensor_dict) {
     pybind11::gil_scoped_release release;
+    InvalidateChangedRemoteShards();
     auto total_start_time = std::chrono::high_resolution_clock::now();
 
     try {
-        // Step 1: Initialize data structures
-        auto step1_start = std::chrono::high_resolution_clock::now();
-        std::unordered_map<ShardedKey, std::vector<std::pair<ShardedKey, torch::Tensor>>&, ShardedKeyHash>
-            candidates_map;
-        std::vector<std::pair<ShardedKey, ATensor>> query_list;
-        auto step1_end = std::chrono::high_resolution_clock::now();
-        auto step1_duration = std::chrono::duration_cast<std::chrono::microseconds>(step1_end - step1_start);
-        SPDLOG_INFO("Step 1 - Initialize data structures: {} us", step1_duration.count());
-
-        // Step 2: Convert py_objects to tensors and get candidates
-        auto step2_start = std::chrono::high_resolution_clock::now();
+        // Convert py_objects to tensors and submit the copy tasks
         size_t total_tensor_size = 0;
         size_t total_small_tensor_size = 0;
         std::vector<std::future<void>> copy_futures;
@@ -322,41 +420,34 @@ bool RemoteTensorTable::MultiGet(int64_t seq_id, std::vector<std::pair<ShardedKe
 
             copy_futures.push_back(SubmitTransferTask(seq_id, pair.first, target_tensor));
         }
-        auto step2_end = std::chrono::high_resolution_clock::now();
-        auto step2_duration = std::chrono::duration_cast<std::chrono::microseconds>(step2_end - step2_start);
-        SPDLOG_INFO(
-            "Step 2 - Convert py_objects and Submit copy tasks: {} us, "
-            "copy_futures size: {}",
-            step2_duration.count(),
-            copy_futures.size());
+        auto submit_end = std::chrono::high_resolution_clock::now();
+        stage_latency_.submit.Record(submit_end - total_start_time);
 
-        auto step3_start = std::chrono::high_resolution_clock::now();
+        // Small tensors are read in compacted buckets (compact_plan and compact_read)
         MultiGetCompactTensors(seq_id, small_tensors);
-        auto step3_end = std::chrono::high_resolution_clock::now();
-        auto step3_duration = std::chrono::duration_cast<std::chrono::microseconds>(step3_end - step3_start);
-        SPDLOG_INFO("Step 3 - multi_get_compact_tensors: {} us", step3_duration.count());
 
-        // Step 3: Wait for all copy operations to complete
-        auto step4_start = std::chrono::high_resolution_clock::now();
+        // Wait for all copy operations to complete
+        auto copy_wait_start = std::chrono::high_resolution_clock::now();
         for (auto& future : copy_futures) {
             future.get();
         }
-        auto step4_end = std::chrono::high_resolution_clock::now();
-        auto step4_duration = std::chrono::duration_cast<std::chrono::microseconds>(step4_end - step4_start);
-        SPDLOG_INFO("Step 4 - Wait for copy operations completion: {} us", step4_duration.count());
-
-        // Total time calculation
         auto total_end_time = std::chrono::high_resolution_clock::now();
-        auto total_duration = std::chrono::duration_cast<std::chrono::microseconds>(total_end_time - total_start_time);
-        SPDLOG_INFO(
-            "RemoteTensorTable::multi_get completed for seq_id {} - Total "
-            "tensor size: {} MB - Total small tensor "
-            "size: {} MB - Total time: {} us ({:.2f} ms)",
-            seq_id,
-            total_tensor_size / 1024 / 1024,
-            total_small_tensor_size / 1024 / 1024,
-            total_duration.count(),
-            total_duration.count() / 1000.0);
+        stage_latency_.copy_wait.Record(total_end_time - copy_wait_start);
+        stage_latency_.multi_get.Record(total_end_time - total_start_time);
+
+        if (perf_metrics_controller_->ShouldLogPerfMetric(seq_id)) {
+            auto total_duration
+                = std::chrono::duration_cast<std::chrono::microseconds>(total_end_time - total_start_time);
+            SPDLOG_INFO(
+                "RemoteTensorTable::multi_get completed for seq_id {} - Total "
+                "tensor size: {} MB - Total small tensor "
+                "size: {} MB - Total time: {} us ({:.2f} ms)",
+                seq_id,
+                total_tensor_size / 1024 / 1024,
+                total_small_tensor_size / 1024 / 1024,
+                total_duration.count(),
+                total_duration.count() / 1000.0);
+        }
 
         return true;
     } catch (const std::exception& e) {
@@ -369,6 +460,7 @@ bool RemoteTensorTable::MultiGet(int64_t seq_id, std::vector<std::pair<ShardedKe
 
 bool RemoteTensorTable::MultiGetCompactTensors(
     int64_t seq_id, const std::unordered_map<ShardedKey, const torch::Tensor&, ShardedKeyHash>& small_tensors) {
+    InvalidateChangedRemoteShards();
     auto start_time = std::chrono::high_resolution_clock::now();
     std::unordered_map<ShardedKey, ATensor, ShardedKeyHash> tensor_shards;
     std::unordered_map<ShardedKey, std::vector<std::pair<ShardedKey, const torch::Tensor&>>, ShardedKeyHash>
@@ -397,119 +489,92 @@ bool RemoteTensorTable::MultiGetCompactTensors(
             cached_small_tensor_shards_ = tensor_shards;
         }
     }
-    auto compact_tensor_infos_end = std::chrono::high_resolution_clock::now();
-    auto compact_tensor_infos_duration
-        = std::chrono::duration_cast<std::chrono::microseconds>(compact_tensor_infos_end - start_time);
-    SPDLOG_INFO(
-        "multi_get_compact_tensors::compact_tensor_infos cost {} us for {} "
-        "compact tensor infos from "
-        "small_tensors: {}",
-        compact_tensor_infos_duration.count(),
-        compact_tensor_infos.size(),
-        small_tensors.size());
-
     auto submit_start = std::chrono::high_resolution_clock::now();
-    std::vector<std::future<bool>> read_futures{};
-    read_futures.reserve(compact_tensor_infos.size());
-    for (const auto& compact_tensor_info : compact_tensor_infos) {
-        read_futures.push_back(copy_thread_pool_->Submit(
-            [&](torch::Tensor& local_cache, const std::shared_ptr<c10::cuda::CUDAStream>& stream) {
-                ATStorage astorage = TensorStorageToATStorage(local_cache);
-                if (!ctx_->transfer_service->RawGet(
-                        seq_id,
-                        astorage,
-                        compact_tensor_info.node_info,
-                        compact_tensor_info.addr,
-                        compact_tensor_info.size)) {
-                    SPDLOG_ERROR(
-                        "Failed to read tensor from remote for seq_id {} and "
-                        "compact_tensor_info.node_info: {}:{} and "
-                        "compact_tensor_info.addr: {} and "
-                        "compact_tensor_info.size: {} local_addr:{} "
-                        "local_size:{}",
-                        seq_id,
-                        compact_tensor_info.node_info.hostname_or_ip,
-                        compact_tensor_info.node_info.rdma_port,
-                        compact_tensor_info.addr,
-                        compact_tensor_info.size,
-                        astorage.data,
-                        astorage.storage_size);
-                    throw std::runtime_error("Failed to read tensor from remote for seq_id " + std::to_string(seq_id));
-                }
+    stage_latency_.compact_plan.Record(submit_start - start_time);
+
+    copy_thread_pool_->SubmitBatch(
+        compact_tensor_infos,
+        [&](const auto& compact_tensor_info,
+            torch::Tensor& local_cache,
+            const std::shared_ptr<c10::cuda::CUDAStream>& stream) {
+            ATStorage astorage = TensorStorageToATStorage(local_cache);
+            if (!ctx_->transfer_service->RawGet(
+                    seq_id,
+                    astorage,
+                    compact_tensor_info.node_info,
+                    compact_tensor_info.addr,
+                    compact_tensor_info.size)) {
+                SPDLOG_ERROR(
+                    "Failed to read tensor from remote for seq_id {} and "
+                    "compact_tensor_info.node_info: {}:{} and "
+                    "compact_tensor_info.addr: {} and "
+                    "compact_tensor_info.size: {} local_addr:{} "
+                    "local_size:{}",
+                    seq_id,
+                    compact_tensor_info.node_info.hostname_or_ip,
+                    compact_tensor_info.node_info.rdma_port,
+                    compact_tensor_info.addr,
+                    compact_tensor_info.size,
+                    astorage.data,
+                    astorage.storage_size);
+                throw std::runtime_error("Failed to read tensor from remote for seq_id " + std::to_string(seq_id));
+            }
 
-                for (const auto& pair : compact_tensor_info.atensors) {
-                    const ShardedKey& shard_key = pair.first;
-                    const ATensor& atensor = pair.second;
-
-                    char* local_cache_ptr = static_cast<char*>(local_cache.data_ptr())
-                        + GetStorageByteOffset(pair.second.dtype, atensor.storage_offset);
-
-                    std::vector<int64_t> sizes(pair.second.size, pair.second.size + pair.second.dim_num);
-                    std::vector<int64_t> strides(pair.second.stride, pair.second.stride + pair.second.dim_num);
-                    torch::Tensor local_tensor = torch::from_blob(
-                        local_cache_ptr,
-                        sizes,
-                        strides,
-                        torch::TensorOptions()
-                            .dtype(ATDtypeToTorchDtype(pair.second.dtype))
-                            .device(torch::Device(torch::DeviceType::CPU))
-                            .layout(torch::Layout::Strided)
-                            .memory_format(torch::MemoryFormat::Contiguous)
-                            .pinned_memory(pinned_memory_enabled_)
-                            .requires_grad(false));
-
-                    const auto& target_pair_list = target_tensor_map.at(shard_key);
-                    for (const auto& target_pair : target_pair_list) {
-                        const torch::Tensor& target_tensor = target_pair.second;
-                        if (stream != nullptr && target_tensor.device().is_cuda()
-                            && target_tensor.device().index() != stream->device_index()) {
-                            SPDLOG_ERROR(
-                                "multi_get_compact_tensors: target_tensor "
-                                "device index {} not match thread pool device "
-                                "index {}",
-                                target_tensor.device().index(),
-                                stream->device_index());
-                        }
-
-                        if (target_tensor.requires_grad()) {
-                            CopyTensorWithShardedKeysUnsafe(
-                                shard_key,
-                                local_tensor,
-                                target_pair.first,
-                                target_tensor.detach(),
-                                stream.get(),
-                                enable_read_gpu_async_copy_);
-                        } else {
-                            CopyTensorWithShardedKeysUnsafe(
-                                shard_key,
-                                local_tensor,
-                                target_pair.first,
-                                target_tensor,
-                                stream.get(),
-                                enable_read_gpu_async_copy_);
-                        }
+            for (const auto& pair : compact_tensor_info.atensors) {
+                const ShardedKey& shard_key = pair.first;
+                const ATensor& atensor = pair.second;
+
+                char* local_cache_ptr = static_cast<char*>(local_cache.data_ptr())
+                    + GetStorageByteOffset(pair.second.dtype, atensor.storage_offset);
+
+                std::vector<int64_t> sizes(pair.second.size, pair.second.size + pair.second.dim_num);
+                std::vector<int64_t> strides(pair.second.stride, pair.second.stride + pair.second.dim_num);
+                torch::Tensor local_tensor = torch::from_blob(
+                    local_cache_ptr,
+                    sizes,
+                    strides,
+                    torch::TensorOptions()
+                        .dtype(ATDtypeToTorchDtype(pair.second.dtype))
+                        .device(torch::Device(torch::DeviceType::CPU))
+                        .layout(torch::Layout::Strided)
+                        .memory_format(torch::MemoryFormat::Contiguous)
+                        .pinned_memory(pinned_memory_enabled_)
+                        .requires_grad(false));
+
+                const auto& target_pair_list = target_tensor_map.at(shard_key);
+                for (const auto& target_pair : target_pair_list) {
+                    const torch::Tensor& target_tensor = target_pair.second;
+                    if (stream != nullptr && target_tensor.device().is_cuda()
+                        && target_tensor.device().index() != stream->device_index()) {
+                        SPDLOG_ERROR(
+                            "multi_get_compact_tensors: target_tensor "
+                            "device index {} not match thread pool device "
+                            "index {}",
+                            target_tensor.device().index(),
+                            stream->device_index());
                     }
-                }
-                return true;
-            }));
-    }
-    auto submit_end = std::chrono::high_resolution_clock::now();
-    auto submit_duration = std::chrono::duration_cast<std::chrono::microseconds>(submit_end - submit_start);
-    SPDLOG_INFO(
-        "multi_get_compact_tensors::Submit cost {} us for {} tasks", submit_duration.count(), read_futures.size());
 
-    auto read_start = std::chrono::high_resolution_clock::now();
-    for (auto& future : read_futures) {
-        future.get();
-    }
-    auto read_end = std::chrono::high_resolution_clock::now();
-    auto read_duration = std::chrono::duration_cast<std::chrono::microseconds>(read_end - read_start);
-    SPDLOG_INFO(
-        "multi_get_compact_tensors::wait for read&copy completion cost {} us "
-        "for {} tasks and {} small tensors",
-        read_duration.count(),
-        read_futures.size(),
-        small_tensors.size());
+                    if (target_tensor.requires_grad()) {
+                        CopyTensorWithShardedKeysUnsafe(
+                            shard_key,
+                            local_tensor,
+                            target_pair.first,
+                            target_tensor.detach(),
+                            stream.get(),
+                            enable_read_gpu_async_copy_);
+                    } else {
+                        CopyTensorWithShardedKeysUnsafe(
+                            shard_key,
+                            local_tensor,
+                            target_pair.first,
+                            target_tensor,
+                            stream.get(),
+                            enable_read_gpu_async_copy_);
+                    }
+                }
+            }
+        });
+    stage_latency_.compact_read.Record(std::chrono::high_resolution_clock::now() - submit_start);
     return true;
 }
 
@@ -535,14 +600,7 @@ RemoteTensorTable::GetTensor(int64_t seq_id, const ShardedKey& tensor_key, const
         // Convert to pybind11 object
         auto result = TensorToPyObject(ret);
 
-        // Total time calculation - 只在seq_id变化时打印
-        // if (print_cuda) {
-        auto total_end_time = std::chrono::high_resolution_clock::now();
-        auto total_duration = std::chrono::duration_cast<std::chrono::microseconds>(total_end_time - total_start_time);
-        SPDLOG_INFO("get_tensor::total cost {} us", total_duration.count());
-        // astate::::print_cuda_memory_summary("RemoteTensorTable::get_tensor_after_convert");
-        // }
-
+        stage_latency_.get_tensor.Record(std::chrono::high_resolution_clock::now() - total_start_time);
         return result;
     } catch (const std::exception& e) {
         auto total_end_time = std::chrono::high_resolution_clock::now();
@@ -560,6 +618,7 @@ RemoteTensorTable::GetTensor(int64_t seq_id, const ShardedKey& tensor_key, const
 std::vector<std::pair<ShardedKey, pybind11::object>> RemoteTensorTable::MultiGetTensor(
     int64_t seq_id, const std::vector<std::pair<ShardedKey, TorchTensorMeta>>& tensor_meta_list) {
     pybind11::gil_scoped_release release;
+    InvalidateChangedRemoteShards();
     auto total_start_time = std::chrono::high_resolution_clock::now();
 
     SPDLOG_INFO(
@@ -595,7 +654,10 @@ std::vector<std::pair<ShardedKey, pybind11::object>> RemoteTensorTable::MultiGet
         // Total time calculation
         auto total_end_time = std::chrono::high_resolution_clock::now();
         auto total_duration = std::chrono::duration_cast<std::chrono::microseconds>(total_end_time - total_start_time);
-        SPDLOG_INFO("MultiGetTensor::total cost {} us", total_duration.count());
+        stage_latency_.multi_get_tensor.Record(total_duration);
+        if (perf_metrics_controller_->ShouldLogPerfMetric(seq_id)) {
+            SPDLOG_INFO("MultiGetTensor::total cost {} us", total_duration.count());
+        }
 
         return result;
     } catch (const std::exception& e) {
@@ -655,6 +717,10 @@ std::vector<std::pair<std::string, TorchTensorMeta>> RemoteTensorTable::ScanTens
     return result;
 }
 
+std::map<std::string, std::map<std::string, double>> RemoteTensorTable::Stats() {
+    return GetMetricsRegistry().Stats();
+}
+
 std::shared_ptr<torch::Tensor>
 RemoteTensorTable::GetLocalPrefetchCachedTensor(const ShardedKey& sharded_key, const torch::Tensor& target_tensor) {
     if (!enable_local_cache_prefetch_) {
@@ -780,6 +846,13 @@ std::shared_ptr<TensorDict> RemoteTensorTable::ReadTensors(
     return tensors;
 }
 
+int RemoteTensorTable::GetTensorNumaNode(const torch::Tensor& tensor) const {
+    if (tensor.is_cuda()) {
+        return numa_allocator_->GetNumaNodeForCuda(tensor.device().index());
+    }
+    return NumaNodeOfAddress(tensor.data_ptr());
+}
+
 std::future<void> RemoteTensorTable::SubmitTransferTask(
     int64_t seq_id, const ShardedKey& sharded_key, const torch::Tensor& target_tensor) {
     auto copy_task = [seq_id, sharded_key, &target_tensor, this](
@@ -811,6 +884,7 @@ std::future<void> RemoteTensorTable::SubmitTransferTask(
         //}
 
         auto end_time = std::chrono::high_resolution_clock::now();
+        stage_latency_.copy.Record(end_time - copy_time);
         if (perf_metrics_controller_->ShouldLogPerfMetric(seq_id)) {
             SPDLOG_INFO(
                 "SubmitTransferTask::tensor_key: {}, total cost {} us, "
@@ -825,11 +899,11 @@ std::future<void> RemoteTensorTable::SubmitTransferTask(
     size_t cache_size_needed = GetTensorTotalByteSize(target_tensor) * ctx_->parallel_config.tp_size;
     if (cache_size_needed <= this->copy_bucket_mem_size_) {
         copy_task_counter_++;
-        return copy_thread_pool_->Submit(copy_task);
+        return copy_thread_pool_->SubmitToNode(GetTensorNumaNode(target_tensor), copy_task);
     }
     if (cache_size_needed <= this->copy_large_bucket_mem_size_) {
         copy_large_task_counter_++;
-        return copy_large_thread_pool_->Submit(copy_task);
+        return copy_large_thread_pool_->SubmitToNode(GetTensorNumaNode(target_tensor), copy_task);
     }
     SPDLOG_WARN(
         "{} with size might be needed {} and copy large bucket mem size {}",
@@ -895,8 +969,17 @@ RemoteTensorTable::GetOrCreateLocalReshardTensors(const ShardedKey& tensor_key,
     } else {
         std::vector<ReshardingInfo> reshard_infos;
 
+        bool found = false;
         {
-            RWSpinGuard lock(rw_spin_lock_, true);
+            ReaderBiasedGuard lock(local_tensor_lock_, false);
+            auto it = tensor_resharding_map_.find(tensor_key);
+            if (it != tensor_resharding_map_.end()) {
+                reshard_infos = it->second;
+                found = true;
+            }
+        }
+        if (!found) {
+            ReaderBiasedGuard lock(local_tensor_lock_, true);
             auto it = tensor_resharding_map_.find(tensor_key);
             if (it != tensor_resharding_map_.end()) {
                 reshard_infos = it->second;
@@ -923,7 +1006,7 @@ std::shared_ptr<torch::Tensor>
 RemoteTensorTable::GetOrCreateLocalTensorCopy(const ShardedKey& tensor_key, const torch::Tensor& source_tensor) {
     // std::lock_guard<std::mutex> lock(mutex_);
     {
-        RWSpinGuard lock(rw_spin_lock_, false);
+        ReaderBiasedGuard lock(local_tensor_lock_, false);
         auto it = local_tensor_mapping_.find(tensor_key);
         if (it != local_tensor_mapping_.end()) {
             return it->second.second;
@@ -931,7 +1014,7 @@ RemoteTensorTable::GetOrCreateLocalTensorCopy(const ShardedKey& tensor_key, cons
     }
 
     {
-        RWSpinGuard lock(rw_spin_lock_, true);
+        ReaderBiasedGuard lock(local_tensor_lock_, true);
 
         // Check again in case another thread has created the tensor copy
         auto it = local_tensor_mapping_.find(tensor_key);
@@ -986,6 +1069,49 @@ RemoteTensorTable::GetOrCreateLocalTensorCopy(const ShardedKey& tensor_key, cons
     }
 }
 
+void RemoteTensorTable::InvalidateChangedRemoteShards() {
+    uint64_t epoch = ctx_->transfer_service->GetRemoteMetaEpoch();
+    if (epoch == seen_remote_meta_epoch_.load()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (epoch == seen_remote_meta_epoch_.load()) {
+        return;
+    }
+    auto changed_names = ctx_->transfer_service->TakeChangedTensorNames();
+    seen_remote_meta_epoch_.store(epoch);
+    if (changed_names.empty()) {
+        return;
+    }
+
+    // The meta list is a snapshot of all shards, it is fetched again on demand
+    {
+        std::lock_guard<std::mutex> meta_lock(tensor_meta_mutex_);
+        std::atomic_store(&tensor_meta_list_, std::shared_ptr<std::vector<std::pair<ShardedKey, ATensor>>>(nullptr));
+    }
+    auto is_changed = [&changed_names](const ShardedKey& key) { return changed_names.count(key.key) != 0; };
+    size_t dropped = std::erase_if(shard_mapping_, [&is_changed](const auto& entry) {
+        return is_changed(entry.first)
+            || std::any_of(entry.second.begin(), entry.second.end(), [&is_changed](const ShardedATensorTuple& shard) {
+                   return is_changed(std::get<0>(shard));
+               });
+    });
+    bool compact_changed = std::any_of(
+        cached_small_tensor_shards_.begin(), cached_small_tensor_shards_.end(), [&is_changed](const auto& entry) {
+            return is_changed(entry.first);
+        });
+    if (compact_changed) {
+        compact_tensor_infos_.clear();
+        cached_small_tensor_shards_.clear();
+    }
+    SPDLOG_INFO(
+        "Remote metas of {} tensors changed, dropped {} cached shard mappings{}",
+        changed_names.size(),
+        dropped,
+        compact_changed ? " and the compact tensor infos" : "");
+}
+
 const std::vector<ShardedATensorTuple>& RemoteTensorTable::GetRemoteTensorShards(
     const ShardedKey& sharded_key, int64_t seq_id, const ATensor& target_tensor, bool try_prune_redundant_shard) {
     {
@@ -1046,6 +1172,7 @@ RemoteTensorTable::GetRemoteTensorShards(const ShardedKey& sharded_key, int64_t
 }
 
 void RemoteTensorTable::PrefetchCachedTensors(int64_t seq_id) {
+    InvalidateChangedRemoteShards();
     auto start_time = std::chrono::high_resolution_clock::now();
     try {
         TensorDict prefetch_tensors;
@@ -1104,14 +1231,14 @@ torch::Tensor RemoteTensorTable::CreateZeroTensor(
     // Try NUMA-aware allocation if enabled
     if (enable_numa_allocation_ && device_type == torch::DeviceType::CPU) {
         try {
-            auto allocation_result = numa_allocator_.TryAllocateNearCurrentDevice(total_size);
+            auto allocation_result = numa_allocator_->TryAllocateNearCurrentDevice(total_size);
             if (allocation_result.success) {
                 // Successfully allocated with NUMA awareness
                 // Create tensor from the allocated memory
                 void* data_ptr = allocation_result.ptr;
-                auto deleter = [this, allocation_result](void*) {
+                auto deleter = [allocator = numa_allocator_, allocation_result](void*) {
                     // Custom deleter to properly deallocate NUMA memory
-                    numa_allocator_.Deallocate(allocation_result.ptr, allocation_result.size);
+                    allocator->Deallocate(allocation_result.ptr, allocation_result.size);
                 };
 
                 // Create tensor options
@@ -1137,6 +1264,22 @@ torch::Tensor RemoteTensorTable::CreateZeroTensor(
         }
     }
 
+    // Zero large buffers with several threads instead of one memset
+    constexpr size_t kParallelZeroSize = 256UL * 1024 * 1024;
+    if (device_type == torch::DeviceType::CPU && total_size >= kParallelZeroSize
+        && numa_allocator_->GetPrefaultThreads() > 1) {
+        torch::Tensor tensor = torch::empty(
+            sizes,
+            torch::TensorOptions()
+                .dtype(dtype)
+                .device(device_type)
+                .requires_grad(requires_grad)
+                .pinned_memory(pinned_memory)
+                .memory_format(torch::MemoryFormat::Contiguous));
+        PrefaultOnNumaNode(tensor.data_ptr(), total_size, -1, numa_allocator_->GetPrefaultThreads(), true);
+        return tensor;
+    }
+
     // Default allocation method
     return torch::zeros(
         sizes,
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <exception>
 #include <unordered_map>
 
@@ -50,6 +51,8 @@ class RemoteTensorTable : public TensorTable {
 
     std::vector<std::pair<std::string, TorchTensorMeta>> ScanTensorMeta(int64_t seq_id) override;
 
+    std::map<std::string, std::map<std::string, double>> Stats() override;
+
     /**
      * @brief [Receiver] Compact the small tensors, e.g. KB, into a tensor for better performance in further transfer.
      * @param seq_id step id for current inferencing.
@@ -68,13 +71,32 @@ class RemoteTensorTable : public TensorTable {
      */
     void PrefetchCachedTensors(int64_t seq_id) override;
 
+    /**
+     * @brief Map, prefault and pin the staging memory the table will need on a background thread, so the page
+     * faulting overlaps the transfer service start and discovery instead of delaying the first step. Called before
+     * the transfer service starts, only when both the arena and prefault threads are enabled; the table takes the
+     * allocator once it is created.
+     */
+    static std::shared_future<std::shared_ptr<NumaAwareAllocator>>
+    StartStagingWarmup(const Options& options, const AParallelConfig& parallel_config);
+
  private:
+    static void ConfigureStagingAllocator(NumaAwareAllocator& allocator, const Options& options);
+
+    /**
+     * @brief Drop the cached read plans (shard mapping, tensor meta list, compact infos) of the tensors whose remote
+     * metas were changed by incremental meta publishing. Called at the start of every read, before references into
+     * shard_mapping_ are taken.
+     */
+    void InvalidateChangedRemoteShards();
+
     bool is_debug_mode_{false};
     std::shared_ptr<ATensorStorageCtx> ctx_;
 
     // Mutex for thread-safe access
     std::mutex mutex_;
-    RWSpinLock rw_spin_lock_;
+    // Guards local_tensor_mapping_ and tensor_resharding_map_, looked up for every tensor of every MultiPut
+    ReaderBiasedLock local_tensor_lock_;
 
     std::mutex tensor_meta_mutex_;
     std::shared_ptr<std::vector<std::pair<ShardedKey, ATensor>>> tensor_meta_list_ = nullptr;
@@ -104,8 +126,10 @@ class RemoteTensorTable : public TensorTable {
 
     // The cached remote tensor shards for current seq
     bool enable_local_cache_prefetch_ = false;
-    // TODO(root): The cached remote tensor shards should be updated while the remote tensors were reallocated.
+    // Invalidated by InvalidateChangedRemoteShards() when the remote tensors were reallocated.
     std::unordered_map<ShardedKey, std::vector<ShardedATensorTuple>, ShardedKeyHash> shard_mapping_;
+    // Remote meta epoch of the transfer service the cached read plans were built on
+    std::atomic<uint64_t> seen_remote_meta_epoch_{0};
     // Cached local tensors which could be updated before the reading request submitted from inference engine.
     // The bool variable is whether the tensor is cached for current seq.
     TensorExtDict<bool> local_cached_tensors_;
@@ -131,9 +155,25 @@ class RemoteTensorTable : public TensorTable {
 
     std::shared_ptr<PerfMetricsController> perf_metrics_controller_;
 
+    // Stage latencies of the table calls, the transfer stages are recorded by the transfer service
+    struct StageLatencies {
+        LatencyHistogram& put = GetMetricsRegistry().GetHistogram(kStageLatencyUs, "put");
+        LatencyHistogram& multi_put = GetMetricsRegistry().GetHistogram(kStageLatencyUs, "multi_put");
+        LatencyHistogram& put_copy = GetMetricsRegistry().GetHistogram(kStageLatencyUs, "put_copy");
+        LatencyHistogram& submit = GetMetricsRegistry().GetHistogram(kStageLatencyUs, "submit");
+        LatencyHistogram& compact_plan = GetMetricsRegistry().GetHistogram(kStageLatencyUs, "compact_plan");
+        LatencyHistogram& compact_read = GetMetricsRegistry().GetHistogram(kStageLatencyUs, "compact_read");
+        LatencyHistogram& copy = GetMetricsRegistry().GetHistogram(kStageLatencyUs, "copy");
+        LatencyHistogram& copy_wait = GetMetricsRegistry().GetHistogram(kStageLatencyUs, "copy_wait");
+        LatencyHistogram& multi_get = GetMetricsRegistry().GetHistogram(kStageLatencyUs, "multi_get");
+        LatencyHistogram& get_tensor = GetMetricsRegistry().GetHistogram(kStageLatencyUs, "get_tensor");
+        LatencyHistogram& multi_get_tensor = GetMetricsRegistry().GetHistogram(kStageLatencyUs, "multi_get_tensor");
+    } stage_latency_;
+
     bool pinned_memory_enabled_ = true; // Pinned memory is only avaiable in GPU env, not in CPU only env.
 
-    astate::NumaAwareAllocator numa_allocator_;
+    // Shared with the deleters of the tensors it allocated
+    std::shared_ptr<astate::NumaAwareAllocator> numa_allocator_;
 
     std::atomic_bool enable_numa_allocation_{true};
 
@@ -250,6 +290,9 @@ class RemoteTensorTable : public TensorTable {
     std::future<void>
     SubmitTransferTask(int64_t seq_id, const ShardedKey& sharded_key, const torch::Tensor& target_tensor);
 
+    // NUMA node a copy task for tensor should run on: the node of its GPU, or of its host pages; -1 when unknown
+    int GetTensorNumaNode(const torch::Tensor& tensor) const;
+
     // [Receiver] Record the tensor metas in first step.
     void UpdateReadingTensorsMeta(const int64_t seq_id, const ShardedKey& tensor_key, const torch::Tensor& atensor) {
         // only update the reading_tensors_meta_ when first step (-1)
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <unordered_map>
 #include <utility>
@@ -66,6 +67,8 @@ class InMemoryTensorTable : public TensorTable {
         throw std::runtime_error("prefetch_cached_tensors is not supported for in-memory table");
     }
 
+    std::map<std::string, std::map<std::string, double>> Stats() override;
+
  private:
     // Internal storage structure: seq_id -> (tensor_key -> tensor)
     using TableData = std::unordered_map<int64_t, TensorDict>;
@@ -1,13 +1,17 @@
 #include "discovery/discovery_manager.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cmath>
 #include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <utility>
@@ -15,6 +19,7 @@
 
 #include <spdlog/spdlog.h>
 
+#include "common/file_utils.h"
 #include "common/network_utils.h"
 #include "common/option.h"
 #include "core/atensor.h"
@@ -25,6 +30,13 @@
 
 namespace astate {
 
+namespace {
+
+// Layout: header line, "train_world_size inference_world_size", then one "incarnation node" line per node
+constexpr const char* kDiscoverySnapshotHeader = "astate_discovery_snapshot_v1";
+
+} // namespace
+
 // 静态工厂方法实现
 std::unique_ptr<DiscoveryManager> DiscoveryManager::CreateFromOptions(
     const Options& options, const AParallelConfig& parallel_config, int rdma_port, int ctrl_port) {
@@ -79,6 +91,11 @@ DiscoveryManager::DiscoveryManager(
     current_node_.node_info.rdma_port = rdma_port;
     current_node_.node_info.ctrl_flow_port = ctrl_port;
 
+    auto snapshot_dir = GetOptionValue<std::string>(options_, TRANSFER_ENGINE_RESTART_SNAPSHOT_DIR);
+    if (!snapshot_dir.empty()) {
+        snapshot_path_ = RestartSnapshotPath(snapshot_dir, current_node_.role, current_node_.rank, "discovery");
+    }
+
     // 根据类型创建配置中心 client
     config_center_ = CreateConfigCenterByType(config_type);
     if (!config_center_) {
@@ -148,6 +165,107 @@ bool DiscoveryManager::RegisterCurrentNode() {
 }
 
 std::vector<NodeEntry> DiscoveryManager::DiscoverAllNodes() {
+    if (!snapshot_path_.empty()) {
+        auto nodes = RestoreFromSnapshot();
+        if (!nodes.empty()) {
+            restored_from_snapshot_ = true;
+            return nodes;
+        }
+    }
+    auto nodes = DiscoverAllNodesFromStore();
+    if (!snapshot_path_.empty()) {
+        SaveSnapshot(nodes);
+    }
+    return nodes;
+}
+
+std::vector<NodeEntry> DiscoveryManager::RestoreFromSnapshot() {
+    auto start_time = std::chrono::steady_clock::now();
+    auto content = ReadFile(snapshot_path_);
+    if (!content.has_value()) {
+        SPDLOG_INFO("No discovery snapshot at {}", snapshot_path_);
+        return {};
+    }
+
+    std::vector<NodeEntry> nodes;
+    std::vector<NodeEntry> peers;
+    std::vector<std::string> incarnations;
+    bool current_node_found = false;
+    try {
+        std::istringstream iss(*content);
+        std::string header;
+        int train_world_size = 0;
+        int inference_world_size = 0;
+        if (!std::getline(iss, header) || header != kDiscoverySnapshotHeader
+            || !(iss >> train_world_size >> inference_world_size)) {
+            throw std::runtime_error("invalid header");
+        }
+        if (train_world_size != GetTrainWorldSize() || inference_world_size != GetInferenceWorldSize()) {
+            SPDLOG_INFO(
+                "World sizes changed since the discovery snapshot: train={}/{}, inference={}/{}",
+                train_world_size,
+                GetTrainWorldSize(),
+                inference_world_size,
+                GetInferenceWorldSize());
+            return {};
+        }
+        std::string incarnation;
+        std::string node_str;
+        while (iss >> incarnation >> node_str) {
+            auto node = ServiceDiscovery::StringToNode(node_str);
+            nodes.push_back(node);
+            if (node.role == current_node_.role && node.rank == current_node_.rank) {
+                // Registered again with a new incarnation, the peers only keep working if the address is the same
+                if (!(node.node_info == current_node_.node_info)) {
+                    SPDLOG_INFO(
+                        "Current node moved since the discovery snapshot: {} -> {}",
+                        node.node_info.ToString(),
+                        current_node_.node_info.ToString());
+                    return {};
+                }
+                current_node_found = true;
+                continue;
+            }
+            peers.push_back(node);
+            incarnations.push_back(incarnation);
+        }
+    } catch (const std::exception& e) {
+        SPDLOG_WARN("Ignore invalid discovery snapshot {}: {}", snapshot_path_, e.what());
+        return {};
+    }
+
+    if (!current_node_found || !CheckNodesCount(nodes) || !service_discovery_->ValidateNodes(peers, incarnations)) {
+        SPDLOG_INFO("Discovery snapshot {} is stale, discover all nodes again", snapshot_path_);
+        return {};
+    }
+    SPDLOG_INFO(
+        "Restored {} nodes from the discovery snapshot {} in {} ms",
+        nodes.size(),
+        snapshot_path_,
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count());
+    PrintNodesInfo(nodes);
+    return nodes;
+}
+
+void DiscoveryManager::SaveSnapshot(const std::vector<NodeEntry>& nodes) {
+    auto incarnations = service_discovery_->GetIncarnations(nodes);
+    if (incarnations.size() != nodes.size()) {
+        SPDLOG_WARN("Node incarnations are not available, skip the discovery snapshot");
+        return;
+    }
+    std::ostringstream oss;
+    oss << kDiscoverySnapshotHeader << '\n' << GetTrainWorldSize() << ' ' << GetInferenceWorldSize() << '\n';
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        oss << incarnations[i] << ' ' << ServiceDiscovery::NodeToString(nodes[i]) << '\n';
+    }
+    if (!WriteFileAtomically(snapshot_path_, oss.str())) {
+        SPDLOG_WARN("Failed to write the discovery snapshot {}", snapshot_path_);
+        return;
+    }
+    SPDLOG_INFO("Saved the discovery snapshot of {} nodes to {}", nodes.size(), snapshot_path_);
+}
+
+std::vector<NodeEntry> DiscoveryManager::DiscoverAllNodesFromStore() {
     auto start_time = std::chrono::steady_clock::now();
     auto timeout = kDefaultTimeout;
 
@@ -156,6 +274,22 @@ std::vector<NodeEntry> DiscoveryManager::DiscoverAllNodes() {
         SPDLOG_INFO("Using batch discovery");
     }
 
+    // Block on the registration barrier, then read the node list once
+    if (GetOptionValue<bool>(options_, DISCOVERY_USE_BARRIER)) {
+        // Leave the polling below time to catch nodes the barrier missed
+        auto barrier_timeout = std::min(
+            std::chrono::milliseconds(GetOptionValue<int64_t>(options_, DISCOVERY_BARRIER_TIMEOUT_MS)),
+            std::chrono::duration_cast<std::chrono::milliseconds>(timeout) / 2);
+        if (service_discovery_->WaitForAllRegistered(barrier_timeout)) {
+            auto nodes = service_discovery_->DiscoverNodesBatch();
+            if (CheckNodesCount(nodes)) {
+                SPDLOG_INFO("All nodes discovered after the registration barrier");
+                return nodes;
+            }
+        }
+        SPDLOG_WARN("Registration barrier did not complete the node list, fall back to polling");
+    }
+
     while (std::chrono::steady_clock::now() - start_time < timeout) {
         std::vector<NodeEntry> nodes;
         if (use_batch) {
@@ -280,9 +414,95 @@ std::unique_ptr<ServiceDiscovery> DiscoveryManager::CreateServiceDiscoveryByType
     }
 }
 
+void DiscoveryManager::StartMembershipWatch(const std::vector<NodeEntry>& nodes, MembershipCallback callback) {
+    if (discovery_thread_.joinable()) {
+        SPDLOG_WARN("Discovery thread already running, membership watch not started");
+        return;
+    }
+    // Read the version first, changes racing with the listing below are reported by the first round
+    membership_version_ = service_discovery_->GetMembershipVersion();
+    if (membership_version_ < 0) {
+        SPDLOG_WARN("Service discovery keeps no membership version, membership watch not started");
+        return;
+    }
+    auto members = ListMembers(nodes);
+    if (!members.has_value()) {
+        SPDLOG_WARN("Node incarnations are not available, membership watch not started");
+        return;
+    }
+    members_ = std::move(*members);
+    membership_callback_ = std::move(callback);
+    all_nodes_ready_.store(true);
+    should_stop_.store(false);
+    enable_discovery_thread_ = true;
+    discovery_thread_ = std::thread(&DiscoveryManager::DiscoveryThreadFunc, this);
+    SPDLOG_INFO("Membership watch started with {} members at version {}", members_.size(), membership_version_);
+}
+
+std::optional<std::map<std::string, NodeEntry>> DiscoveryManager::ListMembers(const std::vector<NodeEntry>& nodes) {
+    auto incarnations = service_discovery_->GetIncarnations(nodes);
+    if (incarnations.size() != nodes.size()) {
+        return std::nullopt;
+    }
+    std::map<std::string, NodeEntry> members;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].role == current_node_.role && nodes[i].rank == current_node_.rank) {
+            continue;
+        }
+        members.emplace(incarnations[i] + " " + ServiceDiscovery::NodeToString(nodes[i]), nodes[i]);
+    }
+    return members;
+}
+
+void DiscoveryManager::WatchMembership() {
+    int64_t version = service_discovery_->GetMembershipVersion();
+    if (version < 0 || version == membership_version_) {
+        return;
+    }
+    auto nodes = service_discovery_->ListRegisteredNodes();
+    auto listed = ListMembers(nodes);
+    if (!listed.has_value()) {
+        // A node left between the listing and the incarnation read, list again next round
+        return;
+    }
+    auto& members = *listed;
+
+    std::vector<NodeEntry> joined;
+    std::vector<NodeEntry> left;
+    for (const auto& [key, node] : members) {
+        if (members_.count(key) == 0) {
+            joined.push_back(node);
+        }
+    }
+    for (const auto& [key, node] : members_) {
+        if (members.count(key) == 0) {
+            left.push_back(node);
+        }
+    }
+    members_ = std::move(members);
+    membership_version_ = version;
+    if (joined.empty() && left.empty()) {
+        return;
+    }
+
+    SPDLOG_INFO("Membership changed at version {}: {} joined, {} left", version, joined.size(), left.size());
+    for (const auto& node : left) {
+        SPDLOG_INFO("Node left: {}", ServiceDiscovery::NodeToString(node));
+    }
+    for (const auto& node : joined) {
+        SPDLOG_INFO("Node joined: {}", ServiceDiscovery::NodeToString(node));
+    }
+    membership_callback_(joined, left);
+}
+
 void DiscoveryManager::DiscoveryThreadFunc() {
     while (!should_stop_.load()) {
         try {
+            if (all_nodes_ready_.load() && membership_callback_) {
+                WatchMembership();
+                std::this_thread::sleep_for(kDiscoveryInterval);
+                continue;
+            }
             auto nodes = service_discovery_->DiscoverNodes();
 
             {
@@ -315,8 +535,10 @@ void DiscoveryManager::DiscoveryThreadFunc() {
                 if (nodes_ready_callback_) {
                     nodes_ready_callback_(nodes);
                 }
-                SPDLOG_INFO("All nodes are ready, stopping discovery thread");
-                should_stop_.store(true);
+                if (!membership_callback_) {
+                    SPDLOG_INFO("All nodes are ready, stopping discovery thread");
+                    should_stop_.store(true);
+                }
             }
 
         } catch (const std::exception& e) {
@@ -4,7 +4,10 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
+#include <optional>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -17,8 +20,16 @@ namespace astate {
 enum class ConfigCenterType : uint8_t { TCPStore, HTTP, FILE };
 enum class DiscoveryType : uint8_t { TCPStore };
 
+// Local file of a warm restart snapshot (TRANSFER_ENGINE_RESTART_SNAPSHOT_DIR), one per rank and kind
+inline std::string RestartSnapshotPath(const std::string& dir, ARole role, int rank, const std::string& kind) {
+    return dir + "/astate_" + RoleToString(role) + "_" + std::to_string(rank) + "." + kind;
+}
+
 class DiscoveryManager {
  public:
+    using MembershipCallback =
+        std::function<void(const std::vector<NodeEntry>& joined, const std::vector<NodeEntry>& left)>;
+
     explicit DiscoveryManager(
         ConfigCenterType config_type,
         DiscoveryType discovery_type,
@@ -63,6 +74,16 @@ class DiscoveryManager {
 
     bool WaitForAllNodes(std::chrono::milliseconds timeout);
 
+    /*
+     * Elastic membership: watch the registrations from the discovery thread and report the nodes that joined or
+     * left since nodes. A node registered again (restarted) is reported as left and joined, the current node is
+     * never reported. The callback runs on the discovery thread until Stop.
+     */
+    void StartMembershipWatch(const std::vector<NodeEntry>& nodes, MembershipCallback callback);
+
+    // Whether DiscoverAllNodes took the nodes from a validated local snapshot, i.e. no peer restarted since
+    bool IsRestoredFromSnapshot() const { return restored_from_snapshot_; }
+
  private:
     static std::unique_ptr<ConfigCenter> CreateConfigCenterByType(ConfigCenterType type);
 
@@ -72,6 +93,19 @@ class DiscoveryManager {
 
     bool CheckNodesCount(const std::vector<NodeEntry>& nodes) const;
 
+    std::vector<NodeEntry> DiscoverAllNodesFromStore();
+
+    // Nodes of the local snapshot if all of them are unchanged in the store, empty otherwise
+    std::vector<NodeEntry> RestoreFromSnapshot();
+
+    void SaveSnapshot(const std::vector<NodeEntry>& nodes);
+
+    // Members keyed by "incarnation node", a restarted node gets a new key
+    std::optional<std::map<std::string, NodeEntry>> ListMembers(const std::vector<NodeEntry>& nodes);
+
+    // One round of the membership watch, reports the changes if the membership version moved
+    void WatchMembership();
+
     static void PrintNodesInfo(const std::vector<NodeEntry>& nodes);
 
     AParallelConfig parallel_config_;
@@ -101,6 +135,13 @@ class DiscoveryManager {
 
     std::function<void(const std::vector<NodeEntry>&)> nodes_ready_callback_;
 
+    MembershipCallback membership_callback_;
+    std::map<std::string, NodeEntry> members_;
+    int64_t membership_version_{-1};
+
+    std::string snapshot_path_; // empty if warm restart snapshots are disabled
+    bool restored_from_snapshot_{false};
+
     static constexpr bool kDefaultControlMaster = true;
     static constexpr auto kDiscoveryInterval = std::chrono::seconds(1);
     static constexpr auto kDefaultTimeout = std::chrono::seconds(1800);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -38,6 +39,41 @@ class ServiceDiscovery {
 
     virtual std::vector<NodeEntry> DiscoverNodesBatch() { return DiscoverNodes(); }
 
+    /*
+     * Barrier over the registration of all nodes: count the local node as registered and block until every
+     * node of both roles is. Shall be called once per node, after RegisterNode.
+     * @return false on timeout or if the discovery has no such primitive, callers fall back to polling
+     */
+    virtual bool WaitForAllRegistered(std::chrono::milliseconds /*timeout*/) { return false; }
+
+    /*
+     * Incarnations of the nodes, read in one round trip. Every RegisterNode writes a new random token, so an
+     * unchanged token means the node has not restarted since.
+     * @return empty if any node is not registered or the discovery keeps no incarnations
+     */
+    virtual std::vector<std::string> GetIncarnations(const std::vector<NodeEntry>& /*nodes*/) { return {}; }
+
+    /*
+     * Warm restart: check in one round trip that the nodes of a local snapshot are still registered with the same
+     * address and incarnation, and take them as discovered.
+     * @return false if any node changed, callers fall back to the full discovery
+     */
+    virtual bool
+    ValidateNodes(const std::vector<NodeEntry>& /*nodes*/, const std::vector<std::string>& /*incarnations*/) {
+        return false;
+    }
+
+    /*
+     * Membership version, bumped by every RegisterNode and Unregister. Cheap to poll, the registered nodes only
+     * need to be listed again when it changes.
+     * @return -1 if the discovery keeps no version
+     */
+    virtual int64_t GetMembershipVersion() { return -1; }
+
+    // Nodes registered right now (ranks within the world sizes), without waiting for the missing ones.
+    // Throws on store errors, an empty list means no node is registered
+    virtual std::vector<NodeEntry> ListRegisteredNodes() { return {}; }
+
     virtual int GetTrainWorldSize() = 0;
 
     virtual int GetInferenceWorldSize() = 0;
@@ -1,6 +1,7 @@
 #include "tcpstore_discovery.h"
 
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <random>
@@ -40,6 +41,25 @@ static std::string NodeKey(int rank, ARole role) {
     return oss.str();
 }
 
+static std::string IncarnationKey(int rank, ARole role) {
+    std::ostringstream oss;
+    std::string prefix = GenerateKeyPrefix();
+    if (role == ARole::TRAINING) {
+        oss << prefix << ".incarnation_train_" << rank;
+    } else {
+        oss << prefix << ".incarnation_inference_" << rank;
+    }
+    return oss.str();
+}
+
+static std::string GenerateIncarnation() {
+    std::random_device rd;
+    std::mt19937_64 gen((static_cast<uint64_t>(rd()) << 32) ^ rd());
+    std::ostringstream oss;
+    oss << std::hex << gen() << '-' << std::chrono::steady_clock::now().time_since_epoch().count();
+    return oss.str();
+}
+
 static std::string WorldSizeKey(ARole role) {
     std::ostringstream oss;
     std::string prefix = GenerateKeyPrefix();
@@ -51,6 +71,23 @@ static std::string WorldSizeKey(ARole role) {
     return oss.str();
 }
 
+static std::string RunIdKey() {
+    return GenerateKeyPrefix() + ".run_id";
+}
+
+// The barrier keys carry the run id, counts left on the store by an earlier run can not open the barrier
+static std::string RegisteredCountKey(const std::string& run_id) {
+    return GenerateKeyPrefix() + "." + run_id + ".nodes_registered";
+}
+
+static std::string AllRegisteredKey(const std::string& run_id) {
+    return GenerateKeyPrefix() + "." + run_id + ".nodes_all_registered";
+}
+
+static std::string MembershipVersionKey() {
+    return GenerateKeyPrefix() + ".membership_version";
+}
+
 static std::string TcpStoreAddressKey() {
     std::ostringstream oss;
     std::string prefix = GenerateKeyPrefix();
@@ -58,6 +95,9 @@ static std::string TcpStoreAddressKey() {
     return oss.str();
 }
 
+// One attempt of the world size fetch, DISCOVERY_WORLD_SIZE_RETRY_COUNT attempts in total
+constexpr auto kWorldSizeWaitSlice = std::chrono::seconds(10);
+
 struct TCPStoreServiceDiscovery::Impl {
     std::unique_ptr<c10d::TCPStore> store;
     std::unique_ptr<c10d::TCPStore> master_store;
@@ -74,6 +114,9 @@ struct TCPStoreServiceDiscovery::Impl {
     ConfigCenter* config_center = nullptr;
     astate::Options options;
     std::unordered_map<std::string, NodeEntry> discovered_nodes_cache;
+    // Whether this node was added to the registration counter, it must be counted once
+    bool arrived = false;
+    std::string run_id;
 
     Impl(
         const std::string& addr,
@@ -188,6 +231,18 @@ struct TCPStoreServiceDiscovery::Impl {
         }
     }
 
+    // DISCOVERY_RUN_ID if set, else the id the master drew when it created the store
+    const std::string& RunId() {
+        if (run_id.empty()) {
+            run_id = GetOptionValue<std::string>(options, DISCOVERY_RUN_ID);
+        }
+        if (run_id.empty()) {
+            auto value = store->get(RunIdKey());
+            run_id.assign(value.begin(), value.end());
+        }
+        return run_id;
+    }
+
     void MakeSureConnect() {
         if (!store) {
             for (int retry = 0; retry < kMaxRetry; ++retry) {
@@ -238,6 +293,12 @@ struct TCPStoreServiceDiscovery::Impl {
 
                 master_store = std::make_unique<c10d::TCPStore>(master_addr, opts);
                 master_port = port;
+                // Published before the address, every node reaching the store finds it
+                std::string id = GetOptionValue<std::string>(options, DISCOVERY_RUN_ID);
+                if (id.empty()) {
+                    id = GenerateIncarnation();
+                }
+                master_store->set(RunIdKey(), std::vector<uint8_t>(id.begin(), id.end()));
                 master_running.store(true);
 
                 SPDLOG_INFO("Master service started on {}:{}", master_addr, port);
@@ -337,8 +398,9 @@ struct TCPStoreServiceDiscovery::Impl {
                         SPDLOG_INFO("Registered world size: {}={}", my_key, my_world_size);
                     }
 
-                    // 获取另一个Role的world_size
+                    // 获取另一个Role的world_size, 阻塞等待该 key 写入而不是轮询
                     try {
+                        store->wait({other_key}, kWorldSizeWaitSlice);
                         std::vector<uint8_t> other_data = store->get(other_key);
                         std::string other_value(other_data.begin(), other_data.end());
                         int other_world_size = std::stoi(other_value);
@@ -363,8 +425,6 @@ struct TCPStoreServiceDiscovery::Impl {
                             other_key,
                             retry_policy->GetAttemptCount(),
                             e.what());
-
-                        std::this_thread::sleep_for(std::chrono::seconds(1));
                         throw std::runtime_error("Other world size not available, will retry");
                     }
                 },
@@ -398,9 +458,13 @@ bool TCPStoreServiceDiscovery::RegisterNode(const NodeEntry& entry) {
         impl_->MakeSureConnect();
         std::string key = NodeKey(entry.rank, entry.role);
         std::string value = ServiceDiscovery::NodeToString(entry);
-        std::vector<uint8_t> data(value.begin(), value.end());
-        impl_->store->set(key, data);
-        SPDLOG_INFO("Registered node: {} with value: {}", key, value);
+        std::string incarnation = GenerateIncarnation();
+        impl_->store->multiSet(
+            {key, IncarnationKey(entry.rank, entry.role)},
+            {std::vector<uint8_t>(value.begin(), value.end()),
+             std::vector<uint8_t>(incarnation.begin(), incarnation.end())});
+        impl_->store->add(MembershipVersionKey(), 1);
+        SPDLOG_INFO("Registered node: {} with value: {}, incarnation: {}", key, value, incarnation);
         return true;
     } catch (const std::exception& e) {
         SPDLOG_ERROR("Failed to register node: {}", e.what());
@@ -654,6 +718,149 @@ std::vector<NodeEntry> TCPStoreServiceDiscovery::DiscoverNodesBatch() {
     return result;
 }
 
+bool TCPStoreServiceDiscovery::WaitForAllRegistered(std::chrono::milliseconds timeout) {
+    int total = impl_->train_world_size + impl_->inference_world_size;
+    if (impl_->train_world_size <= 0 || impl_->inference_world_size <= 0) {
+        SPDLOG_WARN(
+            "World sizes not known yet, train={}, inference={}",
+            impl_->train_world_size,
+            impl_->inference_world_size);
+        return false;
+    }
+    auto start_time = std::chrono::steady_clock::now();
+    try {
+        impl_->MakeSureConnect();
+        const std::string& run_id = impl_->RunId();
+        if (!impl_->arrived) {
+            int64_t registered = impl_->store->add(RegisteredCountKey(run_id), 1);
+            impl_->arrived = true;
+            SPDLOG_INFO("Registration barrier: {}/{} nodes registered", registered, total);
+            // A restarted node counts again, every arrival past the total sets the key once more
+            if (registered >= total) {
+                std::string value = std::to_string(registered);
+                impl_->store->set(AllRegisteredKey(run_id), std::vector<uint8_t>(value.begin(), value.end()));
+            }
+        }
+        impl_->store->wait({AllRegisteredKey(run_id)}, timeout);
+    } catch (const std::exception& e) {
+        SPDLOG_WARN("Registration barrier failed: {}", e.what());
+        return false;
+    }
+    SPDLOG_INFO(
+        "Registration barrier passed in {} ms, total {} nodes",
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count(),
+        total);
+    return true;
+}
+
+std::vector<std::string> TCPStoreServiceDiscovery::GetIncarnations(const std::vector<NodeEntry>& nodes) {
+    std::vector<std::string> keys;
+    keys.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        keys.push_back(IncarnationKey(node.rank, node.role));
+    }
+    std::vector<std::string> incarnations;
+    try {
+        impl_->MakeSureConnect();
+        auto values = impl_->store->multiGet(keys);
+        incarnations.reserve(values.size());
+        for (const auto& value : values) {
+            incarnations.emplace_back(value.begin(), value.end());
+        }
+    } catch (const std::exception& e) {
+        SPDLOG_WARN("Failed to get node incarnations: {}", e.what());
+        incarnations.clear();
+    }
+    return incarnations;
+}
+
+bool TCPStoreServiceDiscovery::ValidateNodes(
+    const std::vector<NodeEntry>& nodes, const std::vector<std::string>& incarnations) {
+    if (nodes.size() != incarnations.size()) {
+        SPDLOG_WARN("Got {} incarnations for {} nodes", incarnations.size(), nodes.size());
+        return false;
+    }
+    // Node and incarnation keys are read in a single multiGet
+    std::vector<std::string> keys;
+    keys.reserve(2 * nodes.size());
+    for (const auto& node : nodes) {
+        keys.push_back(NodeKey(node.rank, node.role));
+    }
+    for (const auto& node : nodes) {
+        keys.push_back(IncarnationKey(node.rank, node.role));
+    }
+    std::vector<std::vector<uint8_t>> values;
+    try {
+        impl_->MakeSureConnect();
+        // multiGet blocks on a missing key until the store timeout, e.g. for a snapshot of an earlier job
+        if (!impl_->store->check(keys)) {
+            SPDLOG_INFO("Nodes of the snapshot are not all registered");
+            return false;
+        }
+        values = impl_->store->multiGet(keys);
+    } catch (const std::exception& e) {
+        SPDLOG_WARN("Failed to read the snapshot nodes: {}", e.what());
+        return false;
+    }
+    if (values.size() != keys.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        std::string value(values[i].begin(), values[i].end());
+        std::string incarnation(values[nodes.size() + i].begin(), values[nodes.size() + i].end());
+        if (value != ServiceDiscovery::NodeToString(nodes[i]) || incarnation != incarnations[i]) {
+            SPDLOG_INFO(
+                "Node {} changed since the snapshot: {} (incarnation {}), was {} (incarnation {})",
+                keys[i],
+                value,
+                incarnation,
+                ServiceDiscovery::NodeToString(nodes[i]),
+                incarnations[i]);
+            return false;
+        }
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        impl_->discovered_nodes_cache[keys[i]] = nodes[i];
+    }
+    return true;
+}
+
+int64_t TCPStoreServiceDiscovery::GetMembershipVersion() {
+    try {
+        impl_->MakeSureConnect();
+        return impl_->store->add(MembershipVersionKey(), 0);
+    } catch (const std::exception& e) {
+        SPDLOG_WARN("Failed to get membership version: {}", e.what());
+        return -1;
+    }
+}
+
+std::vector<NodeEntry> TCPStoreServiceDiscovery::ListRegisteredNodes() {
+    impl_->MakeSureConnect();
+    // Probe each key first, multiGet would block on the keys of the nodes that left
+    std::vector<std::string> keys;
+    for (ARole role : {ARole::TRAINING, ARole::INFERENCE}) {
+        int world_size = role == ARole::TRAINING ? impl_->train_world_size : impl_->inference_world_size;
+        for (int i = 0; i < world_size; ++i) {
+            std::string key = NodeKey(i, role);
+            if (impl_->store->check({key})) {
+                keys.push_back(std::move(key));
+            }
+        }
+    }
+    std::vector<NodeEntry> result;
+    if (keys.empty()) {
+        return result;
+    }
+    auto values = impl_->store->multiGet(keys);
+    result.reserve(values.size());
+    for (const auto& value : values) {
+        result.push_back(ServiceDiscovery::StringToNode(std::string(value.begin(), value.end())));
+    }
+    return result;
+}
+
 bool TCPStoreServiceDiscovery::Refresh(const NodeEntry& entry) {
     return RegisterNode(entry);
 }
@@ -663,6 +870,7 @@ bool TCPStoreServiceDiscovery::Unregister(const NodeEntry& entry) {
         impl_->MakeSureConnect();
         std::string key = NodeKey(entry.rank, entry.role);
         impl_->store->deleteKey(key);
+        impl_->store->add(MembershipVersionKey(), 1);
         SPDLOG_INFO("Unregistered node: {}", key);
         return true;
     } catch (const std::exception& e) {
@@ -40,6 +40,16 @@ class TCPStoreServiceDiscovery : public ServiceDiscovery {
 
     std::vector<NodeEntry> DiscoverNodesBatch() override;
 
+    // Every node adds itself to a counter, the last one sets a completion key the others wait on
+    bool WaitForAllRegistered(std::chrono::milliseconds timeout) override;
+
+    // Incarnation tokens live under their own keys next to the node keys
+    std::vector<std::string> GetIncarnations(const std::vector<NodeEntry>& nodes) override;
+    bool ValidateNodes(const std::vector<NodeEntry>& nodes, const std::vector<std::string>& incarnations) override;
+
+    int64_t GetMembershipVersion() override;
+    std::vector<NodeEntry> ListRegisteredNodes() override;
+
  private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
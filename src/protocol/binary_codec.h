@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace astate {
+
+/*
+ * Little helpers for the compact binary control messages.
+ *
+ * Integers are LEB128 varints, signed ones are zigzag encoded first so that
+ * small negative values (e.g. -1 device index) stay short. Strings are a
+ * varint length followed by the bytes. The reader works on a borrowed buffer
+ * and returns string_views into it, so decoding does not allocate per field.
+ */
+class BinaryWriter {
+ public:
+    explicit BinaryWriter(size_t reserve_size = 0) { buffer_.reserve(reserve_size); }
+
+    void WriteU8(uint8_t value) { buffer_.push_back(static_cast<char>(value)); }
+
+    void WriteRaw(const void* data, size_t size) { buffer_.append(static_cast<const char*>(data), size); }
+
+    void WriteVarint(uint64_t value) {
+        while (value >= 0x80) {
+            buffer_.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        buffer_.push_back(static_cast<char>(value));
+    }
+
+    void WriteSignedVarint(int64_t value) {
+        WriteVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    void WriteString(std::string_view value) {
+        WriteVarint(value.size());
+        buffer_.append(value.data(), value.size());
+    }
+
+    [[nodiscard]] size_t Size() const { return buffer_.size(); }
+
+    std::string Release() { return std::move(buffer_); }
+
+ private:
+    std::string buffer_;
+};
+
+class BinaryReader {
+ public:
+    BinaryReader(const void* data, size_t size)
+        : cur_(static_cast<const uint8_t*>(data)),
+          end_(cur_ + size) {}
+
+    uint8_t ReadU8() {
+        Require(1);
+        return *cur_++;
+    }
+
+    void ReadRaw(void* data, size_t size) {
+        Require(size);
+        std::memcpy(data, cur_, size);
+        cur_ += size;
+    }
+
+    uint64_t ReadVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = ReadU8();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("BinaryReader: varint too long");
+    }
+
+    int64_t ReadSignedVarint() {
+        uint64_t value = ReadVarint();
+        return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    std::string_view ReadString() {
+        uint64_t size = ReadVarint();
+        Require(size);
+        std::string_view value(reinterpret_cast<const char*>(cur_), size);
+        cur_ += size;
+        return value;
+    }
+
+    // Read a count and check it can not exceed the remaining bytes, guards allocations on corrupt input
+    size_t ReadCount(size_t min_bytes_per_item = 1) {
+        uint64_t count = ReadVarint();
+        if (min_bytes_per_item > 0 && count > Remaining() / min_bytes_per_item) {
+            throw std::runtime_error("BinaryReader: count " + std::to_string(count) + " exceeds message size");
+        }
+        return count;
+    }
+
+    [[nodiscard]] size_t Remaining() const { return end_ - cur_; }
+
+ private:
+    void Require(size_t size) const {
+        if (size > Remaining()) {
+            throw std::runtime_error("BinaryReader: message truncated");
+        }
+    }
+
+    const uint8_t* cur_;
+    const uint8_t* end_;
+};
+
+/*
+ * Assigns a dense index to every distinct string, used to send each tensor
+ * name / rkey once per message.
+ */
+class StringInterner {
+ public:
+    uint64_t Intern(const std::string& value) {
+        auto [it, inserted] = index_.emplace(value, strings_.size());
+        if (inserted) {
+            strings_.push_back(&it->first);
+        }
+        return it->second;
+    }
+
+    [[nodiscard]] const std::vector<const std::string*>& Strings() const { return strings_; }
+
+ private:
+    std::unordered_map<std::string, uint64_t> index_;
+    std::vector<const std::string*> strings_;
+};
+
+} // namespace astate
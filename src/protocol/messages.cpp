@@ -1,11 +1,20 @@
 #include "protocol/messages.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <json/json.h>
 #include <spdlog/spdlog.h>
 
 #include "core/shardedkey.h"
+#include "protocol/binary_codec.h"
 #include "transport/atensor_serializer.h"
 
 namespace astate {
@@ -337,6 +346,14 @@ Json::Value ToJson(const TensorRDMAMetaPublishMessage& msg) {
         }
         root["tensor_rdma_metas"] = metas;
 
+        root["version"] = Json::Value::UInt64(msg.version);
+        root["base_version"] = Json::Value::UInt64(msg.base_version);
+        Json::Value removed(Json::arrayValue);
+        for (const auto& key : msg.removed_keys) {
+            removed.append(ToJson(key));
+        }
+        root["removed_keys"] = removed;
+
         return root;
     } catch (const std::exception& e) {
         SPDLOG_ERROR("Failed to serialize TensorRDMAMetaPublishMessage: {}", e.what());
@@ -366,6 +383,13 @@ TensorRDMAMetaPublishMessage FromJson(const Json::Value& root, const TensorRDMAM
             msg.tensor_rdma_metas[shardKey] = fromJson(metas[key], TensorMemoryRDMAInfo{});
         }
 
+        // 版本与删除字段可选, 兼容旧版本发送方
+        msg.version = root.get("version", 0).asUInt64();
+        msg.base_version = root.get("base_version", 0).asUInt64();
+        for (const auto& key : root.get("removed_keys", Json::Value(Json::arrayValue))) {
+            msg.removed_keys.push_back(FromJson(key, ShardedKey{}));
+        }
+
         return msg;
     } catch (const std::exception& e) {
         SPDLOG_ERROR("Failed to deserialize TensorRDMAMetaPublishMessage: {}", e.what());
@@ -373,6 +397,270 @@ TensorRDMAMetaPublishMessage FromJson(const Json::Value& root, const TensorRDMAM
     }
 }
 
+// Tensor RDMA 元数据二进制编码
+namespace {
+
+void EncodeBinary(BinaryWriter& writer, const NodeInfo& info) {
+    writer.WriteString(info.hostname_or_ip);
+    writer.WriteVarint(static_cast<uint32_t>(info.rdma_port));
+    writer.WriteVarint(static_cast<uint32_t>(info.ctrl_flow_port));
+}
+
+NodeInfo DecodeBinaryNodeInfo(BinaryReader& reader) {
+    NodeInfo info;
+    info.hostname_or_ip = std::string(reader.ReadString());
+    info.rdma_port = static_cast<int>(reader.ReadVarint());
+    info.ctrl_flow_port = static_cast<int>(reader.ReadVarint());
+    return info;
+}
+
+void EncodeBinary(BinaryWriter& writer, const ATensor& atensor) {
+    writer.WriteSignedVarint(atensor.storage_offset);
+    int32_t dim_num = (atensor.size != nullptr && atensor.stride != nullptr) ? atensor.dim_num : 0;
+    writer.WriteVarint(static_cast<uint32_t>(dim_num));
+    writer.WriteU8(static_cast<uint8_t>(atensor.dtype));
+    writer.WriteU8(
+        static_cast<uint8_t>(atensor.conj) | (static_cast<uint8_t>(atensor.neg) << 1)
+        | (static_cast<uint8_t>(atensor.requires_grad) << 2));
+    for (int32_t i = 0; i < dim_num; ++i) {
+        writer.WriteSignedVarint(atensor.size[i]);
+    }
+    for (int32_t i = 0; i < dim_num; ++i) {
+        writer.WriteSignedVarint(atensor.stride[i]);
+    }
+    writer.WriteVarint(atensor.storage.storage_size);
+    writer.WriteU8(static_cast<uint8_t>(atensor.storage.device.device_type));
+    writer.WriteSignedVarint(atensor.storage.device.device_index);
+}
+
+void DecodeBinary(BinaryReader& reader, ATensor& atensor) {
+    atensor.storage_offset = reader.ReadSignedVarint();
+    // every dim takes at least two bytes (size and stride)
+    atensor.dim_num = static_cast<int32_t>(reader.ReadCount(2));
+    atensor.dtype = static_cast<ATDtype>(reader.ReadU8());
+    uint8_t flags = reader.ReadU8();
+    atensor.conj = (flags & 1) != 0;
+    atensor.neg = (flags & 2) != 0;
+    atensor.requires_grad = (flags & 4) != 0;
+    if (atensor.dim_num > 0) {
+        atensor.size = new int64_t[atensor.dim_num];
+        atensor.stride = new int64_t[atensor.dim_num];
+        for (int32_t i = 0; i < atensor.dim_num; ++i) {
+            atensor.size[i] = reader.ReadSignedVarint();
+        }
+        for (int32_t i = 0; i < atensor.dim_num; ++i) {
+            atensor.stride[i] = reader.ReadSignedVarint();
+        }
+    }
+    atensor.storage.storage_size = reader.ReadVarint();
+    atensor.storage.device.device_type = static_cast<ATDeviceType>(reader.ReadU8());
+    atensor.storage.device.device_index = static_cast<ATDeviceIndex>(reader.ReadSignedVarint());
+    atensor.storage.data = nullptr; // 运行时设置
+}
+
+void EncodeBinary(BinaryWriter& writer, const ShardedKey& key, uint64_t key_index) {
+    if (key.global_shape.size() != key.global_offset.size()) {
+        throw std::runtime_error("Shape and offset dimensions do not match: " + key.key);
+    }
+    writer.WriteVarint(key_index);
+    writer.WriteVarint(key.global_shape.size());
+    for (auto dim : key.global_shape) {
+        writer.WriteSignedVarint(dim);
+    }
+    for (auto dim : key.global_offset) {
+        writer.WriteSignedVarint(dim);
+    }
+}
+
+ShardedKey DecodeBinaryShardedKey(BinaryReader& reader, const std::vector<std::string_view>& strings) {
+    uint64_t key_index = reader.ReadVarint();
+    if (key_index >= strings.size()) {
+        throw std::runtime_error("Invalid key index: " + std::to_string(key_index));
+    }
+    ShardedKey key;
+    key.key = std::string(strings[key_index]);
+    size_t dims = reader.ReadCount(2);
+    key.global_shape.resize(dims);
+    key.global_offset.resize(dims);
+    for (auto& dim : key.global_shape) {
+        dim = reader.ReadSignedVarint();
+    }
+    for (auto& dim : key.global_offset) {
+        dim = reader.ReadSignedVarint();
+    }
+    return key;
+}
+
+// Rough per entry size, only used to reserve the output buffer
+constexpr size_t kBinaryMetaEntryReserveSize = 64;
+
+} // namespace
+
+bool IsBinaryMessage(const void* data, size_t size) {
+    uint32_t magic = 0;
+    if (data == nullptr || size < sizeof(magic) + 1) {
+        return false;
+    }
+    std::memcpy(&magic, data, sizeof(magic));
+    return magic == kBinaryMessageMagic;
+}
+
+std::string EncodeBinary(const TensorRDMAMetaPublishMessage& msg) {
+    // Intern names and rkeys first, a model has many shards of few tensors and few memory regions
+    StringInterner interner;
+    std::vector<std::pair<uint64_t, uint64_t>> string_indices;
+    string_indices.reserve(msg.tensor_rdma_metas.size());
+    for (const auto& [key, info] : msg.tensor_rdma_metas) {
+        string_indices.emplace_back(interner.Intern(key.key), interner.Intern(info.rkey));
+    }
+    std::vector<uint64_t> removed_indices;
+    removed_indices.reserve(msg.removed_keys.size());
+    for (const auto& key : msg.removed_keys) {
+        removed_indices.push_back(interner.Intern(key.key));
+    }
+
+    BinaryWriter writer(msg.tensor_rdma_metas.size() * kBinaryMetaEntryReserveSize);
+    uint32_t magic = kBinaryMessageMagic;
+    writer.WriteRaw(&magic, sizeof(magic));
+    writer.WriteU8(kBinaryMessageVersion);
+    writer.WriteSignedVarint(msg.seq_id);
+    EncodeBinary(writer, msg.node_info);
+
+    writer.WriteVarint(interner.Strings().size());
+    for (const auto* str : interner.Strings()) {
+        writer.WriteString(*str);
+    }
+
+    writer.WriteVarint(msg.tensor_rdma_metas.size());
+    size_t index = 0;
+    for (const auto& [key, info] : msg.tensor_rdma_metas) {
+        EncodeBinary(writer, key, string_indices[index].first);
+        writer.WriteVarint(reinterpret_cast<uintptr_t>(info.addr));
+        writer.WriteVarint(info.size);
+        writer.WriteVarint(string_indices[index].second);
+        EncodeBinary(writer, info.atensor_meta);
+        ++index;
+    }
+
+    writer.WriteVarint(msg.version);
+    writer.WriteVarint(msg.base_version);
+    writer.WriteVarint(msg.removed_keys.size());
+    for (size_t i = 0; i < msg.removed_keys.size(); ++i) {
+        EncodeBinary(writer, msg.removed_keys[i], removed_indices[i]);
+    }
+    return writer.Release();
+}
+
+TensorRDMAMetaPublishMessage DecodeBinary(const void* data, size_t size, const TensorRDMAMetaPublishMessage&) {
+    try {
+        if (!IsBinaryMessage(data, size)) {
+            throw std::runtime_error("Invalid binary message magic");
+        }
+        BinaryReader reader(data, size);
+        uint32_t magic = 0;
+        reader.ReadRaw(&magic, sizeof(magic));
+        uint8_t version = reader.ReadU8();
+        if (version == 0 || version > kBinaryMessageVersion) {
+            throw std::runtime_error("Unsupported binary message version: " + std::to_string(version));
+        }
+
+        TensorRDMAMetaPublishMessage msg;
+        msg.seq_id = reader.ReadSignedVarint();
+        msg.node_info = DecodeBinaryNodeInfo(reader);
+
+        std::vector<std::string_view> strings(reader.ReadCount());
+        for (auto& str : strings) {
+            str = reader.ReadString();
+        }
+
+        size_t entry_count = reader.ReadCount();
+        msg.tensor_rdma_metas.reserve(entry_count);
+        for (size_t i = 0; i < entry_count; ++i) {
+            ShardedKey key = DecodeBinaryShardedKey(reader, strings);
+            TensorMemoryRDMAInfo info;
+            info.addr = reinterpret_cast<void*>(static_cast<uintptr_t>(reader.ReadVarint()));
+            info.size = reader.ReadVarint();
+            if (info.size == 0) {
+                throw std::runtime_error("Invalid memory size: 0");
+            }
+            uint64_t rkey_index = reader.ReadVarint();
+            if (rkey_index >= strings.size()) {
+                throw std::runtime_error("Invalid rkey index: " + std::to_string(rkey_index));
+            }
+            info.rkey = std::string(strings[rkey_index]);
+            DecodeBinary(reader, info.atensor_meta);
+            msg.tensor_rdma_metas.emplace(std::move(key), std::move(info));
+        }
+
+        if (version >= 2) {
+            msg.version = reader.ReadVarint();
+            msg.base_version = reader.ReadVarint();
+            msg.removed_keys.resize(reader.ReadCount(2));
+            for (auto& key : msg.removed_keys) {
+                key = DecodeBinaryShardedKey(reader, strings);
+            }
+        }
+        return msg;
+    } catch (const std::exception& e) {
+        SPDLOG_ERROR("Failed to decode binary TensorRDMAMetaPublishMessage: {}", e.what());
+        throw;
+    }
+}
+
+std::string EncodeBinary(const ControlRelayMessage& msg) {
+    size_t payload_size = 0;
+    for (const auto& [request, payload] : msg.messages) {
+        payload_size += request.size() + payload.size() + 2 * sizeof(uint64_t);
+    }
+    BinaryWriter writer(payload_size + kBinaryMetaEntryReserveSize);
+    uint32_t magic = kBinaryMessageMagic;
+    writer.WriteRaw(&magic, sizeof(magic));
+    writer.WriteU8(kBinaryMessageVersion);
+    writer.WriteSignedVarint(msg.seq_id);
+    EncodeBinary(writer, msg.node_info);
+    writer.WriteU8(static_cast<uint8_t>(msg.hop));
+    writer.WriteVarint(msg.messages.size());
+    for (const auto& [request, payload] : msg.messages) {
+        writer.WriteString(request);
+        writer.WriteString(payload);
+    }
+    return writer.Release();
+}
+
+ControlRelayMessage DecodeBinary(const void* data, size_t size, const ControlRelayMessage&) {
+    try {
+        if (!IsBinaryMessage(data, size)) {
+            throw std::runtime_error("Invalid binary message magic");
+        }
+        BinaryReader reader(data, size);
+        uint32_t magic = 0;
+        reader.ReadRaw(&magic, sizeof(magic));
+        uint8_t version = reader.ReadU8();
+        if (version == 0 || version > kBinaryMessageVersion) {
+            throw std::runtime_error("Unsupported binary message version: " + std::to_string(version));
+        }
+
+        ControlRelayMessage msg;
+        msg.seq_id = reader.ReadSignedVarint();
+        msg.node_info = DecodeBinaryNodeInfo(reader);
+        uint8_t hop = reader.ReadU8();
+        if (hop > static_cast<uint8_t>(ControlRelayMessage::Hop::FORWARD_FAILED)) {
+            throw std::runtime_error("Invalid relay hop: " + std::to_string(hop));
+        }
+        msg.hop = static_cast<ControlRelayMessage::Hop>(hop);
+        // every message takes at least two bytes (two string lengths)
+        msg.messages.resize(reader.ReadCount(2));
+        for (auto& [request, payload] : msg.messages) {
+            request = std::string(reader.ReadString());
+            payload = std::string(reader.ReadString());
+        }
+        return msg;
+    } catch (const std::exception& e) {
+        SPDLOG_ERROR("Failed to decode binary ControlRelayMessage: {}", e.what());
+        throw;
+    }
+}
+
 // WeightReadyMessage 序列化
 Json::Value ToJson(const WeightReadyMessage& msg) {
     try {
@@ -435,6 +723,204 @@ WeightConsumedMessage FromJson(const Json::Value& root, const WeightConsumedMess
     }
 }
 
+// 订阅区域
+void MetaInterest::Merge(const ShardedKey& shard_key, const ATensor& shard) {
+    bool known_region = shard.size != nullptr && shard.dim_num > 0
+        && static_cast<size_t>(shard.dim_num) == shard_key.global_offset.size();
+    if (key.empty()) {
+        key = shard_key.key;
+        if (known_region) {
+            offset_begin = shard_key.global_offset;
+            offset_end = shard_key.global_offset;
+            for (int32_t i = 0; i < shard.dim_num; ++i) {
+                offset_end[i] += shard.size[i];
+            }
+        }
+        return;
+    }
+    if (offset_begin.empty()) {
+        // Already the whole tensor
+        return;
+    }
+    if (!known_region || offset_begin.size() != shard_key.global_offset.size()) {
+        offset_begin.clear();
+        offset_end.clear();
+        return;
+    }
+    for (int32_t i = 0; i < shard.dim_num; ++i) {
+        offset_begin[i] = std::min(offset_begin[i], shard_key.global_offset[i]);
+        offset_end[i] = std::max(offset_end[i], shard_key.global_offset[i] + shard.size[i]);
+    }
+}
+
+bool MetaInterest::Intersects(const ShardedKey& shard_key, const ATensor& shard) const {
+    if (shard_key.key != key) {
+        return false;
+    }
+    if (offset_begin.empty() || shard.size == nullptr || shard.dim_num < 0
+        || static_cast<size_t>(shard.dim_num) != offset_begin.size()
+        || shard_key.global_offset.size() != offset_begin.size()) {
+        return true;
+    }
+    for (size_t i = 0; i < offset_begin.size(); ++i) {
+        if (shard_key.global_offset[i] >= offset_end[i]
+            || shard_key.global_offset[i] + shard.size[i] <= offset_begin[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TensorRDMAMetaPublishMessage
+FilterByInterests(const TensorRDMAMetaPublishMessage& msg, const std::vector<MetaInterest>& interests) {
+    std::unordered_map<std::string_view, std::vector<const MetaInterest*>> interests_by_key;
+    for (const auto& interest : interests) {
+        interests_by_key[interest.key].push_back(&interest);
+    }
+
+    TensorRDMAMetaPublishMessage filtered;
+    filtered.seq_id = msg.seq_id;
+    filtered.node_info = msg.node_info;
+    filtered.version = msg.version;
+    filtered.base_version = msg.base_version;
+    for (const auto& [shard_key, info] : msg.tensor_rdma_metas) {
+        auto it = interests_by_key.find(shard_key.key);
+        if (it != interests_by_key.end()
+            && std::any_of(it->second.begin(), it->second.end(), [&](const MetaInterest* interest) {
+                   return interest->Intersects(shard_key, info.atensor_meta);
+               })) {
+            filtered.tensor_rdma_metas.emplace(shard_key, info);
+        }
+    }
+    for (const auto& shard_key : msg.removed_keys) {
+        if (interests_by_key.count(shard_key.key) != 0) {
+            filtered.removed_keys.push_back(shard_key);
+        }
+    }
+    return filtered;
+}
+
+Json::Value ToJson(const MetaInterest& interest) {
+    try {
+        Json::Value root;
+        root["key"] = interest.key;
+        Json::Value begin_array(Json::arrayValue);
+        for (const auto& dim : interest.offset_begin) {
+            begin_array.append(Json::Value::Int64(dim));
+        }
+        root["offset_begin"] = begin_array;
+        Json::Value end_array(Json::arrayValue);
+        for (const auto& dim : interest.offset_end) {
+            end_array.append(Json::Value::Int64(dim));
+        }
+        root["offset_end"] = end_array;
+        return root;
+    } catch (const std::exception& e) {
+        SPDLOG_ERROR("Failed to serialize MetaInterest: {}", e.what());
+        throw;
+    }
+}
+
+MetaInterest FromJson(const Json::Value& root, const MetaInterest&) {
+    try {
+        checkRequiredField(root, "key");
+        checkRequiredField(root, "offset_begin");
+        checkRequiredField(root, "offset_end");
+
+        checkFieldType(root, "key", Json::stringValue);
+        checkFieldType(root, "offset_begin", Json::arrayValue);
+        checkFieldType(root, "offset_end", Json::arrayValue);
+
+        MetaInterest interest;
+        interest.key = root["key"].asString();
+        for (const auto& dim : root["offset_begin"]) {
+            interest.offset_begin.push_back(dim.asInt64());
+        }
+        for (const auto& dim : root["offset_end"]) {
+            interest.offset_end.push_back(dim.asInt64());
+        }
+        if (interest.offset_begin.size() != interest.offset_end.size()) {
+            throw std::runtime_error("Offset range dimensions do not match");
+        }
+        return interest;
+    } catch (const std::exception& e) {
+        SPDLOG_ERROR("Failed to deserialize MetaInterest: {}", e.what());
+        throw;
+    }
+}
+
+// MetaSubscriptionMessage 序列化
+Json::Value ToJson(const MetaSubscriptionMessage& msg) {
+    try {
+        Json::Value root;
+        root["seq_id"] = Json::Value::Int64(msg.seq_id);
+        root["node_info"] = toJson(msg.node_info);
+        Json::Value interests(Json::arrayValue);
+        for (const auto& interest : msg.interests) {
+            interests.append(ToJson(interest));
+        }
+        root["interests"] = interests;
+        return root;
+    } catch (const std::exception& e) {
+        SPDLOG_ERROR("Failed to serialize MetaSubscriptionMessage: {}", e.what());
+        throw;
+    }
+}
+
+MetaSubscriptionMessage FromJson(const Json::Value& root, const MetaSubscriptionMessage&) {
+    try {
+        checkRequiredField(root, "seq_id");
+        checkRequiredField(root, "node_info");
+        checkRequiredField(root, "interests");
+
+        checkFieldType(root, "seq_id", Json::intValue);
+        checkFieldType(root, "node_info", Json::objectValue);
+        checkFieldType(root, "interests", Json::arrayValue);
+
+        MetaSubscriptionMessage msg;
+        msg.seq_id = root["seq_id"].asInt64();
+        msg.node_info = fromJson(root["node_info"], NodeInfo{});
+        for (const auto& interest : root["interests"]) {
+            msg.interests.push_back(FromJson(interest, MetaInterest{}));
+        }
+        return msg;
+    } catch (const std::exception& e) {
+        SPDLOG_ERROR("Failed to deserialize MetaSubscriptionMessage: {}", e.what());
+        throw;
+    }
+}
+
+// MetaResyncMessage 序列化
+Json::Value ToJson(const MetaResyncMessage& msg) {
+    try {
+        Json::Value root;
+        root["seq_id"] = Json::Value::Int64(msg.seq_id);
+        root["node_info"] = toJson(msg.node_info);
+        return root;
+    } catch (const std::exception& e) {
+        SPDLOG_ERROR("Failed to serialize MetaResyncMessage: {}", e.what());
+        throw;
+    }
+}
+
+MetaResyncMessage FromJson(const Json::Value& root, const MetaResyncMessage&) {
+    try {
+        checkRequiredField(root, "seq_id");
+        checkRequiredField(root, "node_info");
+
+        checkFieldType(root, "seq_id", Json::intValue);
+        checkFieldType(root, "node_info", Json::objectValue);
+
+        MetaResyncMessage msg;
+        msg.seq_id = root["seq_id"].asInt64();
+        msg.node_info = fromJson(root["node_info"], NodeInfo{});
+        return msg;
+    } catch (const std::exception& e) {
+        SPDLOG_ERROR("Failed to deserialize MetaResyncMessage: {}", e.what());
+        throw;
+    }
+}
+
 // 通用序列化/反序列化函数
 std::string Serialize(const Json::Value& json) {
     Json::StreamWriterBuilder writer;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -108,7 +110,15 @@ struct TensorMemoryRDMAInfo {
 struct TensorRDMAMetaPublishMessage {
     int64_t seq_id;
     NodeInfo node_info;
+    // Initial publish (base_version 0): every shard of the sender.
+    // Diff (base_version > 0): added or relocated shards only, dropped ones are in removed_keys.
     std::unordered_map<ShardedKey, TensorMemoryRDMAInfo, ShardedKeyHash> tensor_rdma_metas{};
+    // Meta version of the sender once this message is applied
+    uint64_t version{0};
+    uint64_t base_version{0};
+    std::vector<ShardedKey> removed_keys{};
+
+    [[nodiscard]] bool IsDiff() const { return base_version > 0; }
 };
 
 struct WeightReadyMessage {
@@ -122,6 +132,71 @@ struct WeightConsumedMessage {
     NodeInfo node_info;
 };
 
+// Global region of a tensor a receiver reads: [offset_begin, offset_end) per dim, empty ranges cover the whole tensor
+struct MetaInterest {
+    std::string key;
+    std::vector<int64_t> offset_begin{};
+    std::vector<int64_t> offset_end{};
+
+    // Widen the region so that it also covers the shard
+    void Merge(const ShardedKey& shard_key, const ATensor& shard);
+
+    [[nodiscard]] bool Intersects(const ShardedKey& shard_key, const ATensor& shard) const;
+};
+
+// 读端订阅消息, 写端此后只发送与之相交的分片元信息
+struct MetaSubscriptionMessage {
+    int64_t seq_id{};
+    NodeInfo node_info;
+    std::vector<MetaInterest> interests{};
+};
+
+// 读端从快照恢复元信息后请求写端重发全量元信息
+struct MetaResyncMessage {
+    int64_t seq_id{};
+    NodeInfo node_info;
+};
+
+// Keep the metas intersecting one of the interests, removed keys are kept by tensor name as their shape is gone
+TensorRDMAMetaPublishMessage
+FilterByInterests(const TensorRDMAMetaPublishMessage& msg, const std::vector<MetaInterest>& interests);
+
+// Control messages of one step bundled along the aggregation tree (see transfer/control_tree.h)
+struct ControlRelayMessage {
+    enum class Hop : uint8_t {
+        TO_LEADER = 0, // member -> own leader
+        TO_PEER_LEADER = 1, // leader -> leaders of the peer role
+        TO_MEMBER = 2, // peer leader -> its members
+        FORWARDED = 3, // leader -> member: its messages reached the peer leaders, no messages
+        FORWARD_FAILED = 4, // leader -> member: forwarding failed, the member sends its messages itself
+    };
+
+    int64_t seq_id{};
+    NodeInfo node_info; // sender of this hop
+    Hop hop{Hop::TO_LEADER};
+    // (request name, encoded message) in the order they are handled
+    std::vector<std::pair<std::string, std::string>> messages{};
+};
+
+// Compact binary encoding of TensorRDMAMetaPublishMessage, JSON stays available for debugging.
+// Layout (varints unless noted):
+//   magic(4 bytes) version(1 byte) seq_id node_info
+//   string table: count, strings  -- tensor names and rkeys, each sent once
+//   entries: count, { key_idx shape[] offset[] addr size rkey_idx tensor_meta }
+//   since v2: version base_version removed_keys: count, { key_idx shape[] offset[] }
+constexpr uint32_t kBinaryMessageMagic = 0x424D5341; // "ASMB"
+constexpr uint8_t kBinaryMessageVersion = 2;
+
+// Whether a control message is binary encoded, JSON ones start with '{'
+bool IsBinaryMessage(const void* data, size_t size);
+
+std::string EncodeBinary(const TensorRDMAMetaPublishMessage& msg);
+TensorRDMAMetaPublishMessage DecodeBinary(const void* data, size_t size, const TensorRDMAMetaPublishMessage&);
+
+// Layout: magic(4 bytes) version(1 byte) seq_id node_info hop(1 byte) messages: count, { request payload }
+std::string EncodeBinary(const ControlRelayMessage& msg);
+ControlRelayMessage DecodeBinary(const void* data, size_t size, const ControlRelayMessage&);
+
 // 辅助函数声明
 void CheckRequiredField(const Json::Value& root, const std::string& field);
 void CheckFieldType(const Json::Value& root, const std::string& field, Json::ValueType type);
@@ -146,6 +221,9 @@ Json::Value ToJson(const ShardedKey& key);
 Json::Value ToJson(const TensorRDMAMetaPublishMessage& msg);
 Json::Value ToJson(const WeightReadyMessage& msg);
 Json::Value ToJson(const WeightConsumedMessage& msg);
+Json::Value ToJson(const MetaInterest& interest);
+Json::Value ToJson(const MetaSubscriptionMessage& msg);
+Json::Value ToJson(const MetaResyncMessage& msg);
 
 // 反序列化函数声明
 NodeInfo FromJson(const Json::Value& root, const NodeInfo&);
@@ -154,5 +232,8 @@ ShardedKey FromJson(const Json::Value& root, const ShardedKey&);
 TensorRDMAMetaPublishMessage FromJson(const Json::Value& root, const TensorRDMAMetaPublishMessage&);
 WeightReadyMessage FromJson(const Json::Value& root, const WeightReadyMessage&);
 WeightConsumedMessage FromJson(const Json::Value& root, const WeightConsumedMessage&);
+MetaInterest FromJson(const Json::Value& root, const MetaInterest&);
+MetaSubscriptionMessage FromJson(const Json::Value& root, const MetaSubscriptionMessage&);
+MetaResyncMessage FromJson(const Json::Value& root, const MetaResyncMessage&);
 
 } // namespace astate
@@ -0,0 +1,41 @@
+#include "transport/brpc_transport.h"
+
+#include <string>
+
+#include <brpc/channel.h>
+#include <brpc/controller.h>
+#include <gtest/gtest.h>
+
+#include "common/metric_utils.h"
+#include "common/option.h"
+
+namespace astate {
+// 测试 brpc 服务端通过 HTTP 的 GET /metrics 暴露进程指标
+TEST(BrpcTransportTest, ServesMetricsOverHttp) {
+    GetMetricsRegistry().GetCounter(kPeerReadBytes, "brpc-metrics-test:1").Add(42);
+
+    Options options;
+    options[TRANSFER_ENGINE_SERVICE_FIXED_PORT] = "false";
+    BrpcTransport transport;
+    ASSERT_TRUE(transport.Start(options));
+
+    brpc::ChannelOptions channel_options;
+    channel_options.protocol = brpc::PROTOCOL_HTTP;
+    channel_options.timeout_ms = 5000;
+    brpc::Channel channel;
+    std::string server_addr = "127.0.0.1:" + std::to_string(transport.GetBindPort());
+    ASSERT_EQ(channel.Init(server_addr.c_str(), &channel_options), 0);
+
+    brpc::Controller cntl;
+    cntl.http_request().uri() = "/metrics";
+    channel.CallMethod(nullptr, &cntl, nullptr, nullptr, nullptr);
+    ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+    EXPECT_EQ(cntl.http_response().status_code(), 200);
+    EXPECT_EQ(cntl.http_response().content_type().rfind("text/plain", 0), 0);
+
+    std::string body = cntl.response_attachment().to_string();
+    EXPECT_NE(body.find(R"(astate_peer_read_bytes_total{peer="brpc-metrics-test:1"} 42)"), std::string::npos) << body;
+
+    transport.Stop();
+}
+} // namespace astate
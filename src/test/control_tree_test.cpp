@@ -0,0 +1,111 @@
+#include "transfer/control_tree.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "protocol/messages.h"
+
+namespace astate {
+class ControlTreeTest : public ::testing::Test {
+ public:
+    void SetUp() override {
+        // 训练端两台机器, 每台两个进程; 推理端三台机器, 每台一个进程
+        trainers_ = {
+            NodeInfo{"10.0.0.2", 51011, 52011},
+            NodeInfo{"10.0.0.1", 51011, 52011},
+            NodeInfo{"10.0.0.1", 51010, 52010},
+            NodeInfo{"10.0.0.2", 51010, 52010},
+        };
+        inferers_ = {
+            NodeInfo{"10.0.1.3", 51010, 52010},
+            NodeInfo{"10.0.1.1", 51010, 52010},
+            NodeInfo{"10.0.1.2", 51010, 52010},
+        };
+    }
+
+    std::vector<NodeInfo> trainers_;
+    std::vector<NodeInfo> inferers_;
+};
+
+// 测试按机器分组, 每组最小的节点为 leader
+TEST_F(ControlTreeTest, LeaderPerHost) {
+    ControlTree leader_tree(trainers_[2], trainers_, inferers_);
+    EXPECT_TRUE(leader_tree.IsLeader());
+    EXPECT_EQ(leader_tree.GetLeader(), trainers_[2]);
+    ASSERT_EQ(leader_tree.GetMembers().size(), 2);
+    EXPECT_EQ(leader_tree.GetMembers()[0], trainers_[2]);
+    EXPECT_EQ(leader_tree.GetMembers()[1], trainers_[1]);
+
+    ControlTree member_tree(trainers_[0], trainers_, inferers_);
+    EXPECT_FALSE(member_tree.IsLeader());
+    EXPECT_EQ(member_tree.GetLeader(), trainers_[3]);
+}
+
+// 测试发现列表不包含本节点或有重复节点时的分组
+TEST_F(ControlTreeTest, LocalNodeMissingFromGroup) {
+    std::vector<NodeInfo> others = {trainers_[0], trainers_[0], trainers_[1]};
+    ControlTree tree(trainers_[3], others, inferers_);
+    EXPECT_TRUE(tree.IsLeader());
+    ASSERT_EQ(tree.GetMembers().size(), 2);
+    EXPECT_EQ(tree.GetMembers()[1], trainers_[0]);
+
+    ControlTree alone(NodeInfo{"10.0.0.9", 1, 2}, {}, inferers_);
+    EXPECT_TRUE(alone.IsLeader());
+    EXPECT_EQ(alone.GetMembers().size(), 1);
+}
+
+// 测试对端 leader 与对端分组, 两端推导出的树一致
+TEST_F(ControlTreeTest, PeerLeadersAndGroups) {
+    ControlTree trainer_tree(trainers_[0], trainers_, inferers_);
+    ASSERT_EQ(trainer_tree.GetPeerLeaders().size(), 3);
+    EXPECT_EQ(trainer_tree.GetPeerLeaders()[0], inferers_[1]);
+    EXPECT_EQ(trainer_tree.GetPeerLeaders()[2], inferers_[0]);
+    EXPECT_EQ(trainer_tree.GetPeerGroup(inferers_[2]).size(), 1);
+    EXPECT_TRUE(trainer_tree.GetPeerGroup(NodeInfo{"unknown", 0, 0}).empty());
+
+    ControlTree inferer_tree(inferers_[0], inferers_, trainers_);
+    ASSERT_EQ(inferer_tree.GetPeerLeaders().size(), 2);
+    EXPECT_EQ(inferer_tree.GetPeerLeaders()[0], ControlTree(trainers_[1], trainers_, inferers_).GetLeader());
+    EXPECT_EQ(inferer_tree.GetPeerLeaders()[1], trainer_tree.GetLeader());
+    EXPECT_EQ(inferer_tree.GetPeerGroup(trainer_tree.GetLeader()), trainer_tree.GetMembers());
+}
+
+// 测试聚合消息二进制编码解码, 以及截断与非法 hop 被拒绝
+TEST_F(ControlTreeTest, RelayMessageRoundTrip) {
+    ControlRelayMessage relay;
+    relay.seq_id = 9;
+    relay.node_info = trainers_[2];
+    relay.hop = ControlRelayMessage::Hop::TO_PEER_LEADER;
+    relay.messages.emplace_back("publish_tensor_meta", std::string("\x41\x53\x4d\x42\x00\x01", 6));
+    relay.messages.emplace_back("weight_ready", R"({"seq_id":9})");
+    relay.messages.emplace_back("weight_ready", "");
+
+    auto binary = EncodeBinary(relay);
+    ASSERT_TRUE(IsBinaryMessage(binary.data(), binary.size()));
+    auto decoded = DecodeBinary(binary.data(), binary.size(), ControlRelayMessage{});
+    EXPECT_EQ(decoded.seq_id, 9);
+    EXPECT_EQ(decoded.node_info, relay.node_info);
+    EXPECT_EQ(decoded.hop, ControlRelayMessage::Hop::TO_PEER_LEADER);
+    EXPECT_EQ(decoded.messages, relay.messages);
+
+    for (size_t size : {size_t{0}, size_t{5}, binary.size() / 2, binary.size() - 1}) {
+        EXPECT_THROW(DecodeBinary(binary.data(), size, ControlRelayMessage{}), std::runtime_error);
+    }
+    relay.messages.clear();
+    // 转发结果不带消息
+    relay.hop = ControlRelayMessage::Hop::FORWARD_FAILED;
+    auto result = EncodeBinary(relay);
+    decoded = DecodeBinary(result.data(), result.size(), ControlRelayMessage{});
+    EXPECT_EQ(decoded.hop, ControlRelayMessage::Hop::FORWARD_FAILED);
+    EXPECT_TRUE(decoded.messages.empty());
+
+    auto empty = EncodeBinary(relay);
+    // 空消息列表时 hop 位于倒数第二个字节
+    empty[empty.size() - 2] = static_cast<char>(7);
+    EXPECT_THROW(DecodeBinary(empty.data(), empty.size(), ControlRelayMessage{}), std::runtime_error);
+}
+
+} // namespace astate
@@ -8,6 +8,7 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -363,4 +364,88 @@ TEST_F(HTTPTransporterTest, ServerRestart) {
     WaitForServerReady();
     EXPECT_TRUE(server_transporter_->IsRunning());
 }
+// 测试连续与并发发送复用长连接, 连接数不超过池大小
+TEST_F(HTTPTransporterTest, KeepAliveConnectionReuse) {
+    std::atomic<int> received{0};
+    const std::string test_path = "keep_alive_test";
+    server_transporter_->RegisterHandler(test_path, [&](const std::string&, const void*, size_t) {
+        received++;
+        return ResponseStatus{true, "OK", ExtendInfo{}};
+    });
+    server_options_[TRANSPORT_HTTP_POOL_SIZE] = "2";
+    EXPECT_TRUE(server_transporter_->Start(server_options_));
+    WaitForServerReady();
+
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_TRUE(server_transporter_->Send(test_path, "seq", 3, TEST_HOST, TEST_PORT, nullptr));
+    }
+    EXPECT_EQ(server_transporter_->GetPooledConnectionCount(TEST_HOST, TEST_PORT), 1);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 5; ++j) {
+                EXPECT_TRUE(server_transporter_->Send(test_path, "par", 3, TEST_HOST, TEST_PORT, nullptr));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(received.load(), 60);
+    EXPECT_LE(server_transporter_->GetPooledConnectionCount(TEST_HOST, TEST_PORT), 2);
+}
+
+// 测试对端重启后失效的长连接被替换, 发送仍然成功
+TEST_F(HTTPTransporterTest, ReconnectAfterPeerRestart) {
+    const std::string test_path = "reconnect_test";
+    server_transporter_->RegisterHandler(test_path, [&](const std::string&, const void*, size_t) {
+        return ResponseStatus{true, "OK", ExtendInfo{}};
+    });
+    EXPECT_TRUE(server_transporter_->Start(server_options_));
+    EXPECT_TRUE(client_transporter_->Start(client_options_));
+    WaitForServerReady();
+    EXPECT_TRUE(client_transporter_->Send(test_path, "before", 6, TEST_HOST, TEST_PORT, nullptr));
+    EXPECT_EQ(client_transporter_->GetPooledConnectionCount(TEST_HOST, TEST_PORT), 1);
+
+    server_transporter_->Stop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_TRUE(server_transporter_->Start(server_options_));
+    WaitForServerReady();
+
+    // 发送重试次数为 1, 依靠连接池立即重连
+    EXPECT_TRUE(client_transporter_->Send(test_path, "after", 5, TEST_HOST, TEST_PORT, nullptr));
+    EXPECT_EQ(client_transporter_->GetPooledConnectionCount(TEST_HOST, TEST_PORT), 1);
+}
+
+// 测试连接池上限阻塞与空闲超时关闭
+TEST_F(HTTPTransporterTest, ClientPoolLimitAndIdleTimeout) {
+    HttpClientPool pool(TEST_HOST, TEST_PORT, 1, 50);
+    bool reused = true;
+    auto client = pool.Acquire(reused);
+    EXPECT_FALSE(reused);
+
+    std::atomic<bool> acquired{false};
+    std::thread waiter([&]() {
+        bool waiter_reused = false;
+        auto other = pool.Acquire(waiter_reused);
+        acquired = true;
+        EXPECT_TRUE(waiter_reused);
+        pool.Release(std::move(other), true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(acquired.load());
+    pool.Release(std::move(client), true);
+    waiter.join();
+    EXPECT_TRUE(acquired.load());
+    EXPECT_EQ(pool.GetOpenCount(), 1);
+
+    // 超过空闲时间的连接被关闭, 重新建立
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    client = pool.Acquire(reused);
+    EXPECT_FALSE(reused);
+    EXPECT_EQ(pool.GetOpenCount(), 1);
+    pool.Release(std::move(client), false);
+    EXPECT_EQ(pool.GetOpenCount(), 0);
+}
 } // namespace astate
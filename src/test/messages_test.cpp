@@ -0,0 +1,174 @@
+#include "protocol/messages.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "core/atensor.h"
+#include "core/shardedkey.h"
+
+namespace astate {
+class MessagesTest : public ::testing::Test {
+ public:
+    static constexpr int kNumTensors = 8;
+    static constexpr int kShardsPerTensor = 16;
+
+    void SetUp() override {
+        msg_.seq_id = 42;
+        msg_.node_info = NodeInfo{"10.0.0.1", 51010, 52010};
+        int64_t size[] = {128, 256};
+        int64_t stride[] = {256, 1};
+        for (int t = 0; t < kNumTensors; ++t) {
+            for (int s = 0; s < kShardsPerTensor; ++s) {
+                ShardedKey key{"layers." + std::to_string(t) + ".mlp.weight", {2048, 256}, {s * 128, 0}};
+                ATStorage storage(128 * 256 * 2, nullptr, ATDevice(ATDeviceType::CUDA, static_cast<ATDeviceIndex>(s % 8)));
+                ATensor atensor(size, stride, s * 7, 2, ATDtype::BFloat16, false, s % 2 == 0, storage, true);
+                auto* addr = reinterpret_cast<void*>(0x7f0000000000ULL + (t * kShardsPerTensor + s) * 65536ULL);
+                msg_.tensor_rdma_metas.emplace(
+                    key, TensorMemoryRDMAInfo(addr, 65536, "rkey-" + std::to_string(s % 2), atensor));
+            }
+        }
+    }
+
+    static void ExpectEqual(const TensorRDMAMetaPublishMessage& lhs, const TensorRDMAMetaPublishMessage& rhs) {
+        EXPECT_EQ(lhs.seq_id, rhs.seq_id);
+        EXPECT_EQ(lhs.node_info, rhs.node_info);
+        ASSERT_EQ(lhs.tensor_rdma_metas.size(), rhs.tensor_rdma_metas.size());
+        for (const auto& [key, info] : lhs.tensor_rdma_metas) {
+            auto it = rhs.tensor_rdma_metas.find(key);
+            ASSERT_NE(it, rhs.tensor_rdma_metas.end());
+            EXPECT_EQ(info.addr, it->second.addr);
+            EXPECT_EQ(info.size, it->second.size);
+            EXPECT_EQ(info.rkey, it->second.rkey);
+            const auto& a = info.atensor_meta;
+            const auto& b = it->second.atensor_meta;
+            EXPECT_EQ(a.storage_offset, b.storage_offset);
+            ASSERT_EQ(a.dim_num, b.dim_num);
+            EXPECT_EQ(a.dtype, b.dtype);
+            EXPECT_EQ(a.conj, b.conj);
+            EXPECT_EQ(a.neg, b.neg);
+            EXPECT_EQ(a.requires_grad, b.requires_grad);
+            for (int32_t i = 0; i < a.dim_num; ++i) {
+                EXPECT_EQ(a.size[i], b.size[i]);
+                EXPECT_EQ(a.stride[i], b.stride[i]);
+            }
+            EXPECT_EQ(a.storage.storage_size, b.storage.storage_size);
+            EXPECT_EQ(a.storage.device.device_type, b.storage.device.device_type);
+            EXPECT_EQ(a.storage.device.device_index, b.storage.device.device_index);
+        }
+    }
+
+    TensorRDMAMetaPublishMessage msg_;
+};
+
+// 测试二进制编码与 JSON 编码解码结果一致
+TEST_F(MessagesTest, BinaryRoundTrip) {
+    auto binary = EncodeBinary(msg_);
+    ASSERT_TRUE(IsBinaryMessage(binary.data(), binary.size()));
+    auto decoded = DecodeBinary(binary.data(), binary.size(), TensorRDMAMetaPublishMessage{});
+    ExpectEqual(msg_, decoded);
+
+    auto json = Serialize(ToJson(msg_));
+    EXPECT_FALSE(IsBinaryMessage(json.data(), json.size()));
+    ExpectEqual(decoded, FromJson(Deserialize(json), TensorRDMAMetaPublishMessage{}));
+    // 名字与 rkey 只发送一次, 体积应远小于 JSON
+    EXPECT_LT(binary.size() * 5, json.size());
+}
+
+// 测试空消息与负数字段
+TEST_F(MessagesTest, EmptyAndNegativeValues) {
+    TensorRDMAMetaPublishMessage empty;
+    empty.seq_id = -1;
+    empty.node_info = NodeInfo{"host", 1, 2};
+    auto binary = EncodeBinary(empty);
+    auto decoded = DecodeBinary(binary.data(), binary.size(), TensorRDMAMetaPublishMessage{});
+    EXPECT_EQ(decoded.seq_id, -1);
+    EXPECT_TRUE(decoded.tensor_rdma_metas.empty());
+
+    TensorRDMAMetaPublishMessage scalar = empty;
+    ATensor atensor;
+    atensor.storage_offset = -3;
+    atensor.storage = ATStorage(4, nullptr, ATDevice(ATDeviceType::CPU, -1));
+    scalar.tensor_rdma_metas.emplace(
+        ShardedKey{"scalar", {}, {}}, TensorMemoryRDMAInfo(reinterpret_cast<void*>(0x1000), 4, "", atensor));
+    binary = EncodeBinary(scalar);
+    decoded = DecodeBinary(binary.data(), binary.size(), TensorRDMAMetaPublishMessage{});
+    ExpectEqual(scalar, decoded);
+}
+
+// 测试增量消息的版本号与删除列表在两种编码下都能还原
+TEST_F(MessagesTest, DiffRoundTrip) {
+    msg_.version = 7;
+    msg_.base_version = 6;
+    msg_.removed_keys.push_back(ShardedKey{"layers.0.mlp.weight", {2048, 256}, {0, 0}});
+    msg_.removed_keys.push_back(ShardedKey{"removed.only", {4}, {2}});
+    ASSERT_TRUE(msg_.IsDiff());
+
+    auto binary = EncodeBinary(msg_);
+    auto from_binary = DecodeBinary(binary.data(), binary.size(), TensorRDMAMetaPublishMessage{});
+    auto from_json = FromJson(Deserialize(Serialize(ToJson(msg_))), TensorRDMAMetaPublishMessage{});
+    for (const auto* decoded : {&from_binary, &from_json}) {
+        ExpectEqual(msg_, *decoded);
+        EXPECT_EQ(decoded->version, 7);
+        EXPECT_EQ(decoded->base_version, 6);
+        EXPECT_EQ(decoded->removed_keys, msg_.removed_keys);
+    }
+
+    // 全量消息 base_version 为 0
+    TensorRDMAMetaPublishMessage full;
+    full.version = 1;
+    binary = EncodeBinary(full);
+    EXPECT_FALSE(DecodeBinary(binary.data(), binary.size(), TensorRDMAMetaPublishMessage{}).IsDiff());
+}
+
+// 测试按订阅区域过滤元信息
+TEST_F(MessagesTest, FilterByInterests) {
+    // 读端读取 layers.1 的第 2, 3 个分片, 区域合并为行 [256, 512)
+    MetaInterest interest;
+    for (int s : {2, 3}) {
+        ShardedKey key{"layers.1.mlp.weight", {2048, 256}, {s * 128, 0}};
+        interest.Merge(key, msg_.tensor_rdma_metas.at(key).atensor_meta);
+    }
+    EXPECT_EQ(interest.key, "layers.1.mlp.weight");
+    EXPECT_EQ(interest.offset_begin, (std::vector<int64_t>{256, 0}));
+    EXPECT_EQ(interest.offset_end, (std::vector<int64_t>{512, 256}));
+
+    MetaSubscriptionMessage subscription{3, NodeInfo{"10.0.0.2", 51011, 52011}, {interest}};
+    subscription.interests.push_back(MetaInterest{"layers.5.mlp.weight", {}, {}});
+    auto decoded = FromJson(Deserialize(Serialize(ToJson(subscription))), MetaSubscriptionMessage{});
+    ASSERT_EQ(decoded.interests.size(), 2);
+    EXPECT_EQ(decoded.node_info, subscription.node_info);
+    EXPECT_EQ(decoded.interests[0].offset_end, interest.offset_end);
+
+    msg_.version = 3;
+    msg_.base_version = 2;
+    msg_.removed_keys = {ShardedKey{"layers.1.mlp.weight", {2048, 256}, {0, 0}}, ShardedKey{"other", {1}, {0}}};
+    auto filtered = FilterByInterests(msg_, decoded.interests);
+    // layers.1 的两个分片加上 layers.5 的全部分片
+    EXPECT_EQ(filtered.tensor_rdma_metas.size(), 2 + kShardsPerTensor);
+    for (const auto& [key, info] : filtered.tensor_rdma_metas) {
+        EXPECT_TRUE(key.key == "layers.5.mlp.weight" || key.global_offset[0] == 256 || key.global_offset[0] == 384);
+    }
+    EXPECT_EQ(filtered.version, 3);
+    EXPECT_EQ(filtered.base_version, 2);
+    ASSERT_EQ(filtered.removed_keys.size(), 1);
+    EXPECT_EQ(filtered.removed_keys[0].key, "layers.1.mlp.weight");
+    EXPECT_TRUE(FilterByInterests(msg_, {}).tensor_rdma_metas.empty());
+}
+
+// 测试截断或损坏的消息被拒绝
+TEST_F(MessagesTest, CorruptedMessage) {
+    auto binary = EncodeBinary(msg_);
+    for (size_t size : {size_t{0}, size_t{4}, binary.size() / 2, binary.size() - 1}) {
+        EXPECT_THROW(DecodeBinary(binary.data(), size, TensorRDMAMetaPublishMessage{}), std::runtime_error);
+    }
+    auto bad_version = binary;
+    bad_version[4] = static_cast<char>(kBinaryMessageVersion + 1);
+    EXPECT_THROW(
+        DecodeBinary(bad_version.data(), bad_version.size(), TensorRDMAMetaPublishMessage{}), std::runtime_error);
+}
+
+} // namespace astate
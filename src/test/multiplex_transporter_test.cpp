@@ -0,0 +1,240 @@
+#include "transport/multiplex_transporter.h"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+
+#include "common/metric_utils.h"
+#include "common/option.h"
+#include "transport/tcp_transporter.h"
+
+namespace astate {
+class MultiplexTransporterTest : public ::testing::Test {
+ public:
+    static constexpr size_t kBufferSize = 4 * 1024 * 1024;
+    static constexpr const char* kLocalHost = "127.0.0.1";
+    static constexpr int kTcpPortOffset = 3000;
+
+    void SetUp() override {
+        // 测试环境没有 RDMA 设备, 只启用 SHM 与 TCP
+        options_[TRANSFER_ENGINE_AUTO_BACKENDS] = "shm,tcp";
+        options_[TRANSFER_ENGINE_LOCAL_ADDRESS] = kLocalHost;
+        options_[TRANSFER_ENGINE_TCP_CHUNK_SIZE] = std::to_string(1024 * 1024);
+
+        server_buffer_.resize(kBufferSize);
+        for (size_t i = 0; i < server_buffer_.size(); ++i) {
+            server_buffer_[i] = static_cast<char>(i * 31 + 7);
+        }
+    }
+
+    std::unique_ptr<MultiplexTransporter> StartTransporter(const std::string& backends) {
+        Options options = options_;
+        options[TRANSFER_ENGINE_AUTO_BACKENDS] = backends;
+        auto transporter = std::make_unique<MultiplexTransporter>();
+        EXPECT_TRUE(transporter->Start(options, parallel_config_));
+        return transporter;
+    }
+
+    Options options_;
+    AParallelConfig parallel_config_;
+    std::vector<char> server_buffer_;
+};
+
+// 测试启动后端口分配与后端状态
+TEST_F(MultiplexTransporterTest, BasicStartStop) {
+    auto server = StartTransporter("shm,tcp");
+    auto client = StartTransporter("shm,tcp");
+    EXPECT_TRUE(server->IsRunning());
+    EXPECT_NE(server->GetBindPort(), client->GetBindPort());
+    EXPECT_TRUE(server->IsBackendRunning(TransportType::SHM));
+    EXPECT_TRUE(server->IsBackendRunning(TransportType::TCP));
+    EXPECT_FALSE(server->IsBackendRunning(TransportType::RDMA));
+    EXPECT_EQ(server->GetLocalServerName(), kLocalHost);
+
+    server->Stop();
+    client->Stop();
+    EXPECT_FALSE(server->IsRunning());
+
+    MultiplexTransporter empty;
+    Options options = options_;
+    options[TRANSFER_ENGINE_AUTO_BACKENDS] = "shm";
+    EXPECT_FALSE(empty.Start(options, parallel_config_));
+}
+
+// 测试同机对端走 SHM
+TEST_F(MultiplexTransporterTest, LocalPeerUsesShm) {
+    auto server = StartTransporter("shm,tcp");
+    auto client = StartTransporter("shm,tcp");
+    ASSERT_TRUE(server->RegisterMemory(server_buffer_.data(), server_buffer_.size()));
+
+    std::vector<char> local(kBufferSize, 0);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    EXPECT_EQ(client->GetPeerTransportType(kLocalHost, server->GetBindPort()), TransportType::UNKNOWN);
+    EXPECT_TRUE(client->Receive(local.data(), local.size(), kLocalHost, server->GetBindPort(), &extend_info));
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+    EXPECT_EQ(client->GetPeerTransportType(kLocalHost, server->GetBindPort()), TransportType::SHM);
+
+    auto routes = client->GetPeerRoutes();
+    ASSERT_EQ(routes.size(), 1);
+    EXPECT_EQ(routes.begin()->second, TransportType::SHM);
+    MetricGauge& route_gauge = GetMetricsRegistry().GetGauge(kPeerRoute, routes.begin()->first);
+    EXPECT_EQ(route_gauge.Value(), static_cast<int64_t>(TransportType::SHM));
+    client->Stop();
+    EXPECT_EQ(route_gauge.Value(), 0);
+    server->Stop();
+}
+
+// 测试对端未开启 SHM 时走 TCP, 批量提交同样生效
+TEST_F(MultiplexTransporterTest, PeerWithoutShmUsesTcp) {
+    auto server = StartTransporter("tcp");
+    auto client = StartTransporter("shm,tcp");
+    ASSERT_TRUE(server->RegisterMemory(server_buffer_.data(), server_buffer_.size()));
+
+    constexpr size_t kNumRequests = 64;
+    constexpr size_t kChunk = kBufferSize / kNumRequests;
+    std::vector<char> local(kBufferSize, 0);
+    std::vector<TransferRequest> requests(kNumRequests);
+    for (size_t i = 0; i < kNumRequests; ++i) {
+        requests[i].opcode = TransferRequest::OpCode::READ;
+        requests[i].local_mem_addr = local.data() + i * kChunk;
+        requests[i].remote_mem_addr = reinterpret_cast<uint64_t>(server_buffer_.data() + i * kChunk);
+        requests[i].length = kChunk;
+        requests[i].remote_net_addr = {kLocalHost, server->GetBindPort()};
+    }
+
+    TransferCompletionQueue completion_queue(requests.size());
+    client->SubmitBatch(requests, completion_queue);
+    std::vector<bool> completed(kNumRequests, false);
+    for (size_t i = 0; i < kNumRequests; ++i) {
+        auto completion = completion_queue.Pop();
+        EXPECT_TRUE(completion.success);
+        ASSERT_LT(completion.request_index, kNumRequests);
+        EXPECT_FALSE(completed[completion.request_index]);
+        completed[completion.request_index] = true;
+    }
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+    EXPECT_EQ(client->GetPeerTransportType(kLocalHost, server->GetBindPort()), TransportType::TCP);
+    client->Stop();
+    server->Stop();
+}
+
+// 测试一个批次同时走 SHM 与 TCP 两个后端
+TEST_F(MultiplexTransporterTest, BatchAcrossBackends) {
+    auto shm_server = StartTransporter("shm,tcp");
+    auto tcp_server = StartTransporter("tcp");
+    auto client = StartTransporter("shm,tcp");
+    ASSERT_TRUE(shm_server->RegisterMemory(server_buffer_.data(), server_buffer_.size()));
+    ASSERT_TRUE(tcp_server->RegisterMemory(server_buffer_.data(), server_buffer_.size()));
+
+    constexpr size_t kNumRequests = 64;
+    constexpr size_t kChunk = kBufferSize / kNumRequests;
+    std::vector<char> local(2 * kBufferSize, 0);
+    std::vector<TransferRequest> requests(2 * kNumRequests);
+    for (size_t i = 0; i < requests.size(); ++i) {
+        // 偶数请求读 SHM 对端, 奇数请求读 TCP 对端
+        auto& server = (i % 2 == 0) ? shm_server : tcp_server;
+        size_t offset = (i / 2) * kChunk;
+        requests[i].opcode = TransferRequest::OpCode::READ;
+        requests[i].local_mem_addr = local.data() + (i % 2) * kBufferSize + offset;
+        requests[i].remote_mem_addr = reinterpret_cast<uint64_t>(server_buffer_.data() + offset);
+        requests[i].length = kChunk;
+        requests[i].remote_net_addr = {kLocalHost, server->GetBindPort()};
+    }
+
+    TransferCompletionQueue completion_queue(requests.size());
+    client->SubmitBatch(requests, completion_queue);
+    std::vector<bool> completed(requests.size(), false);
+    for (size_t i = 0; i < requests.size(); ++i) {
+        auto completion = completion_queue.Pop();
+        EXPECT_TRUE(completion.success);
+        ASSERT_LT(completion.request_index, requests.size());
+        EXPECT_FALSE(completed[completion.request_index]);
+        completed[completion.request_index] = true;
+    }
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+    EXPECT_EQ(std::memcmp(local.data() + kBufferSize, server_buffer_.data(), kBufferSize), 0);
+    EXPECT_EQ(client->GetPeerTransportType(kLocalHost, shm_server->GetBindPort()), TransportType::SHM);
+    EXPECT_EQ(client->GetPeerTransportType(kLocalHost, tcp_server->GetBindPort()), TransportType::TCP);
+    client->Stop();
+    tcp_server->Stop();
+    shm_server->Stop();
+}
+
+// 测试 SHM 失败后回退到 TCP 并降级路由
+TEST_F(MultiplexTransporterTest, FallbackAndDemote) {
+    int ready_pipe[2];
+    int exit_pipe[2];
+    ASSERT_EQ(pipe(ready_pipe), 0);
+    ASSERT_EQ(pipe(exit_pipe), 0);
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        // 子进程持有同一地址的 server_buffer_, 先经 SHM 提供数据
+        MultiplexTransporter server;
+        Options options = options_;
+        options[TRANSFER_ENGINE_AUTO_BACKENDS] = "shm,tcp";
+        if (!server.Start(options, parallel_config_)
+            || !server.RegisterMemory(server_buffer_.data(), server_buffer_.size())) {
+            _exit(2);
+        }
+        int port = server.GetBindPort();
+        (void)!write(ready_pipe[1], &port, sizeof(port));
+        char byte = 0;
+        (void)!read(exit_pipe[0], &byte, 1);
+        _exit(0);
+    }
+
+    int port = 0;
+    ASSERT_EQ(read(ready_pipe[0], &port, sizeof(port)), static_cast<ssize_t>(sizeof(port)));
+    auto client = StartTransporter("shm,tcp");
+    std::vector<char> local(kBufferSize, 0);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    EXPECT_TRUE(client->Receive(local.data(), local.size(), kLocalHost, port, &extend_info));
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+    EXPECT_EQ(client->GetPeerTransportType(kLocalHost, port), TransportType::SHM);
+
+    // 子进程退出后, 由本进程在同一 TCP 端口上提供新数据
+    char byte = 0;
+    ASSERT_EQ(write(exit_pipe[1], &byte, 1), 1);
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+
+    std::memset(server_buffer_.data(), 'b', server_buffer_.size());
+    TcpTransporter tcp_server;
+    Options options = options_;
+    options[TRANSFER_ENGINE_TCP_PORT] = std::to_string(port + kTcpPortOffset);
+    ASSERT_TRUE(tcp_server.Start(options, parallel_config_));
+    ASSERT_TRUE(tcp_server.RegisterMemory(server_buffer_.data(), server_buffer_.size()));
+
+    EXPECT_TRUE(client->Receive(local.data(), local.size(), kLocalHost, port, &extend_info));
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+    EXPECT_EQ(client->GetPeerTransportType(kLocalHost, port), TransportType::TCP);
+
+    client->Stop();
+    tcp_server.Stop();
+    for (int fd : {ready_pipe[0], ready_pipe[1], exit_pipe[0], exit_pipe[1]}) {
+        close(fd);
+    }
+}
+
+// 测试无法到达的对端与非法参数
+TEST_F(MultiplexTransporterTest, UnreachablePeer) {
+    auto client = StartTransporter("shm,tcp");
+    std::vector<char> local(16, 0);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    EXPECT_FALSE(client->Receive(local.data(), local.size(), kLocalHost, 1, &extend_info));
+    EXPECT_EQ(client->GetPeerTransportType(kLocalHost, 1), TransportType::UNKNOWN);
+    EXPECT_THROW((void)client->Receive(nullptr, 0, kLocalHost, 1, &extend_info), std::invalid_argument);
+    EXPECT_FALSE(client->RegisterMemory(local.data(), local.size(), true, 0));
+    client->Stop();
+}
+
+} // namespace astate
@@ -0,0 +1,244 @@
+#include "transport/shm_transporter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+
+#include "common/option.h"
+
+namespace astate {
+class ShmTransporterTest : public ::testing::Test {
+ public:
+    static constexpr size_t kBufferSize = 16 * 1024 * 1024;
+
+    void SetUp() override {
+        // Lets the forked reader in ReceiveFromAnotherProcess attach under yama
+        options_[TRANSFER_ENGINE_SHM_ALLOW_PTRACE] = "true";
+        server_transporter_ = std::make_unique<ShmTransporter>();
+        client_transporter_ = std::make_unique<ShmTransporter>();
+        ASSERT_TRUE(server_transporter_->Start(options_, parallel_config_));
+        ASSERT_TRUE(client_transporter_->Start(options_, parallel_config_));
+
+        server_buffer_.resize(kBufferSize);
+        for (size_t i = 0; i < server_buffer_.size(); ++i) {
+            server_buffer_[i] = static_cast<char>(i * 31 + 7);
+        }
+        ASSERT_TRUE(server_transporter_->RegisterMemory(server_buffer_.data(), server_buffer_.size()));
+    }
+
+    void TearDown() override {
+        client_transporter_->Stop();
+        server_transporter_->Stop();
+    }
+
+    Options options_;
+    AParallelConfig parallel_config_;
+    std::unique_ptr<ShmTransporter> server_transporter_;
+    std::unique_ptr<ShmTransporter> client_transporter_;
+    std::vector<char> server_buffer_;
+};
+
+// 测试启动后端口分配
+TEST_F(ShmTransporterTest, BasicStartStop) {
+    EXPECT_TRUE(server_transporter_->IsRunning());
+    EXPECT_TRUE(client_transporter_->IsRunning());
+    EXPECT_NE(server_transporter_->GetBindPort(), client_transporter_->GetBindPort());
+
+    server_transporter_->Stop();
+    EXPECT_FALSE(server_transporter_->IsRunning());
+}
+
+// 测试本地对端探测
+TEST_F(ShmTransporterTest, PeerReachable) {
+    EXPECT_TRUE(ShmTransporter::IsLocalHost("127.0.0.1"));
+    EXPECT_TRUE(client_transporter_->IsPeerReachable("localhost", server_transporter_->GetBindPort()));
+    EXPECT_FALSE(client_transporter_->IsPeerReachable("10.255.255.1", server_transporter_->GetBindPort()));
+}
+
+// 测试读写远端内存
+TEST_F(ShmTransporterTest, ReceiveAndSend) {
+    std::vector<char> local(kBufferSize, 0);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+
+    EXPECT_TRUE(client_transporter_->Receive(
+        local.data(), local.size(), "127.0.0.1", server_transporter_->GetBindPort(), &extend_info));
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+
+    std::memset(local.data(), 'a', 4096);
+    EXPECT_TRUE(
+        client_transporter_->Send(local.data(), 4096, "127.0.0.1", server_transporter_->GetBindPort(), &extend_info));
+    EXPECT_EQ(server_buffer_[0], 'a');
+    EXPECT_EQ(server_buffer_[4095], 'a');
+}
+
+// 测试批量提交与完成队列
+TEST_F(ShmTransporterTest, SubmitBatch) {
+    constexpr size_t kNumRequests = 64;
+    constexpr size_t kChunk = kBufferSize / kNumRequests;
+    std::vector<char> local(kBufferSize, 0);
+
+    std::vector<TransferRequest> requests(kNumRequests);
+    for (size_t i = 0; i < kNumRequests; ++i) {
+        requests[i].opcode = TransferRequest::OpCode::READ;
+        requests[i].local_mem_addr = local.data() + i * kChunk;
+        requests[i].remote_mem_addr = reinterpret_cast<uint64_t>(server_buffer_.data() + i * kChunk);
+        requests[i].length = kChunk;
+        requests[i].remote_net_addr = {"127.0.0.1", server_transporter_->GetBindPort()};
+    }
+
+    TransferCompletionQueue completion_queue(requests.size());
+    client_transporter_->SubmitBatch(requests, completion_queue);
+    for (size_t i = 0; i < kNumRequests; ++i) {
+        auto completion = completion_queue.Pop();
+        EXPECT_TRUE(completion.success);
+        EXPECT_LT(completion.request_index, kNumRequests);
+    }
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+}
+
+// 测试批量请求在执行器上并行执行
+TEST_F(ShmTransporterTest, SubmitBatchOnExecutor) {
+    constexpr size_t kNumRequests = 64;
+    constexpr size_t kChunk = kBufferSize / kNumRequests;
+    std::vector<char> local(kBufferSize, 0);
+
+    std::atomic<size_t> executed{0};
+    std::set<std::thread::id> thread_ids;
+    std::mutex thread_ids_mutex;
+    client_transporter_->SetBatchExecutor([&](size_t count, const std::function<void(size_t)>& run) {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t] {
+                for (size_t i = t; i < count; i += 4) {
+                    run(i);
+                    ++executed;
+                }
+                std::lock_guard<std::mutex> lock(thread_ids_mutex);
+                thread_ids.insert(std::this_thread::get_id());
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    });
+
+    std::vector<TransferRequest> requests(kNumRequests);
+    for (size_t i = 0; i < kNumRequests; ++i) {
+        requests[i].opcode = TransferRequest::OpCode::READ;
+        requests[i].local_mem_addr = local.data() + i * kChunk;
+        requests[i].remote_mem_addr = reinterpret_cast<uint64_t>(server_buffer_.data() + i * kChunk);
+        requests[i].length = kChunk;
+        requests[i].remote_net_addr = {"127.0.0.1", server_transporter_->GetBindPort()};
+    }
+
+    TransferCompletionQueue completion_queue(requests.size());
+    client_transporter_->SubmitBatch(requests, completion_queue);
+    for (size_t i = 0; i < kNumRequests; ++i) {
+        EXPECT_TRUE(completion_queue.Pop().success);
+    }
+    EXPECT_EQ(executed, kNumRequests);
+    EXPECT_EQ(thread_ids.size(), 4);
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+}
+
+// 测试跨进程读取
+TEST_F(ShmTransporterTest, ReceiveFromAnotherProcess) {
+    int server_port = server_transporter_->GetBindPort();
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        ShmTransporter reader;
+        Options options;
+        if (!reader.Start(options, AParallelConfig{})) {
+            _exit(2);
+        }
+        std::vector<char> local(kBufferSize, 0);
+        ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+        bool ok = reader.Receive(local.data(), local.size(), "127.0.0.1", server_port, &extend_info);
+        reader.Stop();
+        _exit(ok && std::memcmp(local.data(), server_buffer_.data(), kBufferSize) == 0 ? 0 : 1);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+// 测试未注册内存拒绝访问
+TEST_F(ShmTransporterTest, RejectUnregisteredMemory) {
+    int server_port = server_transporter_->GetBindPort();
+    std::vector<char> local(kBufferSize, 0);
+    std::vector<char> unregistered(4096, 'x');
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(unregistered.data());
+    EXPECT_FALSE(client_transporter_->Receive(local.data(), unregistered.size(), "127.0.0.1", server_port, &extend_info));
+
+    // overruns the end of the registered buffer
+    extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data() + 1);
+    EXPECT_FALSE(client_transporter_->Receive(local.data(), kBufferSize, "127.0.0.1", server_port, &extend_info));
+
+    ASSERT_TRUE(server_transporter_->DeregisterMemory(server_buffer_.data(), server_buffer_.size()));
+    extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    EXPECT_FALSE(client_transporter_->Receive(local.data(), 4096, "127.0.0.1", server_port, &extend_info));
+}
+
+// 测试连接之后注册的内存对读端立即可见
+TEST_F(ShmTransporterTest, RegionsRegisteredAfterConnect) {
+    int server_port = server_transporter_->GetBindPort();
+    ASSERT_TRUE(client_transporter_->IsPeerReachable("127.0.0.1", server_port));
+
+    std::vector<char> late(4096, 'z');
+    std::vector<char> local(late.size(), 0);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(late.data());
+    EXPECT_FALSE(client_transporter_->Receive(local.data(), local.size(), "127.0.0.1", server_port, &extend_info));
+
+    ASSERT_TRUE(server_transporter_->RegisterMemory(late.data(), late.size()));
+    EXPECT_TRUE(client_transporter_->Receive(local.data(), local.size(), "127.0.0.1", server_port, &extend_info));
+    EXPECT_EQ(local, late);
+
+    ASSERT_TRUE(server_transporter_->DeregisterMemory(late.data(), late.size()));
+    EXPECT_FALSE(client_transporter_->Receive(local.data(), local.size(), "127.0.0.1", server_port, &extend_info));
+}
+
+// 测试对端重启后重新连接
+TEST_F(ShmTransporterTest, ReconnectAfterPeerRestart) {
+    int server_port = server_transporter_->GetBindPort();
+    std::vector<char> local(4096, 0);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    ASSERT_TRUE(client_transporter_->Receive(local.data(), local.size(), "127.0.0.1", server_port, &extend_info));
+
+    server_transporter_->Stop();
+    EXPECT_FALSE(client_transporter_->Receive(local.data(), local.size(), "127.0.0.1", server_port, &extend_info));
+
+    Options options = options_;
+    options[TRANSFER_ENGINE_SHM_PORT] = std::to_string(server_port);
+    ASSERT_TRUE(server_transporter_->Start(options, parallel_config_));
+    ASSERT_TRUE(server_transporter_->RegisterMemory(server_buffer_.data(), server_buffer_.size()));
+    std::memset(local.data(), 0, local.size());
+    EXPECT_TRUE(client_transporter_->Receive(local.data(), local.size(), "127.0.0.1", server_port, &extend_info));
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), local.size()), 0);
+}
+
+// 测试非法参数
+TEST_F(ShmTransporterTest, InvalidArguments) {
+    std::vector<char> local(16, 0);
+    EXPECT_THROW(
+        (void)client_transporter_->Receive(local.data(), local.size(), "127.0.0.1", 1, nullptr), std::invalid_argument);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    EXPECT_THROW(
+        (void)client_transporter_->Receive(nullptr, 0, "127.0.0.1", 1, &extend_info), std::invalid_argument);
+    // no peer on this port
+    EXPECT_FALSE(client_transporter_->Receive(local.data(), local.size(), "127.0.0.1", 1, &extend_info));
+}
+
+} // namespace astate
@@ -0,0 +1,284 @@
+#include "transport/tcp_transporter.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/option.h"
+#include "transport/tcp_control_transport.h"
+
+namespace astate {
+class TcpTransporterTest : public ::testing::Test {
+ public:
+    static constexpr size_t kBufferSize = 16 * 1024 * 1024;
+    static constexpr const char* kLocalHost = "127.0.0.1";
+
+    void SetUp() override {
+        // 使用较小的分片, 让单次读写覆盖多个连接
+        options_[TRANSFER_ENGINE_TCP_NUM_STREAMS] = "4";
+        options_[TRANSFER_ENGINE_TCP_CHUNK_SIZE] = std::to_string(1024 * 1024);
+        options_[TRANSFER_ENGINE_LOCAL_ADDRESS] = kLocalHost;
+        server_transporter_ = std::make_unique<TcpTransporter>();
+        client_transporter_ = std::make_unique<TcpTransporter>();
+        ASSERT_TRUE(server_transporter_->Start(options_, parallel_config_));
+        ASSERT_TRUE(client_transporter_->Start(options_, parallel_config_));
+
+        server_buffer_.resize(kBufferSize);
+        for (size_t i = 0; i < server_buffer_.size(); ++i) {
+            server_buffer_[i] = static_cast<char>(i * 31 + 7);
+        }
+        ASSERT_TRUE(server_transporter_->RegisterMemory(server_buffer_.data(), server_buffer_.size()));
+    }
+
+    void TearDown() override {
+        client_transporter_->Stop();
+        server_transporter_->Stop();
+    }
+
+    Options options_;
+    AParallelConfig parallel_config_;
+    std::unique_ptr<TcpTransporter> server_transporter_;
+    std::unique_ptr<TcpTransporter> client_transporter_;
+    std::vector<char> server_buffer_;
+};
+
+// 测试启动后端口分配
+TEST_F(TcpTransporterTest, BasicStartStop) {
+    EXPECT_TRUE(server_transporter_->IsRunning());
+    EXPECT_TRUE(client_transporter_->IsRunning());
+    EXPECT_NE(server_transporter_->GetBindPort(), client_transporter_->GetBindPort());
+    EXPECT_EQ(server_transporter_->GetLocalServerName(), kLocalHost);
+
+    server_transporter_->Stop();
+    EXPECT_FALSE(server_transporter_->IsRunning());
+}
+
+// 测试多连接分片读写远端内存
+TEST_F(TcpTransporterTest, ReceiveAndSend) {
+    std::vector<char> local(kBufferSize, 0);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+
+    EXPECT_TRUE(client_transporter_->Receive(
+        local.data(), local.size(), kLocalHost, server_transporter_->GetBindPort(), &extend_info));
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+
+    std::memset(local.data(), 'a', local.size());
+    EXPECT_TRUE(client_transporter_->Send(
+        local.data(), local.size(), kLocalHost, server_transporter_->GetBindPort(), &extend_info));
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+}
+
+// 测试批量提交与完成队列
+TEST_F(TcpTransporterTest, SubmitBatch) {
+    constexpr size_t kNumRequests = 256;
+    constexpr size_t kChunk = kBufferSize / kNumRequests;
+    std::vector<char> local(kBufferSize, 0);
+
+    std::vector<TransferRequest> requests(kNumRequests);
+    for (size_t i = 0; i < kNumRequests; ++i) {
+        requests[i].opcode = TransferRequest::OpCode::READ;
+        requests[i].local_mem_addr = local.data() + i * kChunk;
+        requests[i].remote_mem_addr = reinterpret_cast<uint64_t>(server_buffer_.data() + i * kChunk);
+        requests[i].length = kChunk;
+        requests[i].remote_net_addr = {kLocalHost, server_transporter_->GetBindPort()};
+    }
+
+    TransferCompletionQueue completion_queue(requests.size());
+    client_transporter_->SubmitBatch(requests, completion_queue);
+    std::vector<bool> completed(kNumRequests, false);
+    for (size_t i = 0; i < kNumRequests; ++i) {
+        auto completion = completion_queue.Pop();
+        EXPECT_TRUE(completion.success);
+        ASSERT_LT(completion.request_index, kNumRequests);
+        EXPECT_FALSE(completed[completion.request_index]);
+        completed[completion.request_index] = true;
+    }
+    EXPECT_EQ(completion_queue.Size(), 0);
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+}
+
+// 测试未注册内存被拒绝, 且连接仍可继续使用
+TEST_F(TcpTransporterTest, UnregisteredMemory) {
+    std::vector<char> local(4096, 0);
+    std::vector<char> unregistered(4096, 'x');
+    ExtendInfo bad_info = GetExtendInfoFromRemoteAddr(unregistered.data());
+    EXPECT_FALSE(client_transporter_->Receive(
+        local.data(), local.size(), kLocalHost, server_transporter_->GetBindPort(), &bad_info));
+    EXPECT_FALSE(client_transporter_->Send(
+        local.data(), local.size(), kLocalHost, server_transporter_->GetBindPort(), &bad_info));
+    EXPECT_EQ(unregistered[0], 'x');
+
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    EXPECT_TRUE(client_transporter_->Receive(
+        local.data(), local.size(), kLocalHost, server_transporter_->GetBindPort(), &extend_info));
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), local.size()), 0);
+
+    EXPECT_TRUE(server_transporter_->DeregisterMemory(server_buffer_.data(), server_buffer_.size()));
+    EXPECT_FALSE(client_transporter_->Receive(
+        local.data(), local.size(), kLocalHost, server_transporter_->GetBindPort(), &extend_info));
+}
+
+// 测试对端重启后重连
+TEST_F(TcpTransporterTest, ReconnectAfterPeerRestart) {
+    std::vector<char> local(kBufferSize, 0);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    int port = server_transporter_->GetBindPort();
+    EXPECT_TRUE(client_transporter_->Receive(local.data(), local.size(), kLocalHost, port, &extend_info));
+
+    server_transporter_->Stop();
+    Options options = options_;
+    options[TRANSFER_ENGINE_TCP_PORT] = std::to_string(port);
+    ASSERT_TRUE(server_transporter_->Start(options, parallel_config_));
+    std::fill(local.begin(), local.end(), 0);
+    EXPECT_TRUE(client_transporter_->Receive(local.data(), local.size(), kLocalHost, port, &extend_info));
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+}
+
+// 测试开启 MSG_ZEROCOPY 后读取
+TEST_F(TcpTransporterTest, ZeroCopyReceive) {
+    Options options = options_;
+    options[TRANSFER_ENGINE_TCP_ZEROCOPY] = "true";
+    TcpTransporter zerocopy_server;
+    ASSERT_TRUE(zerocopy_server.Start(options, parallel_config_));
+    ASSERT_TRUE(zerocopy_server.RegisterMemory(server_buffer_.data(), server_buffer_.size()));
+
+    std::vector<char> local(kBufferSize, 0);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    EXPECT_TRUE(client_transporter_->Receive(
+        local.data(), local.size(), kLocalHost, zerocopy_server.GetBindPort(), &extend_info));
+    EXPECT_EQ(std::memcmp(local.data(), server_buffer_.data(), kBufferSize), 0);
+    zerocopy_server.Stop();
+}
+
+// 测试连接数远多于服务线程时, 固定的服务线程池仍能服务所有连接
+TEST_F(TcpTransporterTest, FewServerThreadsManyConnections) {
+    constexpr int kNumClients = 4;
+    Options server_options = options_;
+    server_options[TRANSFER_ENGINE_TCP_SERVER_THREAD_NUM] = "2";
+    TcpTransporter server;
+    ASSERT_TRUE(server.Start(server_options, parallel_config_));
+    ASSERT_TRUE(server.RegisterMemory(server_buffer_.data(), server_buffer_.size()));
+
+    Options client_options = options_;
+    client_options[TRANSFER_ENGINE_TCP_NUM_STREAMS] = "8";
+    std::vector<std::unique_ptr<TcpTransporter>> clients;
+    std::vector<std::vector<char>> locals(kNumClients, std::vector<char>(kBufferSize, 0));
+    for (int i = 0; i < kNumClients; ++i) {
+        clients.emplace_back(std::make_unique<TcpTransporter>());
+        ASSERT_TRUE(clients.back()->Start(client_options, parallel_config_));
+    }
+
+    std::vector<std::thread> readers;
+    std::vector<int> results(kNumClients, 0);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    for (int i = 0; i < kNumClients; ++i) {
+        readers.emplace_back([&, i] {
+            results[i] = clients[i]->Receive(
+                locals[i].data(), locals[i].size(), kLocalHost, server.GetBindPort(), &extend_info);
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    for (int i = 0; i < kNumClients; ++i) {
+        EXPECT_TRUE(results[i]);
+        EXPECT_EQ(std::memcmp(locals[i].data(), server_buffer_.data(), kBufferSize), 0);
+        clients[i]->Stop();
+    }
+    server.Stop();
+}
+
+// 测试非法参数
+TEST_F(TcpTransporterTest, InvalidArguments) {
+    std::vector<char> local(16, 0);
+    EXPECT_THROW(
+        (void)client_transporter_->Receive(local.data(), local.size(), kLocalHost, 1, nullptr), std::invalid_argument);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    EXPECT_THROW((void)client_transporter_->Receive(nullptr, 0, kLocalHost, 1, &extend_info), std::invalid_argument);
+    // no peer on this port
+    EXPECT_FALSE(client_transporter_->Receive(local.data(), local.size(), kLocalHost, 1, &extend_info));
+    EXPECT_FALSE(server_transporter_->RegisterMemory(local.data(), local.size(), true, 0));
+}
+
+// 测试控制消息经由数据连接发送并分发到注册的处理器
+TEST_F(TcpTransporterTest, ControlMessages) {
+    TcpControlTransport server_control(server_transporter_.get());
+    TcpControlTransport client_control(client_transporter_.get());
+    std::string received;
+    server_control.RegisterHandler("echo", [&](const std::string& request, const void* data, size_t size) {
+        received = request + ":" + std::string(static_cast<const char*>(data), size);
+        return ResponseStatus{true, "OK", ExtendInfo{}};
+    });
+    server_control.RegisterHandler("reject", [&](const std::string&, const void*, size_t) {
+        return ResponseStatus{false, "", ExtendInfo{}};
+    });
+    Options options = options_;
+    options[TRANSPORT_SEND_RETRY_COUNT] = "1";
+    ASSERT_TRUE(server_control.Start(options));
+    ASSERT_TRUE(client_control.Start(options));
+    int port = server_control.GetBindPort();
+    EXPECT_EQ(port, server_transporter_->GetBindPort());
+
+    const std::string payload = R"({"seq_id": 1})";
+    EXPECT_TRUE(client_control.Send("echo", payload.data(), payload.size(), kLocalHost, port, nullptr));
+    EXPECT_EQ(received, "echo:" + payload);
+    EXPECT_TRUE(client_control.Send("echo", nullptr, 0, kLocalHost, port, nullptr));
+    EXPECT_EQ(received, "echo:");
+    EXPECT_FALSE(client_control.Send("reject", "x", 1, kLocalHost, port, nullptr));
+    EXPECT_FALSE(client_control.Send("unknown", "x", 1, kLocalHost, port, nullptr));
+
+    // 控制消息与数据读写共用同一端口
+    std::vector<char> local(1024, 0);
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(server_buffer_.data());
+    EXPECT_TRUE(client_transporter_->Receive(local.data(), local.size(), kLocalHost, port, &extend_info));
+    EXPECT_TRUE(client_control.Send("echo", "y", 1, kLocalHost, port, nullptr));
+
+    // 服务端停止控制通道后请求被拒绝, 对端不可达时发送失败
+    server_control.Stop();
+    EXPECT_FALSE(client_control.Send("echo", "z", 1, kLocalHost, port, nullptr));
+    server_transporter_->Stop();
+    EXPECT_FALSE(client_control.Send("echo", "z", 1, kLocalHost, port, nullptr));
+}
+
+// 测试控制请求已送达但回复丢失(读超时)时不会重发, 避免处理器执行两次
+TEST_F(TcpTransporterTest, ControlRequestNotResentAfterLostReply) {
+    TcpControlTransport server_control(server_transporter_.get());
+    std::atomic<int> calls{0};
+    server_control.RegisterHandler("echo", [](const std::string&, const void*, size_t) {
+        return ResponseStatus{true, "OK", ExtendInfo{}};
+    });
+    server_control.RegisterHandler("slow", [&](const std::string&, const void*, size_t) {
+        calls.fetch_add(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(600));
+        return ResponseStatus{true, "OK", ExtendInfo{}};
+    });
+    Options options = options_;
+    options[TRANSPORT_SEND_RETRY_COUNT] = "1";
+    options[TRANSFER_ENGINE_READ_TIMEOUT_MS] = "200";
+    ASSERT_TRUE(server_control.Start(options));
+    TcpTransporter client;
+    ASSERT_TRUE(client.Start(options, parallel_config_));
+    TcpControlTransport client_control(&client);
+    ASSERT_TRUE(client_control.Start(options));
+    int port = server_control.GetBindPort();
+
+    // 先建立并缓存控制连接, 之后的请求走复用连接
+    EXPECT_TRUE(client_control.Send("echo", "x", 1, kLocalHost, port, nullptr));
+    EXPECT_FALSE(client_control.Send("slow", "x", 1, kLocalHost, port, nullptr));
+    std::this_thread::sleep_for(std::chrono::milliseconds(800));
+    EXPECT_EQ(calls.load(), 1);
+    EXPECT_TRUE(client_control.Send("echo", "x", 1, kLocalHost, port, nullptr));
+
+    client_control.Stop();
+    client.Stop();
+    server_control.Stop();
+}
+
+} // namespace astate
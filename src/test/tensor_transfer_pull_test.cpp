@@ -80,7 +80,7 @@ class MockRDMATransporter : public RDMATransporter {
 // Enhanced TensorTransferPull that always uses HTTP for control messages and Mock RDMA for data transfer
 class TestTensorTransferPull : public TensorTransferPull {
  public:
-    TestTensorTransferPull() { data_rdma_transport_ = std::make_unique<MockRDMATransporter>(); }
+    TestTensorTransferPull() { data_transport_ = std::make_unique<MockRDMATransporter>(); }
     virtual ~TestTensorTransferPull() {}
 };
 
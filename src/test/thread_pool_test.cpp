@@ -0,0 +1,84 @@
+#include "common/thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace astate {
+
+class ThreadPoolTest : public ::testing::TestWithParam<bool> {};
+
+// 测试批量任务全部执行完成
+TEST_P(ThreadPoolTest, SubmitBatchRunsEveryElement) {
+    ThreadPool pool(4, GetParam());
+    std::vector<int> values(1000);
+    std::iota(values.begin(), values.end(), 0);
+    std::atomic<int64_t> sum{0};
+    pool.SubmitBatch(values, [&](int value) { sum.fetch_add(value); });
+    EXPECT_EQ(sum.load(), 999 * 1000 / 2);
+}
+
+// 测试同一线程池的任务中嵌套 SubmitBatch 直接失败而不是死锁, 嵌套到另一个线程池可以正常执行
+TEST_P(ThreadPoolTest, NestedSubmitBatchFailsFast) {
+    ThreadPool pool(2, GetParam());
+    ThreadPool other(2, GetParam());
+    std::vector<int> outer(4);
+    std::vector<int> inner(8);
+    std::atomic<int> nested_failures{0};
+    std::atomic<int> other_runs{0};
+    pool.SubmitBatch(outer, [&](int) {
+        try {
+            pool.SubmitBatch(inner, [](int) {});
+        } catch (const std::logic_error&) {
+            nested_failures.fetch_add(1);
+        }
+        other.SubmitBatch(inner, [&](int) { other_runs.fetch_add(1); });
+    });
+    EXPECT_EQ(nested_failures.load(), 4);
+    EXPECT_EQ(other_runs.load(), 32);
+
+    auto future = pool.Submit([&] { pool.SubmitBatch(inner, [](int) {}); });
+    EXPECT_THROW(future.get(), std::logic_error);
+}
+
+INSTANTIATE_TEST_SUITE_P(QueueAndWorkStealing, ThreadPoolTest, ::testing::Bool());
+
+// 测试任务全部指定到一个 NUMA 节点时, 其他节点的空闲 worker 也会跨组窃取执行
+TEST(WorkStealingSchedulerTest, IdleGroupsStealFromBusyNode) {
+    constexpr size_t kTasks = 32;
+    WorkStealingScheduler scheduler(4, {0, 0, 1, 1});
+    ASSERT_EQ(scheduler.GetGroupCount(), 2);
+
+    std::atomic<size_t> remote_runs{0};
+    for (size_t i = 0; i < kTasks; ++i) {
+        scheduler.Submit(
+            [&](size_t worker_index) {
+                if (worker_index >= 2) {
+                    remote_runs.fetch_add(1);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            },
+            0);
+    }
+    TaskBatch batch(kTasks);
+    scheduler.RunBulk(
+        kTasks,
+        [&](size_t index, size_t worker_index) {
+            batch.Run([&] {
+                if (worker_index >= 2) {
+                    remote_runs.fetch_add(1);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            });
+        },
+        batch,
+        std::vector<int>(kTasks, 0));
+    scheduler.WaitIdle();
+    EXPECT_GT(remote_runs.load(), 0);
+}
+} // namespace astate
@@ -0,0 +1,190 @@
+#include "utrans/utrans_mr_set.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace astate {
+namespace {
+constexpr uintptr_t kBase = 0x100000;
+constexpr size_t kStride = 0x1000;
+constexpr size_t kRegionLen = 0x800;
+
+void* Addr(uintptr_t addr) {
+    return reinterpret_cast<void*>(addr);
+}
+
+void* Item(uintptr_t value) {
+    return reinterpret_cast<void*>(value);
+}
+} // namespace
+
+class UtransMrSetTest : public ::testing::Test {
+ protected:
+    void SetUp() override { utrans_mr_set_init(&mr_set_); }
+    void TearDown() override { utrans_mr_set_destroy(&mr_set_, nullptr, nullptr); }
+
+    mr_set_t mr_set_;
+};
+
+// 测试插入、查找、重叠拒绝与删除
+TEST_F(UtransMrSetTest, InsertFindRemove) {
+    for (uintptr_t i = 0; i < 16; ++i) {
+        ASSERT_EQ(utrans_mr_set_insert(&mr_set_, Addr(kBase + i * kStride), kRegionLen, Item(i + 1)), 0);
+    }
+    EXPECT_EQ(utrans_mr_set_getsize(&mr_set_), 16);
+
+    // 区间内任意子区间都能找到所属区域, 越界的区间找不到
+    EXPECT_EQ(utrans_mr_set_find(&mr_set_, Addr(kBase + 7 * kStride), kRegionLen), Item(8));
+    EXPECT_EQ(utrans_mr_set_find(&mr_set_, Addr(kBase + 7 * kStride + 0x10), 8), Item(8));
+    EXPECT_EQ(utrans_mr_set_find(&mr_set_, Addr(kBase + 7 * kStride + kRegionLen - 4), 8), nullptr);
+    EXPECT_EQ(utrans_mr_set_find(&mr_set_, Addr(kBase - 0x10), 8), nullptr);
+
+    // 与已有区域重叠的插入被拒绝
+    EXPECT_NE(utrans_mr_set_insert(&mr_set_, Addr(kBase + 3 * kStride + 0x400), kRegionLen, Item(100)), 0);
+    EXPECT_NE(utrans_mr_set_insert(&mr_set_, Addr(kBase + 3 * kStride - 0x10), 0x20, Item(100)), 0);
+    EXPECT_EQ(utrans_mr_set_getsize(&mr_set_), 16);
+
+    EXPECT_EQ(utrans_mr_set_remove(&mr_set_, Addr(kBase + 5 * kStride), 0x10), Item(6));
+    EXPECT_EQ(utrans_mr_set_remove(&mr_set_, Addr(kBase + 5 * kStride), 0x10), nullptr);
+    EXPECT_EQ(utrans_mr_set_find(&mr_set_, Addr(kBase + 5 * kStride), 8), nullptr);
+    EXPECT_EQ(utrans_mr_set_getsize(&mr_set_), 15);
+
+    int size = 0;
+    void** items = utrans_mr_set_getall(&mr_set_, &size);
+    ASSERT_NE(items, nullptr);
+    ASSERT_EQ(size, 15);
+    // 按起始地址有序
+    for (int i = 1; i < size; ++i) {
+        EXPECT_LT(reinterpret_cast<uintptr_t>(items[i - 1]), reinterpret_cast<uintptr_t>(items[i]));
+    }
+    free(items);
+}
+
+// 测试并发插入不相交的区域, 全部可见且互不丢失, 随后并发删除
+TEST_F(UtransMrSetTest, ConcurrentInsertRemove) {
+    constexpr int kWriters = 4;
+    constexpr uintptr_t kPerWriter = 500;
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kWriters; ++t) {
+        writers.emplace_back([this, t] {
+            for (uintptr_t i = 0; i < kPerWriter; ++i) {
+                uintptr_t index = i * kWriters + t;
+                ASSERT_EQ(
+                    utrans_mr_set_insert(&mr_set_, Addr(kBase + index * kStride), kRegionLen, Item(index + 1)), 0);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    ASSERT_EQ(utrans_mr_set_getsize(&mr_set_), static_cast<int>(kWriters * kPerWriter));
+    for (uintptr_t index = 0; index < kWriters * kPerWriter; ++index) {
+        ASSERT_EQ(utrans_mr_set_find(&mr_set_, Addr(kBase + index * kStride + 0x10), 8), Item(index + 1));
+    }
+
+    writers.clear();
+    for (int t = 0; t < kWriters; ++t) {
+        writers.emplace_back([this, t] {
+            for (uintptr_t i = 0; i < kPerWriter; ++i) {
+                uintptr_t index = i * kWriters + t;
+                ASSERT_EQ(utrans_mr_set_remove(&mr_set_, Addr(kBase + index * kStride), 8), Item(index + 1));
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    EXPECT_EQ(utrans_mr_set_getsize(&mr_set_), 0);
+    EXPECT_EQ(utrans_mr_set_find(&mr_set_, Addr(kBase), 8), nullptr);
+}
+
+// 测试无锁查找与插入/删除并发时, 稳定区域始终可见, 变动区域要么不可见要么返回正确的值
+TEST_F(UtransMrSetTest, ConcurrentLookupDuringUpdates) {
+    constexpr uintptr_t kStable = 256;
+    constexpr int kReaders = 4;
+    constexpr int kRounds = 2000;
+    // 稳定区域与变动区域交错, 变动会重建整个快照
+    for (uintptr_t i = 0; i < kStable; ++i) {
+        ASSERT_EQ(utrans_mr_set_insert(&mr_set_, Addr(kBase + 2 * i * kStride), kRegionLen, Item(i + 1)), 0);
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> started{0};
+    std::atomic<int> errors{0};
+    std::atomic<int64_t> lookups{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < kReaders; ++t) {
+        readers.emplace_back([&, t] {
+            uintptr_t i = t;
+            int64_t count = 0;
+            started.fetch_add(1);
+            while (!stop.load(std::memory_order_relaxed)) {
+                i = (i + 1) % kStable;
+                if (utrans_mr_set_find(&mr_set_, Addr(kBase + 2 * i * kStride + 0x10), 8) != Item(i + 1)) {
+                    errors.fetch_add(1);
+                }
+                void* churned = utrans_mr_set_find(&mr_set_, Addr(kBase + (2 * i + 1) * kStride), 8);
+                if (churned != nullptr && churned != Item(kStable + i + 1)) {
+                    errors.fetch_add(1);
+                }
+                ++count;
+            }
+            lookups.fetch_add(count);
+        });
+    }
+
+    while (started.load() < kReaders) {
+        std::this_thread::yield();
+    }
+    for (int round = 0; round < kRounds; ++round) {
+        uintptr_t i = round % kStable;
+        void* addr = Addr(kBase + (2 * i + 1) * kStride);
+        ASSERT_EQ(utrans_mr_set_insert(&mr_set_, addr, kRegionLen, Item(kStable + i + 1)), 0);
+        ASSERT_EQ(utrans_mr_set_remove(&mr_set_, addr, 8), Item(kStable + i + 1));
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_GT(lookups.load(), 0);
+    EXPECT_EQ(utrans_mr_set_getsize(&mr_set_), static_cast<int>(kStable));
+}
+
+// 测试遍历回调访问每个区域, 回调返回非 0 时提前结束
+TEST_F(UtransMrSetTest, TraverseStopsOnCallbackError) {
+    for (uintptr_t i = 0; i < 8; ++i) {
+        ASSERT_EQ(utrans_mr_set_insert(&mr_set_, Addr(kBase + i * kStride), kRegionLen, Item(i + 1)), 0);
+    }
+    int visited = 0;
+    EXPECT_EQ(
+        utrans_mr_set_traverse(
+            &mr_set_,
+            [](void*, void* arg) {
+                ++*static_cast<int*>(arg);
+                return 0;
+            },
+            &visited),
+        0);
+    EXPECT_EQ(visited, 8);
+
+    visited = 0;
+    EXPECT_EQ(
+        utrans_mr_set_traverse(
+            &mr_set_,
+            [](void* item, void* arg) {
+                ++*static_cast<int*>(arg);
+                return item == reinterpret_cast<void*>(3) ? -1 : 0;
+            },
+            &visited),
+        -1);
+    EXPECT_EQ(visited, 3);
+}
+} // namespace astate
@@ -0,0 +1,61 @@
+#include "transfer/control_tree.h"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace astate {
+
+namespace {
+
+bool NodeLess(const NodeInfo& lhs, const NodeInfo& rhs) {
+    return std::tie(lhs.hostname_or_ip, lhs.rdma_port, lhs.ctrl_flow_port)
+        < std::tie(rhs.hostname_or_ip, rhs.rdma_port, rhs.ctrl_flow_port);
+}
+
+} // namespace
+
+ControlTree::ControlTree(
+    const NodeInfo& local_node, const std::vector<NodeInfo>& group_hosts, const std::vector<NodeInfo>& peer_hosts)
+    : local_node_(local_node) {
+    // The discovered group may or may not list the local node
+    std::vector<NodeInfo> group = group_hosts;
+    if (std::find(group.begin(), group.end(), local_node) == group.end()) {
+        group.push_back(local_node);
+    }
+    auto local_groups = GroupByHost(std::move(group));
+    members_ = std::move(local_groups[local_node.hostname_or_ip]);
+    leader_ = members_.front();
+
+    for (auto& [host, nodes] : GroupByHost(peer_hosts)) {
+        peer_leaders_.push_back(nodes.front());
+        peer_groups_.emplace(nodes.front(), std::move(nodes));
+    }
+    std::sort(peer_leaders_.begin(), peer_leaders_.end(), NodeLess);
+}
+
+const std::vector<NodeInfo>& ControlTree::GetPeerGroup(const NodeInfo& peer_leader) const {
+    static const std::vector<NodeInfo> kEmptyGroup;
+    auto it = peer_groups_.find(peer_leader);
+    return it == peer_groups_.end() ? kEmptyGroup : it->second;
+}
+
+std::string ControlTree::ToString() const {
+    return "leader=[" + leader_.ToString() + "], is_leader=" + (IsLeader() ? "true" : "false")
+        + ", members=" + std::to_string(members_.size()) + ", peer_leaders=" + std::to_string(peer_leaders_.size());
+}
+
+std::unordered_map<std::string, std::vector<NodeInfo>> ControlTree::GroupByHost(std::vector<NodeInfo> nodes) {
+    std::sort(nodes.begin(), nodes.end(), NodeLess);
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    std::unordered_map<std::string, std::vector<NodeInfo>> groups;
+    for (auto& node : nodes) {
+        groups[node.hostname_or_ip].push_back(std::move(node));
+    }
+    return groups;
+}
+
+} // namespace astate
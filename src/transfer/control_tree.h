@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "protocol/messages.h"
+#include "transfer/types.h"
+
+namespace astate {
+
+/*
+ * Two level aggregation tree for control messages (TRANSFER_ENGINE_CTRL_AGGREGATION=host).
+ *
+ * Nodes of one role are grouped by host, the smallest node of a group is its leader. Members hand their
+ * messages of a step to the leader, the leader forwards the whole group's messages as one bundle to every
+ * peer leader, which re-broadcasts it to its members. Per step that is O(T + I + H_T * H_I) posts instead
+ * of O(T * I), with H the host counts.
+ *
+ * Every node derives the same tree from the discovered node lists, no election is needed.
+ */
+class ControlTree {
+ public:
+    ControlTree() = default;
+    ControlTree(
+        const NodeInfo& local_node, const std::vector<NodeInfo>& group_hosts, const std::vector<NodeInfo>& peer_hosts);
+
+    [[nodiscard]] bool IsLeader() const { return local_node_ == leader_; }
+
+    [[nodiscard]] const NodeInfo& GetLeader() const { return leader_; }
+
+    // Nodes of the local group, the leader included
+    [[nodiscard]] const std::vector<NodeInfo>& GetMembers() const { return members_; }
+
+    [[nodiscard]] const std::vector<NodeInfo>& GetPeerLeaders() const { return peer_leaders_; }
+
+    // Members of the peer group led by peer_leader, empty for an unknown leader
+    [[nodiscard]] const std::vector<NodeInfo>& GetPeerGroup(const NodeInfo& peer_leader) const;
+
+    [[nodiscard]] std::string ToString() const;
+
+ private:
+    // Group nodes by host, the smallest node of every group first
+    static std::unordered_map<std::string, std::vector<NodeInfo>> GroupByHost(std::vector<NodeInfo> nodes);
+
+    NodeInfo local_node_{};
+    NodeInfo leader_{};
+    std::vector<NodeInfo> members_;
+    std::vector<NodeInfo> peer_leaders_;
+    std::unordered_map<NodeInfo, std::vector<NodeInfo>, NodeInfoHash> peer_groups_;
+};
+
+} // namespace astate
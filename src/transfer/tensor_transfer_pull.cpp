@@ -1,20 +1,27 @@
 #include "tensor_transfer_pull.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <exception>
 #include <functional>
 #include <future>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <ranges>
 #include <set>
 #include <string>
 #include <thread>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <httplib.h>
 
 #include <spdlog/spdlog.h>
 
+#include "common/file_utils.h"
 #include "common/option.h"
 #include "common/string_utils.h"
 #include "common/thread_pool.h"
@@ -27,21 +34,57 @@
 #include "tensor_transfer_service.h"
 #include "transport/base_transport.h"
 #include "transport/brpc_transport.h"
+#include "transport/multiplex_transporter.h"
 #include "transport/rdma_transporter.h"
+#include "transport/tcp_control_transport.h"
+#include "transport/tcp_transporter.h"
 #include "types.h"
 
 namespace astate {
 
+namespace {
+
+// Whether a shard still lives where it was published, a reallocated or reshaped tensor has to be published again
+bool IsSamePublishedMeta(const TensorMemoryRDMAInfo& lhs, const TensorMemoryRDMAInfo& rhs) {
+    const auto& a = lhs.atensor_meta;
+    const auto& b = rhs.atensor_meta;
+    if (lhs.addr != rhs.addr || lhs.size != rhs.size || lhs.rkey != rhs.rkey || a.storage_offset != b.storage_offset
+        || a.dim_num != b.dim_num || a.dtype != b.dtype || a.storage.storage_size != b.storage.storage_size
+        || a.storage.device.device_type != b.storage.device.device_type
+        || a.storage.device.device_index != b.storage.device.device_index) {
+        return false;
+    }
+    for (int32_t i = 0; i < a.dim_num; ++i) {
+        if (a.size[i] != b.size[i] || a.stride[i] != b.stride[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// TCP data transport control messages may ride on, nullptr if none is running
+TcpTransporter* GetTcpDataTransport(BaseDataTransport* data_transport) {
+    if (auto* tcp = dynamic_cast<TcpTransporter*>(data_transport); tcp != nullptr) {
+        return tcp->IsRunning() ? tcp : nullptr;
+    }
+    if (auto* multiplex = dynamic_cast<MultiplexTransporter*>(data_transport); multiplex != nullptr) {
+        return multiplex->GetTcpBackend();
+    }
+    return nullptr;
+}
+
+} // namespace
+
 TensorTransferPull::TensorTransferPull()
     : random_gen_(rd_()) {
-    data_rdma_transport_ = std::make_unique<RDMATransporter>();
+    data_transport_ = std::make_unique<RDMATransporter>();
     control_transport_ = std::make_unique<BrpcTransport>();
 }
 
 TensorTransferPull::TensorTransferPull(ATensorStorageCtx* ctx)
     : ctx_(ctx),
       random_gen_(rd_()) {
-    data_rdma_transport_ = std::make_unique<RDMATransporter>();
+    data_transport_ = std::make_unique<RDMATransporter>();
     // control_transport_ = std::make_unique<HTTPTransporter>();
     control_transport_ = std::make_unique<BrpcTransport>();
 }
@@ -54,7 +97,7 @@ TensorTransferPull::~TensorTransferPull() {
 
 inline void TensorTransferPull::RegisterMemoryOrThrow(void* addr, size_t size, bool is_cuda, int device_index) {
     try {
-        bool success = data_rdma_transport_->RegisterMemory(addr, size, is_cuda, device_index);
+        bool success = data_transport_->RegisterMemory(addr, size, is_cuda, device_index);
         if (!success) {
             throw std::runtime_error("Failed to register memory");
         }
@@ -76,6 +119,8 @@ inline void TensorTransferPull::RegisterMemoryOrThrow(void* addr, size_t size, b
 
 bool TensorTransferPull::Start(const Options& options, const AParallelConfig& parallel_config) {
     is_debug_mode_ = GetOptionValue<bool>(options, ASTATE_DEBUG_MODE);
+    binary_meta_encoding_ = GetOptionValue<std::string>(options, TRANSFER_ENGINE_META_ENCODING) == "binary";
+    meta_subscription_enabled_ = GetOptionValue<bool>(options, TRANSFER_ENGINE_META_SUBSCRIPTION);
 
     bool init_success = true;
     try {
@@ -83,7 +128,8 @@ bool TensorTransferPull::Start(const Options& options, const AParallelConfig& pa
         role_ = parallel_config.role;
         tensor_ready_timeout_ms_ = GetOptionValue<int>(options, TRANSFER_ENGINE_SERVICE_TENSOR_READY_TIMEOUT_MS);
         int read_thread_num = GetOptionValue<int>(options, TRANSFER_ENGINE_READ_THREAD_NUM);
-        thread_pool_ = std::make_unique<ThreadPool>(read_thread_num);
+        thread_pool_ = std::make_unique<ThreadPool>(
+            read_thread_num, GetOptionValue<bool>(options, TRANSFER_ENGINE_THREAD_POOL_WORK_STEALING));
         skip_rdma_exception_for_test_ = GetOptionValue<bool>(options, TRANSFER_ENGINE_SKIP_RDMA_EXCEPTION);
         SPDLOG_INFO(
             "Start TensorTransferPull with role: {}, read thread num: {}, "
@@ -99,27 +145,51 @@ bool TensorTransferPull::Start(const Options& options, const AParallelConfig& pa
                 skip_rdma_exception_for_test_);
         }
 
-        // Start RDMA data transport service
-        init_success &= data_rdma_transport_->Start(options, parallel_config);
+        // Start data transport service
+        auto engine_type = GetOptionValue<std::string>(options, TRANSFER_ENGINE_TYPE);
+        if (engine_type == "tcp") {
+            data_transport_ = std::make_unique<TcpTransporter>();
+        } else if (engine_type == "auto") {
+            data_transport_ = std::make_unique<MultiplexTransporter>();
+        }
+        if (ctx_ != nullptr) {
+            data_transport_->SetResolvedOptions(ctx_->resolved_options);
+        }
+        init_success &= data_transport_->Start(options, parallel_config);
         if (init_success) {
-            SPDLOG_INFO("RDMA transport service started successfully.");
+            SPDLOG_INFO("Data transport service [{}] started successfully.", engine_type.empty() ? "rdma" : engine_type);
         }
+        // Transports without native batching read the tensors of a MultiGet in parallel on the read threads
+        data_transport_->SetBatchExecutor([this](size_t count, const std::function<void(size_t)>& run) {
+            thread_pool_->SubmitBatch(std::views::iota(size_t{0}, count), run);
+        });
 
         // Start control transport service
+        if (GetOptionValue<std::string>(options, TRANSFER_ENGINE_CTRL_TRANSPORT) == "tcp") {
+            if (auto* tcp = GetTcpDataTransport(data_transport_.get()); tcp != nullptr) {
+                control_transport_ = std::make_unique<TcpControlTransport>(tcp);
+                SPDLOG_INFO("Control messages are carried by the tcp data transport");
+            } else {
+                SPDLOG_WARN("No tcp data transport is running, control messages stay on brpc");
+            }
+        }
         RegisterHandlers();
+        if (ctx_ != nullptr) {
+            control_transport_->SetResolvedOptions(ctx_->resolved_options);
+        }
         init_success &= control_transport_->Start(options);
         if (init_success) {
             SPDLOG_INFO("TensorTransferPull service started successfully.");
             local_node_info_ = NodeInfo{
-                data_rdma_transport_->GetLocalServerName(),
-                data_rdma_transport_->GetBindPort(),
+                data_transport_->GetLocalServerName(),
+                data_transport_->GetBindPort(),
                 control_transport_->GetBindPort()};
         }
 
         bool skip_discovery = GetOptionValue<bool>(options, TRANSFER_ENGINE_SERVICE_SKIP_DISCOVERY);
         if (!skip_discovery) {
             discovery_manager_ = DiscoveryManager::CreateFromOptions(
-                options, parallel_config, data_rdma_transport_->GetBindPort(), control_transport_->GetBindPort());
+                options, parallel_config, data_transport_->GetBindPort(), control_transport_->GetBindPort());
             discovery_manager_->Start();
             discovery_manager_->RegisterCurrentNode();
             auto nodes = discovery_manager_->DiscoverAllNodes();
@@ -133,6 +203,13 @@ bool TensorTransferPull::Start(const Options& options, const AParallelConfig& pa
                         node.node_info.hostname_or_ip, node.node_info.rdma_port, node.node_info.ctrl_flow_port});
                 }
             }
+            elastic_membership_ = GetOptionValue<bool>(options, TRANSFER_ENGINE_ELASTIC_MEMBERSHIP);
+            if (elastic_membership_) {
+                discovery_manager_->StartMembershipWatch(
+                    nodes, [this](const std::vector<NodeEntry>& joined, const std::vector<NodeEntry>& left) {
+                        OnMembershipChanged(joined, left);
+                    });
+            }
         } else {
             auto peers_host = GetOptionValue<std::vector<std::string>>(options, TRANSFER_ENGINE_PEERS_HOST);
             auto group_host = GetOptionValue<std::vector<std::string>>(options, TRANSFER_ENGINE_GROUP_HOST);
@@ -145,17 +222,31 @@ bool TensorTransferPull::Start(const Options& options, const AParallelConfig& pa
                 ToString(group_host));
         }
 
+        auto snapshot_dir = GetOptionValue<std::string>(options, TRANSFER_ENGINE_RESTART_SNAPSHOT_DIR);
+        if (!snapshot_dir.empty()) {
+            meta_snapshot_path_ = RestartSnapshotPath(snapshot_dir, role_, parallel_config.role_rank, "metas");
+            // The metas point into the memory of the peers, they are only valid if none of them restarted
+            if (discovery_manager_ != nullptr && discovery_manager_->IsRestoredFromSnapshot()
+                && RestoreMetaSnapshot() && !SendMetaResync()) {
+                SPDLOG_WARN("Failed to ask the senders for their full metas, retry with Complete()");
+            }
+        }
+
         enable_log_tensor_meta_ = GetOptionValue<bool>(options, TRANSFER_ENGINE_LOG_TENSOR_META);
         perf_metrics_controller_ = std::make_shared<PerfMetricsController>("tensor_transfer_pull_service", options);
-        perf_stats_interval_ms_ = GetOptionValue<int64_t>(options, TRANSFER_ENGINE_PERF_STATS_INTERVAL_MS);
         SPDLOG_INFO(
-            "Enbale log tensor meta: {}, Enable perf metrics: {}, perf stats "
-            "interval ms: {}",
+            "Enbale log tensor meta: {}, Enable perf metrics: {}",
             enable_log_tensor_meta_,
-            perf_metrics_controller_->IsPerfMetricsEnabled(),
-            perf_stats_interval_ms_);
+            perf_metrics_controller_->IsPerfMetricsEnabled());
 
         enable_local_cache_prefetch_ = GetOptionValue<bool>(options, TRANSFER_ENGINE_ENABLE_LOCAL_CACHE_PREFETCH);
+
+        ctrl_aggregation_ = GetOptionValue<std::string>(options, TRANSFER_ENGINE_CTRL_AGGREGATION) == "host";
+        relay_timeout_ms_ = GetOptionValue<int64_t>(options, TRANSFER_ENGINE_CTRL_AGGREGATION_TIMEOUT_MS);
+        if (ctrl_aggregation_) {
+            RebuildControlTree();
+        }
+        RefreshPeerReadCounters();
     } catch (const std::exception& e) {
         SPDLOG_ERROR("Failed to start tensor transfer service [PULL]: {}", e.what());
         init_success = false;
@@ -167,18 +258,24 @@ bool TensorTransferPull::Start(const Options& options, const AParallelConfig& pa
 }
 
 void TensorTransferPull::Stop() {
-    if (data_rdma_transport_ != nullptr && data_rdma_transport_->IsRunning()) {
-        data_rdma_transport_->Stop();
+    // No membership callbacks past this point
+    if (discovery_manager_ != nullptr) {
+        discovery_manager_->Stop();
     }
+    // Control first, its handlers may still read through the data transport, and a control transport riding on
+    // the data connections (TcpControlTransport) must not outlive them
     if (control_transport_ != nullptr && control_transport_->IsRunning()) {
         control_transport_->Stop();
     }
+    if (data_transport_ != nullptr && data_transport_->IsRunning()) {
+        data_transport_->Stop();
+    }
 
     SPDLOG_INFO("Succesfully stop all transport services.");
 }
 
 bool TensorTransferPull::IsRunning() const {
-    return (data_rdma_transport_ != nullptr && data_rdma_transport_->IsRunning())
+    return (data_transport_ != nullptr && data_transport_->IsRunning())
         && (control_transport_ != nullptr && control_transport_->IsRunning());
 }
 
@@ -214,15 +311,24 @@ bool TensorTransferPull::Put(int64_t seq_id, const ShardedKey& tensor_key, const
     // Build RDMA meta message
     TensorMemoryRDMAInfo rdma_info{atensor.storage.data, atensor.storage.GetStorageDataSize(), "", atensor};
 
-    TensorRDMAMetaPublishMessage meta_msg;
-    meta_msg.seq_id = seq_id;
-    meta_msg.node_info = local_node_info_;
-    meta_msg.tensor_rdma_metas[tensor_key] = rdma_info;
+    {
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        step_metas_[tensor_key] = rdma_info;
+    }
 
-    // Send the tensor rdma meta infos to all peers
+    // Send the tensor rdma meta infos to all peers, once published only the changes are sent in Complete()
     // TODO(root): send weight ready message to all peers directly instead of publishing metas first.
     if (!is_publish_meta_) {
-        return SendTensorRDMAMeta(meta_msg);
+        TensorRDMAMetaPublishMessage meta_msg;
+        meta_msg.seq_id = seq_id;
+        meta_msg.node_info = local_node_info_;
+        meta_msg.version = 1;
+        meta_msg.tensor_rdma_metas[tensor_key] = rdma_info;
+        if (!SendTensorRDMAMeta(meta_msg)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        acked_metas_[tensor_key] = std::move(rdma_info);
     }
     return true;
 }
@@ -243,12 +349,31 @@ bool TensorTransferPull::MultiPut(int64_t seq_id, const std::vector<std::pair<Sh
         return false;
     }
 
+    // Once published, only remember the shards of this step, the changes are sent as a diff in Complete()
+    if (is_publish_meta_) {
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        for (const auto& [tensor_key, atensor] : atensors) {
+            TensorMemoryRDMAInfo rdma_info{atensor.storage.data, atensor.storage.GetStorageDataSize(), "", atensor};
+            auto acked_it = acked_metas_.find(tensor_key);
+            if (acked_it == acked_metas_.end() || !IsSamePublishedMeta(acked_it->second, rdma_info)) {
+                // New or reallocated tensor
+                RegisterMemoryOrThrow(
+                    atensor.storage.data,
+                    atensor.storage.GetStorageDataSize(),
+                    atensor.storage.device.device_type == ATDeviceType::CUDA,
+                    atensor.storage.device.device_index);
+            }
+            step_metas_[tensor_key] = std::move(rdma_info);
+        }
+        return true;
+    }
+
     // Send the tensor rdma meta infos to all peers if the metas have not been published yet.
-    // TODO(root): handle the case that the metas were changed.
-    if (!is_publish_meta_) {
+    {
         TensorRDMAMetaPublishMessage meta_msg;
         meta_msg.seq_id = seq_id;
         meta_msg.node_info = local_node_info_;
+        meta_msg.version = 1;
 
         for (const auto& pair : atensors) {
             // Register memory for further rdma transport
@@ -266,44 +391,22 @@ bool TensorTransferPull::MultiPut(int64_t seq_id, const std::vector<std::pair<Sh
             // Build RDMA meta message
             TensorMemoryRDMAInfo rdma_info{
                 pair.second.storage.data, pair.second.storage.GetStorageDataSize(), "", pair.second};
+            step_metas_[pair.first] = rdma_info;
             meta_msg.tensor_rdma_metas[pair.first] = rdma_info;
         }
 
-        return SendTensorRDMAMeta(meta_msg);
+        if (!SendTensorRDMAMeta(meta_msg)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        for (auto& [tensor_key, rdma_info] : meta_msg.tensor_rdma_metas) {
+            acked_metas_[tensor_key] = std::move(rdma_info);
+        }
     }
     return true;
 }
 
-bool TensorTransferPull::Get(int64_t seq_id, const ShardedKey& tensor_key, ATensor& atensor) {
-    auto start_time = std::chrono::high_resolution_clock::now();
-    if (!atensor.IsValid()) {
-        SPDLOG_ERROR("Invalid tensor: {}", atensor.GetTensorInfo());
-        return false;
-    }
-
-    // Check if service is running before proceeding with operations
-    if (!IsRunning()) {
-        SPDLOG_WARN("Service is not running, Get operation cannot proceed");
-        return false;
-    }
-
-    SetRead(current_data_operation_);
-    if (!CheckAndUpdateCurrentSeqId(seq_id)) {
-        return false;
-    }
-
-    RegisterMemoryOrThrow(
-        atensor.storage.data,
-        atensor.storage.GetStorageDataSize(),
-        atensor.storage.device.device_type == ATDeviceType::CUDA,
-        atensor.storage.device.device_index);
-    auto register_end = std::chrono::high_resolution_clock::now();
-
-    if (!WaitForTensorReady(seq_id, tensor_key, static_cast<int>(tensor_ready_timeout_ms_))) {
-        return false;
-    }
-    auto wait_end = std::chrono::high_resolution_clock::now();
-
+TransferRequest TensorTransferPull::BuildReadRequest(int64_t seq_id, const ShardedKey& tensor_key, ATensor& atensor) {
     auto cache_it = remote_tensor_cache_.find(seq_id);
     if (cache_it == remote_tensor_cache_.end()) {
         SPDLOG_ERROR("Tensor RDMA info not found for seq_id: {}", seq_id);
@@ -313,11 +416,13 @@ bool TensorTransferPull::Get(int64_t seq_id, const ShardedKey& tensor_key, ATens
     const auto* rdma_info_list = GetTensorRDMAInfoVector(tensor_key, cache_it->second);
     if (rdma_info_list == nullptr || rdma_info_list->empty()) {
         SPDLOG_ERROR("Tensor RDMA info not found for tensor_key: {}", tensor_key.key);
+        RecordMetaMiss(tensor_key, atensor);
         throw std::runtime_error("illegal state: Tensor RDMA info not found");
     }
 
     size_t random_index = parallel_config_.role_rank % rdma_info_list->size();
     const auto* rdma_info = &((*rdma_info_list)[random_index]);
+    RecordMetaInterest(tensor_key, *rdma_info->atensor);
     // if (atensor.storage_offset != rdma_info->atensor->storage_offset) {
     //     SPDLOG_ERROR("storage_offset mismatch, tensor_key: {}, atensor.storage_offset: {},
     //     rdma_info->atensor->storage_offset: {}", tensor_key.key
@@ -348,30 +453,76 @@ bool TensorTransferPull::Get(int64_t seq_id, const ShardedKey& tensor_key, ATens
     }
 
     auto* remote_addr = static_cast<char*>(rdma_info->addr) + remote_byte_offset;
-    auto* local_addr = static_cast<char*>(atensor.storage.data);
-    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(remote_addr);
+    TransferRequest request;
+    request.opcode = TransferRequest::OpCode::READ;
+    request.local_mem_addr = atensor.storage.data;
+    request.remote_mem_addr = reinterpret_cast<uint64_t>(remote_addr);
+    request.length = byte_size;
+    request.remote_net_addr = {rdma_info->node_info.hostname_or_ip, rdma_info->node_info.rdma_port};
+    request.read_bytes = rdma_info->read_bytes;
+    return request;
+}
 
-    auto read_prepare_end = std::chrono::high_resolution_clock::now();
+bool TensorTransferPull::Get(int64_t seq_id, const ShardedKey& tensor_key, ATensor& atensor) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    if (!atensor.IsValid()) {
+        SPDLOG_ERROR("Invalid tensor: {}", atensor.GetTensorInfo());
+        return false;
+    }
 
-    bool ret = data_rdma_transport_->Receive(
-        local_addr, byte_size, rdma_info->node_info.hostname_or_ip, rdma_info->node_info.rdma_port, &extend_info);
-    auto end_time = std::chrono::high_resolution_clock::now();
+    // Check if service is running before proceeding with operations
+    if (!IsRunning()) {
+        SPDLOG_WARN("Service is not running, Get operation cannot proceed");
+        return false;
+    }
 
-    UpdateThroughputStatistic(rdma_info->node_info.GetHostWithRdmaPort(), byte_size);
-    auto stats_end = std::chrono::high_resolution_clock::now();
+    SetRead(current_data_operation_);
+    if (!CheckAndUpdateCurrentSeqId(seq_id)) {
+        return false;
+    }
+
+    RegisterMemoryOrThrow(
+        atensor.storage.data,
+        atensor.storage.GetStorageDataSize(),
+        atensor.storage.device.device_type == ATDeviceType::CUDA,
+        atensor.storage.device.device_index);
+    auto register_end = std::chrono::high_resolution_clock::now();
+    register_latency_->Record(register_end - start_time);
+
+    if (!WaitForTensorReady(seq_id, tensor_key, static_cast<int>(tensor_ready_timeout_ms_))) {
+        return false;
+    }
+    auto wait_end = std::chrono::high_resolution_clock::now();
+    wait_latency_->Record(wait_end - register_end);
+
+    auto request = BuildReadRequest(seq_id, tensor_key, atensor);
+    auto byte_size = request.length;
+    ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(reinterpret_cast<void*>(request.remote_mem_addr));
+
+    auto read_prepare_end = std::chrono::high_resolution_clock::now();
+    plan_latency_->Record(read_prepare_end - wait_end);
+
+    bool ret = data_transport_->Receive(
+        request.local_mem_addr,
+        byte_size,
+        request.remote_net_addr.host,
+        request.remote_net_addr.port,
+        &extend_info);
+    auto end_time = std::chrono::high_resolution_clock::now();
+    read_latency_->Record(end_time - read_prepare_end);
+    UpdateThroughputStatistic(request);
 
     if (perf_metrics_controller_->ShouldLogPerfMetric(seq_id)) {
         auto register_duration = std::chrono::duration_cast<std::chrono::microseconds>(register_end - start_time);
         auto wait_duration = std::chrono::duration_cast<std::chrono::microseconds>(wait_end - register_end);
         auto read_prepare_duration = std::chrono::duration_cast<std::chrono::microseconds>(read_prepare_end - wait_end);
         auto read_duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - read_prepare_end);
-        auto stats_duration = std::chrono::duration_cast<std::chrono::microseconds>(stats_end - end_time);
-        auto total_duration = std::chrono::duration_cast<std::chrono::microseconds>(stats_end - start_time);
+        auto total_duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
 
         SPDLOG_INFO(
             "Get tensor_key: {}, seq_id: {}, total cost {} us (register {} us, "
             "wait {} us, read_prepare {} us, read {} "
-            "us, stats {} us), throughput {} MB/s from host {}, "
+            "us), throughput {} MB/s from host {}:{}, "
             "local_thread_pool_pending_tasks: {}",
             tensor_key.key,
             seq_id,
@@ -380,9 +531,9 @@ bool TensorTransferPull::Get(int64_t seq_id, const ShardedKey& tensor_key, ATens
             wait_duration.count(),
             read_prepare_duration.count(),
             read_duration.count(),
-            stats_duration.count(),
             BYTES_TO_MB(byte_size) / US_TO_SEC(total_duration.count()),
-            rdma_info->node_info.GetHostWithRdmaPort(),
+            request.remote_net_addr.host,
+            request.remote_net_addr.port,
             thread_pool_->GetTaskCount());
     }
 
@@ -406,25 +557,76 @@ bool TensorTransferPull::MultiGet(int64_t seq_id, std::vector<std::pair<ShardedK
         return false;
     }
 
-    // Use multithreading with std::ref to safely pass references
-    std::vector<std::future<bool>> futures;
-    futures.reserve(atensors.size());
-
-    for (auto& pair : atensors) {
-        // Copy the key and use std::ref for the tensor
-        ShardedKey key_copy = pair.first;
-        std::reference_wrapper<ATensor> tensor_ref = std::ref(pair.second);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    // Register the whole batch up front, then wait for all of its metas at once
+    std::vector<const ShardedKey*> tensor_keys;
+    tensor_keys.reserve(atensors.size());
+    for (auto& [tensor_key, atensor] : atensors) {
+        if (!atensor.IsValid()) {
+            SPDLOG_ERROR("Invalid tensor: {}", atensor.GetTensorInfo());
+            return false;
+        }
+        RegisterMemoryOrThrow(
+            atensor.storage.data,
+            atensor.storage.GetStorageDataSize(),
+            atensor.storage.device.device_type == ATDeviceType::CUDA,
+            atensor.storage.device.device_index);
+        tensor_keys.push_back(&tensor_key);
+    }
+    auto register_end = std::chrono::high_resolution_clock::now();
+    register_latency_->Record(register_end - start_time);
+    if (!WaitForTensorsReady(seq_id, tensor_keys, static_cast<int>(tensor_ready_timeout_ms_))) {
+        return false;
+    }
+    auto wait_end = std::chrono::high_resolution_clock::now();
+    wait_latency_->Record(wait_end - register_end);
 
-        futures.emplace_back(thread_pool_->Submit([this, seq_id, key_copy, tensor_ref]() -> bool {
-            // Get the actual reference from std::reference_wrapper
-            return Get(seq_id, key_copy, tensor_ref.get());
-        }));
+    std::vector<TransferRequest> requests;
+    requests.reserve(atensors.size());
+    for (auto& [tensor_key, atensor] : atensors) {
+        requests.emplace_back(BuildReadRequest(seq_id, tensor_key, atensor));
     }
+    auto prepare_end = std::chrono::high_resolution_clock::now();
+    plan_latency_->Record(prepare_end - wait_end);
+
+    // Post all reads in one batch and reap the per-request completions
+    TransferCompletionQueue completion_queue(requests.size());
+    data_transport_->SubmitBatch(requests, completion_queue);
 
-    // Wait for all operations to complete
     bool success = true;
-    for (auto& future : futures) {
-        success &= future.get();
+    size_t total_bytes = 0;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        auto completion = completion_queue.Pop();
+        const auto& request = requests[completion.request_index];
+        if (!completion.success) {
+            SPDLOG_ERROR(
+                "MultiGet failed to read tensor_key: {}, seq_id: {}, from host {}:{}",
+                atensors[completion.request_index].first.key,
+                seq_id,
+                request.remote_net_addr.host,
+                request.remote_net_addr.port);
+            success = false;
+            continue;
+        }
+        total_bytes += request.length;
+        UpdateThroughputStatistic(request);
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    // One sample per batch: the reads of a batch overlap
+    read_latency_->Record(end_time - prepare_end);
+
+    if (perf_metrics_controller_->ShouldLogPerfMetric(seq_id)) {
+        auto prepare_duration = std::chrono::duration_cast<std::chrono::microseconds>(prepare_end - start_time);
+        auto read_duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - prepare_end);
+        auto total_duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+        SPDLOG_INFO(
+            "MultiGet {} tensors, seq_id: {}, total cost {} us (prepare {} us, read {} us), throughput {} MB/s",
+            requests.size(),
+            seq_id,
+            total_duration.count(),
+            prepare_duration.count(),
+            read_duration.count(),
+            BYTES_TO_MB(total_bytes) / US_TO_SEC(total_duration.count()));
     }
 
     return success;
@@ -443,17 +645,78 @@ void TensorTransferPull::Complete() {
     // If reading finished, send weight consumed message to all peers
     if (IsRead(current_data_operation_)) {
         SPDLOG_INFO("Complete read");
-        SendWeightConsumed(WeightConsumedMessage{current_seq_id_, local_node_info_});
+        // Subscribe before reporting consumed, so the writers filter the metas of the next step
+        if (meta_subscription_enabled_ && !meta_subscribed_ && !SendMetaSubscription()) {
+            SPDLOG_WARN("Failed to subscribe tensor metas of seq {}, retry with the next step", current_seq_id_);
+        }
+        if (meta_resync_pending_ && !SendMetaResync()) {
+            SPDLOG_WARN("Failed to ask the senders for their full metas, retry with the next step");
+        }
+        if (ctrl_aggregation_) {
+            if (!RelayCtrlMessages(
+                    {{WEIGHT_CONSUMED_REQUEST,
+                      Serialize(ToJson(WeightConsumedMessage{current_seq_id_, local_node_info_}))}})) {
+                SendWeightConsumed(WeightConsumedMessage{current_seq_id_, local_node_info_});
+            }
+        } else {
+            SendWeightConsumed(WeightConsumedMessage{current_seq_id_, local_node_info_});
+        }
+        if (!meta_snapshot_path_.empty()) {
+            SaveMetaSnapshot(current_seq_id_);
+        }
     }
 
     // If writing finished, wait for all peers to consume the weights
     if (IsWrite(current_data_operation_)) {
         SPDLOG_INFO("Complete write");
 
-        SendWeightReady(WeightReadyMessage{current_seq_id_, local_node_info_});
+        // Peers that subscribed again or restored their metas get the acked metas before the diff
+        std::vector<NodeInfo> resync_peers;
+        {
+            std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+            resync_peers.assign(resync_peers_.begin(), resync_peers_.end());
+            resync_peers_.clear();
+        }
+        if (!resync_peers.empty() && !SendAckedMetas(resync_peers)) {
+            std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+            resync_peers_.insert(resync_peers.begin(), resync_peers.end());
+        }
+
+        if (ctrl_aggregation_) {
+            // The diff travels with weight ready, so peers apply it before counting this node ready
+            TensorRDMAMetaPublishMessage diff;
+            bool has_diff = is_publish_meta_ && BuildMetaDiff(diff);
+            std::vector<std::pair<std::string, std::string>> messages;
+            if (has_diff) {
+                messages.emplace_back(TENSOR_RDMA_META_REQUEST, EncodeMetaMessage(diff));
+            }
+            messages.emplace_back(
+                WEIGHT_READY_REQUEST, Serialize(ToJson(WeightReadyMessage{current_seq_id_, local_node_info_})));
+            // Acknowledged only once the peer leaders handed the diff down, not when the own leader took it
+            if (RelayCtrlMessages(std::move(messages))) {
+                if (has_diff) {
+                    AckMetaDiff(diff);
+                }
+            } else {
+                // Peers that applied the relayed diff reject it now and get the full metas
+                if (has_diff && !DeliverMetaDiff(diff)) {
+                    SPDLOG_ERROR(
+                        "Failed to publish meta diff of seq {}, it is sent again with the next step", current_seq_id_);
+                }
+                SendWeightReady(WeightReadyMessage{current_seq_id_, local_node_info_});
+            }
+        } else {
+            if (is_publish_meta_ && !PublishMetaDiff()) {
+                SPDLOG_ERROR(
+                    "Failed to publish meta diff of seq {}, it is sent again with the next step", current_seq_id_);
+            }
+            SendWeightReady(WeightReadyMessage{current_seq_id_, local_node_info_});
+        }
 
         std::chrono::milliseconds wait_time_ms(0);
         while (true) {
+            // Departed consumers are not waited for
+            ApplyDepartures();
             // Check if all remote nodes have finished the data reading
             if (consumed_nodes_.size() == peer_hosts_.size()) {
                 SPDLOG_INFO("Seq {} completed, all nodes have received weights", current_seq_id_);
@@ -500,16 +763,495 @@ void TensorTransferPull::Complete() {
     consumed_nodes_.clear();
     // TODO(root): update is_publish_meta_ to false when source nodes' infos were changed.
     is_publish_meta_ = true;
+    {
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        meta_version_ = std::max<uint64_t>(meta_version_, 1);
+        step_metas_.clear();
+    }
+}
+
+bool TensorTransferPull::PublishMetaDiff() {
+    TensorRDMAMetaPublishMessage diff;
+    if (!BuildMetaDiff(diff)) {
+        return true;
+    }
+    return DeliverMetaDiff(diff);
+}
+
+bool TensorTransferPull::DeliverMetaDiff(const TensorRDMAMetaPublishMessage& diff) {
+    std::vector<NodeInfo> failed_peers;
+    if (!SendTensorRDMAMeta(diff, &failed_peers)) {
+        if (failed_peers.empty()) {
+            return false;
+        }
+        TensorRDMAMetaPublishMessage full;
+        {
+            std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+            full.tensor_rdma_metas = acked_metas_;
+        }
+        for (const auto& [tensor_key, rdma_info] : diff.tensor_rdma_metas) {
+            full.tensor_rdma_metas.insert_or_assign(tensor_key, rdma_info);
+        }
+        for (const auto& tensor_key : diff.removed_keys) {
+            full.tensor_rdma_metas.erase(tensor_key);
+        }
+        full.seq_id = diff.seq_id;
+        full.node_info = diff.node_info;
+        full.version = diff.version;
+        SPDLOG_WARN("{} peers did not take meta diff v{}, send them the full metas", failed_peers.size(), diff.version);
+        if (!SendFullMetas(full, failed_peers)) {
+            // Keep the acknowledged snapshot, the next diff covers these changes again
+            return false;
+        }
+    }
+    AckMetaDiff(diff);
+    return true;
+}
+
+bool TensorTransferPull::BuildMetaDiff(TensorRDMAMetaPublishMessage& diff) {
+    std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+    if (step_metas_.empty() && withdrawn_keys_.empty()) {
+        return false;
+    }
+    for (const auto& [tensor_key, rdma_info] : step_metas_) {
+        auto acked_it = acked_metas_.find(tensor_key);
+        if (acked_it == acked_metas_.end() || !IsSamePublishedMeta(acked_it->second, rdma_info)) {
+            diff.tensor_rdma_metas.emplace(tensor_key, rdma_info);
+        }
+    }
+    // A step may put only part of the shards, the others stay published. A shard is withdrawn when Withdraw() was
+    // called for it, or when the tensor was put with another sharding overlapping it
+    std::unordered_map<std::string, std::vector<MetaInterest>> reput_regions;
+    for (const auto& [tensor_key, rdma_info] : step_metas_) {
+        reput_regions[tensor_key.key].emplace_back().Merge(tensor_key, rdma_info.atensor_meta);
+    }
+    for (const auto& [tensor_key, rdma_info] : acked_metas_) {
+        if (step_metas_.count(tensor_key) != 0) {
+            continue;
+        }
+        auto regions_it = reput_regions.find(tensor_key.key);
+        bool relocated = regions_it != reput_regions.end()
+            && std::any_of(regions_it->second.begin(), regions_it->second.end(), [&](const MetaInterest& region) {
+                             return region.Intersects(tensor_key, rdma_info.atensor_meta);
+                         });
+        if (relocated || withdrawn_keys_.count(tensor_key) != 0) {
+            diff.removed_keys.push_back(tensor_key);
+        }
+    }
+    if (diff.tensor_rdma_metas.empty() && diff.removed_keys.empty()) {
+        return false;
+    }
+    diff.seq_id = current_seq_id_;
+    diff.node_info = local_node_info_;
+    diff.base_version = meta_version_;
+    diff.version = meta_version_ + 1;
+    SPDLOG_INFO(
+        "Publishing meta diff v{} -> v{}: {} added or relocated, {} removed",
+        diff.base_version,
+        diff.version,
+        diff.tensor_rdma_metas.size(),
+        diff.removed_keys.size());
+    return true;
+}
+
+void TensorTransferPull::AckMetaDiff(const TensorRDMAMetaPublishMessage& diff) {
+    std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+    for (const auto& [tensor_key, rdma_info] : diff.tensor_rdma_metas) {
+        acked_metas_.insert_or_assign(tensor_key, rdma_info);
+    }
+    for (const auto& tensor_key : diff.removed_keys) {
+        acked_metas_.erase(tensor_key);
+        withdrawn_keys_.erase(tensor_key);
+    }
+    meta_version_ = diff.version;
+}
+
+bool TensorTransferPull::Withdraw(const std::vector<ShardedKey>& tensor_keys) {
+    std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+    for (const auto& tensor_key : tensor_keys) {
+        step_metas_.erase(tensor_key);
+        if (acked_metas_.count(tensor_key) != 0) {
+            withdrawn_keys_.insert(tensor_key);
+        }
+    }
+    return true;
+}
+
+void TensorTransferPull::OnMembershipChanged(const std::vector<NodeEntry>& joined, const std::vector<NodeEntry>& left) {
+    std::lock_guard<std::mutex> lock(membership_mutex_);
+    left_nodes_.insert(left_nodes_.end(), left.begin(), left.end());
+    joined_nodes_.insert(joined_nodes_.end(), joined.begin(), joined.end());
+    membership_changed_.store(true);
+}
+
+void TensorTransferPull::ApplyDepartures() {
+    if (!membership_changed_.load()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+    ApplyMembershipChanges(false);
+}
+
+std::vector<NodeInfo> TensorTransferPull::ApplyMembershipChanges(bool with_joins) {
+    std::vector<NodeEntry> left;
+    std::vector<NodeEntry> joined;
+    {
+        std::lock_guard<std::mutex> lock(membership_mutex_);
+        left.swap(left_nodes_);
+        if (with_joins) {
+            joined.swap(joined_nodes_);
+        }
+        membership_changed_.store(!joined_nodes_.empty());
+    }
+
+    for (const auto& entry : left) {
+        const NodeInfo& node_info = entry.node_info;
+        if (entry.role == role_) {
+            std::erase(group_hosts_, node_info);
+            SPDLOG_INFO("Group member [{}] left, {} in the group", node_info.ToString(), group_hosts_.size());
+            continue;
+        }
+        std::erase(peer_hosts_, node_info);
+        ready_nodes_.erase(node_info);
+        consumed_nodes_.erase(node_info);
+        remote_meta_versions_.erase(node_info);
+        peer_interests_.erase(node_info);
+        // Reads must not pick the replicas of the departed peer any more
+        size_t removed = DropRemoteShards(node_info);
+        SPDLOG_INFO(
+            "Peer [{}] left, {} peers remain, dropped {} cached shards",
+            node_info.ToString(),
+            peer_hosts_.size(),
+            removed);
+    }
+
+    std::vector<NodeInfo> joined_peers;
+    for (const auto& entry : joined) {
+        const NodeInfo& node_info = entry.node_info;
+        auto& hosts = entry.role == role_ ? group_hosts_ : peer_hosts_;
+        if (std::find(hosts.begin(), hosts.end(), node_info) != hosts.end()) {
+            continue;
+        }
+        hosts.push_back(node_info);
+        if (entry.role != role_) {
+            joined_peers.push_back(node_info);
+        }
+        SPDLOG_INFO(
+            "{} [{}] joined, {} peers, {} in the group",
+            entry.role == role_ ? "Group member" : "Peer",
+            node_info.ToString(),
+            peer_hosts_.size(),
+            group_hosts_.size());
+    }
+
+    if (!left.empty() || !joined.empty()) {
+        if (ctrl_aggregation_) {
+            RebuildControlTree();
+        }
+        RefreshPeerReadCounters();
+    }
+    return joined_peers;
+}
+
+size_t TensorTransferPull::DropRemoteShards(const NodeInfo& node_info) {
+    size_t removed = 0;
+    for (auto& [seq_id, transfer_meta] : remote_tensor_cache_) {
+        for (auto it = transfer_meta.begin(); it != transfer_meta.end();) {
+            if (std::erase_if(it->second, [&](const TensorRDMAInfo& info) { return info.node_info == node_info; })
+                > 0) {
+                changed_tensor_names_.insert(it->first.key);
+                ++removed;
+            }
+            it = it->second.empty() ? transfer_meta.erase(it) : std::next(it);
+        }
+    }
+    if (removed > 0) {
+        remote_meta_epoch_.fetch_add(1);
+    }
+    return removed;
+}
+
+bool TensorTransferPull::SendAckedMetas(const std::vector<NodeInfo>& peers) {
+    TensorRDMAMetaPublishMessage meta;
+    {
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        if (!is_publish_meta_ || acked_metas_.empty()) {
+            // Nothing published yet, the first step publishes to every peer anyway
+            return true;
+        }
+        meta.seq_id = current_seq_id_;
+        meta.node_info = local_node_info_;
+        meta.version = meta_version_;
+        meta.tensor_rdma_metas = acked_metas_;
+    }
+    return SendFullMetas(meta, peers);
+}
+
+bool TensorTransferPull::SendFullMetas(const TensorRDMAMetaPublishMessage& meta, const std::vector<NodeInfo>& peers) {
+    std::unordered_map<NodeInfo, std::vector<MetaInterest>, NodeInfoHash> peer_interests;
+    {
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        peer_interests = peer_interests_;
+    }
+    std::string full_message;
+    bool all_success = true;
+    for (const auto& peer : peers) {
+        std::string peer_message;
+        auto it = peer_interests.find(peer);
+        if (it != peer_interests.end()) {
+            peer_message = EncodeMetaMessage(FilterByInterests(meta, it->second));
+        } else if (full_message.empty()) {
+            full_message = EncodeMetaMessage(meta);
+        }
+        const auto& message = it != peer_interests.end() ? peer_message : full_message;
+        if (!SendCtrlMessage(TENSOR_RDMA_META_REQUEST, meta.seq_id, message.data(), message.size(), peer)) {
+            SPDLOG_ERROR("Failed to send the full metas v{} to peer [{}]", meta.version, peer.ToString());
+            all_success = false;
+        }
+    }
+    return all_success;
+}
+
+void TensorTransferPull::SaveMetaSnapshot(int64_t seq_id) {
+    std::unordered_map<NodeInfo, TensorRDMAMetaPublishMessage, NodeInfoHash> sender_metas;
+    uint64_t epoch = 0;
+    {
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        epoch = remote_meta_epoch_.load();
+        auto cache_it = remote_tensor_cache_.find(seq_id);
+        if (cache_it == remote_tensor_cache_.end() || saved_meta_epoch_ == epoch) {
+            return;
+        }
+        for (const auto& [tensor_key, replicas] : cache_it->second) {
+            for (const auto& info : replicas) {
+                auto& meta = sender_metas[info.node_info];
+                meta.tensor_rdma_metas.emplace(
+                    tensor_key, TensorMemoryRDMAInfo(info.addr, info.size, info.rkey, *info.atensor));
+            }
+        }
+        for (auto& [node_info, meta] : sender_metas) {
+            meta.seq_id = seq_id;
+            meta.node_info = node_info;
+            meta.version = remote_meta_versions_[node_info];
+        }
+    }
+
+    ControlRelayMessage snapshot;
+    snapshot.seq_id = seq_id;
+    snapshot.node_info = local_node_info_;
+    snapshot.hop = ControlRelayMessage::Hop::TO_MEMBER;
+    snapshot.messages.reserve(sender_metas.size());
+    for (const auto& [node_info, meta] : sender_metas) {
+        snapshot.messages.emplace_back(TENSOR_RDMA_META_REQUEST, EncodeBinary(meta));
+    }
+    if (!WriteFileAtomically(meta_snapshot_path_, EncodeBinary(snapshot))) {
+        SPDLOG_WARN("Failed to write the meta snapshot {}", meta_snapshot_path_);
+        return;
+    }
+    saved_meta_epoch_ = epoch;
+    SPDLOG_INFO(
+        "Saved the meta snapshot of seq {} from {} senders to {}", seq_id, sender_metas.size(), meta_snapshot_path_);
+}
+
+bool TensorTransferPull::RestoreMetaSnapshot() {
+    auto content = ReadFile(meta_snapshot_path_);
+    if (!content.has_value()) {
+        SPDLOG_INFO("No meta snapshot at {}", meta_snapshot_path_);
+        return false;
+    }
+    try {
+        auto snapshot = DecodeBinary(content->data(), content->size(), ControlRelayMessage{});
+        for (const auto& [request, payload] : snapshot.messages) {
+            auto meta = DecodeBinary(payload.data(), payload.size(), TensorRDMAMetaPublishMessage{});
+            if (request != TENSOR_RDMA_META_REQUEST
+                || std::find(peer_hosts_.begin(), peer_hosts_.end(), meta.node_info) == peer_hosts_.end()) {
+                throw std::runtime_error("unexpected sender " + meta.node_info.ToString());
+            }
+        }
+        // Replayed as the initial publishes of the senders. The snapshot misses the diffs applied after it was
+        // written, so no diff applies on top of it: the senders send their full metas again (see SendMetaResync)
+        for (const auto& [request, payload] : snapshot.messages) {
+            auto status = HandleTensorRDMAMeta(request, payload.data(), payload.size());
+            if (!status.success) {
+                throw std::runtime_error(status.status_message);
+            }
+        }
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        for (auto& [node_info, version] : remote_meta_versions_) {
+            version = 0;
+            restored_senders_.insert(node_info);
+        }
+        meta_resync_pending_ = true;
+        is_publish_meta_ = true;
+        last_completed_seq_id_ = snapshot.seq_id;
+        saved_meta_epoch_ = remote_meta_epoch_.load();
+        SPDLOG_INFO(
+            "Restored the metas of seq {} from {} senders from the meta snapshot {}",
+            snapshot.seq_id,
+            snapshot.messages.size(),
+            meta_snapshot_path_);
+        return true;
+    } catch (const std::exception& e) {
+        SPDLOG_WARN("Ignore invalid meta snapshot {}: {}", meta_snapshot_path_, e.what());
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        remote_tensor_cache_.clear();
+        remote_meta_versions_.clear();
+        restored_senders_.clear();
+        return false;
+    }
+}
+
+TransferTensorMeta* TensorTransferPull::InheritRemoteTensorCache(int64_t seq_id) {
+    auto cache_it = remote_tensor_cache_.find(seq_id);
+    if (cache_it != remote_tensor_cache_.end()) {
+        return &(cache_it->second);
+    }
+    auto last_it = remote_tensor_cache_.end();
+    for (auto it = remote_tensor_cache_.begin(); it != remote_tensor_cache_.end(); ++it) {
+        if (it->first < seq_id && (last_it == remote_tensor_cache_.end() || it->first > last_it->first)) {
+            last_it = it;
+        }
+    }
+    if (last_it == remote_tensor_cache_.end()) {
+        return nullptr;
+    }
+    TransferTensorMeta transfer_meta = std::move(last_it->second);
+    remote_tensor_cache_.erase(last_it);
+    return &(remote_tensor_cache_.emplace(seq_id, std::move(transfer_meta)).first->second);
+}
+
+bool TensorTransferPull::ApplyMetaDiff(const TensorRDMAMetaPublishMessage& msg) {
+    auto& known_version = remote_meta_versions_[msg.node_info];
+    if (msg.base_version != known_version) {
+        // A diff only holds the changes since its base, over another version it would keep withdrawn shards or miss
+        // relocated ones. An unacknowledged diff is resent with the same versions, so this also covers duplicates
+        SPDLOG_WARN(
+            "Reject meta diff v{} -> v{} from {}, v{} is applied",
+            msg.base_version,
+            msg.version,
+            msg.node_info.ToString(),
+            known_version);
+        return false;
+    }
+
+    TransferTensorMeta* transfer_meta = InheritRemoteTensorCache(msg.seq_id);
+    if (transfer_meta == nullptr) {
+        transfer_meta = &(remote_tensor_cache_[msg.seq_id]);
+    }
+    MetricCounter* read_bytes = &PeerReadCounter(msg.node_info.hostname_or_ip, msg.node_info.rdma_port);
+    for (const auto& [tensor_key, protocol_info] : msg.tensor_rdma_metas) {
+        ReplaceTensorRDMAInfo(
+            *transfer_meta,
+            tensor_key,
+            protocol_info.addr,
+            protocol_info.size,
+            protocol_info.rkey,
+            msg.node_info,
+            std::make_shared<ATensor>(protocol_info.atensor_meta),
+            read_bytes);
+        changed_tensor_names_.insert(tensor_key.key);
+    }
+    for (const auto& tensor_key : msg.removed_keys) {
+        RemoveTensorRDMAInfo(*transfer_meta, tensor_key, msg.node_info);
+        changed_tensor_names_.insert(tensor_key.key);
+    }
+    known_version = msg.version;
+    remote_meta_epoch_.fetch_add(1);
+    SPDLOG_INFO(
+        "Applied meta diff v{} -> v{} from {}: {} added or relocated, {} removed",
+        msg.base_version,
+        msg.version,
+        msg.node_info.ToString(),
+        msg.tensor_rdma_metas.size(),
+        msg.removed_keys.size());
+    return true;
+}
+
+std::unordered_set<std::string> TensorTransferPull::TakeChangedTensorNames() {
+    std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+    return std::exchange(changed_tensor_names_, {});
 }
 
 void TensorTransferPull::SetPeerHosts(const std::vector<NodeInfo>& peer_hosts) {
+    std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
     peer_hosts_ = peer_hosts;
+    if (ctrl_aggregation_) {
+        RebuildControlTree();
+    }
+    RefreshPeerReadCounters();
 }
 
-bool TensorTransferPull::SendTensorRDMAMeta(const TensorRDMAMetaPublishMessage& meta) {
-    auto message_data = Serialize(ToJson(meta));
-    return SendCtrlMessageToMultiPeers(
-        TENSOR_RDMA_META_REQUEST, meta.seq_id, message_data.c_str(), message_data.size(), peer_hosts_);
+void TensorTransferPull::RefreshPeerReadCounters() {
+    auto counters = std::make_shared<PeerCounters>();
+    for (const auto* hosts : {&peer_hosts_, &group_hosts_}) {
+        for (const auto& node_info : *hosts) {
+            auto key = node_info.GetHostWithRdmaPort();
+            counters->emplace(key, &GetMetricsRegistry().GetCounter(kPeerReadBytes, key));
+        }
+    }
+    std::atomic_store(&peer_read_bytes_, std::shared_ptr<const PeerCounters>(std::move(counters)));
+}
+
+std::string TensorTransferPull::EncodeMetaMessage(const TensorRDMAMetaPublishMessage& meta) const {
+    return binary_meta_encoding_ ? EncodeBinary(meta) : Serialize(ToJson(meta));
+}
+
+bool TensorTransferPull::SendTensorRDMAMeta(
+    const TensorRDMAMetaPublishMessage& meta, std::vector<NodeInfo>* failed_peers) {
+    auto encode = [this](const TensorRDMAMetaPublishMessage& msg) { return EncodeMetaMessage(msg); };
+    std::unordered_map<NodeInfo, std::vector<MetaInterest>, NodeInfoHash> peer_interests;
+    {
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        peer_interests = peer_interests_;
+    }
+    if (peer_interests.empty() && failed_peers == nullptr) {
+        auto message_data = encode(meta);
+        return SendCtrlMessageToMultiPeers(
+            TENSOR_RDMA_META_REQUEST, meta.seq_id, message_data.c_str(), message_data.size(), peer_hosts_);
+    }
+
+    // Subscribed peers get their own slice, the others the whole message
+    std::string full_message;
+    std::vector<std::string> peer_messages(peer_hosts_.size());
+    std::vector<const std::string*> peer_message_ptrs(peer_hosts_.size(), &full_message);
+    size_t filtered_bytes = 0;
+    for (size_t i = 0; i < peer_hosts_.size(); ++i) {
+        auto it = peer_interests.find(peer_hosts_[i]);
+        if (it == peer_interests.end()) {
+            if (full_message.empty()) {
+                full_message = encode(meta);
+            }
+            continue;
+        }
+        peer_messages[i] = encode(FilterByInterests(meta, it->second));
+        peer_message_ptrs[i] = &peer_messages[i];
+        filtered_bytes += peer_messages[i].size();
+    }
+    if (is_debug_mode_) {
+        SPDLOG_INFO(
+            "Send meta of seq {} to {} subscribed peers with {} bytes in total",
+            meta.seq_id,
+            peer_interests.size(),
+            filtered_bytes);
+    }
+
+    std::vector<std::future<bool>> futures;
+    futures.reserve(peer_hosts_.size());
+    for (size_t i = 0; i < peer_hosts_.size(); ++i) {
+        futures.push_back(thread_pool_->Submit([this, &meta, &peer = peer_hosts_[i], message = peer_message_ptrs[i]]() {
+            return SendCtrlMessage(TENSOR_RDMA_META_REQUEST, meta.seq_id, message->data(), message->size(), peer);
+        }));
+    }
+    bool all_success = true;
+    for (size_t i = 0; i < futures.size(); ++i) {
+        if (!futures[i].get()) {
+            all_success = false;
+            if (failed_peers != nullptr) {
+                failed_peers->push_back(peer_hosts_[i]);
+            }
+        }
+    }
+    return all_success;
 }
 
 bool TensorTransferPull::SendWeightReady(const WeightReadyMessage& msg) {
@@ -524,18 +1266,149 @@ bool TensorTransferPull::SendWeightConsumed(const WeightConsumedMessage& msg) {
         WEIGHT_CONSUMED_REQUEST, msg.seq_id, message_data.c_str(), message_data.size(), peer_hosts_);
 }
 
+bool TensorTransferPull::SendMetaSubscription() {
+    MetaSubscriptionMessage msg{current_seq_id_, local_node_info_, {}};
+    {
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        if (meta_interests_.empty()) {
+            return true;
+        }
+        msg.interests.reserve(meta_interests_.size());
+        for (const auto& [key, interest] : meta_interests_) {
+            msg.interests.push_back(interest);
+        }
+    }
+
+    auto message_data = Serialize(ToJson(msg));
+    if (!SendCtrlMessageToMultiPeers(
+            META_SUBSCRIPTION_REQUEST, msg.seq_id, message_data.c_str(), message_data.size(), peer_hosts_)) {
+        return false;
+    }
+    meta_subscribed_ = true;
+
+    // Drop the metas outside of the subscription, they are not updated any more and must not be read
+    std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+    size_t dropped = 0;
+    for (auto& [seq_id, transfer_meta] : remote_tensor_cache_) {
+        dropped += std::erase_if(transfer_meta, [this](const auto& entry) {
+            auto it = meta_interests_.find(entry.first.key);
+            bool subscribed = it != meta_interests_.end()
+                && std::any_of(entry.second.begin(), entry.second.end(), [&](const TensorRDMAInfo& info) {
+                                  return info.atensor != nullptr && it->second.Intersects(entry.first, *info.atensor);
+                              });
+            if (!subscribed) {
+                changed_tensor_names_.insert(entry.first.key);
+            }
+            return !subscribed;
+        });
+    }
+    if (dropped > 0) {
+        remote_meta_epoch_.fetch_add(1);
+    }
+    SPDLOG_INFO(
+        "Subscribed tensor metas of {} tensors from {} peers, dropped {} cached shards outside of the subscription",
+        msg.interests.size(),
+        peer_hosts_.size(),
+        dropped);
+    return true;
+}
+
+bool TensorTransferPull::SendMetaResync() {
+    auto message_data = Serialize(ToJson(MetaResyncMessage{current_seq_id_, local_node_info_}));
+    if (!SendCtrlMessageToMultiPeers(
+            META_RESYNC_REQUEST, current_seq_id_, message_data.c_str(), message_data.size(), peer_hosts_)) {
+        meta_resync_pending_ = true;
+        return false;
+    }
+    meta_resync_pending_ = false;
+    SPDLOG_INFO("Asked {} senders for their full metas", peer_hosts_.size());
+    return true;
+}
+
+void TensorTransferPull::RecordMetaInterest(const ShardedKey& tensor_key, const ATensor& remote_atensor) {
+    if (!meta_subscription_enabled_ || meta_subscribed_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+    meta_interests_[tensor_key.key].Merge(tensor_key, remote_atensor);
+}
+
+void TensorTransferPull::RecordMetaMiss(const ShardedKey& tensor_key, const ATensor& atensor) {
+    if (!meta_subscription_enabled_ || !meta_subscribed_) {
+        // Not filtered, the miss is not caused by the subscription
+        return;
+    }
+    std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+    meta_interests_[tensor_key.key].Merge(tensor_key, atensor);
+    meta_subscribed_ = false;
+    SPDLOG_WARN("Read of {} is outside of the subscribed metas, subscribe again with Complete()", tensor_key.key);
+}
+
 ResponseStatus
 TensorTransferPull::HandleTensorRDMAMeta(const std::string& /*request*/, const void* message, size_t message_size) {
     try {
-        std::string message_str(static_cast<const char*>(message), message_size);
-        if (is_debug_mode_) {
-            SPDLOG_INFO("Received RDMA meta message: {}", message_str);
+        // Peers may still send JSON, decide by the content rather than by the local option
+        TensorRDMAMetaPublishMessage msg;
+        if (IsBinaryMessage(message, message_size)) {
+            msg = DecodeBinary(message, message_size, TensorRDMAMetaPublishMessage{});
+            if (is_debug_mode_) {
+                SPDLOG_INFO(
+                    "Received binary RDMA meta message: seq_id={}, node=[{}], tensors={}, bytes={}",
+                    msg.seq_id,
+                    msg.node_info.ToString(),
+                    msg.tensor_rdma_metas.size(),
+                    message_size);
+            }
+        } else {
+            std::string message_str(static_cast<const char*>(message), message_size);
+            if (is_debug_mode_) {
+                SPDLOG_INFO("Received RDMA meta message: {}", message_str);
+            }
+            msg = FromJson(Deserialize(message_str), TensorRDMAMetaPublishMessage{});
         }
-        auto json = Deserialize(message_str);
-        TensorRDMAMetaPublishMessage msg = FromJson(json, TensorRDMAMetaPublishMessage{});
 
         {
             std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+            if (msg.IsDiff()) {
+                if (!ApplyMetaDiff(msg)) {
+                    return ResponseStatus{false, "Meta diff does not apply, full metas needed", ExtendInfo{}};
+                }
+                return ResponseStatus{true, "Success", ExtendInfo{}};
+            }
+            auto& known_version = remote_meta_versions_[msg.node_info];
+            if (msg.version > 1 || known_version > 1 || restored_senders_.erase(msg.node_info) != 0) {
+                // Full metas of a later version (resync after a rejected diff, or a joined node), a restarted
+                // sender publishing from scratch, or the answer to SendMetaResync: they replace everything cached
+                // from the sender
+                size_t dropped = DropRemoteShards(msg.node_info);
+                TransferTensorMeta* transfer_meta = InheritRemoteTensorCache(msg.seq_id);
+                if (transfer_meta == nullptr) {
+                    transfer_meta = &(remote_tensor_cache_[msg.seq_id]);
+                }
+                MetricCounter* read_bytes = &PeerReadCounter(msg.node_info.hostname_or_ip, msg.node_info.rdma_port);
+                for (const auto& [tensor_key, protocol_info] : msg.tensor_rdma_metas) {
+                    ReplaceTensorRDMAInfo(
+                        *transfer_meta,
+                        tensor_key,
+                        protocol_info.addr,
+                        protocol_info.size,
+                        protocol_info.rkey,
+                        msg.node_info,
+                        std::make_shared<ATensor>(protocol_info.atensor_meta),
+                        read_bytes);
+                    changed_tensor_names_.insert(tensor_key.key);
+                }
+                known_version = msg.version;
+                remote_meta_epoch_.fetch_add(1);
+                SPDLOG_INFO(
+                    "Replaced {} cached shards from {} with its full metas v{}, {} shards",
+                    dropped,
+                    msg.node_info.ToString(),
+                    msg.version,
+                    msg.tensor_rdma_metas.size());
+                return ResponseStatus{true, "Success", ExtendInfo{}};
+            }
+            known_version = msg.version;
 
             // First check if TransferTensorMeta exists for this seq_id
             auto cache_it = remote_tensor_cache_.find(msg.seq_id);
@@ -552,6 +1425,7 @@ TensorTransferPull::HandleTensorRDMAMeta(const std::string& /*request*/, const v
             }
 
             // Process tensor information in the message
+            MetricCounter* read_bytes = &PeerReadCounter(msg.node_info.hostname_or_ip, msg.node_info.rdma_port);
             for (const auto& pair : msg.tensor_rdma_metas) {
                 const ShardedKey& key = pair.first;
                 const TensorMemoryRDMAInfo& protocol_info = pair.second;
@@ -564,6 +1438,8 @@ TensorTransferPull::HandleTensorRDMAMeta(const std::string& /*request*/, const v
                 node_info.rdma_port = msg.node_info.rdma_port;
                 node_info.ctrl_flow_port = msg.node_info.ctrl_flow_port;
 
+                // The acked metas sent again to a resubscribed peer hold shards it already has
+                RemoveTensorRDMAInfo(*transfer_meta, key, msg.node_info);
                 EmplaceTensorRDMAInfo(
                     *transfer_meta,
                     key,
@@ -571,7 +1447,8 @@ TensorTransferPull::HandleTensorRDMAMeta(const std::string& /*request*/, const v
                     protocol_info.size,
                     protocol_info.rkey,
                     node_info,
-                    std::make_shared<ATensor>(protocol_info.atensor_meta));
+                    std::make_shared<ATensor>(protocol_info.atensor_meta),
+                    read_bytes);
             }
         }
 
@@ -593,6 +1470,11 @@ TensorTransferPull::HandleWeightReady(const std::string& /*request*/, const void
         WeightReadyMessage msg = FromJson(json, WeightReadyMessage{});
 
         std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        if (elastic_membership_ && !IsPeer(msg.node_info)) {
+            // Left already, or joined but takes part from the next step on
+            SPDLOG_WARN("Ignore weight ready of seq {} from non-member [{}]", msg.seq_id, msg.node_info.ToString());
+            return ResponseStatus{true, "Success", ExtendInfo{}};
+        }
         ready_nodes_.insert(msg.node_info);
 
         if (ready_nodes_.size() == peer_hosts_.size() && enable_local_cache_prefetch_) {
@@ -634,6 +1516,10 @@ TensorTransferPull::HandleWeightConsumed(const std::string& /*request*/, const v
                 current_seq_id_);
             return ResponseStatus{false, "Outdated sequence ID", ExtendInfo{}};
         }
+        if (elastic_membership_ && !IsPeer(msg.node_info)) {
+            SPDLOG_WARN("Ignore weight consumed of seq {} from non-member [{}]", msg.seq_id, msg.node_info.ToString());
+            return ResponseStatus{true, "Success", ExtendInfo{}};
+        }
         consumed_nodes_.insert(msg.node_info);
         return ResponseStatus{true, "Success", ExtendInfo{}};
 
@@ -643,6 +1529,299 @@ TensorTransferPull::HandleWeightConsumed(const std::string& /*request*/, const v
     }
 }
 
+ResponseStatus
+TensorTransferPull::HandleMetaSubscription(const std::string& /*request*/, const void* message, size_t message_size) {
+    try {
+        std::string message_str(static_cast<const char*>(message), message_size);
+        if (is_debug_mode_) {
+            SPDLOG_INFO("Received meta subscription message: {}", message_str);
+        }
+        MetaSubscriptionMessage msg = FromJson(Deserialize(message_str), MetaSubscriptionMessage{});
+
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        SPDLOG_INFO(
+            "Peer [{}] subscribed tensor metas of {} tensors at seq {}",
+            msg.node_info.ToString(),
+            msg.interests.size(),
+            msg.seq_id);
+        if (!peer_interests_.insert_or_assign(msg.node_info, std::move(msg.interests)).second) {
+            // The peer already got metas filtered by its old subscription, send it the acked metas again
+            resync_peers_.insert(msg.node_info);
+        }
+        return ResponseStatus{true, "Success", ExtendInfo{}};
+    } catch (const std::exception& e) {
+        SPDLOG_ERROR("Failed to process meta subscription message: {}", e.what());
+        return ResponseStatus{false, e.what(), ExtendInfo{}};
+    }
+}
+
+ResponseStatus
+TensorTransferPull::HandleMetaResync(const std::string& /*request*/, const void* message, size_t message_size) {
+    try {
+        std::string message_str(static_cast<const char*>(message), message_size);
+        MetaResyncMessage msg = FromJson(Deserialize(message_str), MetaResyncMessage{});
+
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        SPDLOG_INFO(
+            "Peer [{}] restored its metas, send it the full metas with the next step", msg.node_info.ToString());
+        resync_peers_.insert(msg.node_info);
+        return ResponseStatus{true, "Success", ExtendInfo{}};
+    } catch (const std::exception& e) {
+        SPDLOG_ERROR("Failed to process meta resync message: {}", e.what());
+        return ResponseStatus{false, e.what(), ExtendInfo{}};
+    }
+}
+
+void TensorTransferPull::RebuildControlTree() {
+    auto control_tree = std::make_shared<const ControlTree>(local_node_info_, group_hosts_, peer_hosts_);
+    SPDLOG_INFO("Control message aggregation by host: {}", control_tree->ToString());
+    std::atomic_store(&control_tree_, std::move(control_tree));
+}
+
+bool TensorTransferPull::RelayCtrlMessages(std::vector<std::pair<std::string, std::string>> messages) {
+    int64_t seq_id = current_seq_id_;
+    std::shared_ptr<const ControlTree> control_tree = std::atomic_load(&control_tree_);
+    if (!control_tree->IsLeader()) {
+        ControlRelayMessage relay{seq_id, local_node_info_, ControlRelayMessage::Hop::TO_LEADER, std::move(messages)};
+        if (!SendRelays({{control_tree->GetLeader(), EncodeBinary(relay)}})) {
+            SPDLOG_WARN(
+                "Failed to hand control messages of seq {} to leader [{}], send them to all peers directly",
+                seq_id,
+                control_tree->GetLeader().ToString());
+            return false;
+        }
+        // Handed over only, the leader reports once it forwarded the group. It waits for the other members first
+        std::unique_lock<std::mutex> lock(relay_mutex_);
+        bool reported = relay_cv_.wait_for(lock, std::chrono::milliseconds(2 * relay_timeout_ms_), [this, seq_id]() {
+            return relay_results_.count(seq_id) != 0;
+        });
+        bool forwarded = reported && relay_results_[seq_id];
+        relay_results_.erase(relay_results_.begin(), relay_results_.upper_bound(seq_id));
+        if (!forwarded) {
+            SPDLOG_WARN(
+                "Leader [{}] {} control messages of seq {}, send them to all peers directly",
+                control_tree->GetLeader().ToString(),
+                reported ? "failed to forward" : "did not report forwarding",
+                seq_id);
+        }
+        return forwarded;
+    }
+
+    // Leader: wait for the members of the host, then forward the whole group at once
+    std::vector<std::pair<std::string, std::string>> group_messages;
+    std::vector<NodeInfo> contributors;
+    {
+        std::unique_lock<std::mutex> lock(relay_mutex_);
+        auto& round = relay_rounds_[seq_id];
+        round.contributors.insert(local_node_info_);
+        round.messages.insert(
+            round.messages.begin(), std::make_move_iterator(messages.begin()), std::make_move_iterator(messages.end()));
+        size_t member_num = control_tree->GetMembers().size();
+        if (!relay_cv_.wait_for(lock, std::chrono::milliseconds(relay_timeout_ms_), [&round, member_num]() {
+                return round.contributors.size() >= member_num;
+            })) {
+            SPDLOG_WARN(
+                "Only {}/{} members handed over control messages of seq {} in {} ms, forward them and the rest later",
+                round.contributors.size(),
+                member_num,
+                seq_id,
+                relay_timeout_ms_);
+        }
+        group_messages = std::move(round.messages);
+        for (const auto& contributor : round.contributors) {
+            if (!(contributor == local_node_info_)) {
+                contributors.push_back(contributor);
+            }
+        }
+        relay_flushed_seq_ = std::max(relay_flushed_seq_, seq_id);
+        relay_rounds_.erase(relay_rounds_.begin(), relay_rounds_.upper_bound(seq_id));
+    }
+    bool forwarded = ForwardToPeerLeaders(seq_id, group_messages);
+    SendRelayResults(seq_id, contributors, forwarded);
+    if (!forwarded) {
+        SPDLOG_WARN("Failed to forward control messages of seq {}, send the own ones to all peers directly", seq_id);
+    }
+    return forwarded;
+}
+
+void TensorTransferPull::SendRelayResults(int64_t seq_id, const std::vector<NodeInfo>& members, bool forwarded) {
+    auto hop = forwarded ? ControlRelayMessage::Hop::FORWARDED : ControlRelayMessage::Hop::FORWARD_FAILED;
+    auto data = EncodeBinary(ControlRelayMessage{seq_id, local_node_info_, hop, {}});
+    std::vector<std::pair<NodeInfo, std::string>> relays;
+    relays.reserve(members.size());
+    for (const auto& member : members) {
+        relays.emplace_back(member, data);
+    }
+    if (!SendRelays(relays)) {
+        // The members not reached time out and send their messages themselves
+        SPDLOG_WARN("Failed to report the forwarding of seq {} to {} members", seq_id, members.size());
+    }
+}
+
+bool TensorTransferPull::ForwardToPeerLeaders(
+    int64_t seq_id, const std::vector<std::pair<std::string, std::string>>& messages) {
+    std::shared_ptr<const ControlTree> control_tree = std::atomic_load(&control_tree_);
+    std::vector<std::pair<NodeInfo, std::string>> relays;
+    relays.reserve(control_tree->GetPeerLeaders().size());
+    for (const auto& peer_leader : control_tree->GetPeerLeaders()) {
+        ControlRelayMessage relay{
+            seq_id,
+            local_node_info_,
+            ControlRelayMessage::Hop::TO_PEER_LEADER,
+            FilterRelayedMetas(messages, control_tree->GetPeerGroup(peer_leader))};
+        relays.emplace_back(peer_leader, EncodeBinary(relay));
+    }
+    if (is_debug_mode_) {
+        SPDLOG_INFO(
+            "Forward {} control messages of seq {} to {} peer leaders", messages.size(), seq_id, relays.size());
+    }
+    return SendRelays(relays);
+}
+
+std::vector<std::pair<std::string, std::string>> TensorTransferPull::FilterRelayedMetas(
+    const std::vector<std::pair<std::string, std::string>>& messages, const std::vector<NodeInfo>& peer_group) {
+    std::vector<MetaInterest> group_interests;
+    {
+        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+        for (const auto& member : peer_group) {
+            auto it = peer_interests_.find(member);
+            if (it == peer_interests_.end()) {
+                return messages;
+            }
+            group_interests.insert(group_interests.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    std::vector<std::pair<std::string, std::string>> filtered;
+    filtered.reserve(messages.size());
+    for (const auto& [request, payload] : messages) {
+        if (request != TENSOR_RDMA_META_REQUEST) {
+            filtered.emplace_back(request, payload);
+            continue;
+        }
+        if (IsBinaryMessage(payload.data(), payload.size())) {
+            auto meta = DecodeBinary(payload.data(), payload.size(), TensorRDMAMetaPublishMessage{});
+            filtered.emplace_back(request, EncodeBinary(FilterByInterests(meta, group_interests)));
+        } else {
+            auto meta = FromJson(Deserialize(payload), TensorRDMAMetaPublishMessage{});
+            filtered.emplace_back(request, Serialize(ToJson(FilterByInterests(meta, group_interests))));
+        }
+    }
+    return filtered;
+}
+
+bool TensorTransferPull::SendRelays(const std::vector<std::pair<NodeInfo, std::string>>& relays) {
+    // Relays may belong to a step this node already completed, so the seq id is not validated
+    auto send = [this](const NodeInfo& node, const std::string& data) {
+        try {
+            return control_transport_->Send(
+                CONTROL_RELAY_REQUEST, data.data(), data.size(), node.hostname_or_ip, node.ctrl_flow_port, nullptr);
+        } catch (const std::exception& e) {
+            SPDLOG_ERROR("Failed to relay control messages to [{}]: {}", node.ToString(), e.what());
+            return false;
+        }
+    };
+    std::vector<std::future<bool>> futures;
+    futures.reserve(relays.size());
+    for (const auto& [node, data] : relays) {
+        futures.push_back(thread_pool_->Submit([&send, &node, &data]() { return send(node, data); }));
+    }
+    bool all_success = true;
+    for (auto& future : futures) {
+        all_success &= future.get();
+    }
+    return all_success;
+}
+
+bool TensorTransferPull::DispatchRelayedMessages(const std::vector<std::pair<std::string, std::string>>& messages) {
+    bool all_success = true;
+    for (const auto& [request, payload] : messages) {
+        ResponseStatus status{false, "Unknown relayed request: " + request, ExtendInfo{}};
+        if (request == TENSOR_RDMA_META_REQUEST) {
+            status = HandleTensorRDMAMeta(request, payload.data(), payload.size());
+        } else if (request == WEIGHT_READY_REQUEST) {
+            status = HandleWeightReady(request, payload.data(), payload.size());
+        } else if (request == WEIGHT_CONSUMED_REQUEST) {
+            status = HandleWeightConsumed(request, payload.data(), payload.size());
+        }
+        if (!status.success) {
+            SPDLOG_ERROR("Failed to handle relayed [{}] message: {}", request, status.status_message);
+            all_success = false;
+        }
+    }
+    return all_success;
+}
+
+ResponseStatus
+TensorTransferPull::HandleControlRelay(const std::string& /*request*/, const void* message, size_t message_size) {
+    try {
+        auto relay = DecodeBinary(message, message_size, ControlRelayMessage{});
+        if (is_debug_mode_) {
+            SPDLOG_INFO(
+                "Received {} relayed control messages of seq {} from [{}], hop {}",
+                relay.messages.size(),
+                relay.seq_id,
+                relay.node_info.ToString(),
+                static_cast<int>(relay.hop));
+        }
+
+        bool success = true;
+        switch (relay.hop) {
+            case ControlRelayMessage::Hop::TO_LEADER: {
+                {
+                    std::lock_guard<std::mutex> lock(relay_mutex_);
+                    if (relay.seq_id > relay_flushed_seq_) {
+                        auto& round = relay_rounds_[relay.seq_id];
+                        if (round.contributors.insert(relay.node_info).second) {
+                            std::move(relay.messages.begin(), relay.messages.end(), std::back_inserter(round.messages));
+                        }
+                        relay_cv_.notify_all();
+                        break;
+                    }
+                }
+                // The leader already forwarded this step, the late member goes on its own
+                SPDLOG_WARN(
+                    "Control messages of seq {} from [{}] arrived late, forward them alone",
+                    relay.seq_id,
+                    relay.node_info.ToString());
+                SendRelayResults(
+                    relay.seq_id, {relay.node_info}, ForwardToPeerLeaders(relay.seq_id, relay.messages));
+                break;
+            }
+            case ControlRelayMessage::Hop::TO_PEER_LEADER: {
+                // Hand down to the members of this host first, then handle locally
+                ControlRelayMessage down{
+                    relay.seq_id, local_node_info_, ControlRelayMessage::Hop::TO_MEMBER, relay.messages};
+                auto data = EncodeBinary(down);
+                std::vector<std::pair<NodeInfo, std::string>> relays;
+                std::shared_ptr<const ControlTree> control_tree = std::atomic_load(&control_tree_);
+                for (const auto& member : control_tree->GetMembers()) {
+                    if (!(member == local_node_info_)) {
+                        relays.emplace_back(member, data);
+                    }
+                }
+                success = SendRelays(relays);
+                success &= DispatchRelayedMessages(relay.messages);
+                break;
+            }
+            case ControlRelayMessage::Hop::TO_MEMBER:
+                success = DispatchRelayedMessages(relay.messages);
+                break;
+            case ControlRelayMessage::Hop::FORWARDED:
+            case ControlRelayMessage::Hop::FORWARD_FAILED: {
+                std::lock_guard<std::mutex> lock(relay_mutex_);
+                relay_results_[relay.seq_id] = relay.hop == ControlRelayMessage::Hop::FORWARDED;
+                relay_cv_.notify_all();
+                break;
+            }
+        }
+        return ResponseStatus{success, success ? "Success" : "Failed to relay control messages", ExtendInfo{}};
+    } catch (const std::exception& e) {
+        SPDLOG_ERROR("Failed to process control relay message: {}", e.what());
+        return ResponseStatus{false, e.what(), ExtendInfo{}};
+    }
+}
+
 bool TensorTransferPull::SendCtrlMessage(
     const std::string& request_name,
     const int64_t seq_id,
@@ -762,8 +1941,8 @@ bool TensorTransferPull::RawGet(
         astorage.device.device_index);
     ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(remote_addr);
 
-    UpdateThroughputStatistic(node_info.GetHostWithRdmaPort(), len);
-    return data_rdma_transport_->Receive(
+    PeerReadCounter(node_info.hostname_or_ip, node_info.rdma_port).Add(len);
+    return data_transport_->Receive(
         astorage.data, len, node_info.hostname_or_ip, node_info.rdma_port, &extend_info);
 }
 
@@ -867,7 +2046,16 @@ std::vector<CompactTensorInfo> TensorTransferPull::GetCompactTensorInfos(
         }
     }
 
+    for (const auto& [sharded_key, rdma_info_list] : target_transfer_meta) {
+        RecordMetaInterest(sharded_key, *rdma_info_list.back().atensor);
+    }
+
     if (target_transfer_meta.size() != atensors.size()) {
+        for (const auto& [sharded_key, atensor] : atensors) {
+            if (target_transfer_meta.count(sharded_key) == 0) {
+                RecordMetaMiss(sharded_key, atensor);
+            }
+        }
         SPDLOG_ERROR(
             "target_transfer_meta.size() != atensors.size(), "
             "target_transfer_meta.size(): {}, atensors.size(): {}",
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <cstdlib>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <random>
 #include <string>
 #include <unordered_map>
@@ -24,15 +29,17 @@
 #include "core/shardedkey.h"
 #include "discovery/discovery_manager.h"
 #include "protocol/messages.h"
+#include "transfer/control_tree.h"
 #include "transfer/tensor_transfer_service.h"
 #include "transfer/types.h"
 #include "transport/base_transport.h"
 #include "transport/rdma_transporter.h"
+#include "transport/tcp_transporter.h"
 
 namespace astate {
 /*
  * TensorTransferPull is a class that implements the TensorTransferService interface for pulling model weights.
- * It uses rdma data transport to pull model weights from remote nodes, while using control transport to send control
+ * It uses rdma (or tcp) data transport to pull model weights from remote nodes, while using control transport to send control
  * messages.
  */
 constexpr int64_t INIT_SEQ_ID = -1;
@@ -40,6 +47,11 @@ constexpr int64_t INIT_SEQ_ID = -1;
 constexpr const char* TENSOR_RDMA_META_REQUEST = "publish_tensor_rdma_meta";
 constexpr const char* WEIGHT_READY_REQUEST = "weight_ready";
 constexpr const char* WEIGHT_CONSUMED_REQUEST = "weight_consumed";
+constexpr const char* META_SUBSCRIPTION_REQUEST = "subscribe_tensor_meta";
+constexpr const char* META_RESYNC_REQUEST = "resync_tensor_meta";
+constexpr const char* CONTROL_RELAY_REQUEST = "relay_control_messages";
+// Prometheus text of the process metrics over the control transport, the brpc server also serves GET /metrics
+constexpr const char* METRICS_REQUEST = "metrics";
 
 class TensorTransferPull : public TensorTransferService {
  public:
@@ -65,6 +77,8 @@ class TensorTransferPull : public TensorTransferService {
 
     void Complete() override;
 
+    bool Withdraw(const std::vector<ShardedKey>& tensor_keys) override;
+
     void SetPeerHosts(const std::vector<NodeInfo>& peer_hosts);
 
     [[nodiscard]] std::vector<std::pair<ShardedKey, ATensor>>
@@ -73,12 +87,17 @@ class TensorTransferPull : public TensorTransferService {
     [[nodiscard]] std::vector<CompactTensorInfo>
     GetCompactTensorInfos(int64_t seq_id, std::unordered_map<ShardedKey, ATensor, ShardedKeyHash> atensors) override;
 
+    [[nodiscard]] uint64_t GetRemoteMetaEpoch() const override { return remote_meta_epoch_.load(); }
+
+    std::unordered_set<std::string> TakeChangedTensorNames() override;
+
  protected:
     ATensorStorageCtx* ctx_ = nullptr;
 
     bool is_debug_mode_{false};
+    bool binary_meta_encoding_{false}; // TRANSFER_ENGINE_META_ENCODING
 
-    std::unique_ptr<RDMATransporter> data_rdma_transport_;
+    std::unique_ptr<BaseDataTransport> data_transport_; // RDMA by default, see TRANSFER_ENGINE_TYPE
     std::unique_ptr<BaseControlTransport> control_transport_;
     std::unique_ptr<DiscoveryManager> discovery_manager_;
 
@@ -102,6 +121,61 @@ class TensorTransferPull : public TensorTransferService {
     bool is_publish_meta_{false};
     int64_t last_completed_seq_id_{INIT_SEQ_ID};
 
+    // Versioned meta publishing, sender side: version 1 is the initial publish of the first step, every later step
+    // sends the diff of the shards it put against the snapshot all peers acknowledged
+    uint64_t meta_version_{0};
+    std::unordered_map<ShardedKey, TensorMemoryRDMAInfo, ShardedKeyHash> acked_metas_;
+    std::unordered_map<ShardedKey, TensorMemoryRDMAInfo, ShardedKeyHash> step_metas_;
+    std::unordered_set<ShardedKey, ShardedKeyHash> withdrawn_keys_; // see Withdraw, removed by the next diff
+    // Receiver side: latest meta version applied per sender, and the tensors changed by diffs
+    std::unordered_map<NodeInfo, uint64_t, NodeInfoHash> remote_meta_versions_;
+    std::unordered_set<std::string> changed_tensor_names_;
+    std::atomic<uint64_t> remote_meta_epoch_{0};
+
+    // Interest-based meta filtering (TRANSFER_ENGINE_META_SUBSCRIPTION): a receiver records the regions it reads in
+    // its first step and subscribes to them, senders then only send it the shards intersecting these regions. A read
+    // missing the subscribed metas widens the regions and subscribes again, the senders answer with their full metas
+    bool meta_subscription_enabled_{false};
+    std::atomic<bool> meta_subscribed_{false};
+    std::unordered_map<std::string, MetaInterest> meta_interests_;
+    std::unordered_map<NodeInfo, std::vector<MetaInterest>, NodeInfoHash> peer_interests_;
+    // Peers that subscribed again or restored their metas from a snapshot, they get the acked metas with the next step
+    std::unordered_set<NodeInfo, NodeInfoHash> resync_peers_;
+
+    // Control message aggregation (TRANSFER_ENGINE_CTRL_AGGREGATION): the step's meta diff and weight ready /
+    // consumed go through the per-host leaders instead of to every peer
+    struct RelayRound {
+        std::unordered_set<NodeInfo, NodeInfoHash> contributors;
+        std::vector<std::pair<std::string, std::string>> messages;
+    };
+    bool ctrl_aggregation_{false};
+    int64_t relay_timeout_ms_{};
+    // Rebuilt on membership changes and swapped with atomic_store, relay paths atomic_load a snapshot
+    std::shared_ptr<const ControlTree> control_tree_ = std::make_shared<const ControlTree>();
+    std::mutex relay_mutex_;
+    std::condition_variable relay_cv_;
+    std::map<int64_t, RelayRound> relay_rounds_; // seq_id -> messages collected by the leader
+    int64_t relay_flushed_seq_{INIT_SEQ_ID}; // members arriving for this seq or before are forwarded at once
+    std::map<int64_t, bool> relay_results_; // member side: seq_id -> whether the leader forwarded its messages
+
+    // Elastic membership (TRANSFER_ENGINE_ELASTIC_MEMBERSHIP): the discovery thread queues the nodes that joined or
+    // left and the caller threads apply them, departures while waiting on the peers, arrivals only when a step
+    // starts so a new peer never takes part in a step half way
+    bool elastic_membership_{false};
+    std::mutex membership_mutex_;
+    std::vector<NodeEntry> joined_nodes_;
+    std::vector<NodeEntry> left_nodes_;
+    std::atomic<bool> membership_changed_{false};
+
+    // Warm restart (TRANSFER_ENGINE_RESTART_SNAPSHOT_DIR): a receiver keeps the remote metas of its last completed
+    // read in a local file, a restarted receiver reloads them if discovery found no peer restarted since
+    std::string meta_snapshot_path_;
+    std::optional<uint64_t> saved_meta_epoch_; // remote_meta_epoch_ of the last snapshot written
+    // Diffs applied after the last snapshot are lost, so the restored versions are not trusted: the senders are asked
+    // for their full metas, which replace the restored ones
+    std::unordered_set<NodeInfo, NodeInfoHash> restored_senders_;
+    std::atomic<bool> meta_resync_pending_{false};
+
     std::unordered_set<NodeInfo, NodeInfoHash> consumed_nodes_;
 
     // Remote tensor meta cache
@@ -120,22 +194,93 @@ class TensorTransferPull : public TensorTransferService {
 
     bool enable_log_tensor_meta_{false};
     std::shared_ptr<PerfMetricsController> perf_metrics_controller_;
-    uint64_t perf_stats_interval_ms_{};
-    std::unordered_map<uint64_t, size_t> throughput_stats_;
-    std::unordered_map<std::string, std::unordered_map<uint64_t, size_t>> throughput_stats_per_host_;
-    std::mutex throughput_stats_mutex_;
+    // Stage latencies of Get and MultiGet, see GetMetricsRegistry()
+    LatencyHistogram* register_latency_{&GetMetricsRegistry().GetHistogram(kStageLatencyUs, "register")};
+    LatencyHistogram* wait_latency_{&GetMetricsRegistry().GetHistogram(kStageLatencyUs, "wait")};
+    LatencyHistogram* plan_latency_{&GetMetricsRegistry().GetHistogram(kStageLatencyUs, "plan")};
+    LatencyHistogram* read_latency_{&GetMetricsRegistry().GetHistogram(kStageLatencyUs, "read")};
+    // "host:rdma_port" -> kPeerReadBytes counter, swapped with atomic_store by RefreshPeerReadCounters
+    using PeerCounters = std::unordered_map<std::string, MetricCounter*>;
+    std::shared_ptr<const PeerCounters> peer_read_bytes_ = std::make_shared<const PeerCounters>();
+    // Peer bytes counted up to the last Complete, the step's throughput is the difference
+    std::map<std::string, uint64_t> logged_peer_bytes_;
 
     bool enable_local_cache_prefetch_{false};
 
     // Send control messages when sync model weights
-    bool SendTensorRDMAMeta(const TensorRDMAMetaPublishMessage& meta);
+    // The peers the meta did not reach, or that rejected it, are appended to failed_peers
+    bool SendTensorRDMAMeta(const TensorRDMAMetaPublishMessage& meta, std::vector<NodeInfo>* failed_peers = nullptr);
     bool SendWeightReady(const WeightReadyMessage& msg);
     bool SendWeightConsumed(const WeightConsumedMessage& msg);
+    bool SendMetaSubscription();
+    bool SendMetaResync();
+
+    // Remember that a remote shard is read, until the subscription is sent
+    void RecordMetaInterest(const ShardedKey& tensor_key, const ATensor& remote_atensor);
+    // A read found no meta for the region of atensor, widen the subscription and send it again with Complete()
+    void RecordMetaMiss(const ShardedKey& tensor_key, const ATensor& atensor);
+
+    // Send the metas changed in the current step as a diff against the acknowledged snapshot
+    bool PublishMetaDiff();
+    // Fill the diff of the current step, false if nothing changed
+    bool BuildMetaDiff(TensorRDMAMetaPublishMessage& diff);
+    // Send the diff, the peers that did not take it get the full metas of its version instead. Acknowledged once
+    // every peer holds that version
+    bool DeliverMetaDiff(const TensorRDMAMetaPublishMessage& diff);
+    // The diff reached all peers, it is merged into the acknowledged snapshot
+    void AckMetaDiff(const TensorRDMAMetaPublishMessage& diff);
+    // Send the metas as an initial publish, narrowed to the subscription of each peer
+    bool SendFullMetas(const TensorRDMAMetaPublishMessage& meta, const std::vector<NodeInfo>& peers);
+
+    [[nodiscard]] std::string EncodeMetaMessage(const TensorRDMAMetaPublishMessage& meta) const;
+
+    // Aggregation tree, see ControlTree
+    void RebuildControlTree();
+    // True once the messages reached the peer leaders, which hand them down before replying. A member waits for
+    // the result from its leader, on false the caller sends the messages itself
+    bool RelayCtrlMessages(std::vector<std::pair<std::string, std::string>> messages);
+    // Tell the members whether their messages of seq_id were forwarded
+    void SendRelayResults(int64_t seq_id, const std::vector<NodeInfo>& members, bool forwarded);
+    bool ForwardToPeerLeaders(int64_t seq_id, const std::vector<std::pair<std::string, std::string>>& messages);
+    // Narrow the meta messages to the interests of a peer group, unchanged if a member did not subscribe
+    std::vector<std::pair<std::string, std::string>> FilterRelayedMetas(
+        const std::vector<std::pair<std::string, std::string>>& messages, const std::vector<NodeInfo>& peer_group);
+    bool SendRelays(const std::vector<std::pair<NodeInfo, std::string>>& relays);
+    bool DispatchRelayedMessages(const std::vector<std::pair<std::string, std::string>>& messages);
+
+    // Patch the cached remote metas with a diff, the caller holds ctrl_message_mutex_. False if the diff is not
+    // based on the version applied from its sender, which then sends its full metas
+    bool ApplyMetaDiff(const TensorRDMAMetaPublishMessage& msg);
+    // Drop the cached shards of a sender from every seq, the caller holds ctrl_message_mutex_
+    size_t DropRemoteShards(const NodeInfo& node_info);
+
+    // Queue a membership change, called from the discovery thread
+    void OnMembershipChanged(const std::vector<NodeEntry>& joined, const std::vector<NodeEntry>& left);
+    // Apply the queued departures, and the arrivals too if with_joins; the caller holds ctrl_message_mutex_.
+    // Returns the joined peers, which need the acknowledged metas of this node
+    std::vector<NodeInfo> ApplyMembershipChanges(bool with_joins);
+    void ApplyDepartures();
+    // Send the acknowledged metas as an initial publish, to peers that joined or subscribed again after it
+    bool SendAckedMetas(const std::vector<NodeInfo>& peers);
+    [[nodiscard]] bool IsPeer(const NodeInfo& node_info) const {
+        return std::find(peer_hosts_.begin(), peer_hosts_.end(), node_info) != peer_hosts_.end();
+    }
+
+    // Persist the remote metas of seq_id as the initial publishes of their senders, replayed by RestoreMetaSnapshot
+    void SaveMetaSnapshot(int64_t seq_id);
+    bool RestoreMetaSnapshot();
+
+    // Get the remote metas of seq_id, moving over the newest older seq when absent (nullptr if none),
+    // the caller holds ctrl_message_mutex_
+    TransferTensorMeta* InheritRemoteTensorCache(int64_t seq_id);
 
     // Receive control messages when sync model weights
     ResponseStatus HandleTensorRDMAMeta(const std::string& request, const void* message, size_t message_size);
     ResponseStatus HandleWeightReady(const std::string& request, const void* message, size_t message_size);
     ResponseStatus HandleWeightConsumed(const std::string& request, const void* message, size_t message_size);
+    ResponseStatus HandleMetaSubscription(const std::string& request, const void* message, size_t message_size);
+    ResponseStatus HandleMetaResync(const std::string& request, const void* message, size_t message_size);
+    ResponseStatus HandleControlRelay(const std::string& request, const void* message, size_t message_size);
 
     void RegisterHandlers() {
         control_transport_->RegisterHandler(
@@ -150,6 +295,22 @@ class TensorTransferPull : public TensorTransferService {
             WEIGHT_CONSUMED_REQUEST, [this](const std::string& request, const void* message, size_t message_size) {
                 return this->HandleWeightConsumed(request, message, message_size);
             });
+        control_transport_->RegisterHandler(
+            META_SUBSCRIPTION_REQUEST, [this](const std::string& request, const void* message, size_t message_size) {
+                return this->HandleMetaSubscription(request, message, message_size);
+            });
+        control_transport_->RegisterHandler(
+            META_RESYNC_REQUEST, [this](const std::string& request, const void* message, size_t message_size) {
+                return this->HandleMetaResync(request, message, message_size);
+            });
+        control_transport_->RegisterHandler(
+            CONTROL_RELAY_REQUEST, [this](const std::string& request, const void* message, size_t message_size) {
+                return this->HandleControlRelay(request, message, message_size);
+            });
+        control_transport_->RegisterHandler(
+            METRICS_REQUEST, [](const std::string& /*request*/, const void* /*message*/, size_t /*message_size*/) {
+                return ResponseStatus{true, GetMetricsRegistry().ToPrometheusText(), ExtendInfo{}};
+            });
     }
 
     bool ValidateSeqId(int64_t seq_id) {
@@ -166,61 +327,85 @@ class TensorTransferPull : public TensorTransferService {
     };
 
     bool CheckAndUpdateCurrentSeqId(int64_t seq_id) {
-        std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
-        if (current_seq_id_ == INIT_SEQ_ID) {
-            current_seq_id_ = seq_id;
-        } else if (seq_id != current_seq_id_) {
-            SPDLOG_ERROR("The seq id [{}] mismatched current id [{}]", seq_id, current_seq_id_);
-            return false;
+        std::vector<NodeInfo> joined_peers;
+        {
+            std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
+            if (current_seq_id_ == INIT_SEQ_ID) {
+                current_seq_id_ = seq_id;
+                // A new step, the peers that joined since the last one take part from now on
+                if (membership_changed_.load()) {
+                    joined_peers = ApplyMembershipChanges(true);
+                }
+            } else if (seq_id != current_seq_id_) {
+                SPDLOG_ERROR("The seq id [{}] mismatched current id [{}]", seq_id, current_seq_id_);
+                return false;
+            }
+        }
+        if (!joined_peers.empty()) {
+            SendAckedMetas(joined_peers);
         }
         return true;
     };
 
     bool WaitForAllTensorReady(const int64_t /*seq_id*/, int64_t max_wait_ms = 60000) {
         return WaitCondition(
-            [this]() { return ready_nodes_.size() == peer_hosts_.size(); }, "wait_for_all_tensor_ready", max_wait_ms);
+            [this]() {
+                ApplyDepartures();
+                return ready_nodes_.size() == peer_hosts_.size();
+            },
+            "wait_for_all_tensor_ready",
+            max_wait_ms);
     };
 
     bool WaitForTensorReady(
         const int64_t seq_id, const ShardedKey& tensor_key, int max_wait_ms = 60000, int interval_ms = 1000) {
+        return WaitForTensorsReady(seq_id, {&tensor_key}, max_wait_ms, interval_ms);
+    };
+
+    // Waits for the metas of the whole batch in one loop, so the waits for the tensors of a MultiGet overlap
+    bool WaitForTensorsReady(
+        const int64_t seq_id,
+        const std::vector<const ShardedKey*>& tensor_keys,
+        int max_wait_ms = 60000,
+        int interval_ms = 1000) {
         if (is_publish_meta_) {
             {
                 // If published meta before, use the last cache meta.
                 std::lock_guard<std::mutex> lock(ctrl_message_mutex_);
-                if (remote_tensor_cache_.find(seq_id) == remote_tensor_cache_.end()) {
-                    auto cache_it = remote_tensor_cache_.find(last_completed_seq_id_);
-                    if (cache_it == remote_tensor_cache_.end()) {
-                        SPDLOG_ERROR(
-                            "Cannot find remote_tensor_cache, using "
-                            "key(last_seq_id)={}",
-                            last_completed_seq_id_);
-                        throw std::runtime_error(
-                            "Cannot find remote_tensor_cache, using "
-                            "key(last_seq_id)="
-                            + std::to_string(last_completed_seq_id_));
-                    }
-                    TransferTensorMeta* transfer_meta = &(cache_it->second);
-                    remote_tensor_cache_.emplace(seq_id, *transfer_meta);
-                    // Remove the last cache meta.
-                    remote_tensor_cache_.erase(last_completed_seq_id_);
+                if (InheritRemoteTensorCache(seq_id) == nullptr) {
+                    SPDLOG_ERROR(
+                        "Cannot find remote_tensor_cache, using "
+                        "key(last_seq_id)={}",
+                        last_completed_seq_id_);
+                    throw std::runtime_error(
+                        "Cannot find remote_tensor_cache, using "
+                        "key(last_seq_id)="
+                        + std::to_string(last_completed_seq_id_));
                 }
             }
 
             // TODO(root): Wait for all put nodes finished. Only need to wait the specified tensor ready in the
             // future.
             return WaitCondition(
-                [this]() { return ready_nodes_.size() == peer_hosts_.size(); },
+                [this]() {
+                    ApplyDepartures();
+                    return ready_nodes_.size() == peer_hosts_.size();
+                },
                 "wait_for_all_tensor_ready",
                 max_wait_ms);
         }
+        // Keys found once stay found, each poll only checks the ones still missing
+        size_t num_ready = 0;
         return WaitCondition(
-            [this, seq_id, tensor_key]() {
+            [this, seq_id, &tensor_keys, &num_ready]() {
                 auto transfer_meta = remote_tensor_cache_.find(seq_id);
                 if (transfer_meta == remote_tensor_cache_.end()) {
                     return false;
                 }
-                if (transfer_meta->second.find(tensor_key) == transfer_meta->second.end()) {
-                    return false;
+                for (; num_ready < tensor_keys.size(); ++num_ready) {
+                    if (transfer_meta->second.find(*tensor_keys[num_ready]) == transfer_meta->second.end()) {
+                        return false;
+                    }
                 }
                 return true;
             },
@@ -246,33 +431,31 @@ class TensorTransferPull : public TensorTransferService {
     // Helper method to register memory with consistent error handling (throws on failure)
     void RegisterMemoryOrThrow(void* addr, size_t size, bool is_cuda, int device_index);
 
-    void UpdateThroughputStatistic(const std::string& node_info, size_t tx_data_bytes) {
-        if (!perf_metrics_controller_->IsPerfMetricsEnabled()) {
-            return;
-        }
-
-        auto now = std::chrono::high_resolution_clock::now();
-        uint64_t current_time_ms
-            = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-        uint64_t time_window_ms = current_time_ms - (current_time_ms % perf_stats_interval_ms_);
+    // Build the READ request of tensor_key from the replica picked for this rank (throws on illegal meta)
+    TransferRequest BuildReadRequest(int64_t seq_id, const ShardedKey& tensor_key, ATensor& atensor);
 
-        std::lock_guard<std::mutex> lock(throughput_stats_mutex_);
-        if (throughput_stats_.find(time_window_ms) == throughput_stats_.end()) {
-            throughput_stats_[time_window_ms] = tx_data_bytes;
+    // Rates per peer are derived by the scraper from the byte counter, always counted as the counter is resolved
+    // with the remote meta and a read only adds to it
+    void UpdateThroughputStatistic(const TransferRequest& request) {
+        MetricCounter* counter = request.read_bytes;
+        if (counter == nullptr) {
+            counter = &PeerReadCounter(request.remote_net_addr.host, request.remote_net_addr.port);
         }
-        throughput_stats_[time_window_ms] += tx_data_bytes;
+        counter->Add(request.length);
+    }
 
-        if (throughput_stats_per_host_.find(node_info) == throughput_stats_per_host_.end()) {
-            throughput_stats_per_host_[node_info] = std::unordered_map<uint64_t, size_t>();
-        }
-        auto& throughput_stats = throughput_stats_per_host_[node_info];
-        if (throughput_stats.find(time_window_ms) == throughput_stats.end()) {
-            throughput_stats[time_window_ms] = tx_data_bytes;
-        } else {
-            throughput_stats[time_window_ms] += tx_data_bytes;
-        }
+    // The kPeerReadBytes counter of a peer, looked up when a remote meta is cached rather than for every read
+    MetricCounter& PeerReadCounter(const std::string& remote_host, int remote_port) {
+        auto key = remote_host + ":" + std::to_string(remote_port);
+        std::shared_ptr<const PeerCounters> counters = std::atomic_load(&peer_read_bytes_);
+        auto it = counters->find(key);
+        // A peer not known yet, e.g. a replica announced before its discovery entry
+        return it != counters->end() ? *it->second : GetMetricsRegistry().GetCounter(kPeerReadBytes, key);
     }
 
+    // Resolve the kPeerReadBytes counter of every peer and group member, whenever they change
+    void RefreshPeerReadCounters();
+
     void LogRemoteTensorMeta() {
         if (!is_publish_meta_ && enable_log_tensor_meta_) {
             // print the remote_tensor_cache_
@@ -295,31 +478,37 @@ class TensorTransferPull : public TensorTransferService {
         }
     }
 
+    // host_with_port is "host:rdma_port"
+    std::string GetPeerTransportName(const std::string& host_with_port) const {
+        auto pos = host_with_port.rfind(':');
+        if (pos == std::string::npos || data_transport_ == nullptr) {
+            return TransportTypeToString(TransportType::UNKNOWN);
+        }
+        int port = std::atoi(host_with_port.c_str() + pos + 1);
+        return TransportTypeToString(data_transport_->GetPeerTransportType(host_with_port.substr(0, pos), port));
+    }
+
     void LogThroughputStatistic() {
         if (!perf_metrics_controller_->IsPerfMetricsEnabled()) {
             return;
         }
 
-        SPDLOG_INFO("[Seq {}] throughput stats: ", current_seq_id_);
         uint64_t total_throughput = 0;
-        for (auto& pair : throughput_stats_) {
-            SPDLOG_INFO("  - {}: {} MB", pair.first, BYTES_TO_MB(pair.second));
-            total_throughput += pair.second;
-        }
-        SPDLOG_INFO("[Seq {}] total throughput: {} MB", current_seq_id_, BYTES_TO_MB(total_throughput));
-        throughput_stats_.clear();
-
-        for (auto& pair : throughput_stats_per_host_) {
-            SPDLOG_INFO("[Seq {} {}] throughput stats: ", current_seq_id_, pair.first);
-            uint64_t throughput_per_host = 0;
-            for (auto& throughput_pair : pair.second) {
-                SPDLOG_INFO("  - {}: {} MB", throughput_pair.first, BYTES_TO_MB(throughput_pair.second));
-                throughput_per_host += throughput_pair.second;
+        for (const auto& [host, bytes] : GetMetricsRegistry().GetCounterValues(kPeerReadBytes)) {
+            uint64_t& logged = logged_peer_bytes_[host];
+            if (bytes == logged) {
+                continue;
             }
             SPDLOG_INFO(
-                "[Seq {} {}] total throughput: {} MB", current_seq_id_, pair.first, BYTES_TO_MB(throughput_per_host));
+                "[Seq {} {}] total throughput over {}: {} MB",
+                current_seq_id_,
+                host,
+                GetPeerTransportName(host),
+                BYTES_TO_MB(bytes - logged));
+            total_throughput += bytes - logged;
+            logged = bytes;
         }
-        throughput_stats_per_host_.clear();
+        SPDLOG_INFO("[Seq {}] total throughput: {} MB", current_seq_id_, BYTES_TO_MB(total_throughput));
     }
 };
 
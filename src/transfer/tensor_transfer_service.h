@@ -84,8 +84,19 @@ class TensorTransferService {
 
     virtual void Complete() = 0;
 
+    // Stop publishing the shards, peers drop them with the meta diff of the next step. Shards that are not put again
+    // stay published otherwise. False if the service does not publish incrementally
+    virtual bool Withdraw(const std::vector<ShardedKey>& /*tensor_keys*/) { return false; }
+
     [[nodiscard]] virtual std::vector<std::pair<ShardedKey, ATensor>>
     GetAllTensorShards(int64_t seq_id, std::function<bool(const ShardedKey&)> filter) = 0;
+
+    // Bumped every time an incremental meta publish from a peer changed the remote tensor metas
+    [[nodiscard]] virtual uint64_t GetRemoteMetaEpoch() const { return 0; }
+
+    // Names of the tensors changed by incremental meta publishing since the last call, read plans built on them
+    // are stale
+    virtual std::unordered_set<std::string> TakeChangedTensorNames() { return {}; }
 };
 
 using TensorTransferDistribution
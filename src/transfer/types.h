@@ -5,6 +5,7 @@
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <infiniband/verbs.h>
 
@@ -15,6 +16,8 @@
 
 namespace astate {
 
+class MetricCounter;
+
 struct RemoteAddress {
     std::string host;
     int port{0};
@@ -79,6 +82,8 @@ struct TransferRequest {
     size_t length{};
 
     RemoteNetAddress remote_net_addr;
+    // kPeerReadBytes counter of the remote, resolved with its meta so a read only adds to it
+    MetricCounter* read_bytes{};
 };
 
 // Hash function for NodeInfo(protocol::NodeInfo)
@@ -96,6 +101,7 @@ struct TensorRDMAInfo {
     NodeInfo node_info;
 
     std::shared_ptr<ATensor> atensor;
+    MetricCounter* read_bytes{}; // kPeerReadBytes counter of node_info, see TransferRequest::read_bytes
 
     TensorRDMAInfo()
         : addr(nullptr),
@@ -203,7 +209,8 @@ inline void EmplaceTensorRDMAInfo(
     size_t size,
     const std::string& rkey,
     const NodeInfo& node_info,
-    std::shared_ptr<ATensor> atensor = nullptr) {
+    std::shared_ptr<ATensor> atensor = nullptr,
+    MetricCounter* read_bytes = nullptr) {
     auto it = tx_tensor_data.find(tensor_key);
     if (it != tx_tensor_data.end() && it->second.size() > 0) {
         if (!it->second.back().atensor->IsShapeEqual(*atensor)) {
@@ -216,11 +223,46 @@ inline void EmplaceTensorRDMAInfo(
                 node_info.rdma_port);
             throw std::runtime_error("illegal state: Tensor shape mismatch");
         }
-        it->second.emplace_back(addr, size, rkey, node_info, std::move(atensor));
+        it->second.emplace_back(addr, size, rkey, node_info, std::move(atensor)).read_bytes = read_bytes;
     } else {
         std::vector<TensorRDMAInfo> vec;
-        vec.emplace_back(addr, size, rkey, node_info, std::move(atensor));
+        vec.emplace_back(addr, size, rkey, node_info, std::move(atensor)).read_bytes = read_bytes;
         tx_tensor_data.emplace(tensor_key, std::move(vec));
     }
 }
+
+// Drop the replica published by node_info, the key is erased when no replica is left
+inline bool
+RemoveTensorRDMAInfo(TransferTensorMeta& tx_tensor_data, const ShardedKey& tensor_key, const NodeInfo& node_info) {
+    auto it = tx_tensor_data.find(tensor_key);
+    if (it == tx_tensor_data.end()) {
+        return false;
+    }
+    auto& replicas = it->second;
+    auto size_before = replicas.size();
+    std::erase_if(replicas, [&node_info](const TensorRDMAInfo& info) { return info.node_info == node_info; });
+    bool removed = replicas.size() != size_before;
+    if (replicas.empty()) {
+        tx_tensor_data.erase(it);
+    }
+    return removed;
+}
+
+// Replace the replica published by node_info, replicas of other nodes left with a different shape are stale and
+// dropped until their own update arrives
+inline void ReplaceTensorRDMAInfo(
+    TransferTensorMeta& tx_tensor_data,
+    const ShardedKey& tensor_key,
+    void* addr,
+    size_t size,
+    const std::string& rkey,
+    const NodeInfo& node_info,
+    std::shared_ptr<ATensor> atensor,
+    MetricCounter* read_bytes = nullptr) {
+    auto& replicas = tx_tensor_data[tensor_key];
+    std::erase_if(replicas, [&node_info, &atensor](const TensorRDMAInfo& info) {
+        return info.node_info == node_info || info.atensor == nullptr || !info.atensor->IsShapeEqual(*atensor);
+    });
+    replicas.emplace_back(addr, size, rkey, node_info, std::move(atensor)).read_bytes = read_bytes;
+}
 } // namespace astate
@@ -3,14 +3,22 @@
 #include <any>
 #include <atomic>
 #include <cstddef>
+#include <exception>
 #include <functional>
+#include <memory>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <spdlog/spdlog.h>
 
+#include "common/network_utils.h"
 #include "common/option.h"
+#include "common/queue_utils.h"
 #include "core/atensor.h"
+#include "transfer/types.h"
+#include "transport/transport_builder.h"
 
 namespace astate {
 
@@ -21,6 +29,39 @@ using ReceiveCallback = std::function<bool(const void*, size_t)>;
 
 using ExtendInfo = std::vector<std::any>;
 
+// Per-request result of a batch submitted by BaseDataTransport::SubmitBatch
+struct TransferCompletion {
+    size_t request_index; // index of the request in the submitted batch
+    bool success;
+};
+
+using TransferCompletionQueue = MessageQueue<TransferCompletion>;
+
+// Runs run(0) .. run(count - 1), possibly in parallel, and returns once all of them returned
+using BatchExecutor = std::function<void(size_t count, const std::function<void(size_t)>& run)>;
+
+/*
+ * Get remote address from extend info
+ * @param extend_info: extend info
+ * @return remote address
+ */
+inline const void* GetRemoteAddrFromExtendInfo(const ExtendInfo* extend_info) {
+    // Data Transport Extend info:[remote_addr]
+    if (extend_info == nullptr || extend_info->size() == 0) {
+        SPDLOG_ERROR("Extend info is null or empty");
+        return nullptr;
+    }
+
+    return std::any_cast<const void*>(extend_info->at(0));
+}
+
+inline ExtendInfo GetExtendInfoFromRemoteAddr(const void* remote_addr) {
+    // Data Transport Extend info:[remote_addr]
+    ExtendInfo extend_info;
+    extend_info.emplace_back(remote_addr);
+    return extend_info;
+}
+
 /*
  * BaseTransport is an abstract class that provides a common interface
  * definition for all data plane transport services.
@@ -54,6 +95,45 @@ class BaseDataTransport {
      */
     [[nodiscard]] virtual int GetBindPort() const = 0;
 
+    /*
+     * Get the host name or ip that peers use to reach the transport service.
+     * @return: The local server name.
+     */
+    [[nodiscard]] virtual std::string GetLocalServerName() const { return GetLocalHostnameOrIP(); }
+
+    /*
+     * Get the backend that serves the remote endpoint, used for metrics.
+     * @param remote_host: The host of the remote endpoint.
+     * @param remote_port: The port of the remote endpoint.
+     * @return: The transport type, UNKNOWN if not decided yet.
+     */
+    [[nodiscard]] virtual TransportType
+    GetPeerTransportType(const std::string& /*remote_host*/, int /*remote_port*/) const {
+        return TransportType::UNKNOWN;
+    }
+
+    /*
+     * Register a memory region that remote peers may read or write.
+     * Transports without registration accept any region.
+     * @param addr: memory address
+     * @param len: memory length
+     * @param is_vram: whether the memory is in VRAM
+     * @param gpu_id_or_numa_node: GPU ID or NUMA node
+     * @return: True if registration successful, false otherwise.
+     */
+    virtual bool
+    RegisterMemory(void* /*addr*/, size_t /*len*/, bool /*is_vram*/ = false, int /*gpu_id_or_numa_node*/ = -1) {
+        return true;
+    }
+
+    /*
+     * Deregister a memory region registered by RegisterMemory.
+     * @param addr: memory address
+     * @param len: memory length
+     * @return: True if deregistration successful, false otherwise.
+     */
+    virtual bool DeregisterMemory(void* /*addr*/, size_t /*len*/) { return true; }
+
     ////////////////////// Sync send and receive //////////////////////
     /*
      * Send data to the remote endpoint synchronously.
@@ -127,10 +207,81 @@ class BaseDataTransport {
         const ReceiveCallback& callback)
         = 0;
 
+    ////////////////////// Batch submission //////////////////////
+    /*
+     * Submit a batch of transfer requests in one call.
+     * Exactly one completion is pushed to completion_queue for every request,
+     * in completion order, carrying the index of the request in the batch.
+     * The requests and the local buffers must stay valid until all their
+     * completions are popped. Implementations may push every completion
+     * before returning, so completion_queue must hold requests.size() of them.
+     * The default implementation runs the requests through the sync Send/Receive
+     * on the batch executor, transports with native async support override it.
+     * @param requests: The requests to submit, the remote address is passed as extend info.
+     * @param completion_queue: The queue receiving per-request completions.
+     */
+    virtual void SubmitBatch(std::span<TransferRequest> requests, TransferCompletionQueue& completion_queue) {
+        auto run = [&](size_t i) {
+            const auto& request = requests[i];
+            ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(reinterpret_cast<const void*>(request.remote_mem_addr));
+            bool success = false;
+            try {
+                if (request.opcode == TransferRequest::OpCode::READ) {
+                    success = Receive(
+                        request.local_mem_addr,
+                        request.length,
+                        request.remote_net_addr.host,
+                        request.remote_net_addr.port,
+                        &extend_info);
+                } else {
+                    success = Send(
+                        request.local_mem_addr,
+                        request.length,
+                        request.remote_net_addr.host,
+                        request.remote_net_addr.port,
+                        &extend_info);
+                }
+            } catch (const std::exception& e) {
+                SPDLOG_ERROR(
+                    "SubmitBatch request {} failed: {}, remote_addr={}:{}",
+                    i,
+                    e.what(),
+                    request.remote_net_addr.host,
+                    request.remote_net_addr.port);
+            }
+            completion_queue.Push({i, success});
+        };
+        if (batch_executor_) {
+            batch_executor_(requests.size(), run);
+            return;
+        }
+        for (size_t i = 0; i < requests.size(); ++i) {
+            run(i);
+        }
+    }
+
+    /*
+     * Set the executor the default SubmitBatch runs the requests of a batch on.
+     * Without one they run one by one on the calling thread.
+     * @param executor: The executor, it must not run on a thread that submits batches.
+     */
+    virtual void SetBatchExecutor(BatchExecutor executor) { batch_executor_ = std::move(executor); }
+
+    /*
+     * Hand down the options resolved by the owner, before Start.
+     * Without them Start resolves its own and fails on invalid options.
+     */
+    void SetResolvedOptions(std::shared_ptr<const ResolvedOptions> resolved_options) {
+        resolved_options_ = std::move(resolved_options);
+    }
+
  protected:
     // Whether the transport service is running
     volatile bool is_running_{false};
     static constexpr int kBindPortMaxRetry = 100;
+
+    BatchExecutor batch_executor_;
+    std::shared_ptr<const ResolvedOptions> resolved_options_;
 };
 
 struct ResponseStatus {
@@ -221,6 +372,14 @@ class BaseControlTransport {
         const ExtendInfo* extend_info)
         = 0;
 
+    /*
+     * Hand down the options resolved by the owner, before Start.
+     * Without them Start resolves its own and fails on invalid options.
+     */
+    void SetResolvedOptions(std::shared_ptr<const ResolvedOptions> resolved_options) {
+        resolved_options_ = std::move(resolved_options);
+    }
+
  protected:
     // Whether the transport service is running
     volatile bool is_running_{false};
@@ -228,6 +387,7 @@ class BaseControlTransport {
     static constexpr int kPortStart = 52010;
 
     std::unordered_map<std::string, Handler> handlers_;
+    std::shared_ptr<const ResolvedOptions> resolved_options_;
 };
 
 } // namespace astate
@@ -4,11 +4,14 @@
 #include <string>
 #include <unordered_map>
 
+#include <brpc/controller.h>
 #include <brpc/server.h>
+#include <butil/iobuf.h>
 #include <google/protobuf/service.h>
 #include <json2pb/pb_to_json.h>
 #include <spdlog/spdlog.h>
 
+#include "common/metric_utils.h"
 #include "protocol/gen/transfer_service.pb.h"
 #include "transport/base_transport.h"
 
@@ -32,8 +35,13 @@ class RpcTransferServiceImpl : public astate::proto::RpcTransferService {
         // cntl->set_after_rpc_resp_fn(std::bind(&RpcTransferServiceImpl::CallAfterRpc, std::placeholders::_1,
         //                                       std::placeholders::_2, std::placeholders::_3));
         const std::string& request_name = request->request_name();
+        // Payload in the protobuf field (older senders) or in the attachment, see BRPC_TRANSPORT_ATTACHMENT
+        std::string flattened;
         const void* data = request->data().data();
         size_t data_size = request->data().size();
+        if (!request->has_data()) {
+            ViewAttachment(cntl->request_attachment(), flattened, data, data_size);
+        }
 
         if (handlers_.find(request_name) == handlers_.end()) {
             response->set_code(404);
@@ -51,6 +59,22 @@ class RpcTransferServiceImpl : public astate::proto::RpcTransferService {
             response->set_message(e.what());
         }
     }
+    /*
+     * Contiguous view over an attachment. Payloads within one IOBuf block are handed out in place,
+     * larger ones are flattened once into buffer.
+     */
+    static void ViewAttachment(const butil::IOBuf& attachment, std::string& buffer, const void*& data, size_t& size) {
+        if (attachment.backing_block_num() == 1) {
+            butil::StringPiece block = attachment.backing_block(0);
+            data = block.data();
+            size = block.size();
+            return;
+        }
+        buffer = attachment.to_string();
+        data = buffer.data();
+        size = buffer.size();
+    }
+
     static void
     CallAfterRpc(brpc::Controller* cntl, const google::protobuf::Message* req, const google::protobuf::Message* res) {
         // at this time res is already sent to client, but cntl/req/res is not destructed
@@ -70,4 +94,19 @@ class RpcTransferServiceImpl : public astate::proto::RpcTransferService {
     std::unordered_map<std::string, Handler> handlers_;
 };
 
+// Mapped to GET /metrics on the brpc server, for Prometheus to scrape GetMetricsRegistry()
+class MetricsServiceImpl : public astate::proto::MetricsService {
+ public:
+    void Metrics(
+        ::google::protobuf::RpcController* cntl_base,
+        const ::astate::proto::HttpRequest* /*request*/,
+        ::astate::proto::HttpResponse* /*response*/,
+        ::google::protobuf::Closure* done) override {
+        brpc::ClosureGuard done_guard(done);
+        brpc::Controller* cntl = static_cast<brpc::Controller*>(cntl_base);
+        cntl->http_response().set_content_type("text/plain; version=0.0.4");
+        cntl->response_attachment().append(GetMetricsRegistry().ToPrometheusText());
+    }
+};
+
 } // namespace astate
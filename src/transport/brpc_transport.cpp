@@ -1,11 +1,14 @@
 #include "transport/brpc_transport.h"
 
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <string>
 #include <thread>
 
 #include <brpc/channel.h>
 #include <brpc/server.h>
+#include <butil/iobuf.h>
 #include <gflags/gflags.h>
 #include <spdlog/spdlog.h>
 
@@ -14,7 +17,8 @@
 namespace astate {
 BrpcTransport::BrpcTransport()
     : server_(new brpc::Server()),
-      service_impl_(new RpcTransferServiceImpl()) {
+      service_impl_(new RpcTransferServiceImpl()),
+      metrics_service_(new MetricsServiceImpl()) {
 }
 BrpcTransport::~BrpcTransport() {
     Stop();
@@ -31,14 +35,27 @@ bool BrpcTransport::Start(const Options& options) {
 
     max_retries_ = astate::GetOptionValue<int>(options, astate::BRPC_TRANSPORT_MAX_RETRIES);
     timeout_ms_ = astate::GetOptionValue<int>(options, astate::BRPC_TRANSPORT_TIMEOUT_MS);
+    use_attachment_ = astate::GetOptionValue<bool>(options, astate::BRPC_TRANSPORT_ATTACHMENT);
+    auto max_body_size = astate::GetOptionValue<int64_t>(options, astate::BRPC_TRANSPORT_MAX_BODY_SIZE);
+    if (max_body_size > 0) {
+        google::SetCommandLineOption("max_body_size", std::to_string(max_body_size).c_str());
+    }
 
-    SPDLOG_INFO("BrpcTransport: Config loaded - max_retries: {}, timeout_ms: {}", max_retries_, timeout_ms_);
+    SPDLOG_INFO(
+        "BrpcTransport: Config loaded - max_retries: {}, timeout_ms: {}, attachment: {}, max_body_size: {}",
+        max_retries_,
+        timeout_ms_,
+        use_attachment_,
+        max_body_size);
 
     for (auto& handler : handlers_) {
         service_impl_->RegisterHandler(handler.first, handler.second);
     }
 
     server_->AddService(service_impl_.get(), brpc::SERVER_DOESNT_OWN_SERVICE);
+    if (server_->AddService(metrics_service_.get(), brpc::SERVER_DOESNT_OWN_SERVICE, "/metrics => Metrics") != 0) {
+        SPDLOG_WARN("BrpcTransport: Failed to map /metrics, the metrics are not served over HTTP");
+    }
 
     brpc::ServerOptions server_options;
     server_options.max_concurrency = 1024;
@@ -193,6 +210,13 @@ bool BrpcTransport::Send(
         return false;
     }
 
+    // Copied once into IOBuf blocks, every attempt shares them. The caller's buffer can not be referenced
+    // directly since a timed out RPC may still have the request queued on the socket.
+    butil::IOBuf payload;
+    if (use_attachment_) {
+        payload.append(send_data, send_size);
+    }
+
     for (int retry = 0; retry < max_retries_; ++retry) {
         brpc::Controller cntl;
 
@@ -200,7 +224,11 @@ bool BrpcTransport::Send(
 
         astate::proto::TransferData req;
         req.set_request_name(request_name);
-        req.set_data(std::string(static_cast<const char*>(send_data), send_size));
+        if (use_attachment_) {
+            cntl.request_attachment() = payload;
+        } else {
+            req.set_data(std::string(static_cast<const char*>(send_data), send_size));
+        }
 
         astate::proto::StatusReply resp;
 
@@ -37,6 +37,7 @@ class BrpcTransport : public BaseControlTransport {
  private:
     std::unique_ptr<brpc::Server> server_;
     std::unique_ptr<RpcTransferServiceImpl> service_impl_;
+    std::unique_ptr<MetricsServiceImpl> metrics_service_;
     int bind_port_ = 0;
     std::thread server_thread_;
 
@@ -61,6 +62,8 @@ class BrpcTransport : public BaseControlTransport {
 
     int max_retries_ = 90;
     int timeout_ms_ = 10000;
+    // Payload as request attachment instead of the protobuf bytes field
+    bool use_attachment_ = false;
 
     astate::proto::RpcTransferService_Stub* GetOrCreateStub(const std::string& server_addr);
 
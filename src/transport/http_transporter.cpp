@@ -1,12 +1,19 @@
 #include "http_transporter.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <cstdint>
 #include <exception>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include <httplib.h>
 
@@ -22,6 +29,77 @@
 namespace astate {
 
 constexpr const char* PING_REQUEST = "ping";
+// Requests served over one keep-alive connection before the server closes it
+constexpr size_t kServerKeepAliveMaxCount = 100000;
+constexpr time_t kServerKeepAliveTimeoutSec = 5;
+
+namespace {
+
+httplib::Result PostPooled(
+    HttpClientPool& pool, const std::string& http_path, const std::string& data, bool& reused) {
+    auto client = pool.Acquire(reused);
+    auto res = client->Post(http_path, data, "application/json; charset=utf-8");
+    // Any response, even an error status, means the connection is still usable
+    bool healthy = static_cast<bool>(res);
+    pool.Release(std::move(client), healthy);
+    return res;
+}
+
+// The request never reached the peer, the connection could not be opened or written to, so it is safe to resend
+bool FailedBeforeSent(const httplib::Result& res) {
+    return !res && (res.error() == httplib::Error::Connection || res.error() == httplib::Error::Write);
+}
+
+} // namespace
+
+HttpClientPool::HttpClientPool(std::string host, int port, size_t max_size, int64_t idle_timeout_ms)
+    : host_(std::move(host)),
+      port_(port),
+      max_size_(std::max<size_t>(max_size, 1)),
+      idle_timeout_(idle_timeout_ms) {}
+
+std::unique_ptr<httplib::Client> HttpClientPool::Acquire(bool& reused) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    released_cv_.wait(lock, [this] { return !idle_.empty() || open_count_ < max_size_; });
+
+    // Close connections idle for too long, the server may drop them at any moment
+    auto now = std::chrono::steady_clock::now();
+    while (!idle_.empty() && now - idle_.front().since >= idle_timeout_) {
+        idle_.pop_front();
+        --open_count_;
+    }
+    if (!idle_.empty()) {
+        auto client = std::move(idle_.back().client);
+        idle_.pop_back();
+        reused = true;
+        return client;
+    }
+    ++open_count_;
+    lock.unlock();
+
+    reused = false;
+    auto client = std::make_unique<httplib::Client>(host_, port_);
+    client->set_keep_alive(true);
+    client->set_tcp_nodelay(true);
+    return client;
+}
+
+void HttpClientPool::Release(std::unique_ptr<httplib::Client> client, bool healthy) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (healthy) {
+            idle_.push_back(IdleClient{std::move(client), std::chrono::steady_clock::now()});
+        } else {
+            --open_count_;
+        }
+    }
+    released_cv_.notify_one();
+}
+
+size_t HttpClientPool::GetOpenCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return open_count_;
+}
 
 HTTPTransporter::~HTTPTransporter() {
     // Ensure cleanup happens in destructor
@@ -34,6 +112,13 @@ bool HTTPTransporter::Start(const Options& options) {
     SPDLOG_INFO("Starting HTTP service...");
 
     options_ = options;
+    // Send reads its retry settings from it
+    if (resolved_options_ == nullptr) {
+        resolved_options_ = TryResolveOptions(options);
+        if (resolved_options_ == nullptr) {
+            return false;
+        }
+    }
 
     CountingRetry retry_policy(3);
 
@@ -70,7 +155,10 @@ bool HTTPTransporter::StartHttpService(const Options& options) {
 
     // Initialize HTTP server and thread pool
     http_server_ = std::make_unique<httplib::Server>();
-    receive_thread_pool_ = std::make_unique<ThreadPool>(GetOptionValue<int>(options, TRANSFER_ENGINE_READ_THREAD_NUM));
+    ConfigureServer(*http_server_);
+    receive_thread_pool_ = std::make_unique<ThreadPool>(
+        GetOptionValue<int>(options, TRANSFER_ENGINE_READ_THREAD_NUM),
+        GetOptionValue<bool>(options, TRANSFER_ENGINE_THREAD_POOL_WORK_STEALING));
 
     // Register handlers to HTTP server BEFORE starting the server thread
     for (const auto& handler : handlers_) {
@@ -152,6 +240,11 @@ void HTTPTransporter::Stop() {
         receive_thread_pool_->WaitForTasks();
     }
 
+    {
+        std::lock_guard<std::mutex> lock(client_pools_mutex_);
+        client_pools_.clear();
+    }
+
     is_running_ = false;
     SPDLOG_INFO("HTTPTransporter stopped.");
 }
@@ -169,16 +262,24 @@ bool HTTPTransporter::Send(
         return false;
     }
 
-    int retry_count = GetOptionValue<int>(options_, TRANSPORT_SEND_RETRY_COUNT);
-    int retry_sleep_ms = GetOptionValue<int>(options_, TRANSPORT_SEND_RETRY_SLEEP_MS);
+    int retry_count = resolved_options_->Get(TRANSPORT_SEND_RETRY_COUNT_KEY);
+    int retry_sleep_ms = resolved_options_->Get(TRANSPORT_SEND_RETRY_SLEEP_MS_KEY);
     CountingAndSleepRetryPolicy policy(retry_count, retry_sleep_ms);
     auto remote_addr = remote_host + ":" + std::to_string(remote_port);
+    auto pool = GetClientPool(remote_host, remote_port);
 
     auto send_func = [&]() -> bool {
-        httplib::Client client(remote_host, remote_port);
         std::string data(static_cast<const char*>(send_data), send_size);
         SPDLOG_INFO("Send message: {} to {}: {}", http_path, remote_addr, data);
-        auto res = client.Post(http_path, data, "application/json; charset=utf-8");
+        bool reused = false;
+        auto res = PostPooled(*pool, http_path, data, reused);
+        if (reused && FailedBeforeSent(res)) {
+            // Stale keep-alive connection, retry at once on a fresh one instead of burning a retry. A request that
+            // went out and got no response may have been handled, it is left to the retry policy
+            SPDLOG_WARN(
+                "Pooled connection to {} failed: {}, reconnecting", remote_addr, httplib::to_string(res.error()));
+            res = PostPooled(*pool, http_path, data, reused);
+        }
         if (res && res->status == 200) {
             SPDLOG_INFO("Send message: {} to {} success", http_path, remote_addr);
             return true;
@@ -213,6 +314,40 @@ bool HTTPTransporter::Send(
     return true;
 }
 
+size_t HTTPTransporter::GetPooledConnectionCount(const std::string& remote_host, int remote_port) const {
+    std::lock_guard<std::mutex> lock(client_pools_mutex_);
+    auto it = client_pools_.find(remote_host + ":" + std::to_string(remote_port));
+    return it == client_pools_.end() ? 0 : it->second->GetOpenCount();
+}
+
+std::shared_ptr<HttpClientPool> HTTPTransporter::GetClientPool(const std::string& remote_host, int remote_port) {
+    std::lock_guard<std::mutex> lock(client_pools_mutex_);
+    auto& pool = client_pools_[remote_host + ":" + std::to_string(remote_port)];
+    if (!pool) {
+        pool = std::make_shared<HttpClientPool>(
+            remote_host,
+            remote_port,
+            GetOptionValue<int>(options_, TRANSPORT_HTTP_POOL_SIZE),
+            GetOptionValue<int>(options_, TRANSPORT_HTTP_IDLE_TIMEOUT_MS));
+    }
+    return pool;
+}
+
+void HTTPTransporter::ConfigureServer(httplib::Server& server) const {
+    // Peers keep their connections open, every open one occupies a worker of the server: leave room for the pools
+    // of all known peers so that idle connections do not hold back new ones
+    int thread_num = GetOptionValue<int>(options_, TRANSPORT_HTTP_SERVER_THREAD_NUM);
+    auto peers = GetOptionValue<std::vector<std::string>>(options_, TRANSFER_ENGINE_PEERS_HOST);
+    int pooled = static_cast<int>(peers.size()) * std::max(GetOptionValue<int>(options_, TRANSPORT_HTTP_POOL_SIZE), 1);
+    if (pooled >= thread_num) {
+        thread_num = pooled + thread_num / 2;
+        SPDLOG_INFO("HTTP server threads raised to {} for {} peers", thread_num, peers.size());
+    }
+    server.new_task_queue = [thread_num] { return new httplib::ThreadPool(thread_num); };
+    server.set_keep_alive_max_count(kServerKeepAliveMaxCount);
+    server.set_keep_alive_timeout(kServerKeepAliveTimeoutSec);
+}
+
 void HTTPTransporter::HandlePing(const httplib::Request& req, httplib::Response& res) {
     try {
         SPDLOG_INFO("Received ping request from: {}", req.get_header_value("Host"));
@@ -277,6 +412,7 @@ bool HTTPTransporter::SetupServerWithRetry() {
                 }
                 http_server_.reset();
                 http_server_ = std::make_unique<httplib::Server>();
+                ConfigureServer(*http_server_);
                 attempt++;
             }
         } catch (const std::exception& e) {
@@ -287,6 +423,7 @@ bool HTTPTransporter::SetupServerWithRetry() {
             }
             http_server_.reset();
             http_server_ = std::make_unique<httplib::Server>();
+            ConfigureServer(*http_server_);
             attempt++;
         }
     }
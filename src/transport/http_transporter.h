@@ -1,7 +1,12 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -9,12 +14,52 @@
 #include <httplib.h>
 
 #include "common/option.h"
-#include "common/queue_utils.h"
 #include "common/thread_pool.h"
 #include "transport/base_transport.h"
 
 namespace astate {
 
+/*
+ * Keep-alive clients to one peer, shared by all sending threads.
+ *
+ * httplib::Client handles one request at a time, so every concurrent sender borrows its own client and at most
+ * max_size connections are open to the peer. Idle clients are closed once idle for idle_timeout_ms, before the
+ * server drops them; a client whose request got no response is closed instead of being returned.
+ */
+class HttpClientPool {
+ public:
+    HttpClientPool(std::string host, int port, size_t max_size, int64_t idle_timeout_ms);
+
+    /*
+     * Borrow a client, blocks while max_size clients are borrowed.
+     * @param reused: set to true if the client is an idle connection, which the peer may have closed meanwhile
+     */
+    std::unique_ptr<httplib::Client> Acquire(bool& reused);
+
+    // Give the client back, a broken one is closed and replaced by the next Acquire
+    void Release(std::unique_ptr<httplib::Client> client, bool healthy);
+
+    // Connections currently open, borrowed or idle
+    [[nodiscard]] size_t GetOpenCount() const;
+
+ private:
+    struct IdleClient {
+        std::unique_ptr<httplib::Client> client;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    std::string host_;
+    int port_;
+    size_t max_size_;
+    std::chrono::milliseconds idle_timeout_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable released_cv_;
+    // Oldest first, borrowed from the back so that the warmest connection is reused
+    std::deque<IdleClient> idle_;
+    size_t open_count_{0};
+};
+
 class HTTPTransporter : public BaseControlTransport {
  public:
     HTTPTransporter() = default;
@@ -41,6 +86,9 @@ class HTTPTransporter : public BaseControlTransport {
     bool StartHttpService(const Options& options);
     bool CheckHttpService() const;
 
+    // Connections currently pooled to the peer, 0 if nothing was sent to it yet
+    [[nodiscard]] size_t GetPooledConnectionCount(const std::string& remote_host, int remote_port) const;
+
  private:
     Options options_;
 
@@ -52,9 +100,13 @@ class HTTPTransporter : public BaseControlTransport {
 
     std::unique_ptr<ThreadPool> receive_thread_pool_;
 
-    // path -> message queue
-    std::unordered_map<std::string, MessageQueue<httplib::Request>> receive_queues_;
+    // "host:port" -> keep-alive clients, shared_ptr so that Stop may drop them while a Send is in flight
+    mutable std::mutex client_pools_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<HttpClientPool>> client_pools_;
+
     bool SetupServerWithRetry();
+    void ConfigureServer(httplib::Server& server) const;
+    std::shared_ptr<HttpClientPool> GetClientPool(const std::string& remote_host, int remote_port);
 };
 
 inline static std::string ToHttpPath(const std::string& request_name) {
@@ -0,0 +1,504 @@
+#include "transport/multiplex_transporter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include <netinet/in.h>
+#include <spdlog/spdlog.h>
+#include <sys/socket.h>
+
+#include "common/metric_utils.h"
+#include "common/option.h"
+#include "common/string_utils.h"
+#include "transport/base_transport.h"
+
+namespace astate {
+
+// Exported as kPeerRoute, the first backend of the route or 0 once the peer is forgotten
+static void PublishRoute(const std::string& key, const std::vector<TransportType>& route) {
+    GetMetricsRegistry().GetGauge(kPeerRoute, key).Set(route.empty() ? 0 : static_cast<int64_t>(route.front()));
+}
+
+static std::string RouteToString(const std::vector<TransportType>& route) {
+    std::string result;
+    for (auto type : route) {
+        if (!result.empty()) {
+            result += " > ";
+        }
+        result += TransportTypeToString(type);
+    }
+    return result;
+}
+
+MultiplexTransporter::~MultiplexTransporter() {
+    if (is_running_) {
+        Stop();
+    }
+}
+
+bool MultiplexTransporter::StartRdma(const Options& options, const AParallelConfig& parallel_config) {
+    rdma_ = std::make_unique<RDMATransporter>();
+    rdma_->SetResolvedOptions(resolved_options_);
+    bool started = false;
+    try {
+        started = rdma_->Start(options, parallel_config);
+    } catch (const std::exception& e) {
+        SPDLOG_WARN("RDMA backend failed to start: {}", e.what());
+    }
+    if (!started) {
+        SPDLOG_WARN("RDMA backend is not available, peers will be served over SHM/TCP only");
+        rdma_.reset();
+    }
+    return started;
+}
+
+bool MultiplexTransporter::StartTcp(const Options& options, const AParallelConfig& parallel_config) {
+    Options tcp_options = options;
+    tcp_ = std::make_unique<TcpTransporter>();
+    if (rdma_ != nullptr) {
+        tcp_options[TRANSFER_ENGINE_TCP_PORT] = std::to_string(local_server_port_ + kTcpPortOffset);
+        if (tcp_->Start(tcp_options, parallel_config)) {
+            return true;
+        }
+        tcp_.reset();
+        return false;
+    }
+
+    // No RDMA: reserve P so that no RDMA transport of this host advertises the same port
+    for (int i = 0; i < kBindPortMaxRetry; ++i) {
+        int port = kPortStart + i;
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            break;
+        }
+        struct sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            continue;
+        }
+        tcp_options[TRANSFER_ENGINE_TCP_PORT] = std::to_string(port + kTcpPortOffset);
+        if (tcp_->Start(tcp_options, parallel_config)) {
+            reserve_fd_ = fd;
+            local_server_port_ = port;
+            return true;
+        }
+        close(fd);
+    }
+    tcp_.reset();
+    return false;
+}
+
+bool MultiplexTransporter::Start(const Options& options, const AParallelConfig& parallel_config) {
+    if (is_running_) {
+        SPDLOG_WARN("MultiplexTransporter already started");
+        return true;
+    }
+
+    auto backends = GetOptionValue<std::vector<std::string>>(options, TRANSFER_ENGINE_AUTO_BACKENDS);
+    auto enabled = [&backends](const std::string& name) {
+        return std::find(backends.begin(), backends.end(), name) != backends.end();
+    };
+
+    if (enabled("rdma") && StartRdma(options, parallel_config)) {
+        local_server_port_ = rdma_->GetBindPort();
+        local_server_name_ = rdma_->GetLocalServerName();
+    }
+    if (enabled("tcp") && !StartTcp(options, parallel_config)) {
+        SPDLOG_WARN("TCP backend failed to start");
+    }
+    if (rdma_ == nullptr && tcp_ == nullptr) {
+        SPDLOG_ERROR("MultiplexTransporter has neither RDMA nor TCP backend, backends: {}", ToString(backends));
+        return false;
+    }
+    if (tcp_ != nullptr) {
+        tcp_->SetCapabilities(rdma_ != nullptr ? TcpTransporter::kCapabilityRdma : 0);
+        if (local_server_name_.empty()) {
+            local_server_name_ = tcp_->GetLocalServerName();
+        }
+    }
+
+    if (enabled("shm")) {
+        Options shm_options = options;
+        shm_options[TRANSFER_ENGINE_SHM_PORT] = std::to_string(local_server_port_);
+        shm_ = std::make_unique<ShmTransporter>();
+        if (!shm_->Start(shm_options, parallel_config)) {
+            SPDLOG_WARN("SHM backend failed to start");
+            shm_.reset();
+        }
+    }
+
+    if (batch_executor_) {
+        SetBatchExecutor(batch_executor_);
+    }
+
+    is_running_ = true;
+    SPDLOG_INFO(
+        "MultiplexTransporter started on {}:{}, shm={}, rdma={}, tcp={}",
+        local_server_name_,
+        local_server_port_,
+        shm_ != nullptr,
+        rdma_ != nullptr,
+        tcp_ != nullptr ? tcp_->GetBindPort() : 0);
+    return true;
+}
+
+void MultiplexTransporter::Stop() {
+    if (!is_running_) {
+        return;
+    }
+    if (shm_ != nullptr) {
+        shm_->Stop();
+    }
+    if (tcp_ != nullptr) {
+        tcp_->Stop();
+    }
+    if (rdma_ != nullptr) {
+        rdma_->Stop();
+    }
+    if (reserve_fd_ >= 0) {
+        close(reserve_fd_);
+        reserve_fd_ = -1;
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(route_mutex_);
+        for (const auto& [key, route] : routes_) {
+            PublishRoute(key, {});
+        }
+        routes_.clear();
+    }
+    is_running_ = false;
+    SPDLOG_INFO("MultiplexTransporter stopped");
+}
+
+BaseDataTransport* MultiplexTransporter::GetBackend(TransportType type) const {
+    switch (type) {
+        case TransportType::SHM:
+            return shm_.get();
+        case TransportType::RDMA:
+            return rdma_.get();
+        case TransportType::TCP:
+            return tcp_.get();
+        default:
+            return nullptr;
+    }
+}
+
+void MultiplexTransporter::SetBatchExecutor(BatchExecutor executor) {
+    batch_executor_ = std::move(executor);
+    for (auto type : {TransportType::SHM, TransportType::RDMA, TransportType::TCP}) {
+        if (auto* backend = GetBackend(type); backend != nullptr) {
+            backend->SetBatchExecutor(batch_executor_);
+        }
+    }
+}
+
+bool MultiplexTransporter::IsBackendRunning(TransportType type) const {
+    auto* backend = GetBackend(type);
+    return backend != nullptr && backend->IsRunning();
+}
+
+bool MultiplexTransporter::RegisterMemory(void* addr, size_t len, bool is_vram, int gpu_id_or_numa_node) {
+    if (is_vram && rdma_ == nullptr) {
+        SPDLOG_ERROR(
+            "VRAM can only be served over RDMA which is not available, addr: {}, len: {}",
+            PointerToHexString(addr),
+            len);
+        return false;
+    }
+    bool success = true;
+    if (rdma_ != nullptr) {
+        success &= rdma_->RegisterMemory(addr, len, is_vram, gpu_id_or_numa_node);
+    }
+    if (tcp_ != nullptr && !is_vram) {
+        success &= tcp_->RegisterMemory(addr, len, is_vram, gpu_id_or_numa_node);
+    }
+    // Optional: local readers of a region SHM could not take fall back to RDMA or TCP
+    if (shm_ != nullptr && !is_vram && !shm_->RegisterMemory(addr, len, is_vram, gpu_id_or_numa_node)) {
+        SPDLOG_WARN("Region not served over SHM, addr: {}, len: {}", PointerToHexString(addr), len);
+    }
+    if (success) {
+        std::unique_lock<std::shared_mutex> lock(region_mutex_);
+        regions_[reinterpret_cast<uint64_t>(addr)] = {len, is_vram};
+    }
+    return success;
+}
+
+bool MultiplexTransporter::DeregisterMemory(void* addr, size_t len) {
+    bool success = true;
+    if (rdma_ != nullptr) {
+        success &= rdma_->DeregisterMemory(addr, len);
+    }
+    if (tcp_ != nullptr) {
+        tcp_->DeregisterMemory(addr, len);
+    }
+    if (shm_ != nullptr) {
+        shm_->DeregisterMemory(addr, len);
+    }
+    std::unique_lock<std::shared_mutex> lock(region_mutex_);
+    regions_.erase(reinterpret_cast<uint64_t>(addr));
+    return success;
+}
+
+bool MultiplexTransporter::IsHostMemory(const void* addr, size_t len) const {
+    auto key = reinterpret_cast<uint64_t>(addr);
+    std::shared_lock<std::shared_mutex> lock(region_mutex_);
+    auto it = regions_.upper_bound(key);
+    if (it == regions_.begin()) {
+        return true;
+    }
+    --it;
+    bool inside = key + len <= it->first + it->second.first;
+    return !(inside && it->second.second);
+}
+
+MultiplexTransporter::Route MultiplexTransporter::ResolveRoute(const std::string& remote_host, int remote_port) {
+    auto key = PeerKey(remote_host, remote_port);
+    {
+        std::shared_lock<std::shared_mutex> lock(route_mutex_);
+        auto it = routes_.find(key);
+        if (it != routes_.end()) {
+            return it->second;
+        }
+    }
+
+    Route route;
+    if (shm_ != nullptr && shm_->IsPeerReachable(remote_host, remote_port)) {
+        route.push_back(TransportType::SHM);
+    }
+    uint64_t capabilities = 0;
+    bool tcp_reachable
+        = tcp_ != nullptr && tcp_->ProbePeer(remote_host, GetBackendPort(TransportType::TCP, remote_port), capabilities);
+    // Peers not answering the TCP probe may still have RDMA
+    bool peer_has_rdma = !tcp_reachable || (capabilities & TcpTransporter::kCapabilityRdma) != 0;
+    if (rdma_ != nullptr && peer_has_rdma) {
+        route.push_back(TransportType::RDMA);
+    }
+    if (tcp_reachable) {
+        route.push_back(TransportType::TCP);
+    }
+    if (route.empty()) {
+        // Not cached, the peer may not be up yet
+        SPDLOG_ERROR("No transport can reach {}", key);
+        return route;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(route_mutex_);
+    auto [it, inserted] = routes_.emplace(key, std::move(route));
+    if (inserted) {
+        PublishRoute(key, it->second);
+        SPDLOG_INFO("Data transport route to {}: {}", key, RouteToString(it->second));
+    }
+    return it->second;
+}
+
+void MultiplexTransporter::DemoteRoute(const std::string& remote_host, int remote_port, TransportType failed) {
+    auto key = PeerKey(remote_host, remote_port);
+    std::unique_lock<std::shared_mutex> lock(route_mutex_);
+    auto it = routes_.find(key);
+    if (it == routes_.end() || it->second.size() <= 1 || it->second.front() != failed) {
+        return;
+    }
+    it->second.erase(it->second.begin());
+    PublishRoute(key, it->second);
+    SPDLOG_WARN(
+        "Data transport route to {} demoted from {}: {}", key, TransportTypeToString(failed), RouteToString(it->second));
+}
+
+TransportType MultiplexTransporter::GetPeerTransportType(const std::string& remote_host, int remote_port) const {
+    std::shared_lock<std::shared_mutex> lock(route_mutex_);
+    auto it = routes_.find(PeerKey(remote_host, remote_port));
+    if (it == routes_.end() || it->second.empty()) {
+        return TransportType::UNKNOWN;
+    }
+    return it->second.front();
+}
+
+std::unordered_map<std::string, TransportType> MultiplexTransporter::GetPeerRoutes() const {
+    std::unordered_map<std::string, TransportType> result;
+    std::shared_lock<std::shared_mutex> lock(route_mutex_);
+    for (const auto& [key, route] : routes_) {
+        result.emplace(key, route.empty() ? TransportType::UNKNOWN : route.front());
+    }
+    return result;
+}
+
+bool MultiplexTransporter::TransferOnRoute(
+    const void* local_addr,
+    size_t size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info,
+    bool is_read,
+    TransportType skip) {
+    bool host_memory = IsHostMemory(local_addr, size);
+    std::vector<TransportType> failed;
+    for (auto type : ResolveRoute(remote_host, remote_port)) {
+        if (type == skip || (type != TransportType::RDMA && !host_memory)) {
+            continue;
+        }
+        auto* backend = GetBackend(type);
+        int backend_port = GetBackendPort(type, remote_port);
+        bool success = false;
+        try {
+            success = is_read ? backend->Receive(local_addr, size, remote_host, backend_port, extend_info)
+                              : backend->Send(local_addr, size, remote_host, backend_port, extend_info);
+        } catch (const std::exception& e) {
+            SPDLOG_WARN("{} transfer with {}:{} failed: {}", TransportTypeToString(type), remote_host, remote_port, e.what());
+        }
+        if (success) {
+            // Only demote once another backend proved to work, a transient failure of all keeps the route
+            for (auto failed_type : failed) {
+                DemoteRoute(remote_host, remote_port, failed_type);
+            }
+            return true;
+        }
+        failed.push_back(type);
+    }
+    if (skip != TransportType::UNKNOWN) {
+        failed.push_back(skip);
+    }
+    SPDLOG_ERROR(
+        "Transfer with {}:{} failed on all backends, tried: {}", remote_host, remote_port, RouteToString(failed));
+    return false;
+}
+
+bool MultiplexTransporter::Send(
+    const void* local_addr,
+    size_t send_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info) {
+    if (local_addr == nullptr || send_size == 0) {
+        SPDLOG_ERROR("Local data is null or size is zero");
+        throw std::invalid_argument("MultiplexTransporter: local data is null or size is zero");
+    }
+    return TransferOnRoute(local_addr, send_size, remote_host, remote_port, extend_info, false);
+}
+
+bool MultiplexTransporter::Receive(
+    const void* local_addr,
+    size_t recv_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info) {
+    if (local_addr == nullptr || recv_size == 0) {
+        SPDLOG_ERROR("Local data is null or size is zero");
+        throw std::invalid_argument("MultiplexTransporter: local data is null or size is zero");
+    }
+    return TransferOnRoute(local_addr, recv_size, remote_host, remote_port, extend_info, true);
+}
+
+void MultiplexTransporter::AsyncSend(
+    const void* local_addr,
+    size_t send_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info,
+    const SendCallback& callback) {
+    bool success = Send(local_addr, send_size, remote_host, remote_port, extend_info);
+    if (callback) {
+        callback(success ? local_addr : nullptr, success ? send_size : 0);
+    }
+}
+
+void MultiplexTransporter::AsyncReceive(
+    const void* local_addr,
+    size_t recv_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info,
+    const ReceiveCallback& callback) {
+    bool success = Receive(local_addr, recv_size, remote_host, remote_port, extend_info);
+    if (callback) {
+        callback(success ? local_addr : nullptr, success ? recv_size : 0);
+    }
+}
+
+void MultiplexTransporter::SubmitBatch(std::span<TransferRequest> requests, TransferCompletionQueue& completion_queue) {
+    // backend -> indices of the requests it serves first
+    std::map<TransportType, std::vector<size_t>> groups;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const auto& request = requests[i];
+        bool host_memory = IsHostMemory(request.local_mem_addr, request.length);
+        auto route = ResolveRoute(request.remote_net_addr.host, request.remote_net_addr.port);
+        auto it = std::find_if(route.begin(), route.end(), [host_memory](TransportType type) {
+            return type == TransportType::RDMA || host_memory;
+        });
+        if (it == route.end()) {
+            SPDLOG_ERROR(
+                "SubmitBatch request {} has no route to {}:{}",
+                i,
+                request.remote_net_addr.host,
+                request.remote_net_addr.port);
+            completion_queue.Push({i, false});
+            continue;
+        }
+        groups[*it].push_back(i);
+    }
+
+    auto run_group = [&](TransportType type, const std::vector<size_t>& indices) {
+        std::vector<TransferRequest> backend_requests;
+        backend_requests.reserve(indices.size());
+        for (auto index : indices) {
+            auto request = requests[index];
+            request.remote_net_addr.port = GetBackendPort(type, request.remote_net_addr.port);
+            backend_requests.push_back(std::move(request));
+        }
+
+        TransferCompletionQueue backend_queue(backend_requests.size());
+        GetBackend(type)->SubmitBatch(backend_requests, backend_queue);
+        for (size_t k = 0; k < indices.size(); ++k) {
+            auto completion = backend_queue.Pop();
+            size_t index = indices[completion.request_index];
+            bool success = completion.success;
+            if (!success) {
+                const auto& request = requests[index];
+                ExtendInfo extend_info
+                    = GetExtendInfoFromRemoteAddr(reinterpret_cast<const void*>(request.remote_mem_addr));
+                success = TransferOnRoute(
+                    request.local_mem_addr,
+                    request.length,
+                    request.remote_net_addr.host,
+                    request.remote_net_addr.port,
+                    &extend_info,
+                    request.opcode == TransferRequest::OpCode::READ,
+                    type);
+            }
+            completion_queue.Push({index, success});
+        }
+    };
+
+    // Backends run their shares side by side, at most one extra thread per backend. Not on the batch executor:
+    // the backends submit to it themselves and it must not be entered from one of its own tasks.
+    std::vector<std::future<void>> others;
+    auto first = groups.begin();
+    for (auto it = groups.begin(); it != groups.end(); ++it) {
+        if (it != first) {
+            others.emplace_back(std::async(std::launch::async, run_group, it->first, std::cref(it->second)));
+        }
+    }
+    if (first != groups.end()) {
+        run_group(first->first, first->second);
+    }
+    for (auto& other : others) {
+        other.get();
+    }
+}
+
+} // namespace astate
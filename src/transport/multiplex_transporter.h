@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/option.h"
+#include "core/atensor.h"
+#include "transfer/types.h"
+#include "transport/base_transport.h"
+#include "transport/rdma_transporter.h"
+#include "transport/shm_transporter.h"
+#include "transport/tcp_transporter.h"
+#include "transport/transport_builder.h"
+
+namespace astate {
+
+/*
+ * MultiplexTransporter picks the fastest data transport for every remote peer.
+ *
+ * It runs a ShmTransporter, an RDMATransporter and a TcpTransporter side by side
+ * (each can be disabled, RDMA is skipped when no device works) and advertises a
+ * single port P, the one found in NodeInfo through discovery:
+ *   - RDMA serves on P itself,
+ *   - SHM listens on the abstract socket named after P,
+ *   - TCP listens on P + kTcpPortOffset.
+ * When RDMA is not available P is reserved with a bound socket so that it can
+ * not be taken by another RDMA transport of the same host.
+ *
+ * The route to a peer is decided on first use: SHM if the peer runs on this host
+ * and answers, otherwise the TCP probe tells whether the peer has RDMA, so RDMA
+ * is used when both sides have it and TCP otherwise. A request failing on its
+ * route falls through the remaining backends and demotes the route, e.g. when
+ * the peer's memory is on the GPU and can not be read through SHM or TCP.
+ */
+class MultiplexTransporter : public BaseDataTransport {
+ public:
+    MultiplexTransporter() = default;
+
+    ~MultiplexTransporter() override;
+
+    MultiplexTransporter(const MultiplexTransporter&) = delete;
+    MultiplexTransporter& operator=(const MultiplexTransporter&) = delete;
+    MultiplexTransporter(MultiplexTransporter&&) = delete;
+    MultiplexTransporter& operator=(MultiplexTransporter&&) = delete;
+
+    ////////////////////// Override BaseTransport methods //////////////////////
+    [[nodiscard]] bool Start(const Options& options, const AParallelConfig& parallel_config) override;
+
+    void Stop() override;
+
+    [[nodiscard]] int GetBindPort() const override { return local_server_port_; }
+
+    [[nodiscard]] std::string GetLocalServerName() const override { return local_server_name_; }
+
+    [[nodiscard]] TransportType GetPeerTransportType(const std::string& remote_host, int remote_port) const override;
+
+    bool RegisterMemory(void* addr, size_t len, bool is_vram = false, int gpu_id_or_numa_node = -1) override;
+
+    bool DeregisterMemory(void* addr, size_t len) override;
+
+    [[nodiscard]] bool Send(
+        const void* local_addr,
+        size_t send_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info) override;
+
+    [[nodiscard]] bool Receive(
+        const void* local_addr,
+        size_t recv_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info) override;
+
+    // Runs synchronously, callback gets (local_addr, size) on success or (nullptr, 0) on failure
+    void AsyncSend(
+        const void* local_addr,
+        size_t send_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info,
+        const SendCallback& callback) override;
+
+    void AsyncReceive(
+        const void* local_addr,
+        size_t recv_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info,
+        const ReceiveCallback& callback) override;
+
+    /*
+     * Requests are split by route and handed to each backend's SubmitBatch,
+     * the backends run their shares concurrently and failed requests are
+     * retried on the remaining backends.
+     */
+    void SubmitBatch(std::span<TransferRequest> requests, TransferCompletionQueue& completion_queue) override;
+
+    // Handed to the backends as well, those without native batching run on it
+    void SetBatchExecutor(BatchExecutor executor) override;
+
+    ////////////////////// Multiplex specific methods //////////////////////
+    /*
+     * Get the route chosen for every peer seen so far, also exported as the kPeerRoute gauges.
+     * @return "host:port" -> transport type
+     */
+    [[nodiscard]] std::unordered_map<std::string, TransportType> GetPeerRoutes() const;
+
+    /*
+     * Check whether a backend is running.
+     * @param type: SHM, RDMA or TCP
+     */
+    [[nodiscard]] bool IsBackendRunning(TransportType type) const;
+
+    /*
+     * Get the TCP backend, e.g. to carry control messages.
+     * @return nullptr if TCP is not running
+     */
+    [[nodiscard]] TcpTransporter* GetTcpBackend() const {
+        return tcp_ != nullptr && tcp_->IsRunning() ? tcp_.get() : nullptr;
+    }
+
+ private:
+    static constexpr int kPortStart = 51010;
+    static constexpr int kTcpPortOffset = 3000;
+
+    // Backends to try for a peer, best first
+    using Route = std::vector<TransportType>;
+
+    static std::string PeerKey(const std::string& remote_host, int remote_port) {
+        return remote_host + ":" + std::to_string(remote_port);
+    }
+
+    BaseDataTransport* GetBackend(TransportType type) const;
+
+    // Port of the backend on a peer advertising remote_port
+    static int GetBackendPort(TransportType type, int remote_port) {
+        return type == TransportType::TCP ? remote_port + kTcpPortOffset : remote_port;
+    }
+
+    bool StartRdma(const Options& options, const AParallelConfig& parallel_config);
+
+    // Start TCP on P + kTcpPortOffset, reserving P first when RDMA is not running
+    bool StartTcp(const Options& options, const AParallelConfig& parallel_config);
+
+    // Decide the route of a peer on first use, cached afterwards
+    Route ResolveRoute(const std::string& remote_host, int remote_port);
+
+    // Drop the failed backend from the head of the peer's route
+    void DemoteRoute(const std::string& remote_host, int remote_port, TransportType failed);
+
+    // Whether [addr, addr + len) is not registered as VRAM, only RDMA can move VRAM
+    bool IsHostMemory(const void* addr, size_t len) const;
+
+    // Try the request on every backend of the route in turn
+    bool TransferOnRoute(
+        const void* local_addr,
+        size_t size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info,
+        bool is_read,
+        TransportType skip = TransportType::UNKNOWN);
+
+    std::string local_server_name_;
+    int local_server_port_{0};
+    int reserve_fd_{-1};
+
+    std::unique_ptr<ShmTransporter> shm_;
+    std::unique_ptr<RDMATransporter> rdma_;
+    std::unique_ptr<TcpTransporter> tcp_;
+
+    mutable std::shared_mutex route_mutex_;
+    std::unordered_map<std::string, Route> routes_;
+
+    // start address -> (length, is_vram) of every registered region
+    mutable std::shared_mutex region_mutex_;
+    std::map<uint64_t, std::pair<size_t, bool>> regions_;
+};
+
+} // namespace astate
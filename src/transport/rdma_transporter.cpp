@@ -9,6 +9,8 @@
 #include <random>
 #include <stdexcept>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include <unistd.h>
 
@@ -37,11 +39,20 @@ static int NumaNodeOfInfiniband(const std::string& dev) {
     return -1;
 }
 
-void RDMATransporter::InitializeFromOptions(const Options& options) {
+bool RDMATransporter::InitializeFromOptions(const Options& options) {
+    options_ = options;
+    // Send and Receive read their retry settings from it
+    if (resolved_options_ == nullptr) {
+        resolved_options_ = TryResolveOptions(options);
+        if (resolved_options_ == nullptr) {
+            return false;
+        }
+    }
     local_server_name_ = GetLocalHostnameOrIP();
     meta_addr_ = GetOptionValue<std::string>(options, TRANSFER_ENGINE_META_SERVICE_ADDRESS);
     read_timeout_ms_ = GetOptionValue<int>(options, TRANSFER_ENGINE_READ_TIMEOUT_MS);
     write_timeout_ms_ = GetOptionValue<int>(options, TRANSFER_ENGINE_WRITE_TIMEOUT_MS);
+    return true;
 }
 
 void RDMATransporter::InitializeLoggingConfig(utrans_config_t& utrans_config) {
@@ -105,6 +116,10 @@ void RDMATransporter::InitializeRdmaConfig(
         SPDLOG_WARN("No RDMA devices selected, using default configuration");
         utrans_config.rdma_conf.valid_dev_patt = nullptr;
     }
+#ifdef ASTATE_RDMA_BACKEND_UCX
+    // utrans pins its poller threads (and their UCX workers) to the NIC's NUMA node
+    utrans_config.rdma_conf.numa_node = rdma_numa_node_;
+#endif
 }
 
 bool RDMATransporter::SetupUtransContext(utrans_config_t& utrans_config) {
@@ -237,7 +252,9 @@ std::string RDMATransporter::SelectRdmaDevices(const Options& options, int rank_
 
 bool RDMATransporter::Start(const Options& options, const AParallelConfig& parallel_config) {
     // Initialize basic options
-    InitializeFromOptions(options);
+    if (!InitializeFromOptions(options)) {
+        return false;
+    }
 
     // Initialize utrans context
     utrans_config_t utrans_config = {};
@@ -322,8 +339,8 @@ bool RDMATransporter::Send(
               .count();
     last_send_receive_time_ = now;
 
-    int retry_count = GetOptionValue<int>(options_, TRANSPORT_SEND_RETRY_COUNT);
-    int retry_sleep_ms = GetOptionValue<int>(options_, TRANSPORT_SEND_RETRY_SLEEP_MS);
+    int retry_count = resolved_options_->Get(TRANSPORT_SEND_RETRY_COUNT_KEY);
+    int retry_sleep_ms = resolved_options_->Get(TRANSPORT_SEND_RETRY_SLEEP_MS_KEY);
 
     auto send_func = [&]() -> bool {
         uint64_t remote_inst_id = UTRANS_INVALID_INST_ID;
@@ -429,8 +446,8 @@ bool RDMATransporter::Receive(
               .count();
     last_send_receive_time_ = now;
 
-    int retry_count = GetOptionValue<int>(options_, TRANSPORT_RECEIVE_RETRY_COUNT);
-    int retry_sleep_ms = GetOptionValue<int>(options_, TRANSPORT_RECEIVE_RETRY_SLEEP_MS);
+    int retry_count = resolved_options_->Get(TRANSPORT_RECEIVE_RETRY_COUNT_KEY);
+    int retry_sleep_ms = resolved_options_->Get(TRANSPORT_RECEIVE_RETRY_SLEEP_MS_KEY);
 
     auto recv_func = [&]() -> bool {
         uint64_t remote_inst_id = UTRANS_INVALID_INST_ID;
@@ -546,6 +563,129 @@ void RDMATransporter::AsyncReceive(
     throw std::runtime_error("Not implemented");
 }
 
+void RDMATransporter::SubmitBatch(std::span<TransferRequest> requests, TransferCompletionQueue& completion_queue) {
+    if (ctx_ == nullptr) {
+        SPDLOG_ERROR("Context not initialized");
+        throw std::invalid_argument("RDMATransporter::SubmitBatch: context not initialized");
+    }
+    if (requests.empty()) {
+        return;
+    }
+
+    auto now
+        = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+              .count();
+    last_send_receive_time_ = now;
+
+    // Resolve every distinct peer once for the whole batch
+    std::unordered_map<RemoteAddress, uint64_t, RemoteAddressHash> inst_ids;
+    std::vector<utrans_req_info_t*> op_infos(requests.size(), nullptr);
+    for (size_t i = 0; i < requests.size(); ++i) {
+        auto& request = requests[i];
+        if (request.local_mem_addr == nullptr || request.length == 0 || request.remote_mem_addr == 0) {
+            SPDLOG_ERROR("SubmitBatch request {} has null address or zero length", i);
+            continue;
+        }
+
+        RemoteAddress peer{request.remote_net_addr.host, request.remote_net_addr.port};
+        auto inst_it = inst_ids.find(peer);
+        if (inst_it == inst_ids.end()) {
+            uint64_t remote_inst_id = UTRANS_INVALID_INST_ID;
+            int ret = utrans_query_instid(ctx_, peer.host.c_str(), peer.port, &remote_inst_id);
+            if (ret != UTRANS_RET_SUCC) {
+                SPDLOG_ERROR("Query remote instance id failed, remote_addr={}:{}, ret={}", peer.host, peer.port, ret);
+                continue;
+            }
+            inst_it = inst_ids.emplace(std::move(peer), remote_inst_id).first;
+        }
+
+        bool is_read = request.opcode == TransferRequest::OpCode::READ;
+        trans_req_t req{
+            inst_it->second,
+            static_cast<int16_t>(is_read ? USER_OP_READ : USER_OP_WRITE),
+            1,
+            reinterpret_cast<void*>(request.remote_mem_addr),
+            nullptr,
+            {{request.local_mem_addr, request.length}}};
+        // wait_ms == 0 posts the request without waiting, all requests are in flight together
+        trans_conf_t conf{4, 1024 * 1024, 0};
+        op_infos[i] = utrans_exec_transfer(ctx_, &req, &conf);
+    }
+
+    // Failed requests fall back to the sync path which owns the retry policy
+    auto complete = [&](size_t i, bool success) {
+        const auto& request = requests[i];
+        if (!success && request.local_mem_addr != nullptr && request.length != 0 && request.remote_mem_addr != 0) {
+            ExtendInfo extend_info = GetExtendInfoFromRemoteAddr(reinterpret_cast<void*>(request.remote_mem_addr));
+            try {
+                success = request.opcode == TransferRequest::OpCode::READ
+                    ? Receive(
+                          request.local_mem_addr,
+                          request.length,
+                          request.remote_net_addr.host,
+                          request.remote_net_addr.port,
+                          &extend_info)
+                    : Send(
+                          request.local_mem_addr,
+                          request.length,
+                          request.remote_net_addr.host,
+                          request.remote_net_addr.port,
+                          &extend_info);
+            } catch (const std::exception& e) {
+                SPDLOG_ERROR("SubmitBatch request {} failed: {}", i, e.what());
+            }
+        }
+        completion_queue.Push({i, success});
+    };
+
+    std::vector<size_t> pending;
+    pending.reserve(requests.size());
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (op_infos[i] != nullptr) {
+            pending.push_back(i);
+        } else {
+            complete(i, false);
+        }
+    }
+
+    // Reap in completion order, the requests were posted without a timeout so the transport's timeouts apply here
+    auto submit_time = std::chrono::steady_clock::now();
+    while (!pending.empty()) {
+        auto elapsed_ms
+            = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - submit_time)
+                  .count();
+        size_t still_running = 0;
+        for (size_t i : pending) {
+            const auto& request = requests[i];
+            bool is_read = request.opcode == TransferRequest::OpCode::READ;
+            auto state = utrans_get_req_state(op_infos[i]);
+            bool finished = state == USER_STATE_FINISHED || state == USER_STATE_TIMEOUT || state == USER_STATE_INVALID;
+            if (!finished && elapsed_ms < (is_read ? read_timeout_ms_ : write_timeout_ms_)) {
+                pending[still_running++] = i;
+                continue;
+            }
+            auto result = state == USER_STATE_FINISHED ? utrans_get_req_exec_result(op_infos[i]) : URES_ERR_TIMEOUT;
+            if (result != URES_SUCCESS) {
+                SPDLOG_WARN(
+                    "SubmitBatch request {} failed with status: {}, remote_addr={}:{}, laddr={}, raddr={}, length={}",
+                    i,
+                    static_cast<int>(result),
+                    request.remote_net_addr.host,
+                    request.remote_net_addr.port,
+                    PointerToHexString(request.local_mem_addr),
+                    PointerToHexString(reinterpret_cast<void*>(request.remote_mem_addr)),
+                    request.length);
+            }
+            utrans_unref_req_info(op_infos[i]);
+            complete(i, result == URES_SUCCESS);
+        }
+        pending.resize(still_running);
+        if (!pending.empty()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
 bool RDMATransporter::RegisterMemory(void* addr, size_t len, bool is_vram, int gpu_id_or_numa_node) {
     if (ctx_ == nullptr) {
         SPDLOG_ERROR("Context not initialized");
@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -70,6 +71,12 @@ class RDMATransporter : public BaseDataTransport {
         const ExtendInfo* extend_info,
         const ReceiveCallback& callback) override;
 
+    /*
+     * Post all requests to utrans without waiting, then reap them.
+     * Remote instance ids are resolved once per distinct peer in the batch.
+     */
+    void SubmitBatch(std::span<TransferRequest> requests, TransferCompletionQueue& completion_queue) override;
+
     ////////////////////// RDMA specific methods //////////////////////
     /*
      * Register memory region
@@ -80,7 +87,7 @@ class RDMATransporter : public BaseDataTransport {
      * @return true if registration successful, false otherwise
      * @throws std::runtime_error if memory registration fails
      */
-    bool RegisterMemory(void* addr, size_t len, bool is_vram = false, int gpu_id_or_numa_node = -1);
+    bool RegisterMemory(void* addr, size_t len, bool is_vram = false, int gpu_id_or_numa_node = -1) override;
 
     /*
      * Deregister memory region
@@ -88,12 +95,15 @@ class RDMATransporter : public BaseDataTransport {
      * @param len: memory length
      * @return deregistered memory region
      */
-    bool DeregisterMemory(void* addr, size_t len);
+    bool DeregisterMemory(void* addr, size_t len) override;
 
     ////////////////////// Getters //////////////////////
     int GetWriteTimeout() const { return write_timeout_ms_; }
     int GetReadTimeout() const { return read_timeout_ms_; }
-    std::string GetLocalServerName() const { return local_server_name_; }
+    std::string GetLocalServerName() const override { return local_server_name_; }
+    TransportType GetPeerTransportType(const std::string& /*remote_host*/, int /*remote_port*/) const override {
+        return TransportType::RDMA;
+    }
     int GetBindPort() const override { return local_server_port_; }
     std::string GetMetaAddr() const { return meta_addr_; }
 
@@ -116,7 +126,8 @@ class RDMATransporter : public BaseDataTransport {
     static std::string SelectRdmaDevices(const Options& options, int rank_id);
 
     // Initialize basic options
-    void InitializeFromOptions(const Options& options);
+    // false on invalid options when none were resolved by the owner
+    bool InitializeFromOptions(const Options& options);
 
     // Initialize utrans logging configuration
     static void InitializeLoggingConfig(utrans_config_t& utrans_config);
@@ -195,26 +206,4 @@ static std::shared_ptr<RegisteredMemRegion> ConvertFromCMemRegion(const mem_regi
     return result;
 }
 
-/*
- * Get remote address from extend info
- * @param extend_info: extend info
- * @return remote address
- */
-static const void* GetRemoteAddrFromExtendInfo(const ExtendInfo* extend_info) {
-    // RDMA Transport Extend info:[remote_addr]
-    if (extend_info == nullptr || extend_info->size() == 0) {
-        SPDLOG_ERROR("Extend info is null or empty");
-        return nullptr;
-    }
-
-    return std::any_cast<const void*>(extend_info->at(0));
-}
-
-static ExtendInfo GetExtendInfoFromRemoteAddr(const void* remote_addr) {
-    // RDMA Transport Extend info:[remote_addr]
-    ExtendInfo extend_info;
-    extend_info.emplace_back(remote_addr);
-    return extend_info;
-}
-
 } // namespace astate
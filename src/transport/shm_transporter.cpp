@@ -0,0 +1,543 @@
+#include "transport/shm_transporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "common/network_utils.h"
+#include "common/option.h"
+#include "common/string_utils.h"
+#include "transport/base_transport.h"
+
+namespace astate {
+
+ShmTransporter::~ShmTransporter() {
+    if (is_running_) {
+        Stop();
+    }
+}
+
+std::string ShmTransporter::SocketName(int port) {
+    return "astate_shm_" + std::to_string(port);
+}
+
+bool ShmTransporter::IsLocalHost(const std::string& host) {
+    static const std::string kLocalHost = GetLocalHostnameOrIP();
+    return host == kLocalHost || host == "127.0.0.1" || host == "localhost";
+}
+
+bool ShmTransporter::BindLocalSocket(int port) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        SPDLOG_ERROR("Failed to create unix socket: {}", strerror(errno));
+        return false;
+    }
+
+    // Abstract namespace, no file to clean up and gone with the process
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    auto name = SocketName(port);
+    std::memcpy(addr.sun_path + 1, name.data(), name.size());
+    auto addr_len = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + 1 + name.size());
+
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), addr_len) != 0 || listen(fd, SOMAXCONN) != 0) {
+        SPDLOG_WARN("Failed to bind shm socket {}: {}", name, strerror(errno));
+        close(fd);
+        return false;
+    }
+    listen_fd_ = fd;
+    local_port_ = port;
+    return true;
+}
+
+bool ShmTransporter::Start(const Options& options, const AParallelConfig& /*parallel_config*/) {
+    if (is_running_) {
+        SPDLOG_WARN("ShmTransporter already started");
+        return true;
+    }
+
+    // Opt-in: lets any local process read us even when yama ptrace_scope is 1
+    if (GetOptionValue<bool>(options, TRANSFER_ENGINE_SHM_ALLOW_PTRACE)
+        && prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY, 0, 0, 0) != 0) {
+        SPDLOG_WARN("Failed to set PR_SET_PTRACER_ANY: {}", strerror(errno));
+    }
+
+    if (!CreateRegionTable()) {
+        return false;
+    }
+
+    int port = GetOptionValue<int>(options, TRANSFER_ENGINE_SHM_PORT);
+    bool bound = false;
+    if (port > 0) {
+        bound = BindLocalSocket(port);
+    } else {
+        for (int i = 0; i < kBindPortMaxRetry && !bound; ++i) {
+            bound = BindLocalSocket(kShmPortStart + i);
+        }
+    }
+    if (!bound) {
+        SPDLOG_ERROR("ShmTransporter failed to bind local socket, port={}", port);
+        return false;
+    }
+
+    accept_running_ = true;
+    accept_thread_ = std::thread(&ShmTransporter::AcceptThreadFunc, this);
+
+    is_running_ = true;
+    SPDLOG_INFO("ShmTransporter started, port={}, pid={}", local_port_, getpid());
+    return true;
+}
+
+void ShmTransporter::Stop() {
+    if (!is_running_) {
+        return;
+    }
+
+    accept_running_ = false;
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(peer_mutex_);
+        peers_.clear();
+    }
+    {
+        // Peers keep their own mapping of the table, unmapping ours does not pull it from under them
+        std::lock_guard<std::mutex> lock(region_mutex_);
+        if (region_table_ != nullptr) {
+            munmap(region_table_, sizeof(ShmRegionTable));
+            region_table_ = nullptr;
+        }
+        if (region_table_fd_ >= 0) {
+            close(region_table_fd_);
+            region_table_fd_ = -1;
+        }
+        regions_.clear();
+    }
+    is_running_ = false;
+    SPDLOG_INFO("ShmTransporter stopped");
+}
+
+ShmTransporter::ShmPeer::~ShmPeer() {
+    if (regions != nullptr) {
+        munmap(const_cast<ShmRegionTable*>(regions), sizeof(ShmRegionTable));
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool ShmTransporter::CreateRegionTable() {
+    int fd = memfd_create("astate_shm_regions", MFD_CLOEXEC);
+    if (fd < 0) {
+        SPDLOG_ERROR("Failed to create shm region table: {}", strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, sizeof(ShmRegionTable)) != 0) {
+        SPDLOG_ERROR("Failed to size shm region table: {}", strerror(errno));
+        close(fd);
+        return false;
+    }
+    // A fresh memfd reads as zeros: empty table, seq and epoch 0
+    void* table = mmap(nullptr, sizeof(ShmRegionTable), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (table == MAP_FAILED) {
+        SPDLOG_ERROR("Failed to map shm region table: {}", strerror(errno));
+        close(fd);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(region_mutex_);
+    region_table_fd_ = fd;
+    region_table_ = static_cast<ShmRegionTable*>(table);
+    return true;
+}
+
+void ShmTransporter::PublishRegions() {
+    auto& table = *region_table_;
+    uint64_t seq = table.seq.load(std::memory_order_relaxed);
+    table.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    uint32_t i = 0;
+    for (const auto& [addr, length] : regions_) {
+        table.entries[i].addr.store(addr, std::memory_order_relaxed);
+        table.entries[i].length.store(length, std::memory_order_relaxed);
+        ++i;
+    }
+    table.size.store(i, std::memory_order_relaxed);
+    table.seq.store(seq + 2, std::memory_order_release);
+}
+
+bool ShmTransporter::RegisterMemory(void* addr, size_t len, bool is_vram, int /*gpu_id_or_numa_node*/) {
+    if (addr == nullptr || len == 0 || is_vram) {
+        SPDLOG_ERROR("ShmTransporter only serves host memory, addr: {}, len: {}", PointerToHexString(addr), len);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(region_mutex_);
+    if (region_table_ == nullptr) {
+        SPDLOG_ERROR("ShmTransporter is not started, can not register {}", PointerToHexString(addr));
+        return false;
+    }
+    auto key = reinterpret_cast<uint64_t>(addr);
+    if (regions_.size() >= kMaxRegions && regions_.count(key) == 0) {
+        SPDLOG_ERROR(
+            "ShmTransporter region table is full ({} regions), addr: {}", kMaxRegions, PointerToHexString(addr));
+        return false;
+    }
+    regions_[key] = len;
+    PublishRegions();
+    return true;
+}
+
+bool ShmTransporter::DeregisterMemory(void* addr, size_t /*len*/) {
+    std::lock_guard<std::mutex> lock(region_mutex_);
+    if (regions_.erase(reinterpret_cast<uint64_t>(addr)) == 0) {
+        return false;
+    }
+    PublishRegions();
+    // Before the caller may release the memory: readers copying from it see the epoch move and drop the data
+    region_table_->deregister_epoch.fetch_add(1, std::memory_order_seq_cst);
+    return true;
+}
+
+bool ShmTransporter::IsRegistered(const ShmRegionTable& regions, uint64_t addr, size_t len) {
+    // Bounded, the owner may have died half way through an update
+    static constexpr int kMaxReadAttempts = 1024;
+    for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+        uint64_t seq = regions.seq.load(std::memory_order_acquire);
+        if ((seq & 1) != 0) {
+            sched_yield();
+            continue;
+        }
+        uint32_t size = std::min(regions.size.load(std::memory_order_relaxed), kMaxRegions);
+        // Last entry starting at or before addr
+        uint32_t lo = 0;
+        uint32_t hi = size;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (regions.entries[mid].addr.load(std::memory_order_relaxed) <= addr) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        bool found = false;
+        if (lo > 0) {
+            uint64_t start = regions.entries[lo - 1].addr.load(std::memory_order_relaxed);
+            uint64_t end = start + regions.entries[lo - 1].length.load(std::memory_order_relaxed);
+            found = addr < end && len <= end - addr;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (regions.seq.load(std::memory_order_relaxed) == seq) {
+            return found;
+        }
+    }
+    return false;
+}
+
+void ShmTransporter::AcceptThreadFunc() {
+    static constexpr int kAcceptPollMs = 100;
+    // The listen socket first, then one entry per connected peer. Peers never send, a readable
+    // peer socket means it closed its end.
+    std::vector<struct pollfd> pfds{{listen_fd_, POLLIN, 0}};
+    while (accept_running_) {
+        int n = poll(pfds.data(), pfds.size(), kAcceptPollMs);
+        if (n <= 0) {
+            continue;
+        }
+        for (size_t i = pfds.size() - 1; i > 0; --i) {
+            if (pfds[i].revents != 0) {
+                close(pfds[i].fd);
+                pfds.erase(pfds.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+        }
+        if ((pfds[0].revents & POLLIN) == 0) {
+            continue;
+        }
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        // Hand the region table over, the peer maps it read-only
+        char byte = 0;
+        struct iovec iov {
+            &byte, sizeof(byte)
+        };
+        alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+        struct msghdr msg {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &region_table_fd_, sizeof(int));
+        if (sendmsg(fd, &msg, MSG_NOSIGNAL) != sizeof(byte)) {
+            SPDLOG_WARN("Failed to hand shm region table to a local peer: {}", strerror(errno));
+            close(fd);
+            continue;
+        }
+        pfds.push_back({fd, POLLIN, 0});
+    }
+    for (size_t i = 1; i < pfds.size(); ++i) {
+        close(pfds[i].fd);
+    }
+}
+
+std::shared_ptr<ShmTransporter::ShmPeer> ShmTransporter::ResolvePeer(int remote_port) {
+    static constexpr struct timeval kRecvTimeout {
+        5, 0
+    };
+    {
+        std::lock_guard<std::mutex> lock(peer_mutex_);
+        auto it = peers_.find(remote_port);
+        if (it != peers_.end()) {
+            return it->second;
+        }
+    }
+
+    auto peer = std::make_shared<ShmPeer>();
+    peer->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (peer->fd < 0) {
+        SPDLOG_ERROR("Failed to create unix socket: {}", strerror(errno));
+        return nullptr;
+    }
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    auto name = SocketName(remote_port);
+    std::memcpy(addr.sun_path + 1, name.data(), name.size());
+    auto addr_len = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + 1 + name.size());
+
+    struct ucred cred {};
+    socklen_t cred_len = sizeof(cred);
+    if (connect(peer->fd, reinterpret_cast<struct sockaddr*>(&addr), addr_len) != 0
+        || getsockopt(peer->fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) != 0 || cred.pid <= 0) {
+        return nullptr;
+    }
+    peer->pid = cred.pid;
+    setsockopt(peer->fd, SOL_SOCKET, SO_RCVTIMEO, &kRecvTimeout, sizeof(kRecvTimeout));
+
+    char byte = 0;
+    struct iovec iov {
+        &byte, sizeof(byte)
+    };
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    struct msghdr msg {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr* cmsg = nullptr;
+    if (recvmsg(peer->fd, &msg, MSG_CMSG_CLOEXEC) != sizeof(byte) || (cmsg = CMSG_FIRSTHDR(&msg)) == nullptr
+        || cmsg->cmsg_type != SCM_RIGHTS) {
+        SPDLOG_ERROR("Failed to receive shm region table from local peer on port {}", remote_port);
+        return nullptr;
+    }
+    int table_fd = -1;
+    std::memcpy(&table_fd, CMSG_DATA(cmsg), sizeof(int));
+    void* table = mmap(nullptr, sizeof(ShmRegionTable), PROT_READ, MAP_SHARED, table_fd, 0);
+    close(table_fd);
+    if (table == MAP_FAILED) {
+        SPDLOG_ERROR("Failed to map shm region table of local peer on port {}: {}", remote_port, strerror(errno));
+        return nullptr;
+    }
+    peer->regions = static_cast<const ShmRegionTable*>(table);
+
+    std::lock_guard<std::mutex> lock(peer_mutex_);
+    return peers_.emplace(remote_port, std::move(peer)).first->second;
+}
+
+void ShmTransporter::EvictPeer(int remote_port) {
+    std::lock_guard<std::mutex> lock(peer_mutex_);
+    peers_.erase(remote_port);
+}
+
+bool ShmTransporter::IsPeerReachable(const std::string& remote_host, int remote_port) {
+    return IsLocalHost(remote_host) && ResolvePeer(remote_port) != nullptr;
+}
+
+bool ShmTransporter::IsPeerAlive(const ShmPeer& peer) {
+    char byte = 0;
+    ssize_t n = recv(peer.fd, &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT);
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+int ShmTransporter::CopyFromOrToPeer(pid_t pid, void* local_addr, const void* remote_addr, size_t size, bool is_read) {
+    size_t done = 0;
+    while (done < size) {
+        struct iovec local_iov {
+            static_cast<char*>(local_addr) + done, size - done
+        };
+        struct iovec remote_iov {
+            const_cast<char*>(static_cast<const char*>(remote_addr)) + done, size - done
+        };
+        ssize_t n = is_read ? process_vm_readv(pid, &local_iov, 1, &remote_iov, 1, 0)
+                            : process_vm_writev(pid, &local_iov, 1, &remote_iov, 1, 0);
+        if (n < 0) {
+            int err = errno;
+            if (err == EINTR) {
+                continue;
+            }
+            SPDLOG_ERROR(
+                "process_vm_{} failed: {}, pid={}, laddr={}, raddr={}, length={}, done={}",
+                is_read ? "readv" : "writev",
+                strerror(err),
+                pid,
+                PointerToHexString(local_addr),
+                PointerToHexString(remote_addr),
+                size,
+                done);
+            return err;
+        }
+        if (n == 0) {
+            SPDLOG_ERROR("process_vm_{} made no progress, pid={}", is_read ? "readv" : "writev", pid);
+            return EIO;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return 0;
+}
+
+int ShmTransporter::TransferWithPeer(
+    const ShmPeer& peer, void* local_addr, const void* remote_addr, size_t size, bool is_read) {
+    static constexpr int kMaxAttempts = 3;
+    auto raddr = reinterpret_cast<uint64_t>(remote_addr);
+    for (int attempt = 0; attempt < kMaxAttempts; ++attempt) {
+        uint64_t epoch = peer.regions->deregister_epoch.load(std::memory_order_seq_cst);
+        if (!IsRegistered(*peer.regions, raddr, size)) {
+            SPDLOG_ERROR(
+                "Request on memory the local peer did not register, pid={}, raddr={}, length={}",
+                peer.pid,
+                PointerToHexString(remote_addr),
+                size);
+            return EFAULT;
+        }
+        int err = CopyFromOrToPeer(peer.pid, local_addr, remote_addr, size, is_read);
+        if (err != 0) {
+            return err;
+        }
+        // A pid is only trusted while the peer still holds its end of the connection
+        if (!IsPeerAlive(peer)) {
+            return ECONNRESET;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (peer.regions->deregister_epoch.load(std::memory_order_seq_cst) == epoch) {
+            return 0;
+        }
+        // Something was deregistered while copying, the data may come from released memory
+    }
+    SPDLOG_ERROR(
+        "Local peer kept deregistering memory during the copy, pid={}, raddr={}, length={}",
+        peer.pid,
+        PointerToHexString(remote_addr),
+        size);
+    return ESTALE;
+}
+
+bool ShmTransporter::Transfer(
+    const void* local_addr,
+    size_t size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info,
+    bool is_read) {
+    if (local_addr == nullptr || size == 0) {
+        SPDLOG_ERROR("Local data is null or size is zero");
+        throw std::invalid_argument("ShmTransporter: local data is null or size is zero");
+    }
+    const void* rbuf = GetRemoteAddrFromExtendInfo(extend_info);
+    if (rbuf == nullptr) {
+        SPDLOG_ERROR("Remote address is null");
+        throw std::invalid_argument("ShmTransporter: remote address is null");
+    }
+    if (!IsLocalHost(remote_host)) {
+        SPDLOG_ERROR("ShmTransporter can not reach non-local peer {}:{}", remote_host, remote_port);
+        return false;
+    }
+
+    auto peer = ResolvePeer(remote_port);
+    if (peer == nullptr) {
+        SPDLOG_ERROR("ShmTransporter failed to resolve local peer on port {}", remote_port);
+        return false;
+    }
+    int err = TransferWithPeer(*peer, const_cast<void*>(local_addr), rbuf, size, is_read);
+    if (err == ESRCH || err == ECONNRESET || err == EPIPE) {
+        // The peer may have restarted on the same port, resolve again once
+        EvictPeer(remote_port);
+        peer = ResolvePeer(remote_port);
+        if (peer != nullptr) {
+            err = TransferWithPeer(*peer, const_cast<void*>(local_addr), rbuf, size, is_read);
+        }
+    }
+    return err == 0;
+}
+
+bool ShmTransporter::Send(
+    const void* local_addr,
+    size_t send_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info) {
+    return Transfer(local_addr, send_size, remote_host, remote_port, extend_info, false);
+}
+
+bool ShmTransporter::Receive(
+    const void* local_addr,
+    size_t recv_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info) {
+    return Transfer(local_addr, recv_size, remote_host, remote_port, extend_info, true);
+}
+
+void ShmTransporter::AsyncSend(
+    const void* local_addr,
+    size_t send_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info,
+    const SendCallback& callback) {
+    bool success = Send(local_addr, send_size, remote_host, remote_port, extend_info);
+    if (callback) {
+        callback(success ? local_addr : nullptr, success ? send_size : 0);
+    }
+}
+
+void ShmTransporter::AsyncReceive(
+    const void* local_addr,
+    size_t recv_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info,
+    const ReceiveCallback& callback) {
+    bool success = Receive(local_addr, recv_size, remote_host, remote_port, extend_info);
+    if (callback) {
+        callback(success ? local_addr : nullptr, success ? recv_size : 0);
+    }
+}
+
+} // namespace astate
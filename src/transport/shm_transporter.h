@@ -0,0 +1,196 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <sys/types.h>
+
+#include "common/option.h"
+#include "core/atensor.h"
+#include "transport/base_transport.h"
+
+namespace astate {
+
+/*
+ * ShmTransporter is a data transport for peers running on the same host.
+ *
+ * Every instance listens on an abstract unix socket named after its port. It
+ * hands its pid to local peers (SO_PEERCRED) together with a memfd holding the
+ * table of memory registered with RegisterMemory, the same check the TCP
+ * transport does before serving. Readers map that table once per peer and look
+ * ranges up locally, then read and write directly against the peer's address
+ * space with process_vm_readv / process_vm_writev, so the trainer's pinned
+ * copies are served at memory bandwidth without going through the NIC loopback.
+ *
+ * DeregisterMemory bumps an epoch in the table before it returns. A reader
+ * checks the epoch again once the copy is done and drops the data when a region
+ * went away in between, so it never returns memory the peer already released.
+ *
+ * Under yama ptrace_scope 1 a peer may only be read when it granted it, which is
+ * opt-in through TRANSFER_ENGINE_SHM_ALLOW_PTRACE. Without it such transfers fail
+ * with EPERM and the multiplexer falls back to the next backend.
+ *
+ * The remote address is passed as extend info, same as RDMATransporter.
+ * Only host memory is supported on both sides.
+ */
+class ShmTransporter : public BaseDataTransport {
+ public:
+    ShmTransporter() = default;
+
+    ~ShmTransporter() override;
+
+    ShmTransporter(const ShmTransporter&) = delete;
+    ShmTransporter& operator=(const ShmTransporter&) = delete;
+    ShmTransporter(ShmTransporter&&) = delete;
+    ShmTransporter& operator=(ShmTransporter&&) = delete;
+
+    ////////////////////// Override BaseTransport methods //////////////////////
+    [[nodiscard]] bool Start(const Options& options, const AParallelConfig& parallel_config) override;
+
+    void Stop() override;
+
+    [[nodiscard]] int GetBindPort() const override { return local_port_; }
+
+    [[nodiscard]] TransportType
+    GetPeerTransportType(const std::string& /*remote_host*/, int /*remote_port*/) const override {
+        return TransportType::SHM;
+    }
+
+    bool RegisterMemory(void* addr, size_t len, bool is_vram = false, int gpu_id_or_numa_node = -1) override;
+
+    bool DeregisterMemory(void* addr, size_t len) override;
+
+    [[nodiscard]] bool Send(
+        const void* local_addr,
+        size_t send_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info) override;
+
+    [[nodiscard]] bool Receive(
+        const void* local_addr,
+        size_t recv_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info) override;
+
+    // Runs synchronously, callback gets (local_addr, size) on success or (nullptr, 0) on failure
+    void AsyncSend(
+        const void* local_addr,
+        size_t send_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info,
+        const SendCallback& callback) override;
+
+    void AsyncReceive(
+        const void* local_addr,
+        size_t recv_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info,
+        const ReceiveCallback& callback) override;
+
+    ////////////////////// Shm specific methods //////////////////////
+    /*
+     * Check whether the host refers to this machine.
+     * @param host: hostname or ip of the remote endpoint
+     * @return true if the host is local
+     */
+    static bool IsLocalHost(const std::string& host);
+
+    /*
+     * Check whether a shm transport is reachable at the port on this host.
+     * @param port: the bind port of the remote shm transport
+     * @return true if the peer is reachable
+     */
+    bool IsPeerReachable(const std::string& remote_host, int remote_port);
+
+ private:
+    static constexpr int kShmPortStart = 53010;
+
+    static constexpr uint32_t kMaxRegions = 1U << 16;
+
+    // Registered regions of an instance, shared read-only with its local peers through a memfd.
+    // Entries are sorted by address and guarded by a seqlock, seq is odd while the owner rewrites them.
+    struct ShmRegionTable {
+        struct Entry {
+            std::atomic<uint64_t> addr;
+            std::atomic<uint64_t> length;
+        };
+        std::atomic<uint64_t> seq;
+        std::atomic<uint64_t> deregister_epoch;
+        std::atomic<uint32_t> size;
+        Entry entries[kMaxRegions];
+    };
+
+    // Connection to a local peer, kept open so a restarted peer is noticed
+    struct ShmPeer {
+        pid_t pid{-1};
+        int fd{-1};
+        const ShmRegionTable* regions{nullptr};
+
+        ~ShmPeer();
+    };
+
+    static std::string SocketName(int port);
+
+    bool BindLocalSocket(int port);
+
+    // Accepts local peers and hands them the region table
+    void AcceptThreadFunc();
+
+    bool CreateRegionTable();
+
+    // Rewrite the shared table from regions_, shall hold region_mutex_
+    void PublishRegions();
+
+    // Lock-free lookup in a peer's table, false when [addr, addr + len) is not inside one registered region
+    static bool IsRegistered(const ShmRegionTable& regions, uint64_t addr, size_t len);
+
+    // Connect to the local peer listening on remote_port, cached per port
+    std::shared_ptr<ShmPeer> ResolvePeer(int remote_port);
+
+    void EvictPeer(int remote_port);
+
+    // False once the peer closed its end, e.g. it exited or restarted
+    static bool IsPeerAlive(const ShmPeer& peer);
+
+    // Copy between local and remote address space, loops on partial transfers, returns 0 or errno
+    static int CopyFromOrToPeer(pid_t pid, void* local_addr, const void* remote_addr, size_t size, bool is_read);
+
+    // Check the peer's table, copy, then make sure nothing was deregistered meanwhile, returns 0 or errno
+    static int
+    TransferWithPeer(const ShmPeer& peer, void* local_addr, const void* remote_addr, size_t size, bool is_read);
+
+    bool Transfer(
+        const void* local_addr,
+        size_t size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info,
+        bool is_read);
+
+    int local_port_{0};
+    int listen_fd_{-1};
+    std::thread accept_thread_;
+    std::atomic<bool> accept_running_{false};
+
+    std::mutex peer_mutex_;
+    std::unordered_map<int, std::shared_ptr<ShmPeer>> peers_;
+
+    // start address -> length of every registered region, published to region_table_
+    std::mutex region_mutex_;
+    std::map<uint64_t, size_t> regions_;
+    int region_table_fd_{-1};
+    ShmRegionTable* region_table_{nullptr};
+};
+
+} // namespace astate
@@ -0,0 +1,104 @@
+#include "transport/tcp_control_transport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+#include "common/option.h"
+#include "transport/base_transport.h"
+
+namespace astate {
+
+TcpControlTransport::~TcpControlTransport() {
+    if (is_running_) {
+        Stop();
+    }
+}
+
+bool TcpControlTransport::Start(const Options& options) {
+    if (data_transport_ == nullptr || !data_transport_->IsRunning()) {
+        SPDLOG_ERROR("TcpControlTransport requires a running TcpTransporter");
+        return false;
+    }
+    retry_count_ = std::max(1, GetOptionValue<int>(options, TRANSPORT_SEND_RETRY_COUNT));
+    retry_sleep_ms_ = GetOptionValue<int>(options, TRANSPORT_SEND_RETRY_SLEEP_MS);
+    data_transport_->SetControlHandler(
+        [this](const std::string& request_name, const void* data, size_t size) {
+            return Dispatch(request_name, data, size);
+        });
+    is_running_ = true;
+    SPDLOG_INFO(
+        "TcpControlTransport started on {}:{}, handlers={}",
+        data_transport_->GetLocalServerName(),
+        GetBindPort(),
+        handlers_.size());
+    return true;
+}
+
+void TcpControlTransport::Stop() {
+    if (data_transport_ != nullptr) {
+        data_transport_->SetControlHandler(nullptr);
+    }
+    is_running_ = false;
+    SPDLOG_INFO("TcpControlTransport stopped");
+}
+
+int TcpControlTransport::GetBindPort() const {
+    return data_transport_ == nullptr ? 0 : data_transport_->GetBindPort();
+}
+
+ResponseStatus TcpControlTransport::Dispatch(const std::string& request_name, const void* data, size_t size) {
+    Handler handler = GetHandler(request_name);
+    if (!handler) {
+        SPDLOG_ERROR("No handler registered for control request: {}", request_name);
+        return ResponseStatus{false, "no handler for " + request_name, ExtendInfo{}};
+    }
+    return handler(request_name, data, size);
+}
+
+bool TcpControlTransport::Send(
+    const std::string& request_name,
+    const void* send_data,
+    size_t send_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* /*extend_info*/) {
+    if (!is_running_) {
+        SPDLOG_ERROR("TcpControlTransport is not running, drop request {}", request_name);
+        return false;
+    }
+    for (int attempt = 1; attempt <= retry_count_; ++attempt) {
+        auto reply = data_transport_->SendControl(request_name, send_data, send_size, remote_host, remote_port);
+        // The handler answered, retrying would deliver the request twice
+        if (reply.has_value()) {
+            if (!reply->success) {
+                SPDLOG_ERROR(
+                    "Control request {} to {}:{} failed: {}",
+                    request_name,
+                    remote_host,
+                    remote_port,
+                    reply->status_message);
+            }
+            return reply->success;
+        }
+        if (attempt < retry_count_) {
+            SPDLOG_WARN(
+                "Control request {} to {}:{} failed, attempt {}/{}",
+                request_name,
+                remote_host,
+                remote_port,
+                attempt,
+                retry_count_);
+            std::this_thread::sleep_for(std::chrono::milliseconds(retry_sleep_ms_));
+        }
+    }
+    SPDLOG_ERROR(
+        "Control request {} to {}:{} failed after {} attempts", request_name, remote_host, remote_port, retry_count_);
+    return false;
+}
+
+} // namespace astate
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "common/option.h"
+#include "transport/base_transport.h"
+#include "transport/tcp_transporter.h"
+
+namespace astate {
+
+/*
+ * TcpControlTransport carries control requests over the connections of a running TcpTransporter.
+ *
+ * No server or port of its own: GetBindPort is the data port of the TcpTransporter, so the control port
+ * found in NodeInfo points at the peer's TcpTransporter. Every peer gets one dedicated control connection
+ * next to its data streams and requests are dispatched to the handlers registered by RegisterHandler.
+ * The TcpTransporter shall be started before and stopped after this transport.
+ */
+class TcpControlTransport : public BaseControlTransport {
+ public:
+    explicit TcpControlTransport(TcpTransporter* data_transport)
+        : data_transport_(data_transport) {}
+
+    ~TcpControlTransport() override;
+
+    TcpControlTransport(const TcpControlTransport&) = delete;
+    TcpControlTransport& operator=(const TcpControlTransport&) = delete;
+    TcpControlTransport(TcpControlTransport&&) = delete;
+    TcpControlTransport& operator=(TcpControlTransport&&) = delete;
+
+    [[nodiscard]] bool Start(const Options& options) override;
+
+    void Stop() override;
+
+    [[nodiscard]] int GetBindPort() const override;
+
+    [[nodiscard]] bool Send(
+        const std::string& request_name,
+        const void* send_data,
+        size_t send_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info) override;
+
+ private:
+    ResponseStatus Dispatch(const std::string& request_name, const void* data, size_t size);
+
+    TcpTransporter* data_transport_;
+    int retry_count_{1};
+    int retry_sleep_ms_{0};
+};
+
+} // namespace astate
@@ -0,0 +1,958 @@
+#include "transport/tcp_transporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <spdlog/spdlog.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "common/network_utils.h"
+#include "common/option.h"
+#include "common/string_utils.h"
+#include "transport/base_transport.h"
+
+#ifndef SO_ZEROCOPY
+#    define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#    define MSG_ZEROCOPY 0x4000000
+#endif
+
+namespace astate {
+
+/*
+ * Send the whole iov, advancing it on partial sends.
+ * A MSG_ZEROCOPY send refused for lack of optmem (ENOBUFS) is retried as a regular copy.
+ * @return 0 or errno
+ */
+static int SendAll(int fd, struct iovec* iov, size_t iovcnt, int flags) {
+    while (iovcnt > 0) {
+        struct msghdr msg {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        ssize_t n = sendmsg(fd, &msg, flags | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == ENOBUFS && (flags & MSG_ZEROCOPY) != 0) {
+                flags &= ~MSG_ZEROCOPY;
+                continue;
+            }
+            return errno;
+        }
+        auto sent = static_cast<size_t>(n);
+        while (iovcnt > 0 && sent >= iov->iov_len) {
+            sent -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + sent;
+            iov->iov_len -= sent;
+        }
+    }
+    return 0;
+}
+
+static bool RecvAll(int fd, void* buf, size_t len) {
+    auto* p = static_cast<char*>(buf);
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, MSG_WAITALL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// An idle cached connection the peer already closed (restart, idle timeout) reads as EOF
+static bool ClosedByPeer(int fd) {
+    char byte = 0;
+    ssize_t n = recv(fd, &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT);
+    return n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+}
+
+// Drop the payload of a request that can not be served to keep the stream in sync
+static bool DiscardAll(int fd, size_t len) {
+    char buf[64 * 1024];
+    while (len > 0) {
+        size_t n = std::min(len, sizeof(buf));
+        if (!RecvAll(fd, buf, n)) {
+            return false;
+        }
+        len -= n;
+    }
+    return true;
+}
+
+TcpTransporter::~TcpTransporter() {
+    if (is_running_) {
+        Stop();
+    }
+}
+
+void TcpTransporter::ConfigureSocket(int fd) const {
+    int one = 1;
+    if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) != 0) {
+        SPDLOG_WARN("Failed to set TCP_NODELAY: {}", strerror(errno));
+    }
+    // Shall be set before listen/connect so that the window scale is negotiated with it
+    if (socket_buffer_size_ > 0) {
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &socket_buffer_size_, sizeof(socket_buffer_size_));
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &socket_buffer_size_, sizeof(socket_buffer_size_));
+    }
+}
+
+bool TcpTransporter::BindAndListen(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        SPDLOG_ERROR("Failed to create tcp socket: {}", strerror(errno));
+        return false;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ConfigureSocket(fd);
+
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        SPDLOG_WARN("Failed to bind tcp port {}: {}", port, strerror(errno));
+        close(fd);
+        return false;
+    }
+    listen_fd_ = fd;
+    local_server_port_ = port;
+    return true;
+}
+
+bool TcpTransporter::Start(const Options& options, const AParallelConfig& /*parallel_config*/) {
+    if (is_running_) {
+        SPDLOG_WARN("TcpTransporter already started");
+        return true;
+    }
+
+    num_streams_ = std::max(1, GetOptionValue<int>(options, TRANSFER_ENGINE_TCP_NUM_STREAMS));
+    chunk_size_
+        = static_cast<size_t>(std::max<int64_t>(1, GetOptionValue<int64_t>(options, TRANSFER_ENGINE_TCP_CHUNK_SIZE)));
+    socket_buffer_size_ = GetOptionValue<int>(options, TRANSFER_ENGINE_TCP_SOCKET_BUFFER_SIZE);
+    enable_zerocopy_ = GetOptionValue<bool>(options, TRANSFER_ENGINE_TCP_ZEROCOPY);
+    read_timeout_ms_ = GetOptionValue<int>(options, TRANSFER_ENGINE_READ_TIMEOUT_MS);
+    local_server_name_ = GetOptionValue<std::string>(options, TRANSFER_ENGINE_LOCAL_ADDRESS);
+    if (local_server_name_.empty()) {
+        local_server_name_ = GetLocalHostnameOrIP();
+    }
+
+    int port = GetOptionValue<int>(options, TRANSFER_ENGINE_TCP_PORT);
+    bool bound = false;
+    if (port > 0) {
+        bound = BindAndListen(port);
+    } else {
+        for (int i = 0; i < kBindPortMaxRetry && !bound; ++i) {
+            bound = BindAndListen(kTcpPortStart + i);
+        }
+    }
+    if (!bound) {
+        SPDLOG_ERROR("TcpTransporter failed to bind, port={}", port);
+        return false;
+    }
+    server_epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (server_epoll_fd_ < 0) {
+        SPDLOG_ERROR("TcpTransporter failed to create epoll: {}", strerror(errno));
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    accept_running_ = true;
+    accept_thread_ = std::thread(&TcpTransporter::AcceptThreadFunc, this);
+    int num_server_threads = std::max(1, GetOptionValue<int>(options, TRANSFER_ENGINE_TCP_SERVER_THREAD_NUM));
+    for (int i = 0; i < num_server_threads; ++i) {
+        server_threads_.emplace_back(&TcpTransporter::ServerThreadFunc, this);
+    }
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        workers_running_ = true;
+    }
+    int num_workers = std::max(1, GetOptionValue<int>(options, TRANSFER_ENGINE_TCP_WORKER_NUM));
+    for (int i = 0; i < num_workers; ++i) {
+        workers_.emplace_back(&TcpTransporter::WorkerThreadFunc, this);
+    }
+
+    is_running_ = true;
+    SPDLOG_INFO(
+        "TcpTransporter started on {}:{}, streams={}, chunk_size={}, socket_buffer_size={}, zerocopy={}",
+        local_server_name_,
+        local_server_port_,
+        num_streams_,
+        chunk_size_,
+        socket_buffer_size_,
+        enable_zerocopy_);
+    return true;
+}
+
+void TcpTransporter::Stop() {
+    if (!is_running_) {
+        return;
+    }
+
+    accept_running_ = false;
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        workers_running_ = false;
+    }
+    worker_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+    {
+        // Wake up server threads blocked in recv
+        std::lock_guard<std::mutex> lock(server_conns_mutex_);
+        for (auto& conn : server_conns_) {
+            shutdown(conn->fd, SHUT_RDWR);
+        }
+    }
+    for (auto& thread : server_threads_) {
+        thread.join();
+    }
+    server_threads_.clear();
+    {
+        std::lock_guard<std::mutex> lock(server_conns_mutex_);
+        for (auto& conn : server_conns_) {
+            close(conn->fd);
+        }
+        server_conns_.clear();
+    }
+    if (server_epoll_fd_ >= 0) {
+        close(server_epoll_fd_);
+        server_epoll_fd_ = -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(peer_mutex_);
+        for (auto& [key, peer] : peers_) {
+            for (auto& stream : peer->streams) {
+                std::lock_guard<std::mutex> stream_lock(stream->mutex);
+                if (stream->fd >= 0) {
+                    close(stream->fd);
+                    stream->fd = -1;
+                }
+            }
+            std::lock_guard<std::mutex> control_lock(peer->control.mutex);
+            if (peer->control.fd >= 0) {
+                close(peer->control.fd);
+                peer->control.fd = -1;
+            }
+        }
+        peers_.clear();
+    }
+    is_running_ = false;
+    SPDLOG_INFO("TcpTransporter stopped");
+}
+
+bool TcpTransporter::RegisterMemory(void* addr, size_t len, bool is_vram, int /*gpu_id_or_numa_node*/) {
+    if (addr == nullptr || len == 0) {
+        SPDLOG_ERROR("Invalid memory region, addr: {}, len: {}", PointerToHexString(addr), len);
+        return false;
+    }
+    if (is_vram) {
+        SPDLOG_ERROR("TcpTransporter does not support VRAM, addr: {}, len: {}", PointerToHexString(addr), len);
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(region_mutex_);
+    regions_[reinterpret_cast<uint64_t>(addr)] = len;
+    return true;
+}
+
+bool TcpTransporter::DeregisterMemory(void* addr, size_t /*len*/) {
+    std::unique_lock<std::shared_mutex> lock(region_mutex_);
+    return regions_.erase(reinterpret_cast<uint64_t>(addr)) > 0;
+}
+
+bool TcpTransporter::IsRegistered(uint64_t addr, size_t len) {
+    std::shared_lock<std::shared_mutex> lock(region_mutex_);
+    auto it = regions_.upper_bound(addr);
+    if (it == regions_.begin()) {
+        return false;
+    }
+    --it;
+    uint64_t end = it->first + it->second;
+    return addr < end && len <= end - addr;
+}
+
+void TcpTransporter::AcceptThreadFunc() {
+    static constexpr int kAcceptPollMs = 100;
+    struct pollfd pfd {
+        listen_fd_, POLLIN, 0
+    };
+    while (accept_running_) {
+        if (poll(&pfd, 1, kAcceptPollMs) <= 0) {
+            continue;
+        }
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        ConfigureSocket(fd);
+        auto conn = std::make_unique<ServerConnection>();
+        conn->fd = fd;
+        if (enable_zerocopy_) {
+            int one = 1;
+            conn->zerocopy = setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+            if (!conn->zerocopy) {
+                SPDLOG_WARN("Failed to enable SO_ZEROCOPY: {}", strerror(errno));
+            }
+        }
+
+        struct epoll_event event {};
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.ptr = conn.get();
+        // Added under the lock, a server thread closing it right away waits until it is tracked
+        std::lock_guard<std::mutex> lock(server_conns_mutex_);
+        if (epoll_ctl(server_epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            SPDLOG_ERROR("Failed to add connection to the server epoll: {}", strerror(errno));
+            close(fd);
+            continue;
+        }
+        server_conns_.push_back(std::move(conn));
+    }
+}
+
+void TcpTransporter::ServerThreadFunc() {
+    static constexpr int kServerPollMs = 100;
+    while (accept_running_) {
+        struct epoll_event event {};
+        if (epoll_wait(server_epoll_fd_, &event, 1, kServerPollMs) <= 0) {
+            continue;
+        }
+        auto* conn = static_cast<ServerConnection*>(event.data.ptr);
+        bool keep = ServeRequests(*conn);
+        if (keep) {
+            event.events = EPOLLIN | EPOLLONESHOT;
+            keep = epoll_ctl(server_epoll_fd_, EPOLL_CTL_MOD, conn->fd, &event) == 0;
+        }
+        if (!keep) {
+            CloseServerConnection(conn);
+        }
+    }
+}
+
+void TcpTransporter::CloseServerConnection(ServerConnection* conn) {
+    std::lock_guard<std::mutex> lock(server_conns_mutex_);
+    auto it = std::find_if(
+        server_conns_.begin(), server_conns_.end(), [conn](const auto& entry) { return entry.get() == conn; });
+    if (it != server_conns_.end()) {
+        // Closing drops it from the epoll as well
+        close(conn->fd);
+        server_conns_.erase(it);
+    }
+}
+
+bool TcpTransporter::ServeRequests(ServerConnection& conn) {
+    // Re-arm after a bounded run so a busy stream does not starve the other connections
+    for (size_t served = 0; served < kMaxInflightPerStream && accept_running_; ++served) {
+        if (!ServeRequest(conn)) {
+            return false;
+        }
+        char byte = 0;
+        ssize_t n = recv(conn.fd, &byte, sizeof(byte), MSG_PEEK | MSG_DONTWAIT);
+        if (n == 0) {
+            return false;
+        }
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+    }
+    return accept_running_;
+}
+
+bool TcpTransporter::ReapZeroCopyCompletions(int fd, int timeout_ms) {
+    if (timeout_ms > 0) {
+        // completions are signaled as POLLERR
+        struct pollfd pfd {
+            fd, 0, 0
+        };
+        poll(&pfd, 1, timeout_ms);
+    }
+    bool copied = false;
+    while (true) {
+        char control[128];
+        struct msghdr msg {};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;
+        }
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+                  || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            const auto* serr = reinterpret_cast<const struct sock_extended_err*>(CMSG_DATA(cmsg));
+            if (serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY && (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0) {
+                copied = true;
+            }
+        }
+    }
+    return copied;
+}
+
+bool TcpTransporter::SendResponse(int fd, const TcpResponseHeader& header, const void* payload, bool& zerocopy) {
+    struct iovec iov[2] = {
+        {const_cast<TcpResponseHeader*>(&header), sizeof(header)},
+        {const_cast<void*>(payload), header.length},
+    };
+    size_t iovcnt = (payload != nullptr && header.length > 0) ? 2 : 1;
+    bool use_zerocopy = zerocopy && header.length >= kZeroCopyThreshold;
+    int err = SendAll(fd, iov, iovcnt, use_zerocopy ? MSG_ZEROCOPY : 0);
+    if (use_zerocopy && ReapZeroCopyCompletions(fd, 0)) {
+        // The kernel fell back to copying (e.g. loopback), stop paying for the notifications
+        SPDLOG_INFO("MSG_ZEROCOPY is copied by the kernel, disable it on this connection");
+        zerocopy = false;
+    }
+    if (err != 0) {
+        SPDLOG_ERROR("Failed to send response: {}, length={}", strerror(err), header.length);
+        return false;
+    }
+    return true;
+}
+
+bool TcpTransporter::ServeRequest(ServerConnection& conn) {
+    int fd = conn.fd;
+    TcpRequestHeader request{};
+    if (!RecvAll(fd, &request, sizeof(request))) {
+        return false;
+    }
+    if (request.magic != kTcpMagic) {
+        SPDLOG_ERROR("Bad request magic {:#x}, closing connection", request.magic);
+        return false;
+    }
+    bool valid = request.opcode == kTcpOpProbe || request.opcode == kTcpOpControl
+        || IsRegistered(request.remote_addr, request.length);
+    if (!valid) {
+        SPDLOG_ERROR("Request on unregistered memory, addr: {:#x}, length: {}", request.remote_addr, request.length);
+    }
+    auto* addr = reinterpret_cast<void*>(request.remote_addr);
+    TcpResponseHeader response{kTcpMagic, valid ? 0 : EFAULT, 0};
+
+    if (request.opcode == static_cast<uint8_t>(TransferRequest::OpCode::READ)) {
+        response.length = valid ? request.length : 0;
+        return SendResponse(fd, response, valid ? addr : nullptr, conn.zerocopy);
+    }
+    if (request.opcode == static_cast<uint8_t>(TransferRequest::OpCode::WRITE)) {
+        bool ok = valid ? RecvAll(fd, addr, request.length) : DiscardAll(fd, request.length);
+        return ok && SendResponse(fd, response, nullptr, conn.zerocopy);
+    }
+    if (request.opcode == kTcpOpProbe) {
+        TcpResponseHeader probe_response{kTcpMagic, 0, capabilities_.load()};
+        return SendResponse(fd, probe_response, nullptr, conn.zerocopy);
+    }
+    if (request.opcode == kTcpOpControl) {
+        return ServeControl(fd, request, conn.zerocopy);
+    }
+    SPDLOG_ERROR("Unknown request opcode {}, closing connection", request.opcode);
+    return false;
+}
+
+void TcpTransporter::SetControlHandler(const Handler& handler) {
+    std::lock_guard<std::mutex> lock(control_handler_mutex_);
+    control_handler_ = handler;
+}
+
+bool TcpTransporter::ServeControl(int fd, const TcpRequestHeader& request, bool& zerocopy) {
+    size_t name_size = request.remote_addr;
+    if (name_size > kMaxControlNameSize || request.length > kMaxControlPayloadSize) {
+        SPDLOG_ERROR("Control request too large, name: {}, payload: {}, closing connection", name_size, request.length);
+        return false;
+    }
+    std::string request_name(name_size, '\0');
+    std::string payload(request.length, '\0');
+    if (!RecvAll(fd, request_name.data(), name_size) || !RecvAll(fd, payload.data(), payload.size())) {
+        return false;
+    }
+
+    Handler handler;
+    {
+        std::lock_guard<std::mutex> lock(control_handler_mutex_);
+        handler = control_handler_;
+    }
+    ResponseStatus status{false, "control requests are not served", ExtendInfo{}};
+    if (handler) {
+        try {
+            status = handler(request_name, payload.data(), payload.size());
+        } catch (const std::exception& e) {
+            SPDLOG_ERROR("Control handler of {} failed: {}", request_name, e.what());
+            status = ResponseStatus{false, e.what(), ExtendInfo{}};
+        }
+    }
+    TcpResponseHeader response{kTcpMagic, status.success ? 0 : EPROTO, status.status_message.size()};
+    return SendResponse(fd, response, status.status_message.data(), zerocopy);
+}
+
+std::optional<ResponseStatus> TcpTransporter::SendControl(
+    const std::string& request_name,
+    const void* send_data,
+    size_t send_size,
+    const std::string& remote_host,
+    int remote_port) {
+    if (request_name.size() > kMaxControlNameSize || send_size > kMaxControlPayloadSize
+        || (send_data == nullptr && send_size > 0)) {
+        SPDLOG_ERROR("Invalid control request {}, size: {}", request_name, send_size);
+        return ResponseStatus{false, "invalid control request", ExtendInfo{}};
+    }
+    TcpStream& stream = GetPeer(remote_host, remote_port)->control;
+    std::lock_guard<std::mutex> lock(stream.mutex);
+
+    // Same as data streams, a cached connection may have been closed by a restarted peer
+    if (stream.fd >= 0 && ClosedByPeer(stream.fd)) {
+        close(stream.fd);
+        stream.fd = -1;
+    }
+    bool reused = stream.fd >= 0;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (stream.fd < 0) {
+            stream.fd = ConnectToPeer(remote_host, remote_port);
+            if (stream.fd < 0) {
+                return std::nullopt;
+            }
+        }
+
+        TcpRequestHeader request{kTcpMagic, kTcpOpControl, {}, request_name.size(), send_size};
+        struct iovec iov[3] = {
+            {&request, sizeof(request)},
+            {const_cast<char*>(request_name.data()), request_name.size()},
+            {const_cast<void*>(send_data), send_size},
+        };
+        if (int err = SendAll(stream.fd, iov, send_size > 0 ? 3 : 2, 0); err != 0) {
+            // The peer did not get the whole request, so it was not served and can be sent again
+            SPDLOG_WARN("Control request to {}:{} not sent: {}", remote_host, remote_port, strerror(err));
+            close(stream.fd);
+            stream.fd = -1;
+            if (!reused) {
+                break;
+            }
+            reused = false;
+            continue;
+        }
+
+        TcpResponseHeader response{};
+        if (RecvAll(stream.fd, &response, sizeof(response)) && response.magic == kTcpMagic
+            && response.length <= kMaxControlPayloadSize) {
+            std::string message(response.length, '\0');
+            if (RecvAll(stream.fd, message.data(), message.size())) {
+                return ResponseStatus{response.status == 0, std::move(message), ExtendInfo{}};
+            }
+        }
+        // The request may have been served already, a control request is not resent
+        SPDLOG_WARN("Control connection to {}:{} broken: {}", remote_host, remote_port, strerror(errno));
+        close(stream.fd);
+        stream.fd = -1;
+        break;
+    }
+    return std::nullopt;
+}
+
+int TcpTransporter::ConnectToPeer(const std::string& remote_host, int remote_port) const {
+    struct addrinfo hints {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    int rc = getaddrinfo(remote_host.c_str(), std::to_string(remote_port).c_str(), &hints, &result);
+    if (rc != 0) {
+        SPDLOG_ERROR("Failed to resolve {}:{}: {}", remote_host, remote_port, gai_strerror(rc));
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* ai = result; ai != nullptr; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        ConfigureSocket(fd);
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if (fd < 0) {
+        SPDLOG_ERROR("Failed to connect to {}:{}: {}", remote_host, remote_port, strerror(errno));
+        return -1;
+    }
+
+    if (read_timeout_ms_ > 0) {
+        struct timeval tv {
+            read_timeout_ms_ / 1000, (read_timeout_ms_ % 1000) * 1000
+        };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+    return fd;
+}
+
+bool TcpTransporter::ProbePeer(const std::string& remote_host, int remote_port, uint64_t& capabilities) const {
+    int fd = ConnectToPeer(remote_host, remote_port);
+    if (fd < 0) {
+        return false;
+    }
+    TcpRequestHeader request{kTcpMagic, kTcpOpProbe, {}, 0, 0};
+    struct iovec iov {
+        &request, sizeof(request)
+    };
+    TcpResponseHeader response{};
+    bool ok = SendAll(fd, &iov, 1, 0) == 0 && RecvAll(fd, &response, sizeof(response)) && response.magic == kTcpMagic
+        && response.status == 0;
+    close(fd);
+    if (ok) {
+        capabilities = response.length;
+    }
+    return ok;
+}
+
+TcpTransporter::TcpPeer* TcpTransporter::GetPeer(const std::string& remote_host, int remote_port) {
+    std::string key = remote_host + ":" + std::to_string(remote_port);
+    std::lock_guard<std::mutex> lock(peer_mutex_);
+    auto& peer = peers_[key];
+    if (peer == nullptr) {
+        // Streams connect lazily on first use
+        peer = std::make_unique<TcpPeer>();
+        for (int i = 0; i < num_streams_; ++i) {
+            peer->streams.emplace_back(std::make_unique<TcpStream>());
+        }
+    }
+    return peer.get();
+}
+
+template <typename OnDone>
+void TcpTransporter::RunOnStream(
+    TcpStream& stream, const std::string& remote_host, int remote_port, std::span<const TcpOp> ops, OnDone&& on_done) {
+    std::lock_guard<std::mutex> lock(stream.mutex);
+    std::vector<TcpRequestHeader> headers(std::min(ops.size(), kMaxInflightPerStream));
+    std::vector<struct iovec> iov;
+    size_t done = 0;
+
+    // A cached connection may have been closed by a restarted peer, reconnect once if nothing completed on it
+    bool reused = stream.fd >= 0;
+    for (int attempt = 0; attempt < 2 && done < ops.size(); ++attempt) {
+        if (stream.fd < 0) {
+            stream.fd = ConnectToPeer(remote_host, remote_port);
+            if (stream.fd < 0) {
+                break;
+            }
+        }
+
+        size_t sent = done;
+        bool broken = false;
+        while (done < ops.size()) {
+            // Keep up to kMaxInflightPerStream requests on the wire
+            iov.clear();
+            for (; sent < ops.size() && sent - done < kMaxInflightPerStream; ++sent) {
+                const auto& op = ops[sent];
+                auto& header = headers[sent % headers.size()];
+                header = TcpRequestHeader{kTcpMagic, static_cast<uint8_t>(op.opcode), {}, op.remote_addr, op.length};
+                iov.push_back({&header, sizeof(header)});
+                if (op.opcode == TransferRequest::OpCode::WRITE) {
+                    iov.push_back({op.local_addr, op.length});
+                }
+            }
+            if (!iov.empty() && SendAll(stream.fd, iov.data(), iov.size(), 0) != 0) {
+                broken = true;
+                break;
+            }
+
+            const auto& op = ops[done];
+            TcpResponseHeader response{};
+            if (!RecvAll(stream.fd, &response, sizeof(response)) || response.magic != kTcpMagic) {
+                broken = true;
+                break;
+            }
+            bool success = response.status == 0;
+            if (success && op.opcode == TransferRequest::OpCode::READ) {
+                if (response.length != op.length || !RecvAll(stream.fd, op.local_addr, op.length)) {
+                    broken = true;
+                    break;
+                }
+            }
+            if (!success) {
+                SPDLOG_ERROR(
+                    "Tcp request failed on {}:{}: {}, remote_addr: {:#x}, length: {}",
+                    remote_host,
+                    remote_port,
+                    strerror(response.status),
+                    op.remote_addr,
+                    op.length);
+            }
+            on_done(op, success);
+            ++done;
+        }
+        if (!broken) {
+            break;
+        }
+
+        SPDLOG_WARN(
+            "Tcp stream to {}:{} broken: {}, completed {}/{}",
+            remote_host,
+            remote_port,
+            strerror(errno),
+            done,
+            ops.size());
+        close(stream.fd);
+        stream.fd = -1;
+        if (!reused || done > 0) {
+            break;
+        }
+        reused = false;
+    }
+
+    for (; done < ops.size(); ++done) {
+        on_done(ops[done], false);
+    }
+}
+
+void TcpTransporter::WorkerThreadFunc() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(worker_mutex_);
+            worker_cv_.wait(lock, [this] { return !workers_running_ || !worker_tasks_.empty(); });
+            if (worker_tasks_.empty()) {
+                return;
+            }
+            task = std::move(worker_tasks_.front());
+            worker_tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void TcpTransporter::RunParallel(size_t count, const std::function<void(size_t)>& fn) {
+    struct Batch {
+        std::atomic<size_t> next{0};
+        size_t done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto batch = std::make_shared<Batch>();
+    // Claims indices until none is left, a helper that comes late finds nothing and never touches fn
+    auto drain = [batch, count, &fn]() {
+        for (size_t i = batch->next.fetch_add(1); i < count; i = batch->next.fetch_add(1)) {
+            fn(i);
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            if (++batch->done == count) {
+                batch->cv.notify_all();
+            }
+        }
+    };
+
+    size_t num_helpers = 0;
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        if (workers_running_) {
+            num_helpers = std::min(count, workers_.size() + 1) - 1;
+            for (size_t i = 0; i < num_helpers; ++i) {
+                worker_tasks_.emplace_back(drain);
+            }
+        }
+    }
+    if (num_helpers == 1) {
+        worker_cv_.notify_one();
+    } else if (num_helpers > 1) {
+        worker_cv_.notify_all();
+    }
+    drain();
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->cv.wait(lock, [&] { return batch->done == count; });
+}
+
+template <typename OnDone>
+void TcpTransporter::RunOnPeer(
+    const std::string& remote_host, int remote_port, std::vector<TcpOp>& ops, OnDone&& on_done) {
+    TcpPeer* peer = GetPeer(remote_host, remote_port);
+    size_t num_streams = std::min(peer->streams.size(), ops.size());
+    size_t base = peer->next_stream.fetch_add(num_streams, std::memory_order_relaxed);
+    if (num_streams <= 1) {
+        RunOnStream(*peer->streams[base % peer->streams.size()], remote_host, remote_port, ops, on_done);
+        return;
+    }
+
+    std::vector<std::vector<TcpOp>> stream_ops(num_streams);
+    for (size_t i = 0; i < ops.size(); ++i) {
+        stream_ops[i % num_streams].push_back(ops[i]);
+    }
+    RunParallel(num_streams, [&](size_t s) {
+        RunOnStream(*peer->streams[(base + s) % peer->streams.size()], remote_host, remote_port, stream_ops[s], on_done);
+    });
+}
+
+bool TcpTransporter::Transfer(
+    const void* local_addr,
+    size_t size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info,
+    TransferRequest::OpCode opcode) {
+    if (local_addr == nullptr || size == 0) {
+        SPDLOG_ERROR("Local data is null or size is zero");
+        throw std::invalid_argument("TcpTransporter: local data is null or size is zero");
+    }
+    const void* rbuf = GetRemoteAddrFromExtendInfo(extend_info);
+    if (rbuf == nullptr) {
+        SPDLOG_ERROR("Remote address is null");
+        throw std::invalid_argument("TcpTransporter: remote address is null");
+    }
+
+    std::vector<TcpOp> ops;
+    ops.reserve((size + chunk_size_ - 1) / chunk_size_);
+    for (size_t offset = 0; offset < size; offset += chunk_size_) {
+        ops.push_back(TcpOp{
+            opcode,
+            const_cast<char*>(static_cast<const char*>(local_addr)) + offset,
+            reinterpret_cast<uint64_t>(rbuf) + offset,
+            std::min(chunk_size_, size - offset),
+            0});
+    }
+
+    std::atomic<bool> success{true};
+    RunOnPeer(remote_host, remote_port, ops, [&success](const TcpOp& /*op*/, bool ok) {
+        if (!ok) {
+            success = false;
+        }
+    });
+    return success;
+}
+
+bool TcpTransporter::Send(
+    const void* local_addr,
+    size_t send_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info) {
+    return Transfer(local_addr, send_size, remote_host, remote_port, extend_info, TransferRequest::OpCode::WRITE);
+}
+
+bool TcpTransporter::Receive(
+    const void* local_addr,
+    size_t recv_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info) {
+    return Transfer(local_addr, recv_size, remote_host, remote_port, extend_info, TransferRequest::OpCode::READ);
+}
+
+void TcpTransporter::AsyncSend(
+    const void* local_addr,
+    size_t send_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info,
+    const SendCallback& callback) {
+    bool success = Send(local_addr, send_size, remote_host, remote_port, extend_info);
+    if (callback) {
+        callback(success ? local_addr : nullptr, success ? send_size : 0);
+    }
+}
+
+void TcpTransporter::AsyncReceive(
+    const void* local_addr,
+    size_t recv_size,
+    const std::string& remote_host,
+    int remote_port,
+    const ExtendInfo* extend_info,
+    const ReceiveCallback& callback) {
+    bool success = Receive(local_addr, recv_size, remote_host, remote_port, extend_info);
+    if (callback) {
+        callback(success ? local_addr : nullptr, success ? recv_size : 0);
+    }
+}
+
+void TcpTransporter::SubmitBatch(std::span<TransferRequest> requests, TransferCompletionQueue& completion_queue) {
+    // A request split in chunks completes when its last chunk does
+    auto remaining = std::make_unique<std::atomic<size_t>[]>(requests.size());
+    auto failed = std::make_unique<std::atomic<bool>[]>(requests.size());
+    std::unordered_map<std::string, std::vector<TcpOp>> peer_ops;
+    std::unordered_map<std::string, const RemoteNetAddress*> peer_addrs;
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const auto& request = requests[i];
+        failed[i] = false;
+        if (request.local_mem_addr == nullptr || request.remote_mem_addr == 0 || request.length == 0) {
+            SPDLOG_ERROR("SubmitBatch request {} is invalid, length: {}", i, request.length);
+            remaining[i] = 0;
+            completion_queue.Push({i, false});
+            continue;
+        }
+        std::string key = request.remote_net_addr.host + ":" + std::to_string(request.remote_net_addr.port);
+        peer_addrs.emplace(key, &request.remote_net_addr);
+        auto& ops = peer_ops[key];
+        size_t num_chunks = 0;
+        for (size_t offset = 0; offset < request.length; offset += chunk_size_, ++num_chunks) {
+            ops.push_back(TcpOp{
+                request.opcode,
+                static_cast<char*>(request.local_mem_addr) + offset,
+                request.remote_mem_addr + offset,
+                std::min(chunk_size_, request.length - offset),
+                i});
+        }
+        remaining[i] = num_chunks;
+    }
+
+    auto on_done = [&](const TcpOp& op, bool ok) {
+        if (!ok) {
+            failed[op.request_index] = true;
+        }
+        if (remaining[op.request_index].fetch_sub(1) == 1) {
+            completion_queue.Push({op.request_index, !failed[op.request_index]});
+        }
+    };
+
+    // Peers are served concurrently on the worker pool
+    std::vector<std::pair<const RemoteNetAddress*, std::vector<TcpOp>*>> peers;
+    peers.reserve(peer_ops.size());
+    for (auto& [key, ops] : peer_ops) {
+        peers.emplace_back(peer_addrs[key], &ops);
+    }
+    RunParallel(peers.size(), [&](size_t i) {
+        RunOnPeer(peers[i].first->host, peers[i].first->port, *peers[i].second, on_done);
+    });
+}
+
+} // namespace astate
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/option.h"
+#include "core/atensor.h"
+#include "transfer/types.h"
+#include "transport/base_transport.h"
+
+namespace astate {
+
+/*
+ * TcpTransporter is a data transport over plain TCP for hosts without RDMA NICs.
+ *
+ * Peers serve one-sided reads and writes of their registered memory regions,
+ * the remote address is passed as extend info, same as RDMATransporter.
+ * Every peer is reached through several parallel connections (streams), large
+ * transfers are split into chunks striped across the streams and each stream
+ * pipelines its requests, so the link is kept busy regardless of the RTT.
+ * Payloads are sent straight from the registered region (optionally with
+ * MSG_ZEROCOPY) and received straight into the destination buffer.
+ * Incoming connections share a fixed pool of server threads polling one epoll,
+ * so the thread count does not grow with the number of peers and streams.
+ * Only host memory is supported on both sides.
+ */
+class TcpTransporter : public BaseDataTransport {
+ public:
+    TcpTransporter() = default;
+
+    ~TcpTransporter() override;
+
+    TcpTransporter(const TcpTransporter&) = delete;
+    TcpTransporter& operator=(const TcpTransporter&) = delete;
+    TcpTransporter(TcpTransporter&&) = delete;
+    TcpTransporter& operator=(TcpTransporter&&) = delete;
+
+    ////////////////////// Override BaseTransport methods //////////////////////
+    [[nodiscard]] bool Start(const Options& options, const AParallelConfig& parallel_config) override;
+
+    void Stop() override;
+
+    [[nodiscard]] int GetBindPort() const override { return local_server_port_; }
+
+    [[nodiscard]] std::string GetLocalServerName() const override { return local_server_name_; }
+
+    [[nodiscard]] TransportType
+    GetPeerTransportType(const std::string& /*remote_host*/, int /*remote_port*/) const override {
+        return TransportType::TCP;
+    }
+
+    bool RegisterMemory(void* addr, size_t len, bool is_vram = false, int gpu_id_or_numa_node = -1) override;
+
+    bool DeregisterMemory(void* addr, size_t len) override;
+
+    [[nodiscard]] bool Send(
+        const void* local_addr,
+        size_t send_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info) override;
+
+    [[nodiscard]] bool Receive(
+        const void* local_addr,
+        size_t recv_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info) override;
+
+    // Runs synchronously, callback gets (local_addr, size) on success or (nullptr, 0) on failure
+    void AsyncSend(
+        const void* local_addr,
+        size_t send_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info,
+        const SendCallback& callback) override;
+
+    void AsyncReceive(
+        const void* local_addr,
+        size_t recv_size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info,
+        const ReceiveCallback& callback) override;
+
+    /*
+     * Requests of the batch are grouped by peer and spread over the peer's
+     * streams, every stream pipelines its share.
+     */
+    void SubmitBatch(std::span<TransferRequest> requests, TransferCompletionQueue& completion_queue) override;
+
+    ////////////////////// Tcp specific methods //////////////////////
+    // Capability bits answered to peer probes
+    static constexpr uint64_t kCapabilityRdma = 1UL << 0;
+
+    /*
+     * Set the capability bits answered to ProbePeer of remote peers.
+     * @param capabilities: bitmask of kCapability*
+     */
+    void SetCapabilities(uint64_t capabilities) { capabilities_ = capabilities; }
+
+    /*
+     * Probe a remote tcp transport over a short-lived connection.
+     * @param capabilities: filled with the capability bits of the peer
+     * @return true if the peer answered
+     */
+    bool ProbePeer(const std::string& remote_host, int remote_port, uint64_t& capabilities) const;
+
+    /*
+     * Serve control requests (see TcpControlTransport) with the handler, nullptr rejects them.
+     * The handler runs on the server thread serving the connection the request came in on.
+     */
+    void SetControlHandler(const Handler& handler);
+
+    /*
+     * Send a named control request over the control connection of the peer and wait for the handler's reply.
+     * @return the reply of the remote handler (a failed one for an invalid request), std::nullopt if the peer
+     * could not be reached
+     */
+    std::optional<ResponseStatus> SendControl(
+        const std::string& request_name,
+        const void* send_data,
+        size_t send_size,
+        const std::string& remote_host,
+        int remote_port);
+
+ private:
+    static constexpr int kTcpPortStart = 54010;
+    static constexpr uint32_t kTcpMagic = 0x41535443; // "ASTC"
+    // Opcode beyond TransferRequest::OpCode, answered with the capability bits in the length field
+    static constexpr uint8_t kTcpOpProbe = 0xFF;
+    // Named control request: remote_addr carries the name length, the name and the payload follow the header.
+    // Answered with the status message of the handler as payload.
+    static constexpr uint8_t kTcpOpControl = 0xFE;
+    static constexpr size_t kMaxControlNameSize = 4096;
+    static constexpr size_t kMaxControlPayloadSize = 1UL << 30;
+    // Requests a stream may have on the wire before reading the first response
+    static constexpr size_t kMaxInflightPerStream = 64;
+    // Payloads below this size are copied by the kernel anyway, no point in MSG_ZEROCOPY
+    static constexpr size_t kZeroCopyThreshold = 64 * 1024;
+
+    struct TcpRequestHeader {
+        uint32_t magic;
+        uint8_t opcode; // TransferRequest::OpCode
+        uint8_t reserved[3];
+        uint64_t remote_addr;
+        uint64_t length;
+    };
+
+    struct TcpResponseHeader {
+        uint32_t magic;
+        int32_t status; // 0 or errno
+        uint64_t length; // payload length following the header
+    };
+
+    // One chunk of a transfer carried by a stream
+    struct TcpOp {
+        TransferRequest::OpCode opcode;
+        char* local_addr;
+        uint64_t remote_addr;
+        size_t length;
+        size_t request_index;
+    };
+
+    struct TcpStream {
+        std::mutex mutex;
+        int fd{-1};
+    };
+
+    struct TcpPeer {
+        std::vector<std::unique_ptr<TcpStream>> streams;
+        std::atomic<size_t> next_stream{0};
+        // Control requests get their own connection so that they never queue behind data chunks
+        TcpStream control;
+    };
+
+    // Accepted connection, served by one server thread at a time (EPOLLONESHOT)
+    struct ServerConnection {
+        int fd{-1};
+        bool zerocopy{false};
+    };
+
+    bool BindAndListen(int port);
+
+    // Accepts connections and adds them to the server epoll
+    void AcceptThreadFunc();
+
+    // Takes the next readable connection off the server epoll, serves it and re-arms it
+    void ServerThreadFunc();
+
+    // Serve the requests already buffered on the connection, @return false if it shall be closed
+    bool ServeRequests(ServerConnection& conn);
+
+    // Serve one request, @return false if the connection broke
+    bool ServeRequest(ServerConnection& conn);
+
+    void CloseServerConnection(ServerConnection* conn);
+
+    // Read one control request, run the handler and send its reply, @return false if the connection broke
+    bool ServeControl(int fd, const TcpRequestHeader& request, bool& zerocopy);
+
+    // Check that [addr, addr + len) lies in one registered region
+    bool IsRegistered(uint64_t addr, size_t len);
+
+    void ConfigureSocket(int fd) const;
+
+    int ConnectToPeer(const std::string& remote_host, int remote_port) const;
+
+    TcpPeer* GetPeer(const std::string& remote_host, int remote_port);
+
+    // Run ops on one stream, reconnecting it if needed, and report every op through on_done
+    template <typename OnDone>
+    void RunOnStream(
+        TcpStream& stream, const std::string& remote_host, int remote_port, std::span<const TcpOp> ops, OnDone&& on_done);
+
+    // Run fn(0..count-1) on the worker pool, the calling thread takes its share and returns once all finished.
+    // Waiting callers only wait for indices already running, so it may be nested.
+    void RunParallel(size_t count, const std::function<void(size_t)>& fn);
+
+    void WorkerThreadFunc();
+
+    // Stripe ops over the streams of one peer, the calling thread runs one stream
+    template <typename OnDone>
+    void RunOnPeer(const std::string& remote_host, int remote_port, std::vector<TcpOp>& ops, OnDone&& on_done);
+
+    bool Transfer(
+        const void* local_addr,
+        size_t size,
+        const std::string& remote_host,
+        int remote_port,
+        const ExtendInfo* extend_info,
+        TransferRequest::OpCode opcode);
+
+    // Send the full payload of one response, MSG_ZEROCOPY when enabled for the connection
+    bool SendResponse(int fd, const TcpResponseHeader& header, const void* payload, bool& zerocopy);
+
+    // Drain MSG_ZEROCOPY notifications, @return true if the kernel reported it had to copy
+    static bool ReapZeroCopyCompletions(int fd, int timeout_ms);
+
+    std::string local_server_name_;
+    int local_server_port_{0};
+    int listen_fd_{-1};
+    std::thread accept_thread_;
+    std::atomic<bool> accept_running_{false};
+
+    int num_streams_{4};
+    size_t chunk_size_{4UL << 20};
+    int socket_buffer_size_{16 << 20};
+    bool enable_zerocopy_{false};
+    int read_timeout_ms_{-1};
+    std::atomic<uint64_t> capabilities_{0};
+
+    std::mutex control_handler_mutex_;
+    Handler control_handler_;
+
+    // Fixed pool serving every accepted connection, whatever the number of peers and streams
+    int server_epoll_fd_{-1};
+    std::vector<std::thread> server_threads_;
+    std::mutex server_conns_mutex_;
+    std::vector<std::unique_ptr<ServerConnection>> server_conns_;
+
+    // start address -> length of every registered region
+    std::shared_mutex region_mutex_;
+    std::map<uint64_t, size_t> regions_;
+
+    std::mutex peer_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<TcpPeer>> peers_;
+
+    // Fixed per-transport pool behind RunParallel
+    std::mutex worker_mutex_;
+    std::condition_variable worker_cv_;
+    std::deque<std::function<void()>> worker_tasks_;
+    std::vector<std::thread> workers_;
+    bool workers_running_{false};
+};
+
+} // namespace astate
@@ -4,6 +4,21 @@
 
 namespace astate {
 
-enum class TransportType : uint8_t { HTTP = 1, RDMA = 2, UNKNOWN = 255 };
+enum class TransportType : uint8_t { HTTP = 1, RDMA = 2, TCP = 3, SHM = 4, UNKNOWN = 255 };
+
+inline const char* TransportTypeToString(TransportType type) {
+    switch (type) {
+        case TransportType::HTTP:
+            return "HTTP";
+        case TransportType::RDMA:
+            return "RDMA";
+        case TransportType::TCP:
+            return "TCP";
+        case TransportType::SHM:
+            return "SHM";
+        default:
+            return "UNKNOWN";
+    }
+}
 
 } // namespace astate
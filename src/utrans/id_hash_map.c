@@ -5,4 +5,8 @@
 id_hash_map_t*
 idhm_create(size_t bucket_count, size_t lock_count, void* (*alloc_func)(size_t), void (*free_func)(void*)) {
     return NULL;
-}
\ No newline at end of file
+}
+
+void idhm_destroy(id_hash_map_t* map) {
+    free(map);
+}
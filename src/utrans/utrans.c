@@ -46,8 +46,9 @@ int _parse_config(utrans_ctx_t* ctx, utrans_config_t* config) {
                                    },
                                    .rdma_disabled = 0,
                                    .rdma_conf = {.valid_dev_patt = NULL,
-                                                 .num_pollers = 8,
+                                                 .num_pollers = 1,
                                                  .max_mr = 1024,
+                                                 .numa_node = -1,
                                    }
     };
     if (!config) {
@@ -95,6 +96,7 @@ int _parse_config(utrans_ctx_t* ctx, utrans_config_t* config) {
 
     UTRANS_NUM_ARG_CHECK(rdma_conf.max_mr);
     UTRANS_NUM_ARG_CHECK(rdma_conf.num_pollers);
+    ctx->config->rdma_conf.numa_node = config->rdma_conf.numa_node;
     ctx->config->rdma_disabled = config->rdma_disabled;
 
     _proc_env(ctx);
@@ -142,6 +144,7 @@ end:
             ctx->config->rdma_conf.valid_dev_patt ? ctx->config->rdma_conf.valid_dev_patt : "null");
         LOGI("[CONF]    num_pollers=%d\n", ctx->config->rdma_conf.num_pollers);
         LOGI("[CONF]    max_mr=%d\n", ctx->config->rdma_conf.max_mr);
+        LOGI("[CONF]    numa_node=%d\n", ctx->config->rdma_conf.numa_node);
     }
     return ret;
 }
@@ -181,7 +184,7 @@ int _ucx_ctx_init(ucx_ctx_t* pucx_ctx, rdma_config_t* rdma_conf) {
     ucp_params.field_mask = UCP_PARAM_FIELD_NAME | UCP_PARAM_FIELD_FEATURES | UCP_PARAM_FIELD_ESTIMATED_NUM_EPS
         | UCP_PARAM_FIELD_ESTIMATED_NUM_PPN;
     ucp_params.name = "utrans";
-    ucp_params.features = UCP_FEATURE_RMA;
+    ucp_params.features = UCP_FEATURE_RMA | UCP_FEATURE_WAKEUP;
     ucp_params.estimated_num_eps = 8192;
     ucp_params.estimated_num_ppn = rdma_conf->num_pollers;
 
@@ -199,7 +202,15 @@ int _ucx_ctx_init(ucx_ctx_t* pucx_ctx, rdma_config_t* rdma_conf) {
         goto end;
     }
 
-    ret = _ucp_worker_init(pucx_ctx->pucp_ctx, &pucx_ctx->pucp_wrk, pucx_ctx->putrz_ctx->inst_id);
+    // endpoints, the listener and all requests live on the first worker, there is no path yet that spreads them
+    // over several workers, so extra pollers would only spin on idle workers
+    if (rdma_conf->num_pollers > 1) {
+        LOGW("num_pollers=%d requested, only one poller is started\n", rdma_conf->num_pollers);
+    }
+    ret = ucx_pollers_start(pucx_ctx, 1, rdma_conf->numa_node);
+    if (IS_UTRANS_SUCC(ret)) {
+        pucx_ctx->pucp_wrk = pucx_ctx->poller_group.pollers[0].wrk;
+    }
 end:
     if (IS_UTRANS_FAIL(ret)) {
         _ucx_ctx_destroy(&pucx_ctx->pucp_ctx);
@@ -245,6 +256,7 @@ int utrans_setup(utrans_config_t* putrz_conf, utrans_ctx_t** pputrz_ctx) {
             }
             free(pctx->peer_mgr.lock_pool);
             pctx->peer_mgr.lock_pool = NULL;
+            ret = UTRANS_RET_POSIX_PTHREAD;
             goto err;
         }
     }
@@ -262,6 +274,7 @@ int utrans_setup(utrans_config_t* putrz_conf, utrans_ctx_t** pputrz_ctx) {
         goto err;
     }
     pctx->ucx_ctx.putrz_ctx = pctx;
+    utrans_mr_set_init(&pctx->ucx_ctx.mr_set);
 
     if (IS_UTRANS_FAIL(ret = _ucx_ctx_init(&pctx->ucx_ctx, &pctx->config->rdma_conf))) {
         goto err;
@@ -274,24 +287,58 @@ int utrans_setup(utrans_config_t* putrz_conf, utrans_ctx_t** pputrz_ctx) {
 
 err:
     if (pctx) {
-        _ucx_ctx_destroy(&pctx->ucx_ctx.pucp_ctx);
-        pctx->config = NULL;
-        free(pctx);
+        // owns pconf once it is set in pctx
+        utrans_clean(pctx);
         pctx = NULL;
-    }
-    if (pconf) {
+    } else if (pconf) {
         free(pconf);
-        pconf = NULL;
     }
-    utrans_clean(pctx); // TODO: add clean
     if (pputrz_ctx) {
         *pputrz_ctx = NULL;
     }
     return ret;
 }
 
-int utrans_clean(utrans_ctx_t* pucx_ctx) {
-    return UTRANS_RET_SUCC; // TODO: add implement
+static int _mr_reg_item_destroy(void* item, void* param);
+
+int utrans_clean(utrans_ctx_t* putrz_ctx) {
+    if (!putrz_ctx) {
+        return UTRANS_RET_INVALID_ARGS;
+    }
+    ucx_ctx_t* pucx_ctx = &putrz_ctx->ucx_ctx;
+    if (pucx_ctx->conn_listener) {
+        ucp_listener_destroy(pucx_ctx->conn_listener);
+        pucx_ctx->conn_listener = NULL;
+    }
+    ucx_pollers_stop(pucx_ctx);
+    pucx_ctx->pucp_wrk = NULL;
+    // registered regions are unmapped before the ucp context they belong to
+    utrans_mr_set_destroy(&pucx_ctx->mr_set, _mr_reg_item_destroy, pucx_ctx);
+    _ucx_ctx_destroy(&pucx_ctx->pucp_ctx);
+
+    peer_mgr_t* peer_mgr = &putrz_ctx->peer_mgr;
+    if (peer_mgr->addr2inst) {
+        idhm_destroy(peer_mgr->addr2inst);
+        peer_mgr->addr2inst = NULL;
+    }
+    if (peer_mgr->inst2info) {
+        idhm_destroy(peer_mgr->inst2info);
+        peer_mgr->inst2info = NULL;
+    }
+    if (peer_mgr->lock_pool) {
+        for (uint32_t i = 0; i < peer_mgr->lock_num; ++i) {
+            pthread_mutex_destroy(peer_mgr->lock_pool + i);
+        }
+        free(peer_mgr->lock_pool);
+        peer_mgr->lock_pool = NULL;
+    }
+
+    if (putrz_ctx->config) {
+        free(putrz_ctx->config->rdma_conf.valid_dev_patt);
+        free(putrz_ctx->config);
+    }
+    free(putrz_ctx);
+    return UTRANS_RET_SUCC;
 }
 
 /**
@@ -371,12 +418,9 @@ int utrans_setup_rpcsrv(utrans_ctx_t* putrz_ctx) {
 }
 
 mem_region_registed_t* _regist_pub_buf(ucx_ctx_t* pucx_ctx, int mem_type, void* buf_addr, size_t buf_len) {
-    pthread_rwlock_rdlock(&pucx_ctx->mr_lock);
-
-    // first check whether already exist
+    // first check whether already exist, lock free
     mem_region_registed_t* reged;
     if (buf_addr && (reged = utrans_mr_set_find(&pucx_ctx->mr_set, buf_addr, buf_len)) != NULL) {
-        pthread_rwlock_unlock(&pucx_ctx->mr_lock);
         return reged;
     }
 
@@ -393,7 +437,6 @@ mem_region_registed_t* _regist_pub_buf(ucx_ctx_t* pucx_ctx, int mem_type, void*
             mr_num_fly,
             WARN_MRS_NUM);
     }
-    pthread_rwlock_unlock(&pucx_ctx->mr_lock);
 
     mem_region_registed_t* mrk;
     mrk = (mem_region_registed_t*)calloc(1, sizeof(mem_region_registed_t));
@@ -434,15 +477,12 @@ mem_region_registed_t* _regist_pub_buf(ucx_ctx_t* pucx_ctx, int mem_type, void*
         goto failed;
     }
 
-    // record to local mr_set
-    pthread_rwlock_wrlock(&pucx_ctx->mr_lock);
+    // record to local mr_set, published to lock free readers
     if (0 != utrans_mr_set_insert(&pucx_ctx->mr_set, mrk->mr.addr, mrk->mr.len, mrk)) {
-        pthread_rwlock_unlock(&pucx_ctx->mr_lock);
         LOGE("record registered memory region failed, goto fail\n");
         goto failed;
     }
     __atomic_fetch_sub(&pucx_ctx->num_pending_mrs, 1, __ATOMIC_SEQ_CST);
-    pthread_rwlock_unlock(&pucx_ctx->mr_lock);
     LOGI("Regist succ addr=%p len=%zu type=%s\n", buf_addr, buf_len, utrans_get_mem_type_str(mem_type));
     return mrk;
 
@@ -482,7 +522,8 @@ const mem_region_registed_t* utrans_regist_vram(utrans_ctx_t* putrz_ctx, void* v
     return _regist_pub_buf(&putrz_ctx->ucx_ctx, mem_gpu, vram_addr, vram_len);
 }
 
-static int _mr_reg_item_destroy(mem_region_registed_t* pmr_item, void* param) {
+static int _mr_reg_item_destroy(void* item, void* param) {
+    mem_region_registed_t* pmr_item = (mem_region_registed_t*)item;
     ucx_ctx_t* pucx_ctx = (ucx_ctx_t*)param;
     if (!pmr_item) {
         return 0;
@@ -513,10 +554,8 @@ int utrans_dereg_mem(utrans_ctx_t* putrz_ctx, void* mem_addr, size_t mem_len) {
 
     ucx_ctx_t* pctx = &putrz_ctx->ucx_ctx;
 
-    // use the write lock to prevent another thread visiting the mr which will be dereged
-    pthread_rwlock_wrlock(&pctx->mr_lock);
+    // returns after readers of the old snapshot have left, no one can find the mr any more
     mem_region_registed_t* target_mr = utrans_mr_set_remove(&pctx->mr_set, mem_addr, mem_len);
-    pthread_rwlock_unlock(&pctx->mr_lock);
     if (NULL == target_mr) {
         LOGW("Failed to find memory region at addr 0x%p len %zu\n", mem_addr, mem_len);
         goto end;
@@ -551,6 +590,25 @@ enum user_req_exec_result utrans_get_req_exec_result(utrans_req_info_t* req) {
     return URES_SUCCESS;
 }
 
+enum user_req_state utrans_get_req_state(utrans_req_info_t* req) {
+    if (!req) {
+        return USER_STATE_INVALID;
+    }
+    // utrans_exec_transfer does not post asynchronously, a returned request is finished
+    return USER_STATE_FINISHED;
+}
+
+enum user_req_exec_result utrans_busy_wait(utrans_req_info_t* req) {
+    enum user_req_state state;
+    if (!req) {
+        return URES_ERR_INV_ARG;
+    }
+    do {
+        state = utrans_get_req_state(req);
+    } while (state != USER_STATE_FINISHED && state != USER_STATE_TIMEOUT);
+    return utrans_get_req_exec_result(req);
+}
+
 utrans_req_info_t* utrans_exec_transfer(utrans_ctx_t* ctx, trans_req_t* treq, trans_conf_t* pconf) {
     return NULL;
 }
\ No newline at end of file
@@ -53,6 +53,7 @@ typedef struct {
     char* valid_dev_patt;
     int num_pollers;
     int max_mr;
+    int numa_node; // numa node of the NIC, pollers are pinned to it, < 0 means not care
 } rdma_config_t;
 
 // TODO: hide
@@ -151,6 +152,16 @@ utrans_req_info_t* utrans_exec_transfer(utrans_ctx_t* ctx, trans_req_t* treq, tr
  */
 enum user_req_exec_result utrans_get_req_exec_result(utrans_req_info_t* req);
 
+/** vv
+ * @brief Query request status: running, finished or timed out
+ */
+enum user_req_state utrans_get_req_state(utrans_req_info_t* req);
+
+/** vv
+ * @brief Helper function for busy waitting the request to finish and return the execution result
+ */
+enum user_req_exec_result utrans_busy_wait(utrans_req_info_t* req);
+
 /** vv
  * @brief Release the reference utrans_req_info_t
  * 
@@ -18,6 +18,14 @@ extern "C" {
 #    define UTRANS_PEER_REGINFO_TOLERANCE_MS (200)
 #endif
 
+#ifndef UTRANS_POLLER_IDLE_SPINS
+#    define UTRANS_POLLER_IDLE_SPINS (4096) // empty progress rounds before an idle poller blocks
+#endif
+
+#ifndef UTRANS_POLLER_BLOCK_TIMEOUT_MS
+#    define UTRANS_POLLER_BLOCK_TIMEOUT_MS (100)
+#endif
+
 typedef struct host_info {
     uint64_t inst_id;
     int8_t numa_aware;
@@ -83,17 +83,40 @@ typedef struct {
     volatile int cleaner_exit;
 } cleaner_ctx_t;
 
+struct ucx_ctx;
+
+typedef struct ucx_poller {
+    struct ucx_ctx* pucx_ctx;
+    int idx;
+    int numa_node; // numa node the poller thread is pinned to, -1 if not care
+    pthread_t thd;
+    ucp_worker_h wrk; // owned and progressed by this poller only
+    int wrk_efd;
+    int epoll_fd;
+    int init_ret;
+    volatile int exit;
+    uint64_t num_blocks;
+} __attribute__((aligned(64))) ucx_poller_t;
+
+typedef struct {
+    ucx_poller_t* pollers;
+    int num_pollers;
+
+    pthread_mutex_t start_lock;
+    pthread_cond_t start_cond;
+    int num_inited;
+} ucx_poller_group_t;
+
 typedef struct ucx_ctx {
     struct utrans_ctx* putrz_ctx;
     ucp_context_h pucp_ctx;
-    ucp_worker_h pucp_wrk;
+    ucp_worker_h pucp_wrk; // worker of poller 0, also serves the connection listener
+    ucx_poller_group_t poller_group;
     // ucp_ep_h
     ucp_listener_h conn_listener;
 
-    // TODO: not initialized
     int num_pending_mrs;
-    mr_set_t mr_set;
-    pthread_rwlock_t mr_lock;
+    mr_set_t mr_set; // read lock free, writers serialized inside
 } ucx_ctx_t;
 
 struct utrans_ctx {
@@ -139,6 +162,14 @@ typedef struct utrans_req_info_intl {
     wait_point_t* wait_point;
 } utrans_req_info_intl_t;
 
+/**
+ * @brief Start num_pollers progress threads, each owns one ucp worker and is pinned to numa_node.
+ *   Pollers busy-poll while their worker makes progress and block on the worker event fd when idle.
+ */
+int ucx_pollers_start(ucx_ctx_t* pucx_ctx, int num_pollers, int numa_node);
+
+void ucx_pollers_stop(ucx_ctx_t* pucx_ctx);
+
 utrans_req_info_intl_t* create_utrans_req_info_intl(int will_create_wait_point);
 void release_utrans_req_info_intl(utrans_req_info_intl_t* info);
 
@@ -1,301 +1,170 @@
 #include "utrans_mr_set.h"
 
+#include <sched.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "utrans.h"
 
-struct avl_node {
-    uint64_t addr;
-    size_t len;
+struct mr_entry {
+    uint64_t len;
     void* pvalue;
-
-    struct avl_node* pleft;
-    struct avl_node* pright;
-    int height;
 };
 
-__attribute__((always_inline)) inline int max(int a, int b) {
-    return a < b ? b : a;
-}
-
-__attribute__((always_inline)) inline int avl_height(struct avl_node* pnode) {
-    return pnode == NULL ? 0 : pnode->height;
-}
-
-__attribute__((always_inline)) inline void avl_copy(struct avl_node* pdst, struct avl_node* psrc) {
-    pdst->addr = psrc->addr;
-    pdst->len = psrc->len;
-    pdst->pvalue = psrc->pvalue;
-}
-
-static struct avl_node*
-avl_node_create(uint64_t key, size_t len, void* pval, struct avl_node* pleft, struct avl_node* pright) {
-    struct avl_node* pnode = malloc(sizeof(struct avl_node));
-    if (pnode) {
-        pnode->addr = key;
-        pnode->len = len;
-        pnode->pvalue = pval;
-
-        pnode->pleft = pleft;
-        pnode->pright = pright;
-        pnode->height = 0;
-    }
-    return pnode;
-}
-
-static struct avl_node* avl_ll_rotation(struct avl_node* proot) {
-    struct avl_node* pnode;
-
-    // rotate
-    pnode = proot->pleft;
-    proot->pleft = pnode->pright;
-    pnode->pright = proot;
-
-    // re-calculate height
-    proot->height = max(avl_height(proot->pleft), avl_height(proot->pright)) + 1;
-    pnode->height = max(avl_height(pnode->pleft), avl_height(pnode->pright)) + 1;
-
-    // pnode became new root
-    return pnode;
-}
-
-static struct avl_node* avl_rr_rotation(struct avl_node* proot) {
-    struct avl_node* pnode;
-
-    // rotate
-    pnode = proot->pright;
-    proot->pright = pnode->pleft;
-    pnode->pleft = proot;
-
-    // re-calculate height
-    proot->height = max(avl_height(proot->pleft), avl_height(proot->pright)) + 1;
-    pnode->height = max(avl_height(pnode->pleft), avl_height(pnode->pright)) + 1;
-
-    // pnode became new root
-    return pnode;
-}
-
-static struct avl_node* avl_lr_rotation(struct avl_node* proot) {
-    proot->pleft = avl_rr_rotation(proot->pleft);
-    return avl_ll_rotation(proot);
-}
-
-static struct avl_node* avl_rl_rotation(struct avl_node* proot) {
-    proot->pright = avl_ll_rotation(proot->pright);
-    return avl_rr_rotation(proot);
-}
-
-static struct avl_node* avl_insert(struct avl_node* ptree, uint64_t key, size_t len, void* pval, int* poper_fail) {
-    if (*poper_fail == 1) {
-        return ptree;
-    }
-
-    if (NULL == ptree) {
-        ptree = avl_node_create(key, len, pval, NULL, NULL);
-        if (!ptree) {
-            *poper_fail = 1;
-            return NULL;
-        }
-    } else if (key >= ptree->addr + ptree->len) {
-        // insert to right branch of this tree
-        ptree->pright = avl_insert(ptree->pright, key, len, pval, poper_fail);
-        // check balance of current tree
-        if (avl_height(ptree->pright) - avl_height(ptree->pleft) == 2) {
-            // need re-balance due to height difference larger than 1
-            if (key > ptree->pright->addr) {
-                ptree = avl_rr_rotation(ptree);
-            } else {
-                ptree = avl_rl_rotation(ptree);
-            }
-        }
-    } else if (key + len <= ptree->addr) {
-        // insert to left branch of this tree
-        ptree->pleft = avl_insert(ptree->pleft, key, len, pval, poper_fail);
-        // check balance of current tree
-        if (avl_height(ptree->pleft) - avl_height(ptree->pright) == 2) {
-            // need re-balance due to height difference larger than 1
-            if (key < ptree->pleft->addr) {
-                ptree = avl_ll_rotation(ptree);
-            } else {
-                ptree = avl_lr_rotation(ptree);
-            }
-        }
-    } else {
-        *poper_fail = 1;
-        // node with same key already exists, avoid insert
-        return ptree;
-    }
-    ptree->height = max(avl_height(ptree->pleft), avl_height(ptree->pright)) + 1;
-    return ptree;
-}
+/// immutable once published, addrs[] is kept apart from entries[] so the binary search stays in few cache lines
+struct mr_snapshot {
+    int size;
+    uint64_t* addrs; // sorted start address of each region
+    struct mr_entry* entries;
+};
 
-static struct avl_node* avl_max(struct avl_node* ptree) {
-    struct avl_node* pnode = ptree;
-    if (ptree) {
-        while (pnode->pright) {
-            pnode = pnode->pright;
-        }
-    }
-    return pnode;
-}
+static __thread int tls_reader_slot = -1;
+static int g_next_reader_slot = 0;
 
-static struct avl_node* avl_min(struct avl_node* ptree) {
-    struct avl_node* pnode = ptree;
-    if (ptree) {
-        while (pnode->pleft) {
-            pnode = pnode->pleft;
-        }
+static struct mr_snapshot* mr_snapshot_alloc(int size) {
+    struct mr_snapshot* psnap
+        = malloc(sizeof(struct mr_snapshot) + size * (sizeof(uint64_t) + sizeof(struct mr_entry)));
+    if (psnap) {
+        psnap->size = size;
+        psnap->addrs = (uint64_t*)(psnap + 1);
+        psnap->entries = (struct mr_entry*)(psnap->addrs + size);
     }
-    return pnode;
+    return psnap;
 }
 
-static struct avl_node* avl_find(struct avl_node* ptree, uint64_t addr, size_t len) {
-    struct avl_node* pnode = ptree;
-    while (pnode != NULL) {
-        if (addr + len <= pnode->addr) {
-            // search left branch when addr < root's base addr
-            pnode = pnode->pleft;
-        } else if (addr >= pnode->addr + pnode->len) {
-            // search right branch when addr > root's maximum addr
-            pnode = pnode->pright;
+/// @return index of the last region starting at or before addr, -1 if none
+static int mr_snapshot_floor(const struct mr_snapshot* psnap, uint64_t addr) {
+    int lo = 0;
+    int hi = psnap->size;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (psnap->addrs[mid] <= addr) {
+            lo = mid + 1;
         } else {
-            // addr in mid-item's [0, reg_len], judge whether sub-region of mid-item
-            if (addr >= pnode->addr && addr + len <= pnode->addr + pnode->len) {
-                return pnode;
-            }
-            break;
+            hi = mid;
         }
     }
-    return NULL;
+    return lo - 1;
 }
 
-static void avl_destroy(struct avl_node* ptree, struct mem_region_registed** pitem, int* index) {
-    if (ptree == NULL) {
-        return;
+/// @return index of the region containing [addr, addr + len), -1 if none
+static int mr_snapshot_find(const struct mr_snapshot* psnap, uint64_t addr, size_t len) {
+    if (!psnap) {
+        return -1;
     }
-    avl_destroy(ptree->pleft, pitem, index);
-    avl_destroy(ptree->pright, pitem, index);
-    if (pitem && index) {
-        pitem[(*index)++] = ptree->pvalue;
+    int idx = mr_snapshot_floor(psnap, addr);
+    if (idx >= 0 && addr + len <= psnap->addrs[idx] + psnap->entries[idx].len) {
+        return idx;
     }
-    free(ptree);
+    return -1;
 }
 
-static void avl_scan(struct avl_node* ptree, void** pitem, int* index) {
-    if (ptree == NULL) {
-        return;
+static mr_reader_slot_t* mr_reader_slot(mr_set_t* pmr_set) {
+    if (tls_reader_slot < 0) {
+        tls_reader_slot = __atomic_fetch_add(&g_next_reader_slot, 1, __ATOMIC_RELAXED) % UTRANS_MR_SET_READER_SLOTS;
     }
-    avl_scan(ptree->pleft, pitem, index);
-    pitem[(*index)++] = ptree->pvalue;
-    avl_scan(ptree->pright, pitem, index);
+    return &pmr_set->readers[tls_reader_slot];
 }
 
-static int avl_traverse(struct avl_node* ptree, int judge_cb_ret, item_oper_cb cb_func, void* cb_arg) {
-    if (ptree == NULL) {
-        return 0;
-    }
-
-    int ret;
-
-    ret = avl_traverse(ptree->pleft, judge_cb_ret, cb_func, cb_arg);
-    if (judge_cb_ret && ret != 0) {
-        return ret;
-    }
-
-    if (cb_func) {
-        ret = cb_func(ptree->pvalue, cb_arg);
-        if (judge_cb_ret && ret != 0) {
-            return ret;
+/// enter read side, @return epoch parity to pass to mr_read_unlock
+static int mr_read_lock(mr_reader_slot_t* pslot, mr_set_t* pmr_set) {
+    for (;;) {
+        unsigned long epoch = __atomic_load_n(&pmr_set->epoch, __ATOMIC_SEQ_CST);
+        int idx = (int)(epoch & 1);
+        __atomic_fetch_add(&pslot->cnt[idx], 1, __ATOMIC_SEQ_CST);
+        // re-check so that a reader counted under a parity always entered before that epoch ended
+        if (__atomic_load_n(&pmr_set->epoch, __ATOMIC_SEQ_CST) == epoch) {
+            return idx;
         }
+        __atomic_fetch_sub(&pslot->cnt[idx], 1, __ATOMIC_SEQ_CST);
     }
+}
 
-    ret = avl_traverse(ptree->pright, judge_cb_ret, cb_func, cb_arg);
-    if (judge_cb_ret && ret != 0) {
-        return ret;
-    }
-    return 0;
+static void mr_read_unlock(mr_reader_slot_t* pslot, int idx) {
+    __atomic_fetch_sub(&pslot->cnt[idx], 1, __ATOMIC_RELEASE);
 }
 
-struct avl_node* avl_delete_node(struct avl_node* ptree, struct avl_node* pnode, void** pitem_ret) {
-    if (NULL == ptree || pnode == NULL) {
-        return ptree;
-    } else if (pnode->addr < ptree->addr) {
-        // corresponding node locate at left branch
-        ptree->pleft = avl_delete_node(ptree->pleft, pnode, pitem_ret);
-        // judge balance stat of current tree
-        if (avl_height(ptree->pright) - avl_height(ptree->pleft) == 2) {
-            struct avl_node* pright = ptree->pright;
-            if (avl_height(pright->pleft) > avl_height(pright->pright)) {
-                ptree = avl_rl_rotation(ptree);
-            } else {
-                ptree = avl_rr_rotation(ptree);
-            }
-        }
-    } else if (pnode->addr > ptree->addr) {
-        // corresponding node locate at right branch
-        ptree->pright = avl_delete_node(ptree->pright, pnode, pitem_ret);
-        // judge balance stat of current tree
-        if (avl_height(ptree->pleft) - avl_height(ptree->pright) == 2) {
-            struct avl_node* pleft = ptree->pleft;
-            if (avl_height(pleft->pright) > avl_height(pleft->pleft)) {
-                ptree = avl_lr_rotation(ptree);
-            } else {
-                ptree = avl_ll_rotation(ptree);
-            }
-        }
-    } else {
-        if (pitem_ret) {
-            *pitem_ret = ptree->pvalue;
-        }
-        // root node is the target node to delete
-        if (ptree->pleft && ptree->pright) {
-            // both left and right branch not empty
-            if (avl_height(ptree->pleft) > avl_height(ptree->pright)) {
-                // height of left branch bigger than right
-                struct avl_node* pleft_max = avl_max(ptree->pleft);
-                avl_copy(ptree, pleft_max);
-                ptree->pleft = avl_delete_node(ptree->pleft, pleft_max, NULL);
-            } else {
-                struct avl_node* pright_min = avl_min(ptree->pright);
-                avl_copy(ptree, pright_min);
-                ptree->pright = avl_delete_node(ptree->pright, pright_min, NULL);
-            }
-        } else {
-            // node to free or usless pleft_max/pright_min
-            struct avl_node* pfree = ptree;
-            ptree = ptree->pleft ? ptree->pleft : ptree->pright;
-            free(pfree);
+/// publish new snapshot and reclaim the old one after a grace period, shall hold wr_lock
+static void mr_publish(mr_set_t* pmr_set, struct mr_snapshot* pnew) {
+    struct mr_snapshot* pold = pmr_set->snap;
+    __atomic_store_n(&pmr_set->snap, pnew, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&pmr_set->size, pnew ? pnew->size : 0, __ATOMIC_RELAXED);
+
+    unsigned long epoch = __atomic_fetch_add(&pmr_set->epoch, 1, __ATOMIC_SEQ_CST);
+    int idx = (int)(epoch & 1);
+    for (int i = 0; i < UTRANS_MR_SET_READER_SLOTS; ++i) {
+        while (__atomic_load_n(&pmr_set->readers[i].cnt[idx], __ATOMIC_ACQUIRE) != 0) {
+            sched_yield();
         }
     }
-    return ptree;
+    free(pold);
 }
 
 void utrans_mr_set_init(mr_set_t* pmr_set) {
     if (pmr_set) {
-        pmr_set->root = NULL;
-        pmr_set->size = 0;
+        memset(pmr_set, 0, sizeof(*pmr_set));
+        pthread_mutex_init(&pmr_set->wr_lock, NULL);
     }
 }
 
 int utrans_mr_set_insert(mr_set_t* pmr_set, void* addr, size_t len, void* pitem) {
-    int op_fail = 0;
     if (!pmr_set || !len || !pitem) {
         return -1;
     }
 
-    pmr_set->root = avl_insert(pmr_set->root, (uint64_t)addr, len, pitem, &op_fail);
-    if (!op_fail) {
-        pmr_set->size++;
+    uint64_t key = (uint64_t)addr;
+    int ret = 1;
+    pthread_mutex_lock(&pmr_set->wr_lock);
+    struct mr_snapshot* pold = pmr_set->snap;
+    int old_size = pold ? pold->size : 0;
+    int pos = pold ? mr_snapshot_floor(pold, key) + 1 : 0;
+
+    // reject overlaps with the neighbours
+    if (pos > 0 && pold->addrs[pos - 1] + pold->entries[pos - 1].len > key) {
+        goto end;
+    }
+    if (pos < old_size && key + len > pold->addrs[pos]) {
+        goto end;
+    }
+
+    struct mr_snapshot* pnew = mr_snapshot_alloc(old_size + 1);
+    if (!pnew) {
+        goto end;
+    }
+    if (pos > 0) {
+        memcpy(pnew->addrs, pold->addrs, pos * sizeof(uint64_t));
+        memcpy(pnew->entries, pold->entries, pos * sizeof(struct mr_entry));
+    }
+    pnew->addrs[pos] = key;
+    pnew->entries[pos].len = len;
+    pnew->entries[pos].pvalue = pitem;
+    if (pos < old_size) {
+        memcpy(pnew->addrs + pos + 1, pold->addrs + pos, (old_size - pos) * sizeof(uint64_t));
+        memcpy(pnew->entries + pos + 1, pold->entries + pos, (old_size - pos) * sizeof(struct mr_entry));
     }
-    return op_fail;
+    mr_publish(pmr_set, pnew);
+    ret = 0;
+
+end:
+    pthread_mutex_unlock(&pmr_set->wr_lock);
+    return ret;
 }
 
 void* utrans_mr_set_find(mr_set_t* pmr_set, void* addr, size_t len) {
     if (!pmr_set || !len) {
         return NULL;
     }
-    struct avl_node* pnode = avl_find(pmr_set->root, (uint64_t)addr, len);
-    return pnode ? pnode->pvalue : NULL;
+    void* pitem = NULL;
+    mr_reader_slot_t* pslot = mr_reader_slot(pmr_set);
+    int idx = mr_read_lock(pslot, pmr_set);
+    struct mr_snapshot* psnap = __atomic_load_n(&pmr_set->snap, __ATOMIC_SEQ_CST);
+    int pos = mr_snapshot_find(psnap, (uint64_t)addr, len);
+    if (pos >= 0) {
+        pitem = psnap->entries[pos].pvalue;
+    }
+    mr_read_unlock(pslot, idx);
+    return pitem;
 }
 
 void* utrans_mr_set_remove(mr_set_t* pmr_set, void* addr, size_t len) {
@@ -303,13 +172,30 @@ void* utrans_mr_set_remove(mr_set_t* pmr_set, void* addr, size_t len) {
         return NULL;
     }
     void* pitem = NULL;
-    struct avl_node* pnode = avl_find(pmr_set->root, (uint64_t)addr, len);
-    if (pnode) {
-        pmr_set->root = avl_delete_node(pmr_set->root, pnode, &pitem);
-        if (pitem) {
-            pmr_set->size--;
+    pthread_mutex_lock(&pmr_set->wr_lock);
+    struct mr_snapshot* pold = pmr_set->snap;
+    int pos = mr_snapshot_find(pold, (uint64_t)addr, len);
+    if (pos < 0) {
+        goto end;
+    }
+
+    struct mr_snapshot* pnew = NULL;
+    int new_size = pold->size - 1;
+    if (new_size > 0) {
+        pnew = mr_snapshot_alloc(new_size);
+        if (!pnew) {
+            goto end;
         }
+        memcpy(pnew->addrs, pold->addrs, pos * sizeof(uint64_t));
+        memcpy(pnew->entries, pold->entries, pos * sizeof(struct mr_entry));
+        memcpy(pnew->addrs + pos, pold->addrs + pos + 1, (new_size - pos) * sizeof(uint64_t));
+        memcpy(pnew->entries + pos, pold->entries + pos + 1, (new_size - pos) * sizeof(struct mr_entry));
     }
+    pitem = pold->entries[pos].pvalue;
+    mr_publish(pmr_set, pnew);
+
+end:
+    pthread_mutex_unlock(&pmr_set->wr_lock);
     return pitem;
 }
 
@@ -319,28 +205,43 @@ void** utrans_mr_set_getall(mr_set_t* pmr_set, int* psize) {
     }
 
     void** pitems = NULL;
-    if (pmr_set->size > 0) {
-        pitems = malloc(sizeof(void*) * pmr_set->size);
+    mr_reader_slot_t* pslot = mr_reader_slot(pmr_set);
+    int idx = mr_read_lock(pslot, pmr_set);
+    struct mr_snapshot* psnap = __atomic_load_n(&pmr_set->snap, __ATOMIC_SEQ_CST);
+    if (psnap && psnap->size > 0) {
+        pitems = malloc(sizeof(void*) * psnap->size);
         if (pitems) {
-            *psize = 0;
-            avl_scan(pmr_set->root, pitems, psize);
-        } else {
-            *psize = pmr_set->size;
+            for (int i = 0; i < psnap->size; ++i) {
+                pitems[i] = psnap->entries[i].pvalue;
+            }
         }
+        *psize = psnap->size;
     }
+    mr_read_unlock(pslot, idx);
     return pitems;
 }
 
 int utrans_mr_set_traverse(mr_set_t* pmr_set, item_oper_cb cb_func, void* cb_arg) {
-    if (!pmr_set) {
+    if (!pmr_set || !cb_func) {
         return 0;
     }
-    return avl_traverse(pmr_set->root, 1, cb_func, cb_arg);
+    int ret = 0;
+    mr_reader_slot_t* pslot = mr_reader_slot(pmr_set);
+    int idx = mr_read_lock(pslot, pmr_set);
+    struct mr_snapshot* psnap = __atomic_load_n(&pmr_set->snap, __ATOMIC_SEQ_CST);
+    for (int i = 0; psnap && i < psnap->size; ++i) {
+        ret = cb_func(psnap->entries[i].pvalue, cb_arg);
+        if (ret != 0) {
+            break;
+        }
+    }
+    mr_read_unlock(pslot, idx);
+    return ret;
 }
 
 int utrans_mr_set_getsize(mr_set_t* pmr_set) {
     if (pmr_set) {
-        return pmr_set->size;
+        return __atomic_load_n(&pmr_set->size, __ATOMIC_RELAXED);
     }
     return 0;
 }
@@ -349,10 +250,14 @@ void utrans_mr_set_destroy(mr_set_t* pmr_set, item_oper_cb cb_func, void* cb_arg
     if (!pmr_set) {
         return;
     }
-    if (cb_func) {
-        avl_traverse(pmr_set->root, 0, cb_func, cb_arg);
+    pthread_mutex_lock(&pmr_set->wr_lock);
+    struct mr_snapshot* psnap = pmr_set->snap;
+    if (cb_func && psnap) {
+        for (int i = 0; i < psnap->size; ++i) {
+            cb_func(psnap->entries[i].pvalue, cb_arg);
+        }
     }
-    avl_destroy(pmr_set->root, NULL, NULL);
-    pmr_set->root = NULL;
-    pmr_set->size = 0;
-}
\ No newline at end of file
+    mr_publish(pmr_set, NULL);
+    pthread_mutex_unlock(&pmr_set->wr_lock);
+    pthread_mutex_destroy(&pmr_set->wr_lock);
+}
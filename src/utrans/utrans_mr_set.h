@@ -1,17 +1,34 @@
 #ifndef INCLUDE_UTRANS_MR_SET_H_
 #define INCLUDE_UTRANS_MR_SET_H_
 
+#include <pthread.h>
 #include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-struct avl_node;
+#ifndef UTRANS_MR_SET_READER_SLOTS
+#    define UTRANS_MR_SET_READER_SLOTS (64)
+#endif
+
+struct mr_snapshot;
 
-typedef struct avl_tree {
-    struct avl_node* root;
-    int size;
+/// in-flight reader counters of one slot, indexed by epoch parity
+typedef struct mr_reader_slot {
+    volatile long cnt[2];
+} __attribute__((aligned(64))) mr_reader_slot_t;
+
+/// Registered memory regions kept as a sorted flat array (snapshot).
+/// Readers binary search the published snapshot without taking any lock,
+/// writers rebuild a new snapshot (copy-on-write), publish it, flip the epoch
+/// and free the old one once every reader of the previous epoch has left.
+typedef struct mr_set {
+    struct mr_snapshot* volatile snap;
+    volatile unsigned long epoch;
+    volatile int size;
+    pthread_mutex_t wr_lock; // serializes writers only
+    mr_reader_slot_t readers[UTRANS_MR_SET_READER_SLOTS];
 } mr_set_t;
 
 typedef int (*item_oper_cb)(void* item_val, void* cb_arg);
@@ -24,7 +41,7 @@ void utrans_mr_set_init(mr_set_t* pmr_set);
 /// @return 0 when success
 int utrans_mr_set_insert(mr_set_t* pmr_set, void* addr, size_t len, void* pitem);
 
-/// find corresponding memory region
+/// find corresponding memory region, lock free and safe against concurrent insert/remove
 /// @return target memory region contains input [addr, adrr+len],
 /// will return null when addr range overlaps existed regions
 void* utrans_mr_set_find(mr_set_t* pmr_set, void* addr, size_t len);
@@ -43,6 +60,7 @@ void** utrans_mr_set_getall(mr_set_t* pmr_set, int* psize);
 /// @param cb callback function on each element, cb shall return 0 when succ,
 /// return others will stop traverse
 /// @param cb_arg input param for cb
+/// @note cb runs inside the read side, it shall not insert into or remove from the same set
 /// @return 0 for success, otherwise error happend
 int utrans_mr_set_traverse(mr_set_t* pmr_set, item_oper_cb cb, void* cb_arg);
 
@@ -61,4 +79,4 @@ void utrans_mr_set_destroy(mr_set_t* pmr_set, item_oper_cb cb, void* cb_arg);
 }
 #endif
 
-#endif
\ No newline at end of file
+#endif
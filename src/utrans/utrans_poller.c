@@ -0,0 +1,226 @@
+#ifndef _GNU_SOURCE
+#    define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <numa.h>
+#include <sys/epoll.h>
+
+#include "log.h"
+#include "utils.h"
+#include "utils_helper.h"
+#include "utrans_internal.h"
+
+int _ucp_worker_init(ucp_context_h ucp_ctx, ucp_worker_h* pucp_wrk, size_t inst_id);
+
+static void _poller_pin_numa(ucx_poller_t* poller) {
+    if (poller->numa_node < 0 || numa_available() == -1) {
+        return;
+    }
+    if (numa_run_on_node(poller->numa_node) != 0) {
+        LOGW("poller %d bind to numa node %d failed: %s\n", poller->idx, poller->numa_node, strerror(errno));
+        return;
+    }
+    numa_set_preferred(poller->numa_node);
+}
+
+static int _poller_wrk_init(ucx_poller_t* poller) {
+    int ret = UTRANS_RET_SUCC;
+    ucs_status_t status;
+    ucx_ctx_t* pucx_ctx = poller->pucx_ctx;
+
+    // worker is created by the poller thread itself so that its resources are first-touched on the pinned node
+    ret = _ucp_worker_init(pucx_ctx->pucp_ctx, &poller->wrk, pucx_ctx->putrz_ctx->inst_id);
+    if (IS_UTRANS_FAIL(ret)) {
+        goto end;
+    }
+
+    status = ucp_worker_get_efd(poller->wrk, &poller->wrk_efd);
+    if (status != UCS_OK) {
+        LOGE("poller %d failed to ucp_worker_get_efd (%s)\n", poller->idx, ucs_status_string(status));
+        ret = UTRANS_RET_INTERNAL_ERR;
+        goto end;
+    }
+
+    poller->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (poller->epoll_fd < 0) {
+        LOGE("poller %d failed to epoll_create1: %s\n", poller->idx, strerror(errno));
+        ret = UTRANS_RET_INTERNAL_ERR;
+        goto end;
+    }
+    if (add_fd(poller->epoll_fd, poller->wrk_efd, poller) != 0) {
+        ret = UTRANS_RET_INTERNAL_ERR;
+        goto end;
+    }
+
+end:
+    return ret;
+}
+
+static void _poller_wrk_destroy(ucx_poller_t* poller) {
+    if (poller->epoll_fd >= 0) {
+        close(poller->epoll_fd);
+        poller->epoll_fd = -1;
+    }
+    // wrk_efd is owned by the worker
+    poller->wrk_efd = -1;
+    if (poller->wrk) {
+        ucp_worker_destroy(poller->wrk);
+        poller->wrk = NULL;
+    }
+}
+
+/**
+ * Returns 1 if the worker is armed and the caller may block on its event fd,
+ * 0 if there are still events to progress.
+ */
+static int _poller_try_arm(ucx_poller_t* poller) {
+    ucs_status_t status;
+
+    while (ucp_worker_progress(poller->wrk) != 0) {
+    }
+    status = ucp_worker_arm(poller->wrk);
+    if (status == UCS_ERR_BUSY) {
+        return 0;
+    }
+    if (status != UCS_OK) {
+        LOGE("poller %d failed to ucp_worker_arm (%s)\n", poller->idx, ucs_status_string(status));
+        return 0;
+    }
+    return 1;
+}
+
+static void* _poller_thread_func(void* arg) {
+    ucx_poller_t* poller = (ucx_poller_t*)arg;
+    ucx_poller_group_t* group = &poller->pucx_ctx->poller_group;
+    struct epoll_event ev;
+    unsigned idle_spins = 0;
+    char thd_name[16];
+
+    snprintf(thd_name, sizeof(thd_name), "utrans_poll%d", poller->idx);
+    pthread_setname_np(pthread_self(), thd_name);
+    _poller_pin_numa(poller);
+
+    poller->init_ret = _poller_wrk_init(poller);
+    pthread_mutex_lock(&group->start_lock);
+    ++group->num_inited;
+    pthread_cond_signal(&group->start_cond);
+    pthread_mutex_unlock(&group->start_lock);
+    if (IS_UTRANS_FAIL(poller->init_ret)) {
+        return NULL;
+    }
+
+    while (!__atomic_load_n(&poller->exit, __ATOMIC_ACQUIRE)) {
+        // busy poll while the worker makes progress, completion latency matters most here
+        if (ucp_worker_progress(poller->wrk) != 0) {
+            idle_spins = 0;
+            continue;
+        }
+        // idle, keep spinning for a short grace period to absorb back-to-back submissions
+        if (++idle_spins < UTRANS_POLLER_IDLE_SPINS) {
+            continue;
+        }
+        idle_spins = 0;
+
+        if (!_poller_try_arm(poller)) {
+            continue;
+        }
+        ++poller->num_blocks;
+        // woken by the worker's completion events, the timeout bounds a missed wakeup
+        int n = epoll_wait(poller->epoll_fd, &ev, 1, UTRANS_POLLER_BLOCK_TIMEOUT_MS);
+        if (n < 0 && errno != EINTR) {
+            LOGE("poller %d epoll_wait failed: %s\n", poller->idx, strerror(errno));
+        }
+    }
+
+    return NULL;
+}
+
+int ucx_pollers_start(ucx_ctx_t* pucx_ctx, int num_pollers, int numa_node) {
+    int ret = UTRANS_RET_SUCC;
+    int num_started = 0;
+    ucx_poller_group_t* group = &pucx_ctx->poller_group;
+
+    if (num_pollers <= 0) {
+        return UTRANS_RET_INVALID_ARGS;
+    }
+
+    group->pollers = (ucx_poller_t*)lib2easy_malloc_align(num_pollers * sizeof(ucx_poller_t), 64);
+    if (!group->pollers) {
+        return UTRANS_RET_NO_MEM;
+    }
+    memset(group->pollers, 0, num_pollers * sizeof(ucx_poller_t));
+    group->num_pollers = 0;
+
+    group->num_inited = 0;
+    pthread_mutex_init(&group->start_lock, NULL);
+    pthread_cond_init(&group->start_cond, NULL);
+
+    for (int i = 0; i < num_pollers; ++i) {
+        ucx_poller_t* poller = &group->pollers[i];
+        poller->pucx_ctx = pucx_ctx;
+        poller->idx = i;
+        poller->numa_node = numa_node;
+        poller->wrk_efd = -1;
+        poller->epoll_fd = -1;
+        if (0 != pthread_create(&poller->thd, NULL, _poller_thread_func, poller)) {
+            LOGE("create poller thread %d failed: %s\n", i, strerror(errno));
+            ret = UTRANS_RET_POSIX_PTHREAD;
+            break;
+        }
+        ++num_started;
+    }
+
+    // wait until every started poller owns its worker, or failed to create it
+    pthread_mutex_lock(&group->start_lock);
+    while (group->num_inited < num_started) {
+        pthread_cond_wait(&group->start_cond, &group->start_lock);
+    }
+    pthread_mutex_unlock(&group->start_lock);
+    group->num_pollers = num_started;
+
+    for (int i = 0; i < num_started; ++i) {
+        if (IS_UTRANS_FAIL(group->pollers[i].init_ret)) {
+            ret = group->pollers[i].init_ret;
+        }
+    }
+    if (IS_UTRANS_FAIL(ret)) {
+        ucx_pollers_stop(pucx_ctx);
+        return ret;
+    }
+
+    LOGI("[POLLER] started %d pollers on numa node %d\n", num_started, numa_node);
+    return ret;
+}
+
+void ucx_pollers_stop(ucx_ctx_t* pucx_ctx) {
+    ucx_poller_group_t* group = &pucx_ctx->poller_group;
+    if (!group->pollers) {
+        return;
+    }
+
+    for (int i = 0; i < group->num_pollers; ++i) {
+        ucx_poller_t* poller = &group->pollers[i];
+        __atomic_store_n(&poller->exit, 1, __ATOMIC_RELEASE);
+        if (poller->wrk && IS_UTRANS_SUCC(poller->init_ret)) {
+            ucp_worker_signal(poller->wrk);
+        }
+    }
+    for (int i = 0; i < group->num_pollers; ++i) {
+        ucx_poller_t* poller = &group->pollers[i];
+        pthread_join(poller->thd, NULL);
+        LOGI("[POLLER] poller %d stopped, blocks=%" PRIu64 "\n", i, poller->num_blocks);
+        _poller_wrk_destroy(poller);
+    }
+
+    pthread_cond_destroy(&group->start_cond);
+    pthread_mutex_destroy(&group->start_lock);
+    lib2easy_free_aligned(group->pollers);
+    group->pollers = NULL;
+    group->num_pollers = 0;
+}